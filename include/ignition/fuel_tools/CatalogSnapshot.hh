@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_CATALOGSNAPSHOT_HH_
+#define IGNITION_FUEL_TOOLS_CATALOGSNAPSHOT_HH_
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/Export.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class CatalogSnapshotPrivate;
+
+    /// \brief Read-only, memory-mapped view of a server's catalog of
+    /// models, saved in a compact binary file.
+    ///
+    /// The file holds a header, an array of fixed-size records, and a table
+    /// of the strings they point to. Opening it maps it without reading it,
+    /// and each model is only decoded when it's accessed, so iterating can
+    /// start right away however large the catalog is. Processes opening
+    /// the same snapshot share its pages through the page cache.
+    ///
+    /// Snapshots are written with the byte order of the machine, and files
+    /// with another byte order or format version are rejected.
+    /// \sa LocalCache::ModelSnapshot
+    class IGNITION_FUEL_TOOLS_VISIBLE CatalogSnapshot
+    {
+      /// \brief Constructor. The snapshot is empty until opened.
+      public: CatalogSnapshot();
+
+      /// \brief No copy constructor, share snapshots with std::shared_ptr.
+      public: CatalogSnapshot(const CatalogSnapshot &) = delete;
+
+      /// \brief No assignment operator.
+      /// \return Reference to this object.
+      public: CatalogSnapshot &operator=(const CatalogSnapshot &) = delete;
+
+      /// \brief Destructor. Unmaps the file.
+      public: ~CatalogSnapshot();
+
+      /// \brief Write a snapshot. The file is replaced atomically, so
+      /// processes which have the previous snapshot open keep reading it.
+      /// \param[in] _path Path of the snapshot.
+      /// \param[in] _ids Models of the catalog. The server isn't saved.
+      /// \return True if the file was written.
+      public: static bool Write(const std::string &_path,
+          const std::vector<ModelIdentifier> &_ids);
+
+      /// \brief Open a snapshot, closing the current one if any.
+      /// \param[in] _path Path of the snapshot.
+      /// \return True if the file is a valid snapshot.
+      public: bool Open(const std::string &_path);
+
+      /// \brief Whether a snapshot is open.
+      /// \return True if Open succeeded.
+      public: bool Valid() const;
+
+      /// \brief Number of models.
+      /// \return Number of models in the snapshot.
+      public: size_t Size() const;
+
+      /// \brief When the snapshot was written.
+      /// \return Time the snapshot was written.
+      public: std::chrono::system_clock::time_point Saved() const;
+
+      /// \brief Decode a model.
+      /// \param[in] _index Index of the model, less than Size().
+      /// \param[out] _id The model. Its server isn't set.
+      /// \return False if the index is out of range or the record is
+      /// corrupt.
+      public: bool At(size_t _index, ModelIdentifier &_id) const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<CatalogSnapshotPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
@@ -18,6 +18,8 @@
 #ifndef IGNITION_FUEL_TOOLS_CLIENTCONFIG_HH_
 #define IGNITION_FUEL_TOOLS_CLIENTCONFIG_HH_
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -97,6 +99,22 @@ namespace ignition
       private: std::unique_ptr<ServerConfigPrivate> dataPtr;
     };
 
+    /// \brief How FuelClient::Models answers listings of a server's whole
+    /// catalog, of an owner's models, or of a single model.
+    enum class ListingPolicy
+    {
+      /// \brief Return matching cached models if there are any, otherwise
+      /// request the listing from the server.
+      CACHE_FIRST,
+
+      /// \brief Return the listing saved by a previous request right away,
+      /// and refresh it in the background once it's older than the listing
+      /// TTL, so the next request gets the update. Listings which were
+      /// never requested are fetched from the server. Whole catalogs are
+      /// read from a memory-mapped CatalogSnapshot.
+      STALE_WHILE_REVALIDATE
+    };
+
     /// \brief High level interface to ignition fuel.
     ///
     class IGNITION_FUEL_TOOLS_VISIBLE ClientConfig
@@ -156,6 +174,95 @@ namespace ignition
       /// \param[in] _path path on disk where models are saved.
       public: void SetCacheLocation(const std::string &_path);
 
+      /// \brief Whether model file URLs which are not cached are fetched on
+      /// their own, instead of downloading the whole model. It's enabled by
+      /// default if the IGN_FUEL_LAZY_FILES environment variable is "1" or
+      /// "true".
+      /// \return True if files are fetched lazily.
+      /// \sa FuelClient::DownloadModelFile
+      public: bool LazyFileFetch() const;
+
+      /// \brief Set whether model file URLs which are not cached are fetched
+      /// on their own, instead of downloading the whole model.
+      /// \param[in] _lazy True to fetch files lazily.
+      public: void SetLazyFileFetch(bool _lazy);
+
+      /// \brief Path to a lockfile, which pins the version of resources
+      /// requested without a version. It defaults to the value of the
+      /// IGN_FUEL_LOCKFILE environment variable.
+      /// \return Path to the lockfile, or empty if not used.
+      /// \sa Lockfile
+      public: std::string LockfilePath() const;
+
+      /// \brief Set the path to a lockfile, which is loaded by clients
+      /// created with this configuration.
+      /// \param[in] _path Path to the lockfile, or empty to not use one.
+      public: void SetLockfilePath(const std::string &_path);
+
+      /// \brief Whether a new version of a cached model is assembled from
+      /// the previous version, fetching only the files which changed. It's
+      /// enabled unless the IGN_FUEL_DELTA_UPDATES environment variable is
+      /// "0" or "false".
+      /// \return True if delta updates are enabled.
+      /// \sa FuelClient::DownloadModel
+      public: bool DeltaUpdates() const;
+
+      /// \brief Set whether a new version of a cached model is assembled
+      /// from the previous version.
+      /// \param[in] _delta True to enable delta updates.
+      public: void SetDeltaUpdates(bool _delta);
+
+      /// \brief How model listings are answered. Defaults to
+      /// ListingPolicy::CACHE_FIRST, or to the IGN_FUEL_LISTING_POLICY
+      /// environment variable, "cache_first" or "stale_while_revalidate".
+      /// \return The listing policy.
+      /// \sa FuelClient::Models(const ModelIdentifier &)
+      public: ListingPolicy ListingCachePolicy() const;
+
+      /// \brief Set how model listings are answered.
+      /// \param[in] _policy The listing policy.
+      public: void SetListingCachePolicy(ListingPolicy _policy);
+
+      /// \brief How long a saved listing is considered fresh under
+      /// ListingPolicy::STALE_WHILE_REVALIDATE. Defaults to 5 minutes.
+      /// \return Time to live of saved listings.
+      public: std::chrono::seconds ListingTtl() const;
+
+      /// \brief Set how long a saved listing is considered fresh.
+      /// \param[in] _ttl Time to live. Zero refreshes on every request.
+      public: void SetListingTtl(const std::chrono::seconds &_ttl);
+
+      /// \brief Directory of the hot tier of the cache, a small and fast
+      /// location, such as a tmpfs or a local NVMe drive, holding copies of
+      /// the most accessed models and worlds. Defaults to the
+      /// IGN_FUEL_HOT_CACHE_PATH environment variable.
+      /// \return Path of the hot tier, or empty if the cache has one tier.
+      /// \sa LocalCache::TierStats
+      public: std::string HotCacheLocation() const;
+
+      /// \brief Set the directory of the hot tier of the cache. It must not
+      /// be inside the cache location.
+      /// \param[in] _path Path of the hot tier, or empty to disable it.
+      public: void SetHotCacheLocation(const std::string &_path);
+
+      /// \brief Maximum size of the hot tier. Defaults to 1 GiB.
+      /// \return Capacity in bytes.
+      public: uint64_t HotCacheCapacity() const;
+
+      /// \brief Set the maximum size of the hot tier.
+      /// \param[in] _bytes Capacity in bytes.
+      public: void SetHotCacheCapacity(uint64_t _bytes);
+
+      /// \brief Number of lookups after which a resource is copied to the
+      /// hot tier. Defaults to 3.
+      /// \return Number of lookups.
+      public: unsigned int HotCachePromotion() const;
+
+      /// \brief Set the number of lookups after which a resource is copied
+      /// to the hot tier.
+      /// \param[in] _lookups Number of lookups, at least 1.
+      public: void SetHotCachePromotion(unsigned int _lookups);
+
       /// \brief Returns all the client information as a string.
       /// \param[in] _prefix Optional prefix for every line of the string.
       /// \return Client information string
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_DOWNLOADOPTIONS_HH_
+#define IGNITION_FUEL_TOOLS_DOWNLOADOPTIONS_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/Export.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class DownloadOptionsPrivate;
+
+    /// \brief Phases of a model or world download.
+    enum class DownloadPhase
+    {
+      /// \brief Transferring the archive from the server. Progress is in
+      /// bytes.
+      DOWNLOAD,
+
+      /// \brief Extracting the archive into the cache. Progress is in
+      /// uncompressed bytes.
+      EXTRACT,
+
+      /// \brief Converting model:// URIs to paths on disk. Progress is 0 of 1
+      /// when the phase starts, and 1 of 1 when it ends.
+      FIX_PATHS
+    };
+
+    /// \brief Priority classes of scheduled downloads. Each class has its own
+    /// concurrency limit, so foreground downloads never wait for background
+    /// ones.
+    /// \sa FuelClient::QueueDownloadModel
+    enum class DownloadPriority
+    {
+      /// \brief Needed right now, such as by a blocking DownloadModel call.
+      FOREGROUND,
+
+      /// \brief Speculative, such as prefetching the assets of a scenario.
+      BACKGROUND
+    };
+
+    /// \brief Progress callback.
+    /// \param[in] _phase Current phase.
+    /// \param[in] _current Amount of work done in this phase.
+    /// \param[in] _total Total amount of work of this phase, or 0 if
+    /// unknown, such as when the server doesn't send a content length.
+    using DownloadProgressCallback = std::function<void(DownloadPhase _phase,
+        uint64_t _current, uint64_t _total)>;
+
+    /// \brief Lets one thread cancel a download running in another thread.
+    /// Copies share the same state, so a copy given to DownloadOptions can
+    /// be cancelled through the original.
+    class IGNITION_FUEL_TOOLS_VISIBLE CancellationToken
+    {
+      /// \brief Constructor.
+      public: CancellationToken();
+
+      /// \brief Request cancellation. Downloads using this token stop at the
+      /// next transfer callback or between archive entries, and return
+      /// ResultType::FETCH_CANCELLED.
+      public: void Cancel();
+
+      /// \brief Whether cancellation was requested.
+      /// \return True if Cancel was called.
+      public: bool Cancelled() const;
+
+      /// \brief State shared by all the copies.
+      private: std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    /// \brief Options of a model or world download.
+    class IGNITION_FUEL_TOOLS_VISIBLE DownloadOptions
+    {
+      /// \brief Constructor.
+      public: DownloadOptions();
+
+      /// \brief Copy constructor.
+      /// \param[in] _orig The options to copy.
+      public: DownloadOptions(const DownloadOptions &_orig);
+
+      /// \brief Assignment operator overload.
+      /// \param[in] _orig The options to copy.
+      /// \return Reference to this object.
+      public: DownloadOptions &operator=(const DownloadOptions &_orig);
+
+      /// \brief Destructor.
+      public: ~DownloadOptions();
+
+      /// \brief Get the headers sent with the requests.
+      /// \return Headers, such as {"Private-token: abc"}.
+      public: const std::vector<std::string> &Headers() const;
+
+      /// \brief Set the headers sent with the requests.
+      /// \param[in] _headers Headers, such as {"Private-token: abc"}.
+      public: void SetHeaders(const std::vector<std::string> &_headers);
+
+      /// \brief Get the progress callback.
+      /// \return The callback, which may be empty.
+      public: const DownloadProgressCallback &ProgressCallback() const;
+
+      /// \brief Set a callback to be called as the download progresses. It
+      /// is called from the downloading thread, and should return quickly.
+      /// \param[in] _callback Callback.
+      public: void SetProgressCallback(
+          const DownloadProgressCallback &_callback);
+
+      /// \brief Get the cancellation token.
+      /// \return The token.
+      public: const CancellationToken &Cancellation() const;
+
+      /// \brief Set the cancellation token.
+      /// \param[in] _token Token, whose Cancel function aborts the download.
+      public: void SetCancellation(const CancellationToken &_token);
+
+      /// \brief Report progress to the callback, if any.
+      /// \param[in] _phase Current phase.
+      /// \param[in] _current Amount of work done in this phase.
+      /// \param[in] _total Total amount of work, or 0 if unknown.
+      /// \return False if the download was cancelled.
+      public: bool Report(DownloadPhase _phase, uint64_t _current,
+          uint64_t _total) const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<DownloadOptionsPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
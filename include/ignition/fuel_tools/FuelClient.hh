@@ -18,13 +18,19 @@
 #ifndef IGNITION_FUEL_TOOLS_FUELCLIENT_HH_
 #define IGNITION_FUEL_TOOLS_FUELCLIENT_HH_
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
 #include <ignition/common/URI.hh>
 
+#include "ignition/fuel_tools/DownloadOptions.hh"
 #include "ignition/fuel_tools/Helpers.hh"
+#include "ignition/fuel_tools/Lockfile.hh"
+#include "ignition/fuel_tools/Metrics.hh"
 #include "ignition/fuel_tools/ModelIter.hh"
+#include "ignition/fuel_tools/ModelQuery.hh"
 #include "ignition/fuel_tools/RestClient.hh"
 #include "ignition/fuel_tools/Result.hh"
 #include "ignition/fuel_tools/WorldIter.hh"
@@ -65,6 +71,27 @@ namespace ignition
       /// \return Mutable reference to the client configuration.
       public: ClientConfig &Config();
 
+      /// \brief Get the runtime metrics, such as cache hits and misses,
+      /// request latencies and bytes downloaded. Metrics are shared by all
+      /// the clients in the process.
+      /// \return Metrics registry.
+      /// \sa MetricsRegistry::WritePrometheusText
+      public: MetricsRegistry &Metrics() const;
+
+      /// \brief Replace the lockfile used to pin resource versions. The
+      /// lockfile is otherwise loaded from ClientConfig::LockfilePath when
+      /// the client is constructed. Identifiers parsed from URLs without a
+      /// version resolve to the pinned version, and downloads of a pinned
+      /// version are checked against the recorded archive hash. It's safe to
+      /// call while downloads are running.
+      /// \param[in] _lockfile Lockfile, which may be empty to unpin all.
+      public: void SetLockfile(const Lockfile &_lockfile);
+
+      /// \brief Get the lockfile used to pin resource versions.
+      /// \return A copy of the current lockfile, which SetLockfile may
+      /// replace at any time.
+      public: Lockfile CurrentLockfile() const;
+
       /// \brief Fetch the details of a model.
       /// \param[in] _id a partially filled out identifier used to fetch models
       /// \remarks Fulfills Get-One requirement
@@ -73,6 +100,23 @@ namespace ignition
       public: Result ModelDetails(const ModelIdentifier &_id,
                                   ModelIdentifier &_model) const;
 
+      /// \brief Fetch the details of many models at once. Requests are
+      /// issued concurrently. The details are saved in the local cache, and
+      /// read from there instead of the server while they're younger than
+      /// the listing TTL (see ClientConfig::ListingTtl). Under
+      /// ListingPolicy::STALE_WHILE_REVALIDATE, older details are read from
+      /// there too, and refreshed in the background.
+      /// \param[in] _ids Partially filled out identifiers of the models.
+      /// \param[out] _models The requested models, in the same order.
+      /// \param[in] _headers Headers to set on the HTTP requests, such as
+      /// credentials for private models.
+      /// \return Result of each fetch, in the same order. Details read from
+      /// the local cache have the type ResultType::FETCH_ALREADY_EXISTS.
+      public: std::vector<Result> ModelDetails(
+                  const std::vector<ModelIdentifier> &_ids,
+                  std::vector<ModelIdentifier> &_models,
+                  const std::vector<std::string> &_headers = {}) const;
+
       /// \brief Returns an iterator that can return names of models
       /// \remarks Fulfills Get-All requirement
       /// \remarks an iterator instead of a list of names is returned in case
@@ -102,6 +146,20 @@ namespace ignition
       public: Result WorldDetails(const WorldIdentifier &_id,
                                   WorldIdentifier &_world) const;
 
+      /// \brief Fetch the details of many worlds at once.
+      /// \param[in] _ids Partially filled out identifiers of the worlds.
+      /// \param[out] _worlds The requested worlds, in the same order.
+      /// \param[in] _headers Headers to set on the HTTP requests, such as
+      /// credentials for private worlds.
+      /// \return Result of each fetch, in the same order.
+      /// \sa ModelDetails(const std::vector<ModelIdentifier> &,
+      /// std::vector<ModelIdentifier> &,
+      /// const std::vector<std::string> &) const
+      public: std::vector<Result> WorldDetails(
+                  const std::vector<WorldIdentifier> &_ids,
+                  std::vector<WorldIdentifier> &_worlds,
+                  const std::vector<std::string> &_headers = {}) const;
+
       /// \brief Returns an iterator that can return information of worlds
       /// \remarks An iterator instead of a list of names, to be able to
       ///          handle pagination. The iterator may fetch more names if
@@ -128,11 +186,94 @@ namespace ignition
       /// \return An iterator of models with names matching the criteria
       public: ModelIter Models(const ModelIdentifier &_id) const;
 
+      /// \brief Returns the models of a server matching a query. The query
+      /// is sent to the server, so that only matching pages are transferred,
+      /// and the models received are checked against it, so servers which
+      /// ignore part of it still give the right answer. If the server
+      /// rejects the query, the local search index is queried instead.
+      /// \param[in] _server The server to request the operation.
+      /// \param[in] _query Criteria, order and limit.
+      /// \return An iterator of the matching models.
+      /// \sa SearchModels
+      public: ModelIter Models(const ServerConfig &_server,
+                  const ModelQuery &_query) const;
+
+      /// \brief Search the models of a server by keywords and tags, without
+      /// contacting the server. Only models listed before, for example with
+      /// UpdateSearchIndex or Models, or downloaded before, can be found.
+      /// \param[in] _server The server whose models are searched.
+      /// \param[in] _text Keywords, all of which must be a prefix of a word
+      /// in the name, owner, description or tags of a model.
+      /// \param[in] _tags Tags, all of which must match.
+      /// \param[in] _limit Maximum number of results, or 0 for no limit.
+      /// \return An iterator of matching models, most downloaded first.
+      /// \sa LocalCache::SearchModels
+      public: ModelIter SearchModels(const ServerConfig &_server,
+                  const std::string &_text,
+                  const std::vector<std::string> &_tags = {},
+                  size_t _limit = 0) const;
+
+      /// \brief Fetch the list of all the models of a server, and save it
+      /// in the local cache so that SearchModels can find them.
+      /// \param[in] _server The server to request the operation.
+      /// \return Result of the fetch operation.
+      public: Result UpdateSearchIndex(const ServerConfig &_server);
+
       /// \brief Returns worlds matching a given identifying criteria
       /// \param[in] _id A partially filled out identifier used to fetch worlds
       /// \return An iterator of worlds with names matching the criteria
       public: WorldIter Worlds(const WorldIdentifier &_id) const;
 
+      /// \brief Returns the models from all the servers in the client's
+      /// configuration. The servers are contacted concurrently, so this
+      /// takes about as long as the slowest server. Models are ordered by
+      /// server, following the order of the configuration.
+      /// If a server can't be reached, its cached models are returned
+      /// instead.
+      /// \param[in] _owner Only return models belonging to this owner. If
+      /// empty, all models are returned.
+      /// \return A model iterator
+      public: ModelIter ModelsFromAllServers(
+                  const std::string &_owner = "") const;
+
+      /// \brief Returns the worlds from all the servers in the client's
+      /// configuration. The servers are contacted concurrently.
+      /// If a server can't be reached, its cached worlds are returned
+      /// instead.
+      /// \param[in] _owner Only return worlds belonging to this owner. If
+      /// empty, all worlds are returned.
+      /// \return A world iterator
+      /// \sa ModelsFromAllServers
+      public: WorldIter WorldsFromAllServers(
+                  const std::string &_owner = "") const;
+
+      /// \brief Request models from a server one page at a time, passing
+      /// each page to a callback as soon as it arrives. Unlike Models(),
+      /// the full list is never held in memory and the local cache is not
+      /// consulted.
+      /// \param[in] _id Identifier with the server to request from, and
+      /// optionally the owner to filter by.
+      /// \param[in] _callback Function called with each page of models.
+      /// Return false to stop requesting more pages.
+      /// \return FETCH if at least one page was received, FETCH_ERROR
+      /// otherwise.
+      public: Result StreamModels(const ModelIdentifier &_id,
+          const std::function<bool(const std::vector<ModelIdentifier> &)>
+          &_callback) const;
+
+      /// \brief Request worlds from a server one page at a time, passing
+      /// each page to a callback as soon as it arrives.
+      /// \param[in] _id Identifier with the server to request from, and
+      /// optionally the owner to filter by.
+      /// \param[in] _callback Function called with each page of worlds.
+      /// Return false to stop requesting more pages.
+      /// \return FETCH if at least one page was received, FETCH_ERROR
+      /// otherwise.
+      /// \sa StreamModels
+      public: Result StreamWorlds(const WorldIdentifier &_id,
+          const std::function<bool(const std::vector<WorldIdentifier> &)>
+          &_callback) const;
+
       /// \brief Upload a directory as a new model
       /// \param[in] _pathToModelDir a path to a directory containing a model
       /// \param[in] _id An identifier to assign to this new model
@@ -173,12 +314,77 @@ namespace ignition
       public: Result DownloadModel(const ModelIdentifier &_id,
                   const std::vector<std::string> &_headers);
 
+      /// \brief Download a model from ignition fuel, reporting progress and
+      /// allowing cancellation. This will override an existing local copy
+      /// of the model. The download runs on the calling thread, regardless
+      /// of the concurrency limits: if the same model was queued, it's taken
+      /// out of its queue, and if it's already being downloaded with the
+      /// same headers, it's waited for. Either way, progress is reported to
+      /// the callback of _options, cancelling its token returns right away,
+      /// and the download itself is only cancelled once everyone waiting
+      /// for it has cancelled.
+      /// \param[in] _id The model identifier.
+      /// \param[in] _options Headers, progress callback and cancellation
+      /// token.
+      /// \return Result of the download operation, FETCH_CANCELLED if it was
+      /// cancelled.
+      /// \sa QueueDownloadModel
+      public: Result DownloadModel(const ModelIdentifier &_id,
+                  const DownloadOptions &_options);
+
+      /// \brief Queue a model download without waiting for it, such as to
+      /// prefetch the assets of a scenario. Each priority class has its own
+      /// workers and concurrency limit, so background downloads never delay
+      /// foreground ones. A model already queued or being downloaded with the
+      /// same headers is not downloaded twice, but progress is still
+      /// reported to the callback of _options, and the download is only
+      /// cancelled once everyone waiting for it has cancelled.
+      /// \param[in] _id The model identifier.
+      /// \param[in] _priority Priority class.
+      /// \param[in] _options Headers, progress callback and cancellation
+      /// token. They're copied, and the callback is called from a worker
+      /// thread.
+      /// \return Result of the download, available once it finishes. Queued
+      /// downloads still pending when the client is destroyed finish with
+      /// FETCH_CANCELLED.
+      public: std::shared_future<Result> QueueDownloadModel(
+                  const ModelIdentifier &_id,
+                  DownloadPriority _priority = DownloadPriority::BACKGROUND,
+                  const DownloadOptions &_options = DownloadOptions());
+
+      /// \brief Set the maximum number of concurrent model downloads of a
+      /// priority class, queued with QueueDownloadModel. The defaults are 8
+      /// in the foreground and 2 in the background. Blocking DownloadModel
+      /// calls run on their own thread and aren't limited.
+      /// \param[in] _priority Priority class.
+      /// \param[in] _jobs Maximum number of downloads, at least 1.
+      public: void SetDownloadConcurrency(DownloadPriority _priority,
+                  unsigned int _jobs);
+
+      /// \brief Get the maximum number of concurrent model downloads of a
+      /// priority class.
+      /// \param[in] _priority Priority class.
+      /// \return Maximum number of downloads.
+      public: unsigned int DownloadConcurrency(
+                  DownloadPriority _priority) const;
+
       /// \brief Download a world from Ignition Fuel. This will override an
       /// existing local copy of the world.
       /// \param[out] _id The world identifier, with local path updated.
       /// \return Result of the download operation
       public: Result DownloadWorld(WorldIdentifier &_id);
 
+      /// \brief Download a world from Ignition Fuel, reporting progress and
+      /// allowing cancellation. This will override an existing local copy
+      /// of the world.
+      /// \param[out] _id The world identifier, with local path updated.
+      /// \param[in] _options Headers, progress callback and cancellation
+      /// token.
+      /// \return Result of the download operation, FETCH_CANCELLED if it was
+      /// cancelled.
+      public: Result DownloadWorld(WorldIdentifier &_id,
+                  const DownloadOptions &_options);
+
       /// \brief Download a model from ignition fuel. This will override an
       /// existing local copy of the model.
       /// \param[in] _modelUrl The unique URL of the model to download.
@@ -188,6 +394,17 @@ namespace ignition
       public: Result DownloadModel(const common::URI &_modelUrl,
                                    std::string &_path);
 
+      /// \brief Download a model from ignition fuel, reporting progress and
+      /// allowing cancellation.
+      /// \param[in] _modelUrl The unique URL of the model to download.
+      /// \param[out] _path Path where the model was downloaded.
+      /// \param[in] _options Headers, progress callback and cancellation
+      /// token.
+      /// \return Result of the download operation.
+      public: Result DownloadModel(const common::URI &_modelUrl,
+                                   std::string &_path,
+                                   const DownloadOptions &_options);
+
       /// \brief Download a world from ignition fuel. This will override an
       /// existing local copy of the world.
       /// \param[in] _worldUrl The unique URL of the world to download.
@@ -197,6 +414,32 @@ namespace ignition
       public: Result DownloadWorld(const common::URI &_worldUrl,
                                    std::string &_path);
 
+      /// \brief Download a world from ignition fuel, reporting progress and
+      /// allowing cancellation.
+      /// \param[in] _worldUrl The unique URL of the world to download.
+      /// \param[out] _path Path where the world was downloaded.
+      /// \param[in] _options Headers, progress callback and cancellation
+      /// token.
+      /// \return Result of the download operation.
+      public: Result DownloadWorld(const common::URI &_worldUrl,
+                                   std::string &_path,
+                                   const DownloadOptions &_options);
+
+      /// \brief Download a single file of a model, without the rest of the
+      /// model. The file is saved into a partial cache entry, which is
+      /// completed once the whole model is downloaded.
+      /// \param[in] _fileUrl The unique URL of the file on a Fuel server.
+      /// E.g.: https://server.org/1.0/owner/models/model/1/files/mesh.dae
+      /// \param[out] _path Local path where the file was saved.
+      /// \param[in] _headers Headers to set on the HTTP requests, including
+      /// the one resolving the latest version of the model.
+      /// \return Result of the download operation.
+      /// \sa LocalCache::SaveModelFile
+      public: Result DownloadModelFile(const common::URI &_fileUrl,
+                                       std::string &_path,
+                                       const std::vector<std::string>
+                                       &_headers = {});
+
       /// \brief Check if a model is already present in the local cache.
       /// \param[in] _modelUrl The unique URL of the model on a Fuel server.
       /// E.g.: https://fuel.ignitionrobotics.org/1.0/caguero/models/Beer
@@ -229,6 +472,7 @@ namespace ignition
       /// local cache.
       /// \param[in] _fileUrl The unique URL of the file on a Fuel server. E.g.:
       /// https://server.org/1.0/owner/models/model/files/meshes/mesh.dae
+      /// Files saved by DownloadModelFile are also found.
       /// \param[out] _path Local path where the file can be found.
       /// \return FETCH_ERROR if not cached, FETCH_ALREADY_EXISTS if cached.
       public: Result CachedModelFile(const common::URI &_fileUrl,
@@ -16,6 +16,7 @@
 */
 
 #include <string>
+#include <vector>
 #include "ignition/fuel_tools/Export.hh"
 #include "ignition/fuel_tools/FuelClient.hh"
 
@@ -25,6 +26,9 @@ namespace ignition
   {
     /// \brief Download the specified resource into the default configuration of
     /// fuel tools. This will place the asset in ~/.ignition/fuel.
+    /// A single client is shared by all the calls in the process. It's
+    /// created on the first call, so later changes to the environment, such
+    /// as IGN_FUEL_CACHE_PATH, are not taken into account.
     /// \param[in] _uri URI to the asset.
     /// \return Path to the downloaded asset. Empty on error.
     IGNITION_FUEL_TOOLS_VISIBLE std::string fetchResource(
@@ -37,5 +41,25 @@ namespace ignition
     /// \return Path to the downloaded asset. Empty on error.
     IGNITION_FUEL_TOOLS_VISIBLE std::string fetchResourceWithClient(
         const std::string &_uri, ignition::fuel_tools::FuelClient &_client);
+
+    /// \brief Download several resources in parallel, using the same client
+    /// as fetchResource. Each model or world is downloaded only once, even
+    /// if several URIs, such as URIs of its files, refer to it.
+    /// \param[in] _uris URIs to the assets.
+    /// \return Paths to the downloaded assets, in the same order as _uris.
+    /// Empty on error.
+    IGNITION_FUEL_TOOLS_VISIBLE std::vector<std::string> fetchResources(
+        const std::vector<std::string> &_uris);
+
+    /// \brief Download several resources in parallel, using the ClientConfig
+    /// contained in the FuelClient parameter.
+    /// \param[in] _uris URIs to the assets.
+    /// \param[in] _client Custom FuelClient configuration.
+    /// \return Paths to the downloaded assets, in the same order as _uris.
+    /// Empty on error.
+    /// \sa fetchResources
+    IGNITION_FUEL_TOOLS_VISIBLE std::vector<std::string>
+        fetchResourcesWithClient(const std::vector<std::string> &_uris,
+        ignition::fuel_tools::FuelClient &_client);
   }
 }
@@ -18,6 +18,7 @@
 #ifndef IGNITION_FUEL_TOOLS_JSONPARSER_HH_
 #define IGNITION_FUEL_TOOLS_JSONPARSER_HH_
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -81,11 +82,35 @@ namespace ignition
       /// \return A JSON string representing a single model
       public: static std::string BuildModel(ModelIter _modelIt);
 
+      /// \brief Build a JSON array of models, in the format returned by the
+      /// server, so that it can be read back with ParseModels.
+      /// \param[in] _ids Models to serialize.
+      /// \return A JSON string representing an array of models.
+      public: static std::string BuildModels(
+                  const std::vector<ModelIdentifier> &_ids);
+
+      /// \brief Build a JSON array of worlds, in the format returned by the
+      /// server, so that it can be read back with ParseWorlds.
+      /// \param[in] _ids Worlds to serialize.
+      /// \return A JSON string representing an array of worlds.
+      public: static std::string BuildWorlds(
+                  const std::vector<WorldIdentifier> &_ids);
+
       /// \brief Build a world iterator from a JSON string
       /// \param[in] _worldIt A world iterator containing only one world
       /// \return A JSON string representing a single world
       public: static std::string BuildWorld(WorldIter _worldIt);
 
+      /// \brief Parse the file tree of a resource version, as returned by
+      /// the server's "files" route.
+      /// \param[in] _json JSON string containing a "file_tree" array.
+      /// \param[out] _files Content hash of each file, by path relative to
+      /// the resource, such as "meshes/mesh.dae". The hash is empty if the
+      /// server doesn't provide one.
+      /// \return True if the file tree was parsed.
+      public: static bool ParseFileTree(const std::string &_json,
+                  std::map<std::string, std::string> &_files);
+
       /// \brief Parse a json object as a model.
       /// \param[in] _json JSON object containing a single model
       /// \param[out] _model a model identifier after parsing the JSON
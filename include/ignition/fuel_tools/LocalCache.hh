@@ -18,8 +18,14 @@
 #ifndef IGNITION_FUEL_TOOLS_LOCALCACHE_HH_
 #define IGNITION_FUEL_TOOLS_LOCALCACHE_HH_
 
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "ignition/fuel_tools/Helpers.hh"
 #include "ignition/fuel_tools/Model.hh"
@@ -31,9 +37,165 @@ namespace ignition
   namespace fuel_tools
   {
     /// \brief Forward declaration
+    class CatalogSnapshot;
     class ClientConfig;
+    class DownloadOptions;
     class LocalCachePrivate;
     class ModelIdentifier;
+    class ServerConfig;
+    class WorldIdentifier;
+
+    /// \brief A single version of a model or world in the local cache.
+    struct IGNITION_FUEL_TOOLS_VISIBLE CacheEntry
+    {
+      /// \brief Server directory, such as "fuel.ignitionrobotics.org".
+      public: std::string server;
+
+      /// \brief Owner name.
+      public: std::string owner;
+
+      /// \brief Resource type, either "models" or "worlds".
+      public: std::string type;
+
+      /// \brief Resource name.
+      public: std::string name;
+
+      /// \brief Resource version.
+      public: unsigned int version = 0;
+
+      /// \brief Path to the versioned directory on disk.
+      public: std::string path;
+
+      /// \brief Size of all the files in the entry, in bytes.
+      public: uint64_t bytes = 0;
+
+      /// \brief Number of files in the entry.
+      public: uint64_t files = 0;
+
+      /// \brief Most recent access or modification time of any file in the
+      /// entry.
+      public: std::time_t lastUsed = 0;
+
+      /// \brief True if only some files of the resource were fetched.
+      /// \sa LocalCache::SaveModelFile
+      public: bool partial = false;
+    };
+
+    /// \brief Summary of the contents of the local cache.
+    struct IGNITION_FUEL_TOOLS_VISIBLE CacheStats
+    {
+      /// \brief Number of model versions.
+      public: uint64_t models = 0;
+
+      /// \brief Number of world versions.
+      public: uint64_t worlds = 0;
+
+      /// \brief Number of files.
+      public: uint64_t files = 0;
+
+      /// \brief Total size in bytes.
+      public: uint64_t bytes = 0;
+
+      /// \brief Bytes used by each server directory.
+      public: std::map<std::string, uint64_t> bytesPerServer;
+
+      /// \brief Bytes used by each owner, keyed by "server/owner".
+      public: std::map<std::string, uint64_t> bytesPerOwner;
+
+      /// \brief Largest entries, in decreasing order of size.
+      public: std::vector<CacheEntry> largest;
+
+      /// \brief Bytes used by files whose content is identical to another
+      /// file in the cache, not counting the first copy.
+      public: uint64_t duplicateBytes = 0;
+    };
+
+    /// \brief Criteria used to remove entries from the local cache. Criteria
+    /// set to zero are disabled.
+    struct IGNITION_FUEL_TOOLS_VISIBLE CachePruneOptions
+    {
+      /// \brief Remove entries which haven't been used for longer than this.
+      public: std::chrono::seconds maxAge{0};
+
+      /// \brief Remove the least recently used entries until the cache is
+      /// smaller than this, in bytes.
+      public: uint64_t maxBytes = 0;
+
+      /// \brief Keep only this many of the most recent versions of each
+      /// resource.
+      public: unsigned int keepVersions = 0;
+
+      /// \brief Only report which entries would be removed.
+      public: bool dryRun = false;
+    };
+
+    /// \brief A problem found while verifying the local cache.
+    struct IGNITION_FUEL_TOOLS_VISIBLE CacheIssue
+    {
+      /// \brief Path to the entry, or to the file, with a problem.
+      public: std::string path;
+
+      /// \brief Description of the problem.
+      public: std::string reason;
+    };
+
+    /// \brief Lookups served by each tier of the cache.
+    /// \sa ClientConfig::SetHotCacheLocation
+    struct IGNITION_FUEL_TOOLS_VISIBLE CacheTierStats
+    {
+      /// \brief Lookups served from the hot tier.
+      public: uint64_t hotHits = 0;
+
+      /// \brief Lookups served from the cache directory.
+      public: uint64_t coldHits = 0;
+
+      /// \brief Versions copied to the hot tier.
+      public: uint64_t promotions = 0;
+
+      /// \brief Versions removed from the hot tier to make room.
+      public: uint64_t demotions = 0;
+
+      /// \brief Number of versions in the hot tier.
+      public: uint64_t hotEntries = 0;
+
+      /// \brief Size of the versions in the hot tier, in bytes.
+      public: uint64_t hotBytes = 0;
+
+      /// \brief Size of the retired copies which may still be in use, and
+      /// count against the capacity of the hot tier until removed, in
+      /// bytes.
+      public: uint64_t retiredBytes = 0;
+    };
+
+    /// \brief Kind of change to the local cache.
+    enum class CacheEventType
+    {
+      /// \brief A model or world version was added.
+      INSTALLED,
+
+      /// \brief A model or world version which was already in the cache was
+      /// saved again, overwriting it.
+      UPDATED,
+
+      /// \brief A model or world version was removed.
+      REMOVED,
+    };
+
+    /// \brief A change to the local cache.
+    /// \sa LocalCache::Subscribe
+    struct IGNITION_FUEL_TOOLS_VISIBLE CacheEvent
+    {
+      /// \brief Kind of change.
+      public: CacheEventType type = CacheEventType::INSTALLED;
+
+      /// \brief Version which changed. Only the server, owner, type, name,
+      /// version and path are set.
+      public: CacheEntry entry;
+
+      /// \brief True if the change was made by another process, and was
+      /// noticed by watching the cache directory.
+      public: bool external = false;
+    };
 
     /// \brief Class for managing stuff in the local cache
     class IGNITION_FUEL_TOOLS_VISIBLE LocalCache
@@ -63,6 +225,22 @@ namespace ignition
       /// \return A world which matches all of _id's parameters.
       public: virtual bool MatchingWorld(WorldIdentifier &_id) const;
 
+      /// \brief Same as MatchingModel, but the model is always located in
+      /// the cache directory, and the lookup isn't counted by the hot tier.
+      /// Meant for reading or linking the files of a version, rather than
+      /// handing out its path.
+      /// \param[in] _id An id with ServerUrl, Owner, and Name all set
+      /// \return A model which matches all of _id's parameters.
+      /// \sa TierStats
+      public: Model MatchingColdModel(const ModelIdentifier &_id);
+
+      /// \brief Same as MatchingWorld, but the world is always located in
+      /// the cache directory, and the lookup isn't counted by the hot tier.
+      /// \param[in] _id An id with ServerUrl, Owner, and Name all set
+      /// \return True if a world matches all of _id's parameters.
+      /// \sa TierStats
+      public: bool MatchingColdWorld(WorldIdentifier &_id) const;
+
       /// \brief Get all models partially matching an ID
       /// \param[in] _id An id with at least one of ServerURL, Owner, and Name
       /// \return An iterator with all models that match all fields that are
@@ -87,6 +265,155 @@ namespace ignition
           const std::string &_data,
           const bool _overwrite);
 
+      /// \brief Add a model from packed data to the local cache, reporting
+      /// progress of the extract and fix paths phases.
+      /// \param[in] _id A completely populated ID
+      /// \param[in] _data Compressed content of the model
+      /// \param[in] _overwrite Overwrite model if already exists.
+      /// \param[in] _options Progress callback and cancellation token. A
+      /// cancelled save removes the files it created.
+      /// \returns True if the model was successfully added to the local cache.
+      public: bool SaveModel(
+          const ModelIdentifier &_id,
+          const std::string &_data,
+          const bool _overwrite,
+          const DownloadOptions &_options);
+
+      /// \brief Get the hash of the archive a model or world version was
+      /// extracted from, as recorded by SaveModel and SaveWorld.
+      /// \param[in] _versionedDir Versioned directory of the resource.
+      /// \return Hash, such as "fnv1a64:0123456789abcdef", or empty if it
+      /// wasn't recorded, such as for partial models and versions saved
+      /// with SaveModelDelta.
+      /// \sa Lockfile::Hash
+      public: std::string ArchiveHash(const std::string &_versionedDir) const;
+
+      /// \brief Add a new version of a model to the local cache, assembled
+      /// from a cached previous version and the files which changed. The
+      /// new version is staged next to its final directory and moved into
+      /// place once complete.
+      /// \param[in] _id A completely populated ID of the new version.
+      /// \param[in] _previousDir Versioned directory of the previous version.
+      /// \param[in] _unchanged Paths of the files, relative to the model
+      /// directory, which are hardlinked, or copied, from the previous
+      /// version. Files rewritten when saving a model, such as its SDF file,
+      /// must not be among them.
+      /// \param[in] _changed Content of the other files, by relative path.
+      /// \param[in] _fileTree The server's file tree of the new version.
+      /// \return True if the model was added. Paths which aren't relative
+      /// or have empty, "." or ".." segments, or backslashes, are rejected.
+      /// \sa FileTree
+      public: bool SaveModelDelta(const ModelIdentifier &_id,
+          const std::string &_previousDir,
+          const std::vector<std::string> &_unchanged,
+          const std::map<std::string, std::string> &_changed,
+          const std::string &_fileTree);
+
+      /// \brief Record the server's file tree of a cached model version, so
+      /// that later versions can be saved with SaveModelDelta.
+      /// \param[in] _id A completely populated ID.
+      /// \param[in] _fileTree File tree JSON, as returned by the server.
+      /// \return True if the file tree was recorded.
+      public: bool SaveFileTree(const ModelIdentifier &_id,
+          const std::string &_fileTree);
+
+      /// \brief Get the file tree recorded with SaveFileTree.
+      /// \param[in] _versionedDir Versioned directory of the model.
+      /// \return File tree JSON, or empty if it wasn't recorded.
+      public: std::string FileTree(const std::string &_versionedDir) const;
+
+      /// \brief Save a listing of models received from a server, so it can
+      /// be served without contacting the server.
+      /// \param[in] _server Server the listing comes from.
+      /// \param[in] _route Route of the listing, such as "alice/models".
+      /// \param[in] _ids Models in the listing.
+      /// \return True if the listing was saved.
+      /// \sa ListingPolicy
+      /// \sa ModelSnapshot, written for the "models" route
+      public: bool SaveModelListing(const ServerConfig &_server,
+          const std::string &_route,
+          const std::vector<ModelIdentifier> &_ids);
+
+      /// \brief Get a listing saved with SaveModelListing.
+      /// \param[in] _server Server the listing comes from.
+      /// \param[in] _route Route of the listing.
+      /// \param[out] _ids Models in the listing.
+      /// \param[out] _saved When the listing was saved.
+      /// \return True if the listing was found.
+      public: bool ModelListing(const ServerConfig &_server,
+          const std::string &_route, std::vector<ModelIdentifier> &_ids,
+          std::chrono::system_clock::time_point &_saved) const;
+
+      /// \brief Open the snapshot of a server's catalog, written by
+      /// SaveModelListing for the "models" route.
+      /// \param[in] _server Server of the catalog.
+      /// \return The snapshot, or null if there's no valid snapshot.
+      public: std::shared_ptr<const CatalogSnapshot> ModelSnapshot(
+          const ServerConfig &_server) const;
+
+      /// \brief Search the models of a server known to this cache, without
+      /// contacting the server. These are the models in listings saved with
+      /// SaveModelListing, and the downloaded models, which can only be
+      /// matched by name and owner.
+      ///
+      /// The search index of a server is built on the first search, and
+      /// kept up to date as listings are saved.
+      /// \param[in] _server Server of the models.
+      /// \param[in] _text Keywords, all of which must match.
+      /// \param[in] _tags Tags, all of which must match.
+      /// \param[in] _limit Maximum number of results, or 0 for no limit.
+      /// \return Matching models, most downloaded first.
+      /// \sa SearchIndex
+      public: std::vector<ModelIdentifier> SearchModels(
+          const ServerConfig &_server, const std::string &_text,
+          const std::vector<std::string> &_tags = {},
+          size_t _limit = 0) const;
+
+      /// \brief Save a listing of worlds received from a server.
+      /// \param[in] _server Server the listing comes from.
+      /// \param[in] _route Route of the listing, such as "alice/worlds".
+      /// \param[in] _ids Worlds in the listing.
+      /// \return True if the listing was saved.
+      /// \sa SaveModelListing
+      public: bool SaveWorldListing(const ServerConfig &_server,
+          const std::string &_route,
+          const std::vector<WorldIdentifier> &_ids);
+
+      /// \brief Get a listing saved with SaveWorldListing.
+      /// \param[in] _server Server the listing comes from.
+      /// \param[in] _route Route of the listing.
+      /// \param[out] _ids Worlds in the listing.
+      /// \param[out] _saved When the listing was saved.
+      /// \return True if the listing was found.
+      public: bool WorldListing(const ServerConfig &_server,
+          const std::string &_route, std::vector<WorldIdentifier> &_ids,
+          std::chrono::system_clock::time_point &_saved) const;
+
+      /// \brief Add a single file of a model to the local cache, without the
+      /// rest of the model. Unless the model version is already fully cached,
+      /// its directory is marked as partial. Partial models are not returned
+      /// by AllModels, MatchingModel or MatchingModels until the whole model
+      /// is saved with SaveModel.
+      /// \param[in] _id A completely populated ID
+      /// \param[in] _filePath Path of the file relative to the model
+      /// directory. E.g.: "meshes/bus.obj"
+      /// \param[in] _data Content of the file
+      /// \returns True if the file was saved.
+      public: bool SaveModelFile(
+          const ModelIdentifier &_id,
+          const std::string &_filePath,
+          const std::string &_data);
+
+      /// \brief Find a file saved with SaveModelFile.
+      /// \param[in] _id Model ID. If the version is not set, the highest
+      /// partial version containing the file is used.
+      /// \param[in] _filePath Path of the file relative to the model
+      /// directory.
+      /// \return Path to the file on disk, or empty if not found.
+      public: std::string MatchingPartialModelFile(
+          const ModelIdentifier &_id,
+          const std::string &_filePath) const;
+
       /// \brief Add a world from packed data to the local cache
       /// \param[out] _id A completely populated ID
       /// \param[in] _data Compressed content of the world
@@ -97,6 +424,110 @@ namespace ignition
           const std::string &_data,
           const bool _overwrite);
 
+      /// \brief Add a world from packed data to the local cache, reporting
+      /// progress of the extract phase.
+      /// \param[out] _id A completely populated ID
+      /// \param[in] _data Compressed content of the world
+      /// \param[in] _overwrite Overwrite world if already exists.
+      /// \param[in] _options Progress callback and cancellation token. A
+      /// cancelled save removes the files it created.
+      /// \returns True if the world was successfully added to the local cache
+      public: bool SaveWorld(
+          WorldIdentifier &_id,
+          const std::string &_data,
+          const bool _overwrite,
+          const DownloadOptions &_options);
+
+      /// \brief Get every model and world version found in the cache
+      /// directory, including the ones from servers which are not in the
+      /// client configuration. Directories are scanned in parallel.
+      /// \param[in] _jobs Maximum number of threads. Zero uses one thread per
+      /// core.
+      /// \return All the entries, sorted by path.
+      public: std::vector<CacheEntry> Entries(unsigned int _jobs = 0) const;
+
+      /// \brief Summarize the contents of the cache.
+      /// \param[in] _entries Entries to summarize, as returned by Entries().
+      /// \param[in] _largest Number of largest entries to report.
+      /// \param[in] _jobs Maximum number of threads. Zero uses one thread per
+      /// core.
+      /// \return Cache statistics.
+      public: CacheStats Stats(const std::vector<CacheEntry> &_entries,
+          size_t _largest = 10, unsigned int _jobs = 0) const;
+
+      /// \brief Remove entries from the cache.
+      /// \param[in] _entries Candidate entries, as returned by Entries().
+      /// \param[in] _options Criteria for removal.
+      /// \param[in] _jobs Maximum number of threads. Zero uses one thread per
+      /// core.
+      /// \return Entries which were removed, or which would be removed on a
+      /// dry run.
+      public: std::vector<CacheEntry> Prune(
+          const std::vector<CacheEntry> &_entries,
+          const CachePruneOptions &_options, unsigned int _jobs = 0);
+
+      /// \brief Check the integrity of entries. Every file is read, model
+      /// configuration and SDF files are parsed, and leftovers of interrupted
+      /// downloads are reported.
+      /// \param[in] _entries Entries to verify, as returned by Entries().
+      /// \param[in] _jobs Maximum number of threads. Zero uses one thread per
+      /// core.
+      /// \return Problems found. Empty if all entries are valid.
+      public: std::vector<CacheIssue> Verify(
+          const std::vector<CacheEntry> &_entries,
+          unsigned int _jobs = 0) const;
+
+      /// \brief Read every file of the given entries, so that they're in the
+      /// operating system's page cache when a simulator loads them.
+      /// \param[in] _entries Entries to read, as returned by Entries().
+      /// \param[in] _jobs Maximum number of threads. Zero uses one thread per
+      /// core.
+      /// \return Number of bytes read.
+      public: uint64_t Warm(const std::vector<CacheEntry> &_entries,
+          unsigned int _jobs = 0) const;
+
+      /// \brief Function called with each change to the cache.
+      public: using EventCallback = std::function<void(const CacheEvent &)>;
+
+      /// \brief Be notified of models and worlds installed, updated or
+      /// removed. Changes made through this cache, and its copies, are
+      /// reported by the thread which makes them, once complete. On Linux,
+      /// changes made by other processes, or other LocalCache instances, are
+      /// reported from a thread watching the cache directory with inotify,
+      /// which starts with the first subscription. The directory is never
+      /// scanned periodically.
+      /// \param[in] _callback Function to call with each change.
+      /// \return Subscription id, to pass to Unsubscribe.
+      public: uint64_t Subscribe(const EventCallback &_callback);
+
+      /// \brief Stop being notified of changes. A change which is being
+      /// reported from the watching thread may still reach the callback.
+      /// \param[in] _id Subscription id returned by Subscribe.
+      /// \return True if the subscription existed.
+      public: bool Unsubscribe(uint64_t _id);
+
+      /// \brief True if changes made by other processes are reported, which
+      /// requires a subscription or a hot tier, and support from the
+      /// operating system.
+      /// \return True if the cache directory is being watched.
+      public: bool Watching() const;
+
+      /// \brief Get the statistics of the hot tier, which holds copies of
+      /// the most looked up models and worlds when a hot cache location is
+      /// configured. MatchingModel and MatchingWorld count lookups, and
+      /// return the copy in the hot tier when there's one, without looking
+      /// through the cache directory for versioned lookups. Copies are made
+      /// and retired in the background, and a copy returned is never removed
+      /// while this process runs.
+      /// \return Statistics since the first lookup. All zero without a hot
+      /// tier.
+      /// \sa ClientConfig::SetHotCacheLocation
+      public: CacheTierStats TierStats() const;
+
+      /// \brief Wait until the copies to and removals from the hot tier
+      /// which are queued are done.
+      public: void WaitForTiers() const;
+
       /// \brief Internal data.
       private: std::shared_ptr<LocalCachePrivate> dataPtr;
     };
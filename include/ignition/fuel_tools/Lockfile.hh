@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_LOCKFILE_HH_
+#define IGNITION_FUEL_TOOLS_LOCKFILE_HH_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/Export.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class LockfilePrivate;
+
+    /// \brief A resource pinned by a lockfile.
+    struct IGNITION_FUEL_TOOLS_VISIBLE LockEntry
+    {
+      /// \brief URL which was resolved, such as
+      /// "https://fuel.ignitionrobotics.org/1.0/openrobotics/models/Ambulance".
+      public: std::string url;
+
+      /// \brief Server URL, such as "https://fuel.ignitionrobotics.org".
+      public: std::string server;
+
+      /// \brief Owner name.
+      public: std::string owner;
+
+      /// \brief Resource type, either "models" or "worlds".
+      public: std::string type;
+
+      /// \brief Resource name.
+      public: std::string name;
+
+      /// \brief Resolved version.
+      public: unsigned int version = 0;
+
+      /// \brief Hash of the resource archive, such as
+      /// "fnv1a64:0123456789abcdef". Empty if unknown.
+      /// \sa Lockfile::Hash
+      public: std::string hash;
+    };
+
+    /// \brief Pins resources to exact versions, so that URLs without a
+    /// version, or with "tip", always resolve to the same content. A client
+    /// using a lockfile resolves such URLs to cached paths without asking
+    /// the server for the latest version, and rejects downloaded archives
+    /// whose hash doesn't match.
+    ///
+    /// Lockfiles are JSON files, usually generated with 'ign fuel lock'.
+    /// \sa FuelClient::SetLockfile
+    class IGNITION_FUEL_TOOLS_VISIBLE Lockfile
+    {
+      /// \brief Constructor.
+      public: Lockfile();
+
+      /// \brief Copy constructor.
+      /// \param[in] _orig The lockfile to copy.
+      public: Lockfile(const Lockfile &_orig);
+
+      /// \brief Assignment operator overload.
+      /// \param[in] _orig The lockfile to copy.
+      /// \return Reference to this object.
+      public: Lockfile &operator=(const Lockfile &_orig);
+
+      /// \brief Destructor.
+      public: ~Lockfile();
+
+      /// \brief Load a lockfile, replacing the current entries.
+      /// \param[in] _path Path to the lockfile.
+      /// \return True if the file was read and parsed.
+      public: bool Load(const std::string &_path);
+
+      /// \brief Save the entries. The file is replaced atomically.
+      /// \param[in] _path Path to the lockfile.
+      /// \return True if the file was written.
+      public: bool Save(const std::string &_path) const;
+
+      /// \brief Add an entry, replacing any entry of the same resource.
+      /// \param[in] _entry Entry to add.
+      public: void Set(const LockEntry &_entry);
+
+      /// \brief Find the entry of a resource.
+      /// \param[in] _server Server URL, such as
+      /// "https://fuel.ignitionrobotics.org".
+      /// \param[in] _owner Owner name.
+      /// \param[in] _type Resource type, either "models" or "worlds".
+      /// \param[in] _name Resource name.
+      /// \param[out] _entry The entry, if found.
+      /// \return True if the resource is pinned.
+      public: bool Find(const std::string &_server, const std::string &_owner,
+          const std::string &_type, const std::string &_name,
+          LockEntry &_entry) const;
+
+      /// \brief Get all the entries.
+      /// \return Entries, sorted by server, owner, type and name.
+      public: std::vector<LockEntry> Entries() const;
+
+      /// \brief Number of entries.
+      /// \return Number of pinned resources.
+      public: size_t Size() const;
+
+      /// \brief Hash the content of a resource archive, as stored in
+      /// LockEntry::hash.
+      /// \param[in] _data Archive content.
+      /// \return Hash, such as "fnv1a64:0123456789abcdef".
+      public: static std::string Hash(const std::string &_data);
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<LockfilePrivate> dataPtr;
+    };
+  }
+}
+
+#endif
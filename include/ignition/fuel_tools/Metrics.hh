@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_METRICS_HH_
+#define IGNITION_FUEL_TOOLS_METRICS_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/Export.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class MetricsRegistryPrivate;
+
+    /// \brief Labels of a metric, such as {{"server", "https://..."}}.
+    using MetricLabels = std::map<std::string, std::string>;
+
+    /// \brief A monotonically increasing counter. Lock-free.
+    class IGNITION_FUEL_TOOLS_VISIBLE MetricCounter
+    {
+      /// \brief Increase the counter.
+      /// \param[in] _value Amount to add.
+      public: void Increment(uint64_t _value = 1);
+
+      /// \brief Get the counter value.
+      /// \return Current value.
+      public: uint64_t Value() const;
+
+      /// \brief Counter value.
+      private: std::atomic<uint64_t> value{0};
+    };
+
+    /// \brief A value which goes up and down, such as the number of
+    /// transfers in flight. Lock-free.
+    class IGNITION_FUEL_TOOLS_VISIBLE MetricGauge
+    {
+      /// \brief Add to the gauge.
+      /// \param[in] _value Amount to add, which may be negative.
+      public: void Add(int64_t _value);
+
+      /// \brief Set the gauge.
+      /// \param[in] _value New value.
+      public: void Set(int64_t _value);
+
+      /// \brief Get the gauge value.
+      /// \return Current value.
+      public: int64_t Value() const;
+
+      /// \brief Gauge value.
+      private: std::atomic<int64_t> value{0};
+    };
+
+    /// \brief A distribution of observations, such as durations, counted in
+    /// fixed buckets. Lock-free.
+    class IGNITION_FUEL_TOOLS_VISIBLE MetricHistogram
+    {
+      /// \brief Constructor.
+      /// \param[in] _bounds Upper bounds of the buckets, in ascending order.
+      /// An implicit last bucket holds larger observations.
+      public: explicit MetricHistogram(const std::vector<double> &_bounds);
+
+      /// \brief Record an observation.
+      /// \param[in] _value Observed value, such as seconds.
+      public: void Observe(double _value);
+
+      /// \brief Get the upper bounds of the buckets.
+      /// \return Bounds, without the implicit last bucket.
+      public: const std::vector<double> &Bounds() const;
+
+      /// \brief Get the number of observations of a bucket.
+      /// \param[in] _index Bucket index. Bounds().size() is the implicit
+      /// last bucket.
+      /// \return Observations which fell into this bucket, not including
+      /// those of smaller buckets.
+      public: uint64_t BucketCount(size_t _index) const;
+
+      /// \brief Get the number of observations.
+      /// \return Number of observations.
+      public: uint64_t Count() const;
+
+      /// \brief Get the sum of all observations.
+      /// \return Sum of all observations.
+      public: double Sum() const;
+
+      /// \brief Upper bounds of the buckets.
+      private: std::vector<double> bounds;
+
+      /// \brief Observations per bucket, including the implicit last one.
+      private: std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+
+      /// \brief Number of observations.
+      private: std::atomic<uint64_t> count{0};
+
+      /// \brief Sum of all observations.
+      private: std::atomic<double> sum{0.0};
+    };
+
+    /// \brief Registry of the client metrics, such as cache hits, bytes
+    /// downloaded and request latencies. Metrics are created on first use
+    /// and live as long as the registry, so callers can keep references to
+    /// them and update them without locking.
+    ///
+    /// The metrics can be exported in the Prometheus text format, for
+    /// example into the directory of the node exporter's textfile collector.
+    class IGNITION_FUEL_TOOLS_VISIBLE MetricsRegistry
+    {
+      /// \brief Constructor.
+      public: MetricsRegistry();
+
+      /// \brief Destructor.
+      public: ~MetricsRegistry();
+
+      /// \brief Registry shared by the whole process, where the library
+      /// records its metrics.
+      /// \return The registry.
+      public: static MetricsRegistry &Global();
+
+      /// \brief Default histogram buckets for durations, in seconds.
+      /// \return Bucket upper bounds, from 1 ms to 60 s.
+      public: static const std::vector<double> &DurationBuckets();
+
+      /// \brief Get or create a counter.
+      /// \param[in] _name Metric name, such as "ign_fuel_downloads_total".
+      /// \param[in] _help Description, used when the metric is created.
+      /// \param[in] _labels Labels of this instance of the metric.
+      /// \return The counter.
+      public: MetricCounter &Counter(const std::string &_name,
+          const std::string &_help, const MetricLabels &_labels = {});
+
+      /// \brief Get or create a gauge.
+      /// \param[in] _name Metric name.
+      /// \param[in] _help Description, used when the metric is created.
+      /// \param[in] _labels Labels of this instance of the metric.
+      /// \return The gauge.
+      public: MetricGauge &Gauge(const std::string &_name,
+          const std::string &_help, const MetricLabels &_labels = {});
+
+      /// \brief Get or create a histogram.
+      /// \param[in] _name Metric name.
+      /// \param[in] _help Description, used when the metric is created.
+      /// \param[in] _bounds Bucket upper bounds, used when the metric is
+      /// created.
+      /// \param[in] _labels Labels of this instance of the metric.
+      /// \return The histogram.
+      public: MetricHistogram &Histogram(const std::string &_name,
+          const std::string &_help, const std::vector<double> &_bounds,
+          const MetricLabels &_labels = {});
+
+      /// \brief Get all the metrics in the Prometheus text format.
+      /// \return Text, with HELP and TYPE lines for each metric.
+      public: std::string PrometheusText() const;
+
+      /// \brief Write all the metrics in the Prometheus text format. The
+      /// file is replaced atomically, so a collector never reads a partial
+      /// file.
+      /// \param[in] _path Output file, such as
+      /// "/var/lib/node_exporter/textfile/ign_fuel.prom".
+      /// \return True if the file was written.
+      public: bool WritePrometheusText(const std::string &_path) const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<MetricsRegistryPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
@@ -54,6 +54,9 @@ namespace ignition
     /// \brief Forward declaration
     class IterRestIds;
 
+    /// \brief Forward declaration
+    class IterSnapshot;
+
     /// \brief Forward declaration
     class ModelIterTest;
 
@@ -63,6 +66,7 @@ namespace ignition
       friend IterIds;
       friend IterRESTIds;
       friend IterRestIds;
+      friend IterSnapshot;
       friend ModelIter;
       friend ModelIterPrivate;
       friend ModelIterTest;
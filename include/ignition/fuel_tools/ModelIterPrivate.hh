@@ -18,9 +18,11 @@
 #ifndef IGNITION_FUEL_TOOLS_MODELITERPRIVATE_HH_
 #define IGNITION_FUEL_TOOLS_MODELITERPRIVATE_HH_
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "ignition/fuel_tools/CatalogSnapshot.hh"
 #include "ignition/fuel_tools/ClientConfig.hh"
 #include "ignition/fuel_tools/Model.hh"
 #include "ignition/fuel_tools/ModelIdentifier.hh"
@@ -54,6 +56,15 @@ namespace ignition
                                       const ServerConfig &_server,
                                       const std::string &_api);
 
+      /// \brief Create a model iterator over a catalog snapshot, which
+      /// decodes each model as it's reached.
+      /// \param[in] _snapshot An open snapshot.
+      /// \param[in] _server Server the catalog comes from.
+      /// \return Model iterator
+      public: static ModelIter Create(
+                  std::shared_ptr<const CatalogSnapshot> _snapshot,
+                  const ServerConfig &_server);
+
       /// \brief Create a model iterator that is empty
       /// \return An empty iterator
       public: static ModelIter Create();
@@ -122,6 +133,38 @@ namespace ignition
       protected: std::vector<Model>::iterator modelIter;
     };
 
+    /// \brief class for iterating through the models of a catalog snapshot
+    class IGNITION_FUEL_TOOLS_VISIBLE IterSnapshot : public ModelIterPrivate
+    {
+      /// \brief Constructor
+      /// \param[in] _snapshot An open snapshot.
+      /// \param[in] _server Server the catalog comes from.
+      public: IterSnapshot(std::shared_ptr<const CatalogSnapshot> _snapshot,
+                           const ServerConfig &_server);
+
+      /// \brief Destructor
+      public: virtual ~IterSnapshot();
+
+      // Documentation inherited
+      public: virtual void Next() override;
+
+      // Documentation inherited
+      public: virtual bool HasReachedEnd() override;
+
+      /// \brief Decode the model at the current index, skipping corrupt
+      /// records.
+      private: void Load();
+
+      /// \brief The snapshot, kept mapped while iterating.
+      protected: std::shared_ptr<const CatalogSnapshot> snapshot;
+
+      /// \brief Server the catalog comes from.
+      protected: ServerConfig server;
+
+      /// \brief Index of the current model.
+      protected: size_t index = 0;
+    };
+
     /// \brief class for iterating through model ids from a rest API
     class IGNITION_FUEL_TOOLS_VISIBLE IterRestIds: public ModelIterPrivate
     {
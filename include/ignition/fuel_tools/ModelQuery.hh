@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_MODELQUERY_HH_
+#define IGNITION_FUEL_TOOLS_MODELQUERY_HH_
+
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/Export.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class ModelQueryPrivate;
+
+    /// \brief Orders of query results.
+    enum class ModelSort
+    {
+      /// \brief Whichever order the server returns, such as by relevance.
+      NONE,
+
+      /// \brief Most downloaded first.
+      DOWNLOADS,
+
+      /// \brief Most liked first.
+      LIKES,
+
+      /// \brief Most recently modified first.
+      MODIFIED,
+
+      /// \brief By name, ignoring case.
+      NAME
+    };
+
+    /// \brief Criteria to find models on a server. FuelClient sends the
+    /// text, tags, owner, order and limit to the server, so that only
+    /// matching pages come back, and checks every criterion on the models
+    /// it receives, for servers which can't apply some of them.
+    /// \sa FuelClient::Models(const ServerConfig &, const ModelQuery &)
+    class IGNITION_FUEL_TOOLS_VISIBLE ModelQuery
+    {
+      /// \brief Constructor. An empty query matches all models.
+      public: ModelQuery();
+
+      /// \brief Copy constructor.
+      /// \param[in] _orig The query to copy.
+      public: ModelQuery(const ModelQuery &_orig);
+
+      /// \brief Assignment operator overload.
+      /// \param[in] _orig The query to copy.
+      /// \return Reference to this object.
+      public: ModelQuery &operator=(const ModelQuery &_orig);
+
+      /// \brief Destructor.
+      public: ~ModelQuery();
+
+      /// \brief Get the search text.
+      /// \return Keywords, all of which must appear in the name, owner,
+      /// description or tags of a model, ignoring case.
+      public: const std::string &Text() const;
+
+      /// \brief Set the search text.
+      /// \param[in] _text Keywords, such as "cordless drill".
+      public: void SetText(const std::string &_text);
+
+      /// \brief Get the required tags.
+      /// \return Tags, all of which a model must have, ignoring case.
+      public: const std::vector<std::string> &Tags() const;
+
+      /// \brief Set the required tags.
+      /// \param[in] _tags Tags, such as {"tools"}.
+      public: void SetTags(const std::vector<std::string> &_tags);
+
+      /// \brief Get the owner.
+      /// \return Owner of the models, or empty for any owner.
+      public: const std::string &Owner() const;
+
+      /// \brief Set the owner.
+      /// \param[in] _owner Owner of the models, or empty for any owner.
+      public: void SetOwner(const std::string &_owner);
+
+      /// \brief Get the license.
+      /// \return License name, or empty for any license.
+      public: const std::string &License() const;
+
+      /// \brief Set the license. Only checked locally.
+      /// \param[in] _license License name, such as
+      /// "Creative Commons - Attribution".
+      public: void SetLicense(const std::string &_license);
+
+      /// \brief Get the minimum modification date.
+      /// \return Date, or 0 for any date.
+      public: std::time_t ModifiedSince() const;
+
+      /// \brief Only match models modified at or after a date. Only checked
+      /// locally.
+      /// \param[in] _date Date, or 0 for any date.
+      public: void SetModifiedSince(std::time_t _date);
+
+      /// \brief Get the order of the results.
+      /// \return The order.
+      public: ModelSort Sort() const;
+
+      /// \brief Set the order of the results.
+      /// \param[in] _sort The order.
+      public: void SetSort(ModelSort _sort);
+
+      /// \brief Get the maximum number of results.
+      /// \return Maximum number of results, or 0 for no limit.
+      public: size_t Limit() const;
+
+      /// \brief Set the maximum number of results.
+      /// \param[in] _limit Maximum number of results, or 0 for no limit.
+      public: void SetLimit(size_t _limit);
+
+      /// \brief Query strings which ask a server to apply this query to a
+      /// model listing, such as {"q=drill", "order_by=downloads"}.
+      /// \return Percent-encoded query strings, without paging.
+      public: std::vector<std::string> QueryStrings() const;
+
+      /// \brief Check whether a model matches all the criteria.
+      /// \param[in] _id The model.
+      /// \return True if the model matches.
+      public: bool Matches(const ModelIdentifier &_id) const;
+
+      /// \brief Compare models according to Sort.
+      /// \param[in] _a A model.
+      /// \param[in] _b Another model.
+      /// \return True if _a comes strictly before _b.
+      public: bool Before(const ModelIdentifier &_a,
+          const ModelIdentifier &_b) const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<ModelQueryPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
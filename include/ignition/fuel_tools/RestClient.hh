@@ -17,6 +17,8 @@
 #ifndef IGNITION_FUEL_TOOLS_RESTCLIENT_HH_
 #define IGNITION_FUEL_TOOLS_RESTCLIENT_HH_
 
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -66,6 +68,13 @@ namespace ignition
       POST_FORM
     };
 
+    /// \brief Callback of a transfer in progress.
+    /// \param[in] _current Bytes received so far.
+    /// \param[in] _total Expected bytes, or 0 if unknown.
+    /// \return False to abort the transfer.
+    using RestTransferCallback =
+        std::function<bool(uint64_t _current, uint64_t _total)>;
+
     /// \brief A helper class for making REST requests.
     class IGNITION_FUEL_TOOLS_VISIBLE Rest
     {
@@ -114,8 +123,17 @@ namespace ignition
       /// \return Name of the user agent.
       public: const std::string &UserAgent() const;
 
+      /// \brief Set a callback called while responses are received. If it
+      /// returns false, the transfer is aborted and the response has a
+      /// status code of 0.
+      /// \param[in] _callback Callback, or an empty function to remove it.
+      public: void SetTransferCallback(const RestTransferCallback &_callback);
+
       /// \brief The user agent name.
       private: std::string userAgent;
+
+      /// \brief Transfer callback.
+      private: RestTransferCallback transferCallback;
     };
   }
 }
@@ -68,7 +68,10 @@ namespace ignition
 
       /// \brief Upload failed. Other errors.
       /// \sa ReadableResult
-      UPLOAD_ERROR
+      UPLOAD_ERROR,
+
+      /// \brief Fetch cancelled through a CancellationToken.
+      FETCH_CANCELLED
     };
 
     /// \brief Class describing a result of an operation.
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_SEARCHINDEX_HH_
+#define IGNITION_FUEL_TOOLS_SEARCHINDEX_HH_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/Export.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class SearchIndexPrivate;
+
+    /// \brief Inverted index of models, to search them by keywords and tags
+    /// without scanning every model.
+    ///
+    /// Names, owners, descriptions and tags are split into lowercase words.
+    /// A keyword matches a model if it's a prefix of one of its words, and
+    /// a tag matches a model if it's one of its tags, ignoring case. Results
+    /// are ranked by download count, then by like count.
+    ///
+    /// The index is rebuilt by the first search after models are added or
+    /// removed, so add models in batches when possible. It isn't thread
+    /// safe, not even for concurrent searches.
+    /// \sa LocalCache::SearchModels
+    class IGNITION_FUEL_TOOLS_VISIBLE SearchIndex
+    {
+      /// \brief Constructor.
+      public: SearchIndex();
+
+      /// \brief Copy constructor.
+      /// \param[in] _orig The index to copy.
+      public: SearchIndex(const SearchIndex &_orig);
+
+      /// \brief Assignment operator overload.
+      /// \param[in] _orig The index to copy.
+      /// \return Reference to this object.
+      public: SearchIndex &operator=(const SearchIndex &_orig);
+
+      /// \brief Destructor.
+      public: ~SearchIndex();
+
+      /// \brief Add a model, replacing any model with the same server,
+      /// owner and name.
+      /// \param[in] _id Model to add.
+      public: void Add(const ModelIdentifier &_id);
+
+      /// \brief Add many models.
+      /// \param[in] _ids Models to add.
+      /// \sa Add(const ModelIdentifier &)
+      public: void Add(const std::vector<ModelIdentifier> &_ids);
+
+      /// \brief Remove a model.
+      /// \param[in] _id Model with the server, owner and name to remove.
+      /// \return True if the model was in the index.
+      public: bool Remove(const ModelIdentifier &_id);
+
+      /// \brief Remove all models.
+      public: void Clear();
+
+      /// \brief Number of models.
+      /// \return Number of models in the index.
+      public: size_t Size() const;
+
+      /// \brief Search models.
+      /// \param[in] _text Keywords, all of which must match. An empty string
+      /// matches every model.
+      /// \param[in] _tags Tags, all of which must match.
+      /// \param[in] _limit Maximum number of results, or 0 for no limit.
+      /// \return Matching models, most downloaded first.
+      public: std::vector<ModelIdentifier> Search(const std::string &_text,
+          const std::vector<std::string> &_tags = {},
+          size_t _limit = 0) const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<SearchIndexPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_TRACE_HH_
+#define IGNITION_FUEL_TOOLS_TRACE_HH_
+
+#include <cstdint>
+#include <string>
+
+#include "ignition/fuel_tools/Export.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Records timed spans of the download pipeline, such as URL
+    /// parsing, HTTP requests, archive extraction and path fixing, and
+    /// exports them in the Chrome trace-event format. The result can be
+    /// opened with chrome://tracing or https://ui.perfetto.dev.
+    ///
+    /// Tracing is disabled by default, and then each span only costs a
+    /// check of an atomic flag.
+    class IGNITION_FUEL_TOOLS_VISIBLE Trace
+    {
+      /// \brief Start or stop recording spans.
+      /// \param[in] _enabled True to record spans.
+      public: static void SetEnabled(bool _enabled);
+
+      /// \brief Whether spans are being recorded.
+      /// \return True if spans are being recorded.
+      public: static bool Enabled();
+
+      /// \brief Discard the recorded spans.
+      public: static void Clear();
+
+      /// \brief Number of recorded spans. Once a million spans are
+      /// recorded, further spans are dropped.
+      /// \return Number of spans.
+      public: static uint64_t SpanCount();
+
+      /// \brief Get the recorded spans in the Chrome trace-event format.
+      /// \return JSON object, with a "traceEvents" array of complete
+      /// events. Each event has the thread which recorded it as "tid".
+      public: static std::string ChromeJson();
+
+      /// \brief Write the recorded spans in the Chrome trace-event format.
+      /// \param[in] _path Output file.
+      /// \return True if the file was written.
+      public: static bool WriteChromeJson(const std::string &_path);
+
+      /// \brief Get the current trace time.
+      /// \return Microseconds since an arbitrary point in the past.
+      public: static int64_t Now();
+
+      /// \brief Record a span. TraceSpan calls it when it goes out of scope.
+      /// \param[in] _name Span name. Must outlive the trace, such as a
+      /// string literal.
+      /// \param[in] _category Span category. Must outlive the trace.
+      /// \param[in] _detail Optional detail, such as a URL.
+      /// \param[in] _start Start time, from Now().
+      /// \param[in] _end End time, from Now().
+      public: static void Record(const char *_name, const char *_category,
+          const std::string &_detail, int64_t _start, int64_t _end);
+    };
+
+    /// \brief Records a span from its construction to its destruction, when
+    /// tracing is enabled.
+    ///
+    /// E.g.:
+    ///   TraceSpan span("LocalCache::SaveModel", "cache");
+    ///   if (span.Active())
+    ///     span.SetDetail(_id.UniqueName());
+    class TraceSpan
+    {
+      /// \brief Constructor. Starts the span if tracing is enabled.
+      /// \param[in] _name Span name. Must outlive the trace, such as a
+      /// string literal.
+      /// \param[in] _category Span category, such as "http". Must outlive
+      /// the trace.
+      public: TraceSpan(const char *_name, const char *_category)
+        : name(_name), category(_category), active(Trace::Enabled())
+      {
+        if (this->active)
+          this->start = Trace::Now();
+      }
+
+      /// \brief Destructor. Records the span.
+      public: ~TraceSpan()
+      {
+        if (this->active)
+        {
+          Trace::Record(this->name, this->category, this->detail,
+              this->start, Trace::Now());
+        }
+      }
+
+      /// \brief Copying a span would record it twice.
+      public: TraceSpan(const TraceSpan &) = delete;
+
+      /// \brief Copying a span would record it twice.
+      public: TraceSpan &operator=(const TraceSpan &) = delete;
+
+      /// \brief Whether the span is recorded. Check it before building an
+      /// expensive detail.
+      /// \return True if tracing was enabled when the span started.
+      public: bool Active() const
+      {
+        return this->active;
+      }
+
+      /// \brief Set a detail shown with the span, such as a URL.
+      /// \param[in] _detail Detail.
+      public: void SetDetail(const std::string &_detail)
+      {
+        this->detail = _detail;
+      }
+
+      /// \brief Span name.
+      private: const char *name;
+
+      /// \brief Span category.
+      private: const char *category;
+
+      /// \brief Whether the span is recorded.
+      private: bool active;
+
+      /// \brief Start time, in microseconds.
+      private: int64_t start = 0;
+
+      /// \brief Detail shown with the span.
+      private: std::string detail;
+    };
+  }
+}
+
+#endif
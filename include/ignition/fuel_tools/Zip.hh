@@ -17,6 +17,8 @@
 #ifndef IGNITION_FUEL_TOOLS_ZIP_HH_
 #define IGNITION_FUEL_TOOLS_ZIP_HH_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -41,6 +43,18 @@ namespace ignition
       /// \param[in] _dst Output extracted file path
       public: static bool Extract(const std::string &_src,
           const std::string &_dst);
+
+      /// \brief Extract a compressed file, reporting progress after each
+      /// entry.
+      /// \param[in] _src Path to compressed file
+      /// \param[in] _dst Output extracted file path
+      /// \param[in] _progress Called with the uncompressed bytes extracted
+      /// so far and the total. Returning false stops the extraction, leaving
+      /// the entries extracted so far on disk.
+      /// \return True if all the entries were extracted.
+      public: static bool Extract(const std::string &_src,
+          const std::string &_dst,
+          const std::function<bool(uint64_t, uint64_t)> &_progress);
     };
   }
 }
@@ -0,0 +1,962 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+#include <ignition/common/StringUtils.hh>
+#include <ignition/common/URI.hh>
+
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+#include "ignition/fuel_tools/RestClient.hh"
+#include "ignition/fuel_tools/WorldIdentifier.hh"
+
+#include "CacheServer.hh"
+#include "HttpServer.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Private data for CacheServer.
+class ignition::fuel_tools::CacheServerPrivate
+{
+  /// \brief A proxied response kept in memory.
+  public: struct Memo
+  {
+    /// \brief Response to replay.
+    HttpResponse response;
+
+    /// \brief When the response was received.
+    std::chrono::steady_clock::time_point time;
+  };
+
+  /// \brief Answer a request.
+  /// \param[in] _request Request received.
+  /// \param[out] _response Response to send.
+  public: void Handle(const HttpRequest &_request, HttpResponse &_response);
+
+  /// \brief Run a fetch, unless an identical one is in flight, in which case
+  /// wait for it instead.
+  /// \param[in] _key Identifies the fetch.
+  /// \param[in] _fetch Function doing the fetch.
+  /// \return Result of the fetch.
+  public: bool Coalesce(const std::string &_key,
+      const std::function<bool()> &_fetch);
+
+  /// \brief Get a response from memory, or from the upstream server.
+  /// \param[in] _path Route relative to the upstream server version.
+  /// \param[in] _query Raw query string.
+  /// \param[in] _headers Headers forwarded to the upstream server.
+  /// \param[out] _response Response.
+  /// \param[out] _upstream True if the upstream server had to be contacted.
+  /// \return False if there's no response in memory and the upstream server
+  /// couldn't be reached.
+  public: bool Proxy(const std::string &_path, const std::string &_query,
+      const std::vector<std::string> &_headers, HttpResponse &_response,
+      bool &_upstream);
+
+  /// \brief Send a request to the upstream server.
+  /// \param[in] _path Route relative to the upstream server version.
+  /// \param[in] _query Raw query string.
+  /// \param[in] _headers Headers forwarded to the upstream server.
+  /// \param[out] _response Response.
+  /// \return False if the upstream server couldn't be reached.
+  public: bool Forward(const std::string &_path, const std::string &_query,
+      const std::vector<std::string> &_headers, HttpResponse &_response);
+
+  /// \brief Keep a response in memory. Expired responses are dropped to
+  /// make room, and then the oldest ones. Must be called with mutex held.
+  /// \param[in] _key Identifies the request.
+  /// \param[in] _response Response to keep.
+  public: void Remember(const std::string &_key,
+      const HttpResponse &_response);
+
+  /// \brief Resolve the version of a resource, which may be "tip".
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \param[in] _versionStr Version number or "tip".
+  /// \param[in] _headers Headers forwarded to the upstream server.
+  /// \param[out] _version Resolved version.
+  /// \return True if the version could be resolved.
+  public: bool ResolveVersion(const std::string &_owner,
+      const std::string &_type, const std::string &_name,
+      const std::string &_versionStr,
+      const std::vector<std::string> &_headers, unsigned int &_version);
+
+  /// \brief Make sure the archive of a resource version is stored, and
+  /// installed into the local cache.
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \param[in] _version Version number.
+  /// \param[in] _headers Headers forwarded to the upstream server.
+  /// \return True if the archive is stored.
+  public: bool FetchArchive(const std::string &_owner,
+      const std::string &_type, const std::string &_name,
+      unsigned int _version, const std::vector<std::string> &_headers);
+
+  /// \brief Path where an archive is stored.
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \param[in] _version Version number.
+  /// \return Path to the archive.
+  public: std::string ArchivePath(const std::string &_owner,
+      const std::string &_type, const std::string &_name,
+      unsigned int _version) const;
+
+  /// \brief Path of a resource version in the local cache.
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \param[in] _version Version number.
+  /// \return Path to the versioned directory.
+  public: std::string CachePath(const std::string &_owner,
+      const std::string &_type, const std::string &_name,
+      unsigned int _version) const;
+
+  /// \brief Load request counts saved by a previous run.
+  public: void LoadPopular();
+
+  /// \brief Save request counts for the next run.
+  public: void SavePopular() const;
+
+  /// \brief Client configuration.
+  public: ClientConfig config;
+
+  /// \brief Upstream server.
+  public: ServerConfig upstream;
+
+  /// \brief Cache where resources are installed.
+  public: std::unique_ptr<LocalCache> cache;
+
+  /// \brief HTTP server.
+  public: std::unique_ptr<HttpServer> server;
+
+  /// \brief Directory where archives are stored.
+  public: std::string archiveDir;
+
+  /// \brief How long proxied responses are kept.
+  public: std::chrono::seconds ttl{60};
+
+  /// \brief Maximum number of proxied responses kept.
+  public: size_t maxMemos{1024};
+
+  /// \brief REST client used for upstream requests.
+  public: Rest rest;
+
+  /// \brief Fetches in flight.
+  public: std::map<std::string, std::shared_future<bool>> inflight;
+
+  /// \brief Proxied responses.
+  public: std::map<std::string, Memo> memos;
+
+  /// \brief Number of requests for each resource.
+  public: std::map<std::string, uint64_t> popularity;
+
+  /// \brief Protects inflight, memos and popularity.
+  public: mutable std::mutex mutex;
+
+  /// \brief Number of requests.
+  public: std::atomic<uint64_t> requests{0};
+
+  /// \brief Number of requests answered locally.
+  public: std::atomic<uint64_t> hits{0};
+
+  /// \brief Number of requests which needed the upstream server.
+  public: std::atomic<uint64_t> misses{0};
+
+  /// \brief Number of coalesced fetches.
+  public: std::atomic<uint64_t> coalesced{0};
+
+  /// \brief Number of upstream requests.
+  public: std::atomic<uint64_t> upstreamRequests{0};
+};
+
+//////////////////////////////////////////////////
+/// \brief Check whether a path segment received from a client can be used
+/// as a file or directory name.
+/// \param[in] _segment Percent-decoded segment.
+/// \return False for empty, "." and ".." segments, and segments containing
+/// a separator.
+static bool validSegment(const std::string &_segment)
+{
+  return !_segment.empty() && _segment != "." && _segment != ".." &&
+      _segment.find_first_of("/\\") == std::string::npos;
+}
+
+//////////////////////////////////////////////////
+/// \brief Check whether a path lies under a directory, once symbolic links
+/// are resolved.
+/// \param[in] _root Directory.
+/// \param[in] _path Path to check.
+/// \return True if _path is inside _root.
+static bool within(const std::string &_root, const std::string &_path)
+{
+  std::string root = common::absPath(_root);
+  std::string path = common::absPath(_path);
+  return !root.empty() && path.size() > root.size() &&
+      path.compare(0, root.size(), root) == 0 &&
+      (path[root.size()] == '/' || path[root.size()] == '\\');
+}
+
+//////////////////////////////////////////////////
+CacheServer::CacheServer(const ClientConfig &_config,
+    const ServerConfig &_upstream)
+  : dataPtr(new CacheServerPrivate)
+{
+  this->dataPtr->config = _config;
+  this->dataPtr->upstream = _upstream;
+
+  // The local cache only looks at configured servers.
+  bool found{false};
+  for (const auto &server : this->dataPtr->config.Servers())
+  {
+    if (server.Url().Str() == _upstream.Url().Str())
+      found = true;
+  }
+  if (!found)
+    this->dataPtr->config.AddServer(_upstream);
+
+  this->dataPtr->cache.reset(new LocalCache(&this->dataPtr->config));
+  this->dataPtr->archiveDir = common::joinPaths(
+      this->dataPtr->config.CacheLocation(), ".archives");
+  this->dataPtr->rest.SetUserAgent(this->dataPtr->config.UserAgent());
+  this->dataPtr->server.reset(new HttpServer(
+      [this](const HttpRequest &_request, HttpResponse &_response)
+      {
+        this->dataPtr->Handle(_request, _response);
+      }));
+}
+
+//////////////////////////////////////////////////
+CacheServer::~CacheServer()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void CacheServer::SetArchiveDirectory(const std::string &_path)
+{
+  this->dataPtr->archiveDir = _path;
+}
+
+//////////////////////////////////////////////////
+void CacheServer::SetTtl(const std::chrono::seconds &_ttl)
+{
+  this->dataPtr->ttl = _ttl;
+}
+
+//////////////////////////////////////////////////
+bool CacheServer::Start(const std::string &_host, uint16_t _port)
+{
+  this->dataPtr->LoadPopular();
+  return this->dataPtr->server->Start(_host, _port);
+}
+
+//////////////////////////////////////////////////
+bool CacheServer::StartUnix(const std::string &_path)
+{
+  this->dataPtr->LoadPopular();
+  return this->dataPtr->server->StartUnix(_path);
+}
+
+//////////////////////////////////////////////////
+void CacheServer::Stop()
+{
+  if (!this->dataPtr->server->Running())
+    return;
+
+  this->dataPtr->server->Stop();
+  this->dataPtr->SavePopular();
+}
+
+//////////////////////////////////////////////////
+std::string CacheServer::Url() const
+{
+  return this->dataPtr->server->Url();
+}
+
+//////////////////////////////////////////////////
+size_t CacheServer::Prewarm(const std::vector<std::string> &_urls,
+    unsigned int _jobs)
+{
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> cached{0};
+  auto worker = [&]()
+  {
+    for (size_t i = next++; i < _urls.size(); i = next++)
+    {
+      // Keep the path after the server version, if it's a full URL.
+      std::string path = _urls[i];
+      std::string prefix = "/" + this->dataPtr->upstream.Version() + "/";
+      auto pos = path.find(prefix);
+      if (pos != std::string::npos)
+        path = path.substr(pos + prefix.size());
+
+      auto segments = common::Split(path, '/');
+      segments.erase(std::remove(segments.begin(), segments.end(), ""),
+          segments.end());
+      if (segments.size() < 3 ||
+          (segments[1] != "models" && segments[1] != "worlds") ||
+          !std::all_of(segments.begin(), segments.end(), validSegment))
+      {
+        ignwarn << "Can't prewarm [" << _urls[i] << "]" << std::endl;
+        continue;
+      }
+
+      std::string versionStr = segments.size() > 3 ? segments[3] : "tip";
+      unsigned int version;
+      if (this->dataPtr->ResolveVersion(segments[0], segments[1], segments[2],
+            versionStr, {}, version) &&
+          this->dataPtr->FetchArchive(segments[0], segments[1], segments[2],
+            version, {}))
+      {
+        ++cached;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < std::max(1u, _jobs); ++i)
+    workers.emplace_back(worker);
+  for (auto &thread : workers)
+    thread.join();
+
+  return cached;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> CacheServer::Popular(size_t _count) const
+{
+  std::vector<std::pair<std::string, uint64_t>> counts;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    counts.assign(this->dataPtr->popularity.begin(),
+        this->dataPtr->popularity.end());
+  }
+
+  std::stable_sort(counts.begin(), counts.end(),
+      [](const std::pair<std::string, uint64_t> &_a,
+         const std::pair<std::string, uint64_t> &_b)
+      {
+        return _a.second > _b.second;
+      });
+
+  std::vector<std::string> result;
+  for (size_t i = 0; i < counts.size() && i < _count; ++i)
+    result.push_back(counts[i].first);
+  return result;
+}
+
+//////////////////////////////////////////////////
+CacheServerStats CacheServer::Stats() const
+{
+  CacheServerStats stats;
+  stats.requests = this->dataPtr->requests;
+  stats.hits = this->dataPtr->hits;
+  stats.misses = this->dataPtr->misses;
+  stats.coalesced = this->dataPtr->coalesced;
+  stats.upstreamRequests = this->dataPtr->upstreamRequests;
+  return stats;
+}
+
+//////////////////////////////////////////////////
+void CacheServerPrivate::Handle(const HttpRequest &_request,
+    HttpResponse &_response)
+{
+  ++this->requests;
+
+  if (_request.method != "GET" && _request.method != "HEAD")
+  {
+    _response.status = 405;
+    return;
+  }
+
+  if (_request.path == "/serve-cache/status")
+  {
+    Json::Value status;
+    status["upstream"] = this->upstream.Url().Str();
+    status["requests"] = static_cast<Json::UInt64>(this->requests);
+    status["hits"] = static_cast<Json::UInt64>(this->hits);
+    status["misses"] = static_cast<Json::UInt64>(this->misses);
+    status["coalesced"] = static_cast<Json::UInt64>(this->coalesced);
+    status["upstream_requests"] =
+        static_cast<Json::UInt64>(this->upstreamRequests);
+    Json::StreamWriterBuilder builder;
+    _response.body = Json::writeString(builder, status);
+    _response.headers["Content-Type"] = "application/json";
+    return;
+  }
+
+  // Segments end up in file paths, so anything which could walk out of the
+  // cache, such as "..", is refused. Only the leading and trailing slashes
+  // are allowed to produce empty segments.
+  auto segments = common::Split(_request.path, '/');
+  if (!segments.empty() && segments.front().empty())
+    segments.erase(segments.begin());
+  if (!segments.empty() && segments.back().empty())
+    segments.pop_back();
+  if (segments.empty() || segments[0] != this->upstream.Version() ||
+      !std::all_of(segments.begin(), segments.end(), validSegment))
+  {
+    _response.status = 404;
+    return;
+  }
+  segments.erase(segments.begin());
+
+  // Forward content negotiation and credentials.
+  std::vector<std::string> headers;
+  bool credentials = false;
+  for (const auto &name : {"accept", "authorization", "private-token"})
+  {
+    auto header = _request.headers.find(name);
+    if (header != _request.headers.end())
+    {
+      headers.push_back(std::string(name) + ": " + header->second);
+      credentials = credentials || std::string(name) != "accept";
+    }
+  }
+
+  // Archives fetched with credentials may be private, so they're neither
+  // stored nor installed, and requests carrying credentials are proxied.
+  // Files on disk are only served to requests without credentials.
+  bool resource = !credentials && segments.size() >= 5 &&
+      (segments[1] == "models" || segments[1] == "worlds");
+  std::string extension = _request.path.size() > 4 ?
+      _request.path.substr(_request.path.size() - 4) : "";
+
+  // Archive: <owner>/<type>/<name>/<version>/<name>.zip
+  if (resource && segments.size() == 5 && segments[4] == segments[2] + ".zip")
+  {
+    const auto &owner = segments[0];
+    const auto &type = segments[1];
+    const auto &name = segments[2];
+
+    unsigned int version;
+    if (this->ResolveVersion(owner, type, name, segments[3], headers,
+        version))
+    {
+      auto path = this->ArchivePath(owner, type, name, version);
+      bool cached = common::exists(path);
+      if (this->FetchArchive(owner, type, name, version, headers) &&
+          within(this->archiveDir, path))
+      {
+        if (cached)
+          ++this->hits;
+        else
+          ++this->misses;
+
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          ++this->popularity[owner + "/" + type + "/" + name];
+        }
+
+        _response.file = path;
+        _response.headers["Content-Type"] = "application/zip";
+        _response.headers["X-Ign-Resource-Version"] =
+            std::to_string(version);
+        return;
+      }
+    }
+  }
+
+  // File: <owner>/<type>/<name>/<version>/files/<path>
+  // SDF files in the cache point to absolute paths, so they're proxied.
+  if (resource && segments.size() > 5 && segments[4] == "files" &&
+      extension != ".sdf")
+  {
+    const auto &owner = segments[0];
+    const auto &type = segments[1];
+    const auto &name = segments[2];
+
+    unsigned int version;
+    if (this->ResolveVersion(owner, type, name, segments[3], headers,
+          version))
+    {
+      std::string file = this->CachePath(owner, type, name, version);
+      for (size_t i = 5; i < segments.size(); ++i)
+        file = common::joinPaths(file, segments[i]);
+
+      // Only the whole archive can be installed into the cache.
+      bool cached = common::isFile(file);
+      if ((cached ||
+           (this->FetchArchive(owner, type, name, version, headers) &&
+            common::isFile(file))) &&
+          within(this->config.CacheLocation(), file))
+      {
+        if (cached)
+          ++this->hits;
+        else
+          ++this->misses;
+
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          ++this->popularity[owner + "/" + type + "/" + name];
+        }
+
+        _response.file = file;
+        _response.headers["Content-Type"] = "application/octet-stream";
+        return;
+      }
+    }
+  }
+
+  // Anything else, such as listings and details, is proxied. So is an
+  // archive or file which couldn't be fetched, relaying the upstream
+  // server's answer, such as 401 for a private resource.
+  std::string route;
+  for (const auto &segment : segments)
+    route += (route.empty() ? "" : "/") + segment;
+
+  bool upstreamUsed;
+  if (!this->Proxy(route, _request.query, headers, _response, upstreamUsed))
+  {
+    ++this->misses;
+    _response = HttpResponse();
+    _response.status = 502;
+    return;
+  }
+
+  if (upstreamUsed)
+    ++this->misses;
+  else
+    ++this->hits;
+}
+
+//////////////////////////////////////////////////
+bool CacheServerPrivate::Coalesce(const std::string &_key,
+    const std::function<bool()> &_fetch)
+{
+  std::promise<bool> promise;
+  std::shared_future<bool> future;
+  bool leader{false};
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->inflight.find(_key);
+    if (it != this->inflight.end())
+    {
+      future = it->second;
+      ++this->coalesced;
+    }
+    else
+    {
+      future = promise.get_future().share();
+      this->inflight[_key] = future;
+      leader = true;
+    }
+  }
+
+  if (leader)
+  {
+    bool result{false};
+    try
+    {
+      result = _fetch();
+    }
+    catch(...)
+    {
+      result = false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->inflight.erase(_key);
+    }
+    promise.set_value(result);
+  }
+
+  return future.get();
+}
+
+//////////////////////////////////////////////////
+bool CacheServerPrivate::Proxy(const std::string &_path,
+    const std::string &_query, const std::vector<std::string> &_headers,
+    HttpResponse &_response, bool &_upstream)
+{
+  // Responses to requests with credentials may differ for each user, so
+  // they're neither shared nor kept.
+  std::string key = _path + "?" + _query;
+  for (const auto &header : _headers)
+  {
+    auto name = common::lowercase(header.substr(0, header.find(':')));
+    if (name == "authorization" || name == "private-token")
+    {
+      _upstream = true;
+      return this->Forward(_path, _query, _headers, _response);
+    }
+    key += "\n" + header;
+  }
+
+  _upstream = false;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto memo = this->memos.find(key);
+    if (memo != this->memos.end() &&
+        std::chrono::steady_clock::now() - memo->second.time < this->ttl)
+    {
+      _response = memo->second.response;
+      return true;
+    }
+  }
+
+  _upstream = true;
+  bool leader{false};
+  bool fetched{false};
+  HttpResponse latest;
+  this->Coalesce(key, [&]()
+  {
+    leader = true;
+    fetched = this->Forward(_path, _query, _headers, latest);
+    if (!fetched)
+      return false;
+
+    // Errors aren't kept, and outdate whatever was kept before.
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (latest.status >= 200 && latest.status < 300)
+      this->Remember(key, latest);
+    else
+      this->memos.erase(key);
+    return true;
+  });
+
+  if (fetched)
+  {
+    _response = latest;
+    return true;
+  }
+
+  // Serve the latest response, which may be stale if the upstream server
+  // couldn't be reached.
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto memo = this->memos.find(key);
+    if (memo != this->memos.end())
+    {
+      _response = memo->second.response;
+      return true;
+    }
+  }
+
+  // The request was coalesced with one which got an error, which wasn't
+  // kept, so ask again.
+  return !leader && this->Forward(_path, _query, _headers, _response);
+}
+
+//////////////////////////////////////////////////
+bool CacheServerPrivate::Forward(const std::string &_path,
+    const std::string &_query, const std::vector<std::string> &_headers,
+    HttpResponse &_response)
+{
+  ++this->upstreamRequests;
+  std::vector<std::string> query;
+  if (!_query.empty())
+    query.push_back(_query);
+
+  auto resp = this->rest.Request(HttpMethod::GET, this->upstream.Url().Str(),
+      this->upstream.Version(), _path, query, _headers, "");
+  if (resp.statusCode == 0)
+    return false;
+
+  _response = HttpResponse();
+  _response.status = resp.statusCode;
+  _response.body = resp.data;
+  for (const auto &header : resp.headers)
+  {
+    auto name = common::lowercase(header.first);
+    if (name == "content-type" || name == "link" ||
+        name == "x-ign-resource-version" || name == "x-total-count")
+    {
+      // Rest keeps the trailing CRLF of header values.
+      _response.headers[header.first] = common::trimmed(header.second);
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void CacheServerPrivate::Remember(const std::string &_key,
+    const HttpResponse &_response)
+{
+  auto now = std::chrono::steady_clock::now();
+  if (this->memos.find(_key) == this->memos.end() &&
+      this->memos.size() >= this->maxMemos)
+  {
+    for (auto it = this->memos.begin(); it != this->memos.end();)
+    {
+      if (now - it->second.time >= this->ttl)
+        it = this->memos.erase(it);
+      else
+        ++it;
+    }
+
+    while (this->memos.size() >= this->maxMemos)
+    {
+      auto oldest = std::min_element(this->memos.begin(), this->memos.end(),
+          [](const std::pair<const std::string, Memo> &_a,
+             const std::pair<const std::string, Memo> &_b)
+          {
+            return _a.second.time < _b.second.time;
+          });
+      this->memos.erase(oldest);
+    }
+  }
+
+  auto &memo = this->memos[_key];
+  memo.time = now;
+  memo.response = _response;
+}
+
+//////////////////////////////////////////////////
+bool CacheServerPrivate::ResolveVersion(const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    const std::string &_versionStr, const std::vector<std::string> &_headers,
+    unsigned int &_version)
+{
+  if (_versionStr != "tip")
+  {
+    try
+    {
+      _version = std::stoul(_versionStr);
+      return _version > 0;
+    }
+    catch(...)
+    {
+      return false;
+    }
+  }
+
+  // Ask the upstream server for the latest version. Details are kept in
+  // memory, so this doesn't happen for every request.
+  HttpResponse details;
+  bool upstreamUsed;
+  std::vector<std::string> headers = _headers;
+  headers.push_back("Accept: application/json");
+  if (this->Proxy(_owner + "/" + _type + "/" + _name, "", headers, details,
+        upstreamUsed))
+  {
+    // An error, such as 404 for a private resource requested without
+    // credentials, is final, so what's on disk isn't revealed.
+    Json::CharReaderBuilder builder;
+    Json::Value value;
+    std::string errors;
+    std::istringstream stream(details.body);
+    if (details.status != 200 ||
+        !Json::parseFromStream(builder, stream, &value, &errors) ||
+        !value.isObject() || !value.isMember("version") ||
+        value["version"].asUInt() == 0)
+    {
+      return false;
+    }
+    _version = value["version"].asUInt();
+    return true;
+  }
+
+  // Fall back to the highest version available locally, when the upstream
+  // server can't be reached.
+  _version = 0;
+  std::string archiveDir = common::parentPath(
+      this->ArchivePath(_owner, _type, _name, 1));
+  common::DirIter end;
+  if (common::isDirectory(archiveDir))
+  {
+    for (common::DirIter file(archiveDir); file != end; ++file)
+    {
+      try
+      {
+        _version = std::max(_version, static_cast<unsigned int>(
+            std::stoul(common::basename(*file))));
+      }
+      catch(...)
+      {
+      }
+    }
+  }
+
+  std::string cacheDir = common::parentPath(
+      this->CachePath(_owner, _type, _name, 1));
+  if (common::isDirectory(cacheDir))
+  {
+    for (common::DirIter dir(cacheDir); dir != end; ++dir)
+    {
+      try
+      {
+        _version = std::max(_version, static_cast<unsigned int>(
+            std::stoul(common::basename(*dir))));
+      }
+      catch(...)
+      {
+      }
+    }
+  }
+
+  return _version > 0;
+}
+
+//////////////////////////////////////////////////
+bool CacheServerPrivate::FetchArchive(const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    unsigned int _version, const std::vector<std::string> &_headers)
+{
+  std::string path = this->ArchivePath(_owner, _type, _name, _version);
+  if (common::exists(path))
+    return true;
+
+  return this->Coalesce(path, [&]()
+  {
+    if (common::exists(path))
+      return true;
+
+    ++this->upstreamRequests;
+    common::URIPath route;
+    route = route / _owner / _type / _name / std::to_string(_version) /
+        (_name + ".zip");
+    auto resp = this->rest.Request(HttpMethod::GET,
+        this->upstream.Url().Str(), this->upstream.Version(), route.Str(),
+        {}, _headers, "");
+    if (resp.statusCode != 200)
+    {
+      ignerr << "Failed to fetch [" << route.Str() << "] from ["
+             << this->upstream.Url().Str() << "], REST response code: "
+             << resp.statusCode << std::endl;
+      return false;
+    }
+
+    // Write to a temporary file first, so that concurrent readers never see
+    // a partial archive.
+    common::createDirectories(common::parentPath(path));
+    std::string tmpPath = path + ".download";
+    {
+      std::ofstream out(tmpPath, std::ios::binary);
+      out << resp.data;
+      if (!out.good())
+      {
+        ignerr << "Unable to write [" << tmpPath << "]" << std::endl;
+        return false;
+      }
+    }
+    if (!common::moveFile(tmpPath, path))
+    {
+      ignerr << "Unable to move [" << tmpPath << "] to [" << path << "]"
+             << std::endl;
+      return false;
+    }
+
+    // Install into the shared cache, for clients reading it directly.
+    // Models which only have some files are completed.
+    std::string cachePath = this->CachePath(_owner, _type, _name, _version);
+    if (!common::isDirectory(cachePath) ||
+        common::exists(common::joinPaths(cachePath, ".partial")))
+    {
+      if (_type == "models")
+      {
+        ModelIdentifier id;
+        id.SetServer(this->upstream);
+        id.SetOwner(_owner);
+        id.SetName(_name);
+        id.SetVersion(_version);
+        this->cache->SaveModel(id, resp.data, false);
+      }
+      else
+      {
+        WorldIdentifier id;
+        id.SetServer(this->upstream);
+        id.SetOwner(_owner);
+        id.SetName(_name);
+        id.SetVersion(_version);
+        this->cache->SaveWorld(id, resp.data, false);
+      }
+    }
+
+    return true;
+  });
+}
+
+//////////////////////////////////////////////////
+std::string CacheServerPrivate::ArchivePath(const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    unsigned int _version) const
+{
+  return common::joinPaths(this->archiveDir, this->upstream.Url().Path().Str(),
+      _owner, _type, _name, std::to_string(_version) + ".zip");
+}
+
+//////////////////////////////////////////////////
+std::string CacheServerPrivate::CachePath(const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    unsigned int _version) const
+{
+  return common::joinPaths(this->config.CacheLocation(),
+      this->upstream.Url().Path().Str(), _owner, _type, _name,
+      std::to_string(_version));
+}
+
+//////////////////////////////////////////////////
+void CacheServerPrivate::LoadPopular()
+{
+  std::ifstream in(common::joinPaths(this->archiveDir, "popular.json"));
+  if (!in.is_open())
+    return;
+
+  Json::CharReaderBuilder builder;
+  Json::Value value;
+  std::string errors;
+  if (!Json::parseFromStream(builder, in, &value, &errors) ||
+      !value.isObject())
+  {
+    ignwarn << "Unable to parse request counts: " << errors << std::endl;
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for (const auto &name : value.getMemberNames())
+  {
+    this->popularity[name] = std::max(this->popularity[name],
+        static_cast<uint64_t>(value[name].asUInt64()));
+  }
+}
+
+//////////////////////////////////////////////////
+void CacheServerPrivate::SavePopular() const
+{
+  Json::Value value(Json::objectValue);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (const auto &count : this->popularity)
+      value[count.first] = static_cast<Json::UInt64>(count.second);
+  }
+
+  common::createDirectories(this->archiveDir);
+  std::ofstream out(common::joinPaths(this->archiveDir, "popular.json"));
+  Json::StreamWriterBuilder builder;
+  out << Json::writeString(builder, value);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_FUEL_TOOLS_CACHESERVER_HH_
+#define IGNITION_FUEL_TOOLS_CACHESERVER_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/Export.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class CacheServerPrivate;
+
+    /// \brief Counters describing the activity of a CacheServer.
+    struct IGNITION_FUEL_TOOLS_VISIBLE CacheServerStats
+    {
+      /// \brief Requests received.
+      public: uint64_t requests = 0;
+
+      /// \brief Requests answered without contacting the upstream server.
+      public: uint64_t hits = 0;
+
+      /// \brief Requests which needed the upstream server.
+      public: uint64_t misses = 0;
+
+      /// \brief Requests which waited for an identical upstream request
+      /// already in flight, instead of issuing their own.
+      public: uint64_t coalesced = 0;
+
+      /// \brief Requests sent to the upstream server.
+      public: uint64_t upstreamRequests = 0;
+    };
+
+    /// \brief A caching proxy which speaks the Fuel REST API, so that every
+    /// simulator on a node can share a single local cache. Point the URL of
+    /// a ServerConfig at it to use it.
+    ///
+    /// Model and world archives are kept in an archive directory and are
+    /// also installed into the LocalCache, so clients with direct access to
+    /// the cache find them too. File routes are served from the LocalCache.
+    /// Other routes, such as listings and details, are proxied and kept in
+    /// memory for a short time. Concurrent requests for the same upstream
+    /// resource are coalesced into a single upstream request. Requests
+    /// carrying credentials are always proxied, and nothing fetched with
+    /// credentials is stored, so private resources aren't served to other
+    /// clients.
+    class IGNITION_FUEL_TOOLS_VISIBLE CacheServer
+    {
+      /// \brief Constructor.
+      /// \param[in] _config Client configuration, which determines the
+      /// cache location.
+      /// \param[in] _upstream Server whose routes are cached.
+      public: CacheServer(const ClientConfig &_config,
+          const ServerConfig &_upstream);
+
+      /// \brief Destructor. Stops the server.
+      public: ~CacheServer();
+
+      /// \brief Set the directory where archives are kept. Defaults to
+      /// ".archives" inside the cache location.
+      /// \param[in] _path Directory path.
+      public: void SetArchiveDirectory(const std::string &_path);
+
+      /// \brief Set how long proxied listings and details are kept in memory.
+      /// Defaults to 60 seconds. At most 1024 responses are kept, and
+      /// neither errors nor responses to requests carrying credentials are.
+      /// \param[in] _ttl Time to live.
+      public: void SetTtl(const std::chrono::seconds &_ttl);
+
+      /// \brief Start serving on a TCP port.
+      /// \param[in] _host Address to bind to. E.g.: "127.0.0.1"
+      /// \param[in] _port Port to bind to, or 0 for any free port.
+      /// \return True if the server started.
+      public: bool Start(const std::string &_host, uint16_t _port);
+
+      /// \brief Start serving on a Unix domain socket.
+      /// \param[in] _path Path to the socket file.
+      /// \return True if the server started.
+      public: bool StartUnix(const std::string &_path);
+
+      /// \brief Stop serving, and save the request counts used by
+      /// Popular().
+      public: void Stop();
+
+      /// \brief Base URL of the server, to be used in a ServerConfig.
+      /// \return URL, such as "http://127.0.0.1:8000", or empty if not
+      /// listening on TCP.
+      public: std::string Url() const;
+
+      /// \brief Make sure the archives of the given resources are cached,
+      /// fetching the missing ones in parallel.
+      /// \param[in] _urls Model or world URLs of the upstream server, or
+      /// paths such as "owner/models/name".
+      /// \param[in] _jobs Number of concurrent fetches.
+      /// \return Number of resources which are cached.
+      public: size_t Prewarm(const std::vector<std::string> &_urls,
+          unsigned int _jobs = 4);
+
+      /// \brief Resources requested most often, including requests made
+      /// before the server was last restarted.
+      /// \param[in] _count Maximum number of resources.
+      /// \return Paths such as "owner/models/name", most popular first.
+      public: std::vector<std::string> Popular(size_t _count) const;
+
+      /// \brief Get activity counters.
+      /// \return Counters since the server was created.
+      public: CacheServerStats Stats() const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<CacheServerPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
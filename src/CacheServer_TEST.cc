@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+  #include <arpa/inet.h>
+  #include <netinet/in.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/FuelClient.hh"
+#include "ignition/fuel_tools/RestClient.hh"
+#include "ignition/fuel_tools/Zip.hh"
+
+#include "CacheServer.hh"
+#include "HttpServer.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+#ifndef _WIN32
+/// \brief Send a GET request as is, without the normalization an HTTP
+/// client would apply to the target.
+/// \param[in] _port Server port on 127.0.0.1.
+/// \param[in] _target Request target, such as "/1.0/models".
+/// \return Status line of the response, such as "HTTP/1.1 200 OK".
+static std::string rawGet(uint16_t _port, const std::string &_target)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(_port);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+  std::string answer;
+  std::string request = "GET " + _target +
+      " HTTP/1.1\r\nConnection: close\r\n\r\n";
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+        sizeof(addr)) == 0 &&
+      send(fd, request.data(), request.size(), 0) > 0)
+  {
+    char chunk[1024];
+    ssize_t count;
+    while (answer.find("\r\n") == std::string::npos &&
+        (count = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+    {
+      answer.append(chunk, static_cast<size_t>(count));
+    }
+  }
+  close(fd);
+  return answer.substr(0, answer.find("\r\n"));
+}
+
+/////////////////////////////////////////////////
+/// \brief Fake upstream server with a public model, alice/am1 version 2,
+/// and a private one, bob/secret version 1, which requires the
+/// "Private-Token: secret" header.
+class FakeUpstream
+{
+  /// \brief Constructor. Creates the model archive.
+  /// \param[in] _dir Directory where the archive is created.
+  public: explicit FakeUpstream(const std::string &_dir)
+    : server([this](const HttpRequest &_request, HttpResponse &_response)
+      {
+        this->Handle(_request, _response);
+      })
+  {
+    std::string modelDir = common::joinPaths(_dir, "am1");
+    common::createDirectories(modelDir);
+    {
+      std::ofstream out(common::joinPaths(modelDir, "model.config"));
+      out << "<?xml version=\"1.0\"?><model><name>am1</name></model>";
+    }
+    {
+      std::ofstream out(common::joinPaths(modelDir, "mesh.dae"));
+      out << "mesh";
+    }
+
+    // Compressing files one by one keeps them at the root of the archive.
+    this->archive = common::joinPaths(_dir, "am1.zip");
+    Zip::Compress(common::joinPaths(modelDir, "model.config"), this->archive);
+    Zip::Compress(common::joinPaths(modelDir, "mesh.dae"), this->archive);
+
+    std::ifstream in(this->archive, std::ios::binary);
+    this->archiveData.assign(std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>());
+  }
+
+  /// \brief Answer a request.
+  /// \param[in] _request Request.
+  /// \param[out] _response Response.
+  public: void Handle(const HttpRequest &_request, HttpResponse &_response)
+  {
+    ++this->requests;
+    if (_request.path.find("/1.0/bob/models/secret") == 0)
+    {
+      auto token = _request.headers.find("private-token");
+      if (token == _request.headers.end() || token->second != "secret")
+        _response.status = 401;
+      else if (_request.path == "/1.0/bob/models/secret")
+        _response.body = "{\"name\":\"secret\",\"version\":1}";
+      else if (_request.path == "/1.0/bob/models/secret/1/secret.zip")
+        _response.file = this->archive;
+      else
+        _response.status = 404;
+    }
+    else if (_request.path == "/1.0/alice/models/am1")
+    {
+      _response.body = "{\"name\":\"am1\",\"owner\":\"alice\",\"version\":2}";
+      _response.headers["Content-Type"] = "application/json";
+    }
+    else if (_request.path == "/1.0/alice/models/am1/2/am1.zip")
+    {
+      ++this->archiveRequests;
+      // Give concurrent requests time to pile up.
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      _response.file = this->archive;
+      _response.headers["X-Ign-Resource-Version"] = "2";
+    }
+    else if (_request.path == "/1.0/models")
+    {
+      _response.body = "[{\"name\":\"am1\",\"owner\":\"alice\"}]";
+      _response.headers["Content-Type"] = "application/json";
+    }
+    else
+    {
+      _response.status = 404;
+    }
+  }
+
+  /// \brief Path to the model archive.
+  public: std::string archive;
+
+  /// \brief Content of the model archive.
+  public: std::string archiveData;
+
+  /// \brief Number of requests received.
+  public: std::atomic<int> requests{0};
+
+  /// \brief Number of archive requests received.
+  public: std::atomic<int> archiveRequests{0};
+
+  /// \brief HTTP server.
+  public: HttpServer server;
+};
+
+/////////////////////////////////////////////////
+TEST(CacheServer, Archive)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_cache_server");
+  common::removeAll(root);
+  FakeUpstream upstream(common::joinPaths(root, "upstream"));
+  ASSERT_TRUE(upstream.server.Start("127.0.0.1", 0));
+
+  ServerConfig upstreamConfig;
+  upstreamConfig.SetUrl(common::URI(upstream.server.Url()));
+
+  ClientConfig serverConf;
+  serverConf.SetCacheLocation(common::joinPaths(root, "shared"));
+  CacheServer cacheServer(serverConf, upstreamConfig);
+  ASSERT_TRUE(cacheServer.Start("127.0.0.1", 0));
+  ASSERT_FALSE(cacheServer.Url().empty());
+
+  // Concurrent requests for the same archive reach the upstream server once.
+  std::vector<std::thread> threads;
+  std::atomic<int> ok{0};
+  for (int i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&]()
+    {
+      Rest rest;
+      auto resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0",
+          "alice/models/am1/tip/am1.zip", {}, {}, "");
+      if (resp.statusCode == 200 && resp.data == upstream.archiveData)
+        ++ok;
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_EQ(4, ok);
+  EXPECT_EQ(1, upstream.archiveRequests);
+
+  auto stats = cacheServer.Stats();
+  EXPECT_EQ(4u, stats.requests);
+  EXPECT_LE(3u, stats.coalesced);
+
+  // The model was installed into the shared cache.
+  std::string host = common::URI(upstream.server.Url()).Path().Str();
+  EXPECT_TRUE(common::isFile(common::joinPaths(root, "shared", host,
+      "alice", "models", "am1", "2", "model.config")));
+
+  // A client pointed at the cache server downloads from it.
+  ServerConfig proxyConfig;
+  proxyConfig.SetUrl(common::URI(cacheServer.Url()));
+  ClientConfig clientConf;
+  clientConf.SetCacheLocation(common::joinPaths(root, "client"));
+  clientConf.AddServer(proxyConfig);
+  FuelClient client(clientConf);
+
+  std::string path;
+  EXPECT_TRUE(client.DownloadModel(
+      common::URI(cacheServer.Url() + "/1.0/alice/models/am1"), path));
+  EXPECT_TRUE(common::isFile(common::joinPaths(path, "mesh.dae")));
+  EXPECT_EQ(1, upstream.archiveRequests);
+
+  // Files are served from the shared cache.
+  Rest rest;
+  auto resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0",
+      "alice/models/am1/2/files/mesh.dae", {}, {}, "");
+  EXPECT_EQ(200, resp.statusCode);
+  EXPECT_EQ("mesh", resp.data);
+
+  // Paths can't walk out of the cache, whether encoded or not.
+  uint16_t port = static_cast<uint16_t>(
+      std::stoi(cacheServer.Url().substr(cacheServer.Url().rfind(':') + 1)));
+  EXPECT_EQ("HTTP/1.1 200 OK",
+      rawGet(port, "/1.0/alice/models/am1/2/files/mesh.dae"));
+  std::vector<std::string> ups = {"../", "%2e%2e/", "%2E%2E%2F"};
+  for (const auto &up : ups)
+  {
+    std::string target = "/1.0/alice/models/am1/2/files/";
+    for (int i = 0; i < 8; ++i)
+      target += up;
+    EXPECT_EQ("HTTP/1.1 404 Not Found", rawGet(port, target + "etc/passwd"))
+        << target;
+    EXPECT_EQ("HTTP/1.1 404 Not Found",
+        rawGet(port, "/1.0/" + up + "models/am1/2/am1.zip")) << up;
+  }
+
+  // Listings are proxied, and kept in memory.
+  int before = upstream.requests;
+  for (int i = 0; i < 2; ++i)
+  {
+    resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0", "models",
+        {}, {}, "");
+    EXPECT_EQ(200, resp.statusCode);
+    EXPECT_NE(std::string::npos, resp.data.find("am1"));
+  }
+  EXPECT_EQ(before + 1, upstream.requests);
+
+  // Errors and responses to requests with credentials aren't kept.
+  before = upstream.requests;
+  for (int i = 0; i < 2; ++i)
+  {
+    resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0", "models",
+        {}, {"Private-Token: secret"}, "");
+    EXPECT_EQ(200, resp.statusCode);
+    resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0",
+        "bob/models/missing", {}, {}, "");
+    EXPECT_EQ(404, resp.statusCode);
+  }
+  EXPECT_EQ(before + 4, upstream.requests);
+
+  // Private archives fetched with credentials aren't kept, so they aren't
+  // served to requests without them.
+  resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0",
+      "bob/models/secret/1/secret.zip", {}, {"Private-Token: secret"}, "");
+  EXPECT_EQ(200, resp.statusCode);
+  EXPECT_EQ(upstream.archiveData, resp.data);
+  EXPECT_FALSE(common::exists(common::joinPaths(root, "shared", host, "bob")));
+  EXPECT_FALSE(common::exists(common::joinPaths(root, "shared", ".archives",
+      host, "bob")));
+  for (const auto &target : {"bob/models/secret/1/secret.zip",
+      "bob/models/secret/tip/secret.zip",
+      "bob/models/secret/1/files/mesh.dae"})
+  {
+    resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0", target,
+        {}, {}, "");
+    EXPECT_EQ(401, resp.statusCode) << target;
+  }
+
+  // Only reads are allowed.
+  resp = rest.Request(HttpMethod::DELETE, cacheServer.Url(), "1.0",
+      "alice/models/am1", {}, {}, "");
+  EXPECT_EQ(405, resp.statusCode);
+
+  auto popular = cacheServer.Popular(10);
+  ASSERT_EQ(1u, popular.size());
+  EXPECT_EQ("alice/models/am1", popular[0]);
+
+  cacheServer.Stop();
+  upstream.server.Stop();
+}
+
+/////////////////////////////////////////////////
+TEST(CacheServer, OfflineAndPrewarm)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_cache_server_offline");
+  common::removeAll(root);
+  FakeUpstream upstream(common::joinPaths(root, "upstream"));
+  ASSERT_TRUE(upstream.server.Start("127.0.0.1", 0));
+
+  ServerConfig upstreamConfig;
+  upstreamConfig.SetUrl(common::URI(upstream.server.Url()));
+
+  ClientConfig serverConf;
+  serverConf.SetCacheLocation(common::joinPaths(root, "shared"));
+  CacheServer cacheServer(serverConf, upstreamConfig);
+
+  EXPECT_EQ(1u, cacheServer.Prewarm({"alice/models/am1",
+      "alice/models/missing", "not-a-model"}));
+  EXPECT_EQ(1, upstream.archiveRequests);
+
+  // Cached archives are still served once the upstream server is gone, and
+  // "tip" falls back to the latest cached version.
+  upstream.server.Stop();
+  ASSERT_TRUE(cacheServer.Start("127.0.0.1", 0));
+
+  Rest rest;
+  auto resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0",
+      "alice/models/am1/tip/am1.zip", {}, {}, "");
+  EXPECT_EQ(200, resp.statusCode);
+
+  resp = rest.Request(HttpMethod::GET, cacheServer.Url(), "1.0", "models",
+      {}, {}, "");
+  EXPECT_EQ(502, resp.statusCode);
+
+  // Request counts survive restarts.
+  cacheServer.Stop();
+  CacheServer restarted(serverConf, upstreamConfig);
+  ASSERT_TRUE(restarted.Start("127.0.0.1", 0));
+  auto popular = restarted.Popular(1);
+  ASSERT_EQ(1u, popular.size());
+  EXPECT_EQ("alice/models/am1", popular[0]);
+}
+#endif
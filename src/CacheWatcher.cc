@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef __linux__
+  #include <poll.h>
+  #include <sys/inotify.h>
+  #include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+#include <ignition/common/StringUtils.hh>
+
+#include "CacheWatcher.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Depth of versioned directories below the cache directory:
+/// <server>/<owner>/<type>/<name>/<version>.
+static const int kVersionDepth = 5;
+
+class ignition::fuel_tools::CacheWatcherPrivate
+{
+#ifdef __linux__
+  /// \brief A watched directory.
+  public: struct Watch
+  {
+    /// \brief Path of the directory.
+    std::string path;
+
+    /// \brief Depth below the cache directory.
+    int depth;
+  };
+
+  /// \brief Watch a directory and the directories below it, down to the
+  /// versioned directories.
+  /// \param[in] _path Directory to watch.
+  /// \param[in] _depth Depth of the directory below the cache directory.
+  /// \param[in] _report Report complete versions found as installed.
+  public: void AddTree(const std::string &_path, int _depth, bool _report);
+
+  /// \brief Handle an inotify event.
+  /// \param[in] _event The event.
+  public: void Handle(const struct inotify_event &_event);
+
+  /// \brief Report a change of a versioned directory.
+  /// \param[in] _type Kind of change.
+  /// \param[in] _path Versioned directory.
+  public: void Report(CacheEventType _type, const std::string &_path);
+
+  /// \brief Read and handle events until asked to stop.
+  public: void Run();
+
+  /// \brief inotify file descriptor.
+  public: int fd = -1;
+
+  /// \brief Pipe written to stop the thread.
+  public: int stopPipe[2] = {-1, -1};
+
+  /// \brief Watched directories, by watch descriptor.
+  public: std::map<int, Watch> watches;
+
+  /// \brief Versioned directories known to be complete.
+  public: std::set<std::string> complete;
+
+  /// \brief Complete versioned directories being saved again.
+  public: std::set<std::string> updating;
+
+  /// \brief Watching thread.
+  public: std::thread thread;
+#endif
+
+  /// \brief Cache directory.
+  public: std::string root;
+
+  /// \brief Function called with each change.
+  public: CacheWatcher::Callback callback;
+};
+
+#ifdef __linux__
+//////////////////////////////////////////////////
+/// \brief Parse the name of a versioned directory, without throwing.
+/// \param[in] _name Name of the directory.
+/// \param[out] _version Version number.
+/// \return False if the name isn't a number which fits in an unsigned int.
+static bool parseVersion(const std::string &_name, unsigned int &_version)
+{
+  if (_name.empty())
+    return false;
+
+  uint64_t value{0};
+  for (char c : _name)
+  {
+    if (c < '0' || c > '9')
+      return false;
+    value = value * 10 + static_cast<uint64_t>(c - '0');
+    if (value > std::numeric_limits<unsigned int>::max())
+      return false;
+  }
+  _version = static_cast<unsigned int>(value);
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Check if a name is valid for a directory at a given depth below
+/// the cache directory.
+/// \param[in] _name Name of the directory.
+/// \param[in] _depth Depth of the directory.
+/// \return True if the directory is part of the cache layout.
+static bool validDir(const std::string &_name, int _depth)
+{
+  if (_name.empty() || _name[0] == '.')
+    return false;
+  if (_depth == 3)
+    return _name == "models" || _name == "worlds";
+  unsigned int version;
+  if (_depth == kVersionDepth)
+    return parseVersion(_name, version);
+  return _depth < kVersionDepth;
+}
+
+//////////////////////////////////////////////////
+/// \brief Check if a versioned directory holds a complete version, which
+/// isn't empty, isn't being extracted and isn't partial.
+/// \param[in] _path Versioned directory.
+/// \return True if complete.
+static bool completeVersion(const std::string &_path)
+{
+  std::string name = common::basename(common::parentPath(_path));
+  common::DirIter end;
+  return common::isDirectory(_path) && common::DirIter(_path) != end &&
+      !common::exists(common::joinPaths(_path, ".partial")) &&
+      !common::exists(common::joinPaths(_path, name + ".zip"));
+}
+
+//////////////////////////////////////////////////
+void CacheWatcherPrivate::AddTree(const std::string &_path, int _depth,
+    bool _report)
+{
+  int wd = inotify_add_watch(this->fd, _path.c_str(),
+      IN_ONLYDIR | IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM);
+  if (wd < 0)
+  {
+    ignwarn << "Unable to watch [" << _path << "]: " << std::strerror(errno)
+            << std::endl;
+    return;
+  }
+  this->watches[wd] = {_path, _depth};
+
+  if (_depth == kVersionDepth)
+  {
+    if (completeVersion(_path) && this->complete.insert(_path).second &&
+        _report)
+    {
+      this->Report(CacheEventType::INSTALLED, _path);
+    }
+    return;
+  }
+
+  // Directories created before the watch was added.
+  common::DirIter end;
+  for (common::DirIter iter(_path); iter != end; ++iter)
+  {
+    if (common::isDirectory(*iter) &&
+        validDir(common::basename(*iter), _depth + 1))
+    {
+      this->AddTree(*iter, _depth + 1, _report);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void CacheWatcherPrivate::Handle(const struct inotify_event &_event)
+{
+  if (_event.mask & IN_Q_OVERFLOW)
+  {
+    ignwarn << "Too many changes to [" << this->root << "], some weren't "
+            << "reported" << std::endl;
+    return;
+  }
+
+  auto it = this->watches.find(_event.wd);
+  if (it == this->watches.end())
+    return;
+
+  if (_event.mask & IN_IGNORED)
+  {
+    this->watches.erase(it);
+    return;
+  }
+
+  const Watch watch = it->second;
+  std::string name = _event.len > 0 ? _event.name : "";
+  std::string path = common::joinPaths(watch.path, name);
+
+  if (watch.depth == kVersionDepth)
+  {
+    // A version is complete once it has files, and its archive and partial
+    // marker are gone. Saving it again brings the archive back.
+    if (completeVersion(watch.path))
+    {
+      if (this->updating.erase(watch.path))
+        this->Report(CacheEventType::UPDATED, watch.path);
+      else if (this->complete.insert(watch.path).second)
+        this->Report(CacheEventType::INSTALLED, watch.path);
+    }
+    else if ((_event.mask & (IN_CREATE | IN_MOVED_TO)) &&
+        this->complete.count(watch.path))
+    {
+      this->updating.insert(watch.path);
+    }
+    return;
+  }
+
+  if (!(_event.mask & IN_ISDIR) || !validDir(name, watch.depth + 1))
+    return;
+
+  if (_event.mask & (IN_CREATE | IN_MOVED_TO))
+  {
+    this->AddTree(path, watch.depth + 1, true);
+  }
+  else if (watch.depth + 1 == kVersionDepth && this->complete.erase(path))
+  {
+    this->updating.erase(path);
+    this->Report(CacheEventType::REMOVED, path);
+  }
+}
+
+//////////////////////////////////////////////////
+void CacheWatcherPrivate::Report(CacheEventType _type,
+    const std::string &_path)
+{
+  CacheEvent event;
+  event.type = _type;
+  event.external = true;
+  event.entry.path = _path;
+
+  std::string dir = _path;
+  if (!parseVersion(common::basename(dir), event.entry.version))
+    return;
+  dir = common::parentPath(dir);
+  event.entry.name = common::basename(dir);
+  dir = common::parentPath(dir);
+  event.entry.type = common::basename(dir);
+  dir = common::parentPath(dir);
+  event.entry.owner = common::basename(dir);
+  event.entry.server = common::basename(common::parentPath(dir));
+
+  this->callback(event);
+}
+
+//////////////////////////////////////////////////
+void CacheWatcherPrivate::Run()
+{
+  alignas(struct inotify_event) char buffer[16384];
+  struct pollfd fds[2] = {{this->fd, POLLIN, 0},
+                          {this->stopPipe[0], POLLIN, 0}};
+
+  while (true)
+  {
+    if (poll(fds, 2, -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      ignerr << "Unable to wait for changes to [" << this->root << "]: "
+             << std::strerror(errno) << std::endl;
+      return;
+    }
+
+    if (fds[1].revents)
+      return;
+
+    ssize_t length = read(this->fd, buffer, sizeof(buffer));
+    for (ssize_t offset = 0; offset < length;)
+    {
+      const auto *event =
+          reinterpret_cast<const struct inotify_event *>(buffer + offset);
+      this->Handle(*event);
+      offset += sizeof(struct inotify_event) + event->len;
+    }
+  }
+}
+#endif
+
+//////////////////////////////////////////////////
+CacheWatcher::CacheWatcher(const std::string &_root,
+    const Callback &_callback)
+  : dataPtr(new CacheWatcherPrivate)
+{
+  this->dataPtr->root = _root;
+  this->dataPtr->callback = _callback;
+
+#ifdef __linux__
+  common::createDirectories(_root);
+
+  this->dataPtr->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (this->dataPtr->fd < 0 || pipe(this->dataPtr->stopPipe) != 0)
+  {
+    ignerr << "Unable to watch [" << _root << "]: " << std::strerror(errno)
+           << std::endl;
+    return;
+  }
+
+  this->dataPtr->AddTree(_root, 0, false);
+  if (this->dataPtr->watches.empty())
+    return;
+
+  this->dataPtr->thread = std::thread(&CacheWatcherPrivate::Run,
+      this->dataPtr.get());
+#endif
+}
+
+//////////////////////////////////////////////////
+CacheWatcher::~CacheWatcher()
+{
+#ifdef __linux__
+  if (this->dataPtr->thread.joinable())
+  {
+    char stop = 0;
+    while (write(this->dataPtr->stopPipe[1], &stop, 1) < 0 && errno == EINTR)
+    {
+    }
+    this->dataPtr->thread.join();
+  }
+
+  for (int fd : {this->dataPtr->fd, this->dataPtr->stopPipe[0],
+      this->dataPtr->stopPipe[1]})
+  {
+    if (fd >= 0)
+      close(fd);
+  }
+#endif
+}
+
+//////////////////////////////////////////////////
+bool CacheWatcher::Active() const
+{
+#ifdef __linux__
+  return this->dataPtr->thread.joinable();
+#else
+  return false;
+#endif
+}
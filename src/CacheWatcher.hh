@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_CACHEWATCHER_HH_
+#define IGNITION_FUEL_TOOLS_CACHEWATCHER_HH_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "ignition/fuel_tools/Export.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class CacheWatcherPrivate;
+
+    /// \brief Watches a cache directory for model and world versions
+    /// installed, updated or removed by other processes. On Linux, the
+    /// directories of the cache are watched with inotify, down to the
+    /// versioned directories. A version is installed once it has files,
+    /// and the archive it's extracted from and its partial marker are gone.
+    /// Directories whose name starts with a dot, such as saved listings and
+    /// staged versions, are ignored. Other platforms aren't supported.
+    class IGNITION_FUEL_TOOLS_VISIBLE CacheWatcher
+    {
+      /// \brief Function called with each change.
+      public: using Callback = std::function<void(const CacheEvent &)>;
+
+      /// \brief Constructor. Starts watching, and returns once the versions
+      /// already in the cache are known, so later changes aren't missed.
+      /// \param[in] _root Cache directory, created if it doesn't exist.
+      /// \param[in] _callback Function called from the watching thread.
+      public: CacheWatcher(const std::string &_root,
+          const Callback &_callback);
+
+      /// \brief Destructor. Stops the watching thread.
+      public: ~CacheWatcher();
+
+      /// \brief True if the directory is being watched.
+      /// \return False if not supported, or if watching failed.
+      public: bool Active() const;
+
+      /// \brief Private data.
+      private: std::unique_ptr<CacheWatcherPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
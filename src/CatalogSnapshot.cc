@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+#include <ignition/common/StringUtils.hh>
+
+#include "ignition/fuel_tools/CatalogSnapshot.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Identifies snapshot files.
+static const char kSnapshotMagic[8] = {'I', 'G', 'N', 'F', 'C', 'A', 'T', 0};
+
+/// \brief Version of the snapshot format.
+static const uint32_t kSnapshotVersion = 1;
+
+/// \brief Written in the byte order of the writer, to reject files from
+/// machines with another byte order.
+static const uint32_t kByteOrderMark = 0x01020304;
+
+namespace
+{
+  /// \brief Location of a string in the string table.
+  struct StringRef
+  {
+    /// \brief Offset from the start of the string table.
+    uint32_t offset;
+
+    /// \brief Length in bytes.
+    uint32_t size;
+  };
+
+  /// \brief Start of a snapshot file.
+  struct Header
+  {
+    /// \brief kSnapshotMagic.
+    char magic[8];
+
+    /// \brief kSnapshotVersion.
+    uint32_t version;
+
+    /// \brief kByteOrderMark.
+    uint32_t byteOrder;
+
+    /// \brief When the snapshot was written, in seconds since the epoch.
+    int64_t saved;
+
+    /// \brief Number of records.
+    uint64_t count;
+
+    /// \brief Offset of the records from the start of the file.
+    uint64_t recordsOffset;
+
+    /// \brief Offset of the string table from the start of the file.
+    uint64_t stringsOffset;
+
+    /// \brief Size of the string table.
+    uint64_t stringsSize;
+  };
+
+  /// \brief A model.
+  struct Record
+  {
+    /// \brief Name.
+    StringRef name;
+
+    /// \brief Owner.
+    StringRef owner;
+
+    /// \brief Description.
+    StringRef description;
+
+    /// \brief License name.
+    StringRef licenseName;
+
+    /// \brief License URL.
+    StringRef licenseUrl;
+
+    /// \brief License image URL.
+    StringRef licenseImage;
+
+    /// \brief Tags, separated by newlines.
+    StringRef tags;
+
+    /// \brief Version.
+    uint32_t version;
+
+    /// \brief Like count.
+    uint32_t likes;
+
+    /// \brief Download count.
+    uint32_t downloads;
+
+    /// \brief File size.
+    uint32_t fileSize;
+
+    /// \brief Upload date.
+    int64_t uploadDate;
+
+    /// \brief Modify date.
+    int64_t modifyDate;
+  };
+}
+
+/// \brief Private data class
+class ignition::fuel_tools::CatalogSnapshotPrivate
+{
+  /// \brief Unmap the file, if any.
+  public: void Close();
+
+  /// \brief Get a string from the string table.
+  /// \param[in] _ref Location of the string.
+  /// \param[out] _str The string.
+  /// \return False if the location is outside the table.
+  public: bool String(const StringRef &_ref, std::string &_str) const;
+
+  /// \brief Start of the file.
+  public: const char *data = nullptr;
+
+  /// \brief Size of the file.
+  public: size_t size = 0;
+
+  /// \brief Header, pointing into data.
+  public: const Header *header = nullptr;
+
+  /// \brief Records, pointing into data.
+  public: const Record *records = nullptr;
+
+  /// \brief String table, pointing into data.
+  public: const char *strings = nullptr;
+
+#ifdef _WIN32
+  /// \brief Content of the file, where it can't be mapped.
+  public: std::vector<char> buffer;
+#endif
+};
+
+//////////////////////////////////////////////////
+void CatalogSnapshotPrivate::Close()
+{
+#ifndef _WIN32
+  if (this->data)
+    munmap(const_cast<char *>(this->data), this->size);
+#else
+  this->buffer.clear();
+#endif
+  this->data = nullptr;
+  this->size = 0;
+  this->header = nullptr;
+  this->records = nullptr;
+  this->strings = nullptr;
+}
+
+//////////////////////////////////////////////////
+bool CatalogSnapshotPrivate::String(const StringRef &_ref,
+    std::string &_str) const
+{
+  if (static_cast<uint64_t>(_ref.offset) + _ref.size >
+      this->header->stringsSize)
+  {
+    return false;
+  }
+  _str.assign(this->strings + _ref.offset, _ref.size);
+  return true;
+}
+
+//////////////////////////////////////////////////
+CatalogSnapshot::CatalogSnapshot()
+  : dataPtr(new CatalogSnapshotPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+CatalogSnapshot::~CatalogSnapshot()
+{
+  this->dataPtr->Close();
+}
+
+//////////////////////////////////////////////////
+bool CatalogSnapshot::Write(const std::string &_path,
+    const std::vector<ModelIdentifier> &_ids)
+{
+  // Owners and licenses repeat a lot, so identical strings are stored once.
+  std::string strings;
+  std::unordered_map<std::string, StringRef> refs;
+  auto add = [&](const std::string &_str)
+  {
+    auto it = refs.find(_str);
+    if (it != refs.end())
+      return it->second;
+
+    StringRef ref{static_cast<uint32_t>(strings.size()),
+        static_cast<uint32_t>(_str.size())};
+    strings += _str;
+    refs[_str] = ref;
+    return ref;
+  };
+
+  std::vector<Record> records;
+  records.reserve(_ids.size());
+  for (const auto &id : _ids)
+  {
+    std::string tags;
+    for (const auto &tag : id.Tags())
+      tags += (tags.empty() ? "" : "\n") + tag;
+
+    Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.name = add(id.Name());
+    record.owner = add(id.Owner());
+    record.description = add(id.Description());
+    record.licenseName = add(id.LicenseName());
+    record.licenseUrl = add(id.LicenseUrl());
+    record.licenseImage = add(id.LicenseImageUrl());
+    record.tags = add(tags);
+    record.version = id.Version();
+    record.likes = id.LikeCount();
+    record.downloads = id.DownloadCount();
+    record.fileSize = id.FileSize();
+    record.uploadDate = id.UploadDate();
+    record.modifyDate = id.ModifyDate();
+    records.push_back(record);
+  }
+
+  if (strings.size() > UINT32_MAX)
+  {
+    ignerr << "Catalog too large for a snapshot [" << _path << "]"
+           << std::endl;
+    return false;
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+  header.version = kSnapshotVersion;
+  header.byteOrder = kByteOrderMark;
+  header.saved = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  header.count = records.size();
+  header.recordsOffset = sizeof(Header);
+  header.stringsOffset = header.recordsOffset + records.size() *
+      sizeof(Record);
+  header.stringsSize = strings.size();
+
+  common::createDirectories(common::parentPath(_path));
+  std::string tmpPath = _path + "." + std::to_string(
+      std::random_device()()) + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(records.data()),
+        records.size() * sizeof(Record));
+    out.write(strings.data(), strings.size());
+    if (!out.good())
+    {
+      ignerr << "Unable to write snapshot [" << tmpPath << "]" << std::endl;
+      common::removeFile(tmpPath);
+      return false;
+    }
+  }
+  return common::moveFile(tmpPath, _path);
+}
+
+//////////////////////////////////////////////////
+bool CatalogSnapshot::Open(const std::string &_path)
+{
+  this->dataPtr->Close();
+
+#ifndef _WIN32
+  int fd = open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(Header))
+  {
+    close(fd);
+    return false;
+  }
+
+  // The mapping stays valid after the file is closed, or replaced.
+  void *addr = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    ignwarn << "Unable to map snapshot [" << _path << "]" << std::endl;
+    return false;
+  }
+  this->dataPtr->data = static_cast<const char *>(addr);
+  this->dataPtr->size = info.st_size;
+#else
+  std::ifstream in(_path, std::ios::binary);
+  this->dataPtr->buffer.assign(std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>());
+  if (this->dataPtr->buffer.size() < sizeof(Header))
+  {
+    this->dataPtr->buffer.clear();
+    return false;
+  }
+  this->dataPtr->data = this->dataPtr->buffer.data();
+  this->dataPtr->size = this->dataPtr->buffer.size();
+#endif
+
+  // Only the header is checked, so opening doesn't read the whole file.
+  auto header = reinterpret_cast<const Header *>(this->dataPtr->data);
+  uint64_t size = this->dataPtr->size;
+  if (std::memcmp(header->magic, kSnapshotMagic, sizeof(header->magic)) != 0 ||
+      header->version != kSnapshotVersion ||
+      header->byteOrder != kByteOrderMark ||
+      header->recordsOffset % alignof(Record) != 0u ||
+      header->recordsOffset > size ||
+      header->count > (size - header->recordsOffset) / sizeof(Record) ||
+      header->stringsOffset > size ||
+      header->stringsSize > size - header->stringsOffset)
+  {
+    ignwarn << "Invalid snapshot [" << _path << "]" << std::endl;
+    this->dataPtr->Close();
+    return false;
+  }
+
+  this->dataPtr->header = header;
+  this->dataPtr->records = reinterpret_cast<const Record *>(
+      this->dataPtr->data + header->recordsOffset);
+  this->dataPtr->strings = this->dataPtr->data + header->stringsOffset;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool CatalogSnapshot::Valid() const
+{
+  return this->dataPtr->header != nullptr;
+}
+
+//////////////////////////////////////////////////
+size_t CatalogSnapshot::Size() const
+{
+  return this->dataPtr->header ? this->dataPtr->header->count : 0u;
+}
+
+//////////////////////////////////////////////////
+std::chrono::system_clock::time_point CatalogSnapshot::Saved() const
+{
+  if (!this->dataPtr->header)
+    return std::chrono::system_clock::time_point();
+  return std::chrono::system_clock::time_point(
+      std::chrono::seconds(this->dataPtr->header->saved));
+}
+
+//////////////////////////////////////////////////
+bool CatalogSnapshot::At(size_t _index, ModelIdentifier &_id) const
+{
+  if (_index >= this->Size())
+    return false;
+
+  const Record &record = this->dataPtr->records[_index];
+  std::string name, owner, description, licenseName, licenseUrl,
+      licenseImage, tags;
+  if (!this->dataPtr->String(record.name, name) ||
+      !this->dataPtr->String(record.owner, owner) ||
+      !this->dataPtr->String(record.description, description) ||
+      !this->dataPtr->String(record.licenseName, licenseName) ||
+      !this->dataPtr->String(record.licenseUrl, licenseUrl) ||
+      !this->dataPtr->String(record.licenseImage, licenseImage) ||
+      !this->dataPtr->String(record.tags, tags))
+  {
+    return false;
+  }
+
+  _id = ModelIdentifier();
+  _id.SetName(name);
+  _id.SetOwner(owner);
+  _id.SetDescription(description);
+  _id.SetLicenseName(licenseName);
+  _id.SetLicenseUrl(licenseUrl);
+  _id.SetLicenseImageUrl(licenseImage);
+  _id.SetTags(tags.empty() ? std::vector<std::string>() :
+      common::Split(tags, '\n'));
+  _id.SetVersion(record.version);
+  _id.SetLikeCount(record.likes);
+  _id.SetDownloadCount(record.downloads);
+  _id.SetFileSize(record.fileSize);
+  _id.SetUploadDate(record.uploadDate);
+  _id.SetModifyDate(record.modifyDate);
+  return true;
+}
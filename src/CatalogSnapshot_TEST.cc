@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/CatalogSnapshot.hh"
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+#include "ignition/fuel_tools/ModelIter.hh"
+#include "ignition/fuel_tools/ModelIterPrivate.hh"
+
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+/// \brief Create a fully populated model identifier.
+ModelIdentifier makeModel(const std::string &_name, uint32_t _downloads)
+{
+  ModelIdentifier id;
+  id.SetOwner("alice");
+  id.SetName(_name);
+  id.SetDescription("The " + _name + " model");
+  id.SetLicenseName("MIT");
+  id.SetLicenseUrl("https://opensource.org/licenses/MIT");
+  id.SetLicenseImageUrl("");
+  id.SetTags({"tools", "red"});
+  id.SetVersion(3);
+  id.SetLikeCount(7);
+  id.SetDownloadCount(_downloads);
+  id.SetFileSize(1234);
+  id.SetUploadDate(1000);
+  id.SetModifyDate(2000);
+  return id;
+}
+
+/////////////////////////////////////////////////
+TEST(CatalogSnapshot, WriteOpen)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_catalog_snapshot");
+  common::removeAll(root);
+  std::string path = common::joinPaths(root, "models.snapshot");
+
+  CatalogSnapshot snapshot;
+  EXPECT_FALSE(snapshot.Valid());
+  EXPECT_EQ(0u, snapshot.Size());
+  EXPECT_FALSE(snapshot.Open(path));
+
+  std::vector<ModelIdentifier> ids = {makeModel("Drill", 5),
+      makeModel("Hammer", 6)};
+  ids.push_back(ModelIdentifier());
+  ASSERT_TRUE(CatalogSnapshot::Write(path, ids));
+
+  ASSERT_TRUE(snapshot.Open(path));
+  EXPECT_TRUE(snapshot.Valid());
+  ASSERT_EQ(3u, snapshot.Size());
+  EXPECT_LE(std::chrono::system_clock::now() - snapshot.Saved(),
+      std::chrono::seconds(60));
+
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    ModelIdentifier id;
+    ASSERT_TRUE(snapshot.At(i, id));
+    EXPECT_EQ(ids[i].Name(), id.Name());
+    EXPECT_EQ(ids[i].Owner(), id.Owner());
+    EXPECT_EQ(ids[i].Description(), id.Description());
+    EXPECT_EQ(ids[i].LicenseName(), id.LicenseName());
+    EXPECT_EQ(ids[i].LicenseUrl(), id.LicenseUrl());
+    EXPECT_EQ(ids[i].LicenseImageUrl(), id.LicenseImageUrl());
+    EXPECT_EQ(ids[i].Tags(), id.Tags());
+    EXPECT_EQ(ids[i].Version(), id.Version());
+    EXPECT_EQ(ids[i].LikeCount(), id.LikeCount());
+    EXPECT_EQ(ids[i].DownloadCount(), id.DownloadCount());
+    EXPECT_EQ(ids[i].FileSize(), id.FileSize());
+    EXPECT_EQ(ids[i].UploadDate(), id.UploadDate());
+    EXPECT_EQ(ids[i].ModifyDate(), id.ModifyDate());
+  }
+  ModelIdentifier id;
+  EXPECT_FALSE(snapshot.At(3, id));
+
+  // Replacing the file doesn't affect the open snapshot.
+  ASSERT_TRUE(CatalogSnapshot::Write(path, {makeModel("Saw", 1)}));
+  EXPECT_EQ(3u, snapshot.Size());
+  ASSERT_TRUE(snapshot.At(1, id));
+  EXPECT_EQ("Hammer", id.Name());
+
+  CatalogSnapshot other;
+  ASSERT_TRUE(other.Open(path));
+  EXPECT_EQ(1u, other.Size());
+
+  // Files which aren't snapshots, or are truncated, are rejected.
+  std::ofstream(path) << "not a snapshot";
+  EXPECT_FALSE(other.Open(path));
+  EXPECT_FALSE(other.Valid());
+
+  ASSERT_TRUE(CatalogSnapshot::Write(path, ids));
+  std::string data;
+  {
+    std::ifstream in(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>());
+  }
+  std::ofstream(path, std::ios::binary | std::ios::trunc)
+      << data.substr(0, data.size() / 2);
+  EXPECT_FALSE(other.Open(path));
+
+  common::removeAll(root);
+}
+
+/////////////////////////////////////////////////
+TEST(CatalogSnapshot, Iterate)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_catalog_snapshot_iter");
+  common::removeAll(root);
+
+  ServerConfig server;
+  server.SetUrl(common::URI("http://example.com"));
+  ClientConfig config;
+  config.SetCacheLocation(root);
+  config.AddServer(server);
+
+  LocalCache cache(&config);
+  EXPECT_EQ(nullptr, cache.ModelSnapshot(server));
+
+  // Only the whole catalog is written as a snapshot.
+  ASSERT_TRUE(cache.SaveModelListing(server, "alice/models",
+      {makeModel("Drill", 5)}));
+  EXPECT_EQ(nullptr, cache.ModelSnapshot(server));
+  ASSERT_TRUE(cache.SaveModelListing(server, "models",
+      {makeModel("Drill", 5), makeModel("Hammer", 6)}));
+
+  auto snapshot = cache.ModelSnapshot(server);
+  ASSERT_NE(nullptr, snapshot);
+  std::vector<std::string> names;
+  for (auto iter = ModelIterFactory::Create(snapshot, server); iter; ++iter)
+  {
+    names.push_back(iter->Identification().Name());
+    EXPECT_EQ(server.Url().Str(),
+        iter->Identification().Server().Url().Str());
+  }
+  EXPECT_EQ(std::vector<std::string>({"Drill", "Hammer"}), names);
+
+  auto empty = std::make_shared<CatalogSnapshot>();
+  EXPECT_FALSE(ModelIterFactory::Create(empty, server));
+
+  common::removeAll(root);
+}
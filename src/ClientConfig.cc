@@ -16,6 +16,7 @@
 */
 
 #include <yaml.h>
+#include <algorithm>
 #include <cstdio>
 #include <sstream>
 #include <stack>
@@ -68,6 +69,30 @@ class ignition::fuel_tools::ClientConfigPrivate
   /// \brief Name of the user agent.
   public: std::string userAgent =
           "IgnitionFuelTools-" IGNITION_FUEL_TOOLS_VERSION_FULL;
+
+  /// \brief Whether model files are fetched on their own.
+  public: bool lazyFileFetch = false;
+
+  /// \brief Path to a lockfile pinning resource versions.
+  public: std::string lockfilePath = "";
+
+  /// \brief Whether new model versions are assembled from the previous one.
+  public: bool deltaUpdates = true;
+
+  /// \brief How model listings are answered.
+  public: ListingPolicy listingPolicy = ListingPolicy::CACHE_FIRST;
+
+  /// \brief How long saved listings are fresh.
+  public: std::chrono::seconds listingTtl{300};
+
+  /// \brief Directory of the hot tier of the cache.
+  public: std::string hotCacheLocation = "";
+
+  /// \brief Maximum size of the hot tier, in bytes.
+  public: uint64_t hotCacheCapacity = 1ull << 30;
+
+  /// \brief Lookups after which a resource is promoted to the hot tier.
+  public: unsigned int hotCachePromotion = 3;
 };
 
 //////////////////////////////////////////////////
@@ -211,6 +236,38 @@ ClientConfig::ClientConfig() : dataPtr(new ClientConfigPrivate)
     }
     this->SetCacheLocation(ignFuelPath);
   }
+
+  std::string lazyFiles;
+  if (ignition::common::env("IGN_FUEL_LAZY_FILES", lazyFiles))
+  {
+    lazyFiles = ignition::common::lowercase(lazyFiles);
+    this->dataPtr->lazyFileFetch = lazyFiles == "1" || lazyFiles == "true";
+  }
+
+  ignition::common::env("IGN_FUEL_LOCKFILE", this->dataPtr->lockfilePath);
+
+  std::string deltaUpdates;
+  if (ignition::common::env("IGN_FUEL_DELTA_UPDATES", deltaUpdates))
+  {
+    deltaUpdates = ignition::common::lowercase(deltaUpdates);
+    this->dataPtr->deltaUpdates =
+        deltaUpdates != "0" && deltaUpdates != "false";
+  }
+
+  std::string listingPolicy;
+  if (ignition::common::env("IGN_FUEL_LISTING_POLICY", listingPolicy))
+  {
+    listingPolicy = ignition::common::lowercase(listingPolicy);
+    if (listingPolicy == "stale_while_revalidate")
+      this->dataPtr->listingPolicy = ListingPolicy::STALE_WHILE_REVALIDATE;
+    else if (listingPolicy == "cache_first")
+      this->dataPtr->listingPolicy = ListingPolicy::CACHE_FIRST;
+    else
+      ignwarn << "Unknown IGN_FUEL_LISTING_POLICY [" << listingPolicy << "]\n";
+  }
+
+  ignition::common::env("IGN_FUEL_HOT_CACHE_PATH",
+      this->dataPtr->hotCacheLocation);
 }
 
 //////////////////////////////////////////////////
@@ -449,6 +506,102 @@ void ClientConfig::SetCacheLocation(const std::string &_path)
   this->dataPtr->cacheLocation = _path;
 }
 
+//////////////////////////////////////////////////
+bool ClientConfig::LazyFileFetch() const
+{
+  return this->dataPtr->lazyFileFetch;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetLazyFileFetch(bool _lazy)
+{
+  this->dataPtr->lazyFileFetch = _lazy;
+}
+
+//////////////////////////////////////////////////
+std::string ClientConfig::LockfilePath() const
+{
+  return this->dataPtr->lockfilePath;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetLockfilePath(const std::string &_path)
+{
+  this->dataPtr->lockfilePath = _path;
+}
+
+//////////////////////////////////////////////////
+bool ClientConfig::DeltaUpdates() const
+{
+  return this->dataPtr->deltaUpdates;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetDeltaUpdates(bool _delta)
+{
+  this->dataPtr->deltaUpdates = _delta;
+}
+
+//////////////////////////////////////////////////
+ListingPolicy ClientConfig::ListingCachePolicy() const
+{
+  return this->dataPtr->listingPolicy;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetListingCachePolicy(ListingPolicy _policy)
+{
+  this->dataPtr->listingPolicy = _policy;
+}
+
+//////////////////////////////////////////////////
+std::chrono::seconds ClientConfig::ListingTtl() const
+{
+  return this->dataPtr->listingTtl;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetListingTtl(const std::chrono::seconds &_ttl)
+{
+  this->dataPtr->listingTtl = _ttl;
+}
+
+//////////////////////////////////////////////////
+std::string ClientConfig::HotCacheLocation() const
+{
+  return this->dataPtr->hotCacheLocation;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetHotCacheLocation(const std::string &_path)
+{
+  this->dataPtr->hotCacheLocation = _path;
+}
+
+//////////////////////////////////////////////////
+uint64_t ClientConfig::HotCacheCapacity() const
+{
+  return this->dataPtr->hotCacheCapacity;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetHotCacheCapacity(uint64_t _bytes)
+{
+  this->dataPtr->hotCacheCapacity = _bytes;
+}
+
+//////////////////////////////////////////////////
+unsigned int ClientConfig::HotCachePromotion() const
+{
+  return this->dataPtr->hotCachePromotion;
+}
+
+//////////////////////////////////////////////////
+void ClientConfig::SetHotCachePromotion(unsigned int _lookups)
+{
+  this->dataPtr->hotCachePromotion = std::max(1u, _lookups);
+}
+
 //////////////////////////////////////////////////
 void ClientConfig::SetUserAgent(const std::string &_agent)
 {
@@ -252,6 +252,39 @@ TEST(ClientConfig, UserAgent)
   EXPECT_EQ("my_user_agent", config.UserAgent());
 }
 
+/////////////////////////////////////////////////
+TEST(ClientConfig, LazyFileFetch)
+{
+  ClientConfig config;
+  EXPECT_FALSE(config.LazyFileFetch());
+
+  config.SetLazyFileFetch(true);
+  EXPECT_TRUE(config.LazyFileFetch());
+
+  ClientConfig copy(config);
+  EXPECT_TRUE(copy.LazyFileFetch());
+
+  config.SetLazyFileFetch(false);
+  EXPECT_FALSE(config.LazyFileFetch());
+}
+
+/////////////////////////////////////////////////
+TEST(ClientConfig, HotCache)
+{
+  ClientConfig config;
+  EXPECT_EQ(1ull << 30, config.HotCacheCapacity());
+  EXPECT_EQ(3u, config.HotCachePromotion());
+
+  config.SetHotCacheLocation("/dev/shm/fuel");
+  config.SetHotCacheCapacity(1000);
+  config.SetHotCachePromotion(0);
+
+  ClientConfig copy(config);
+  EXPECT_EQ("/dev/shm/fuel", copy.HotCacheLocation());
+  EXPECT_EQ(1000u, copy.HotCacheCapacity());
+  EXPECT_EQ(1u, copy.HotCachePromotion());
+}
+
 /////////////////////////////////////////////////
 TEST(ServerConfig, ApiKey)
 {
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/DownloadOptions.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Private data class
+class ignition::fuel_tools::DownloadOptionsPrivate
+{
+  /// \brief Headers sent with the requests.
+  public: std::vector<std::string> headers;
+
+  /// \brief Progress callback.
+  public: DownloadProgressCallback progress;
+
+  /// \brief Cancellation token.
+  public: CancellationToken cancellation;
+};
+
+//////////////////////////////////////////////////
+CancellationToken::CancellationToken()
+  : cancelled(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+//////////////////////////////////////////////////
+void CancellationToken::Cancel()
+{
+  this->cancelled->store(true);
+}
+
+//////////////////////////////////////////////////
+bool CancellationToken::Cancelled() const
+{
+  return this->cancelled->load();
+}
+
+//////////////////////////////////////////////////
+DownloadOptions::DownloadOptions()
+  : dataPtr(new DownloadOptionsPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+DownloadOptions::DownloadOptions(const DownloadOptions &_orig)
+  : dataPtr(new DownloadOptionsPrivate)
+{
+  *(this->dataPtr) = *(_orig.dataPtr);
+}
+
+//////////////////////////////////////////////////
+DownloadOptions &DownloadOptions::operator=(const DownloadOptions &_orig)
+{
+  *(this->dataPtr) = *(_orig.dataPtr);
+  return *this;
+}
+
+//////////////////////////////////////////////////
+DownloadOptions::~DownloadOptions()
+{
+}
+
+//////////////////////////////////////////////////
+const std::vector<std::string> &DownloadOptions::Headers() const
+{
+  return this->dataPtr->headers;
+}
+
+//////////////////////////////////////////////////
+void DownloadOptions::SetHeaders(const std::vector<std::string> &_headers)
+{
+  this->dataPtr->headers = _headers;
+}
+
+//////////////////////////////////////////////////
+const DownloadProgressCallback &DownloadOptions::ProgressCallback() const
+{
+  return this->dataPtr->progress;
+}
+
+//////////////////////////////////////////////////
+void DownloadOptions::SetProgressCallback(
+    const DownloadProgressCallback &_callback)
+{
+  this->dataPtr->progress = _callback;
+}
+
+//////////////////////////////////////////////////
+const CancellationToken &DownloadOptions::Cancellation() const
+{
+  return this->dataPtr->cancellation;
+}
+
+//////////////////////////////////////////////////
+void DownloadOptions::SetCancellation(const CancellationToken &_token)
+{
+  this->dataPtr->cancellation = _token;
+}
+
+//////////////////////////////////////////////////
+bool DownloadOptions::Report(DownloadPhase _phase, uint64_t _current,
+    uint64_t _total) const
+{
+  if (this->dataPtr->progress)
+    this->dataPtr->progress(_phase, _current, _total);
+  return !this->dataPtr->cancellation.Cancelled();
+}
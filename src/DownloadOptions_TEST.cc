@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/DownloadOptions.hh"
+#include "ignition/fuel_tools/FuelClient.hh"
+#include "ignition/fuel_tools/Zip.hh"
+
+#include "HttpServer.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+TEST(DownloadOptions, Options)
+{
+  DownloadOptions options;
+  EXPECT_TRUE(options.Headers().empty());
+  EXPECT_FALSE(options.ProgressCallback());
+  EXPECT_FALSE(options.Cancellation().Cancelled());
+  EXPECT_TRUE(options.Report(DownloadPhase::DOWNLOAD, 1, 2));
+
+  std::vector<DownloadPhase> phases;
+  options.SetHeaders({"Private-Token: abc"});
+  options.SetProgressCallback(
+      [&phases](DownloadPhase _phase, uint64_t, uint64_t)
+      {
+        phases.push_back(_phase);
+      });
+
+  // Copies share the cancellation state.
+  CancellationToken token;
+  options.SetCancellation(token);
+  DownloadOptions copy(options);
+  ASSERT_EQ(1u, copy.Headers().size());
+  EXPECT_EQ("Private-Token: abc", copy.Headers()[0]);
+
+  EXPECT_TRUE(copy.Report(DownloadPhase::EXTRACT, 1, 2));
+  token.Cancel();
+  EXPECT_TRUE(options.Cancellation().Cancelled());
+  EXPECT_FALSE(copy.Report(DownloadPhase::FIX_PATHS, 0, 1));
+
+  ASSERT_EQ(2u, phases.size());
+  EXPECT_EQ(DownloadPhase::EXTRACT, phases[0]);
+  EXPECT_EQ(DownloadPhase::FIX_PATHS, phases[1]);
+
+  EXPECT_FALSE(Result(ResultType::FETCH_CANCELLED));
+  EXPECT_EQ("Fetch cancelled",
+      Result(ResultType::FETCH_CANCELLED).ReadableResult());
+}
+
+#ifndef _WIN32
+/// \brief Serve a model archive with a large mesh, so downloads take a
+/// while.
+class DownloadOptionsTest : public ::testing::Test
+{
+  protected: void SetUp() override
+  {
+    this->root = common::joinPaths(PROJECT_BINARY_PATH,
+        "test_download_options");
+    common::removeAll(this->root);
+
+    std::string modelDir = common::joinPaths(this->root, "am1");
+    common::createDirectories(modelDir);
+    {
+      std::ofstream out(common::joinPaths(modelDir, "model.config"));
+      out << "<?xml version=\"1.0\"?><model><name>am1</name>"
+          << "<sdf version=\"1.6\">model.sdf</sdf></model>";
+    }
+    {
+      std::ofstream out(common::joinPaths(modelDir, "model.sdf"));
+      out << "<?xml version=\"1.0\"?><sdf version=\"1.6\">"
+          << "<model name=\"am1\"/></sdf>";
+    }
+    {
+      // Random content doesn't compress, so the archive is large too.
+      std::mt19937 random(1);
+      std::string mesh(20 * 1024 * 1024, ' ');
+      for (auto &c : mesh)
+        c = static_cast<char>(random());
+      std::ofstream out(common::joinPaths(modelDir, "mesh.dae"),
+          std::ios::binary);
+      out << mesh;
+    }
+
+    // Compressing files one by one keeps them at the root of the archive.
+    this->archive = common::joinPaths(this->root, "am1.zip");
+    for (auto file : {"model.config", "model.sdf", "mesh.dae"})
+      Zip::Compress(common::joinPaths(modelDir, file), this->archive);
+
+    this->server.reset(new HttpServer(
+        [this](const HttpRequest &_request, HttpResponse &_response)
+        {
+          if (_request.path == "/1.0/alice/models/am1/tip/am1.zip")
+          {
+            _response.file = this->archive;
+            _response.headers["X-Ign-Resource-Version"] = "1";
+          }
+          else
+          {
+            _response.status = 404;
+          }
+        }));
+    ASSERT_TRUE(this->server->Start("127.0.0.1", 0));
+
+    ServerConfig serverConfig;
+    serverConfig.SetUrl(common::URI(this->server->Url()));
+    this->config.SetCacheLocation(common::joinPaths(this->root, "cache"));
+    this->config.AddServer(serverConfig);
+
+    this->modelDir = common::joinPaths(this->root, "cache",
+        common::URI(this->server->Url()).Path().Str(), "alice", "models",
+        "am1", "1");
+  }
+
+  protected: void TearDown() override
+  {
+    this->server->Stop();
+  }
+
+  /// \brief Test directory.
+  protected: std::string root;
+
+  /// \brief Model archive.
+  protected: std::string archive;
+
+  /// \brief Where the model is saved.
+  protected: std::string modelDir;
+
+  /// \brief Client configuration, using the test server.
+  protected: ClientConfig config;
+
+  /// \brief Test server.
+  protected: std::unique_ptr<HttpServer> server;
+};
+
+/////////////////////////////////////////////////
+TEST_F(DownloadOptionsTest, Progress)
+{
+  std::map<DownloadPhase, std::pair<uint64_t, uint64_t>> last;
+  DownloadOptions options;
+  options.SetProgressCallback(
+      [&last](DownloadPhase _phase, uint64_t _current, uint64_t _total)
+      {
+        last[_phase] = {_current, _total};
+      });
+
+  FuelClient client(this->config);
+  std::string path;
+  Result result = client.DownloadModel(
+      common::URI(this->server->Url() + "/1.0/alice/models/am1"), path,
+      options);
+  ASSERT_TRUE(result) << result.ReadableResult();
+  EXPECT_EQ(this->modelDir, path);
+  EXPECT_TRUE(common::isFile(common::joinPaths(path, "mesh.dae")));
+
+  // Every phase ran to completion.
+  ASSERT_EQ(3u, last.size());
+  EXPECT_LT(0u, last[DownloadPhase::DOWNLOAD].first);
+  EXPECT_EQ(last[DownloadPhase::DOWNLOAD].first,
+      last[DownloadPhase::DOWNLOAD].second);
+  EXPECT_LT(20u * 1024 * 1024, last[DownloadPhase::EXTRACT].first);
+  EXPECT_EQ(last[DownloadPhase::EXTRACT].first,
+      last[DownloadPhase::EXTRACT].second);
+  EXPECT_EQ(1u, last[DownloadPhase::FIX_PATHS].first);
+}
+
+/////////////////////////////////////////////////
+TEST_F(DownloadOptionsTest, Cancel)
+{
+  FuelClient client(this->config);
+  common::URI url(this->server->Url() + "/1.0/alice/models/am1");
+  std::string path;
+
+  // Cancelled before starting.
+  DownloadOptions options;
+  CancellationToken token;
+  options.SetCancellation(token);
+  token.Cancel();
+  EXPECT_EQ(ResultType::FETCH_CANCELLED,
+      client.DownloadModel(url, path, options).Type());
+
+  // Cancelled during each phase. The transfer stops early, and nothing is
+  // left in the cache.
+  for (auto phase : {DownloadPhase::DOWNLOAD, DownloadPhase::EXTRACT,
+      DownloadPhase::FIX_PATHS})
+  {
+    CancellationToken phaseToken;
+    uint64_t received = 0;
+    options.SetCancellation(phaseToken);
+    options.SetProgressCallback(
+        [&](DownloadPhase _phase, uint64_t _current, uint64_t)
+        {
+          if (_phase == DownloadPhase::DOWNLOAD)
+            received = _current;
+          if (_phase == phase &&
+              (_current > 0 || phase != DownloadPhase::DOWNLOAD))
+            phaseToken.Cancel();
+        });
+
+    EXPECT_EQ(ResultType::FETCH_CANCELLED,
+        client.DownloadModel(url, path, options).Type());
+    EXPECT_FALSE(common::exists(this->modelDir));
+    EXPECT_FALSE(client.CachedModel(url));
+    if (phase == DownloadPhase::DOWNLOAD)
+    {
+      std::ifstream in(this->archive, std::ios::binary | std::ios::ate);
+      EXPECT_GT(static_cast<uint64_t>(in.tellg()), received);
+    }
+  }
+}
+#endif
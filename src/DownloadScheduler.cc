@@ -0,0 +1,456 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+
+#include "ignition/fuel_tools/Metrics.hh"
+
+#include "DownloadScheduler.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Number of priority classes.
+static const size_t kPriorities = 2;
+
+/// \brief Get the key of a download in the scheduler. Downloads requested
+/// with different headers, which may carry credentials, aren't shared.
+/// \param[in] _key Key of the resource.
+/// \param[in] _options Options of a waiter.
+/// \return The key of the resource, followed by the headers.
+static std::string scheduleKey(const std::string &_key,
+    const DownloadOptions &_options)
+{
+  std::string key = _key;
+  for (const auto &header : _options.Headers())
+    key += "\n" + header;
+  return key;
+}
+
+/// \brief A scheduled download.
+struct ScheduledDownload
+{
+  /// \brief Add a waiter.
+  /// \param[in] _options Options of the waiter.
+  void Wait(const DownloadOptions &_options)
+  {
+    std::lock_guard<std::mutex> lock(this->waitersMutex);
+    this->waiters.push_back(_options);
+  }
+
+  /// \brief Report progress to the waiters which haven't cancelled, and
+  /// cancel the download if none is left.
+  /// \param[in] _phase Current phase.
+  /// \param[in] _current Amount of work done in this phase.
+  /// \param[in] _total Total amount of work of this phase.
+  void Report(DownloadPhase _phase, uint64_t _current, uint64_t _total)
+  {
+    // Callbacks run without the lock, since they may request the same
+    // download, and a slow one mustn't hold back the waiters joining.
+    std::vector<DownloadOptions> current;
+    {
+      std::lock_guard<std::mutex> lock(this->waitersMutex);
+      current = this->waiters;
+    }
+
+    bool cancelled{true};
+    for (const auto &waiter : current)
+    {
+      if (waiter.Report(_phase, _current, _total))
+        cancelled = false;
+    }
+    if (cancelled)
+      this->token.Cancel();
+  }
+
+  /// \brief Options combining those of every waiter.
+  /// \return Options to run the task with.
+  DownloadOptions Options()
+  {
+    // Headers are part of the key, so every waiter has the same.
+    DownloadOptions options;
+    {
+      std::lock_guard<std::mutex> lock(this->waitersMutex);
+      if (!this->waiters.empty())
+        options.SetHeaders(this->waiters.front().Headers());
+    }
+    options.SetCancellation(this->token);
+    options.SetProgressCallback(
+        [this](DownloadPhase _phase, uint64_t _current, uint64_t _total)
+        {
+          this->Report(_phase, _current, _total);
+        });
+    return options;
+  }
+
+  /// \brief Key of the download.
+  std::string key;
+
+  /// \brief Current priority, which may be raised while queued.
+  DownloadPriority priority;
+
+  /// \brief Download.
+  DownloadScheduler::Task task;
+
+  /// \brief Promise of the result.
+  std::promise<Result> promise;
+
+  /// \brief Future of the result, shared with every requester.
+  std::shared_future<Result> future;
+
+  /// \brief Options of everyone waiting for the download.
+  std::vector<DownloadOptions> waiters;
+
+  /// \brief Protects waiters.
+  std::mutex waitersMutex;
+
+  /// \brief Cancels the download once every waiter has cancelled.
+  CancellationToken token;
+};
+
+/// \brief Private data class
+class ignition::fuel_tools::DownloadSchedulerPrivate
+{
+  /// \brief Worker loop of a priority class.
+  /// \param[in] _priority Priority class.
+  public: void Work(size_t _priority);
+
+  /// \brief Start workers until a class has as many as its limit.
+  /// Must be called with the mutex locked.
+  /// \param[in] _priority Priority class.
+  public: void StartWorkers(size_t _priority);
+
+  /// \brief Queued downloads, per class.
+  public: std::deque<std::shared_ptr<ScheduledDownload>> queues[kPriorities];
+
+  /// \brief Queued and running downloads, by key.
+  public: std::map<std::string, std::shared_ptr<ScheduledDownload>> pending;
+
+  /// \brief Maximum number of concurrent downloads, per class.
+  public: unsigned int limits[kPriorities] = {8, 2};
+
+  /// \brief Number of running downloads, per class.
+  public: size_t running[kPriorities] = {0, 0};
+
+  /// \brief Worker threads, per class.
+  public: std::vector<std::thread> workers[kPriorities];
+
+  /// \brief Set when the scheduler is destroyed.
+  public: bool stop = false;
+
+  /// \brief Protects all the members.
+  public: mutable std::mutex mutex;
+
+  /// \brief Notified when downloads are queued or finish.
+  public: std::condition_variable cv;
+};
+
+//////////////////////////////////////////////////
+/// \brief Name of a priority class, used as a metric label.
+/// \param[in] _priority Priority class.
+/// \return Name of the class.
+static std::string priorityName(size_t _priority)
+{
+  return _priority == static_cast<size_t>(DownloadPriority::FOREGROUND) ?
+      "foreground" : "background";
+}
+
+//////////////////////////////////////////////////
+/// \brief Gauge of the downloads queued in a priority class.
+/// \param[in] _priority Priority class.
+/// \return The gauge.
+static MetricGauge &queuedGauge(size_t _priority)
+{
+  return MetricsRegistry::Global().Gauge(
+      "ign_fuel_scheduled_downloads_queued",
+      "Downloads waiting for a worker, by priority.",
+      {{"priority", priorityName(_priority)}});
+}
+
+//////////////////////////////////////////////////
+/// \brief Run a download, turning exceptions into errors.
+/// \param[in] _download Download to run.
+/// \return Result of the download.
+static Result run(ScheduledDownload &_download)
+{
+  try
+  {
+    return _download.task(_download.Options());
+  }
+  catch (const std::exception &_e)
+  {
+    ignerr << "Download [" << _download.key << "] failed: " << _e.what()
+           << std::endl;
+    return Result(ResultType::FETCH_ERROR);
+  }
+}
+
+//////////////////////////////////////////////////
+void DownloadSchedulerPrivate::Work(size_t _priority)
+{
+  auto &queued = queuedGauge(_priority);
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true)
+  {
+    this->cv.wait(lock, [&]()
+    {
+      return this->stop || (!this->queues[_priority].empty() &&
+          this->running[_priority] < this->limits[_priority]);
+    });
+    if (this->stop)
+      return;
+
+    auto download = this->queues[_priority].front();
+    this->queues[_priority].pop_front();
+    queued.Add(-1);
+    ++this->running[_priority];
+
+    lock.unlock();
+    Result result = run(*download);
+    lock.lock();
+
+    --this->running[_priority];
+    this->pending.erase(download->key);
+    download->promise.set_value(result);
+    this->cv.notify_all();
+  }
+}
+
+//////////////////////////////////////////////////
+void DownloadSchedulerPrivate::StartWorkers(size_t _priority)
+{
+  while (this->workers[_priority].size() < this->limits[_priority] &&
+         this->workers[_priority].size() <
+         this->running[_priority] + this->queues[_priority].size())
+  {
+    this->workers[_priority].emplace_back(
+        &DownloadSchedulerPrivate::Work, this, _priority);
+  }
+}
+
+//////////////////////////////////////////////////
+DownloadScheduler::DownloadScheduler()
+  : dataPtr(new DownloadSchedulerPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+DownloadScheduler::~DownloadScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->stop = true;
+    for (size_t p = 0; p < kPriorities; ++p)
+    {
+      queuedGauge(p).Add(
+          -static_cast<int64_t>(this->dataPtr->queues[p].size()));
+      for (auto &download : this->dataPtr->queues[p])
+      {
+        this->dataPtr->pending.erase(download->key);
+        download->promise.set_value(Result(ResultType::FETCH_CANCELLED));
+      }
+      this->dataPtr->queues[p].clear();
+    }
+  }
+  this->dataPtr->cv.notify_all();
+
+  for (auto &workers : this->dataPtr->workers)
+  {
+    for (auto &worker : workers)
+      worker.join();
+  }
+}
+
+//////////////////////////////////////////////////
+void DownloadScheduler::SetConcurrency(DownloadPriority _priority,
+    unsigned int _jobs)
+{
+  auto p = static_cast<size_t>(_priority);
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->limits[p] = std::max(1u, _jobs);
+  this->dataPtr->StartWorkers(p);
+  this->dataPtr->cv.notify_all();
+}
+
+//////////////////////////////////////////////////
+unsigned int DownloadScheduler::Concurrency(DownloadPriority _priority) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->limits[static_cast<size_t>(_priority)];
+}
+
+//////////////////////////////////////////////////
+std::shared_future<Result> DownloadScheduler::Schedule(
+    const std::string &_key, DownloadPriority _priority,
+    const DownloadOptions &_options, const Task &_task)
+{
+  auto p = static_cast<size_t>(_priority);
+  const std::string key = scheduleKey(_key, _options);
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (this->dataPtr->stop)
+  {
+    std::promise<Result> promise;
+    promise.set_value(Result(ResultType::FETCH_CANCELLED));
+    return promise.get_future().share();
+  }
+
+  auto it = this->dataPtr->pending.find(key);
+  if (it != this->dataPtr->pending.end())
+  {
+    auto download = it->second;
+    download->Wait(_options);
+    auto &queue = this->dataPtr->queues[
+        static_cast<size_t>(download->priority)];
+    auto queued = std::find(queue.begin(), queue.end(), download);
+
+    // Promote a queued download. Running downloads keep their worker.
+    if (queued != queue.end() && _priority < download->priority)
+    {
+      queue.erase(queued);
+      queuedGauge(static_cast<size_t>(download->priority)).Add(-1);
+      MetricsRegistry::Global().Counter(
+          "ign_fuel_scheduled_downloads_promoted_total",
+          "Queued downloads moved to a higher priority.").Increment();
+
+      download->priority = _priority;
+      this->dataPtr->queues[p].push_front(download);
+      queuedGauge(p).Add(1);
+      this->dataPtr->StartWorkers(p);
+      this->dataPtr->cv.notify_all();
+    }
+    return download->future;
+  }
+
+  auto download = std::make_shared<ScheduledDownload>();
+  download->key = key;
+  download->priority = _priority;
+  download->task = _task;
+  download->future = download->promise.get_future().share();
+  download->Wait(_options);
+
+  this->dataPtr->pending[key] = download;
+  this->dataPtr->queues[p].push_back(download);
+  queuedGauge(p).Add(1);
+  this->dataPtr->StartWorkers(p);
+  this->dataPtr->cv.notify_all();
+
+  return download->future;
+}
+
+//////////////////////////////////////////////////
+Result DownloadScheduler::Run(const std::string &_key,
+    const DownloadOptions &_options, const Task &_task)
+{
+  const std::string key = scheduleKey(_key, _options);
+  std::shared_ptr<ScheduledDownload> download;
+  bool runHere{true};
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    if (this->dataPtr->stop)
+      return Result(ResultType::FETCH_CANCELLED);
+
+    auto it = this->dataPtr->pending.find(key);
+    if (it != this->dataPtr->pending.end())
+    {
+      download = it->second;
+      auto p = static_cast<size_t>(download->priority);
+      auto &queue = this->dataPtr->queues[p];
+      auto queued = std::find(queue.begin(), queue.end(), download);
+      if (queued != queue.end())
+      {
+        queue.erase(queued);
+        queuedGauge(p).Add(-1);
+        MetricsRegistry::Global().Counter(
+            "ign_fuel_scheduled_downloads_promoted_total",
+            "Queued downloads moved to a higher priority.").Increment();
+      }
+      else
+      {
+        runHere = false;
+      }
+    }
+    else
+    {
+      download = std::make_shared<ScheduledDownload>();
+      download->key = key;
+      download->priority = DownloadPriority::FOREGROUND;
+      download->task = _task;
+      download->future = download->promise.get_future().share();
+      this->dataPtr->pending[key] = download;
+    }
+    download->Wait(_options);
+  }
+
+  if (runHere)
+  {
+    Result result = run(*download);
+    {
+      std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+      this->dataPtr->pending.erase(key);
+      download->promise.set_value(result);
+    }
+    this->dataPtr->cv.notify_all();
+  }
+  else
+  {
+    // Stop waiting as soon as this waiter cancels, while the download goes
+    // on for the others.
+    while (download->future.wait_for(std::chrono::milliseconds(50)) !=
+        std::future_status::ready)
+    {
+      if (_options.Cancellation().Cancelled())
+        return Result(ResultType::FETCH_CANCELLED);
+    }
+  }
+
+  // The others may have all cancelled before this waiter joined.
+  Result result = download->future.get();
+  if (result.Type() == ResultType::FETCH_CANCELLED &&
+      !_options.Cancellation().Cancelled())
+  {
+    return this->Run(_key, _options, _task);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+size_t DownloadScheduler::Queued(DownloadPriority _priority) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->queues[static_cast<size_t>(_priority)].size();
+}
+
+//////////////////////////////////////////////////
+size_t DownloadScheduler::Running(DownloadPriority _priority) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->running[static_cast<size_t>(_priority)];
+}
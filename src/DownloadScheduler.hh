@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_DOWNLOADSCHEDULER_HH_
+#define IGNITION_FUEL_TOOLS_DOWNLOADSCHEDULER_HH_
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "ignition/fuel_tools/DownloadOptions.hh"
+#include "ignition/fuel_tools/Export.hh"
+#include "ignition/fuel_tools/Result.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class DownloadSchedulerPrivate;
+
+    /// \brief Runs downloads on worker threads, with one queue and one
+    /// concurrency limit per priority class. Downloads are identified by a
+    /// key and the headers of the request, so a resource requested several
+    /// times with the same credentials is downloaded once. A queued
+    /// background download requested in the foreground is promoted to the
+    /// foreground queue.
+    ///
+    /// Everyone requesting a download is a waiter, with their own options:
+    /// the progress of the download is reported to every waiter, and it's
+    /// only cancelled once every waiter has cancelled.
+    class IGNITION_FUEL_TOOLS_VISIBLE DownloadScheduler
+    {
+      /// \brief A download, called with options combining those of every
+      /// waiter: the headers they share, a progress callback reporting to
+      /// all of them, and a token cancelled once all of them are.
+      public: using Task = std::function<Result(const DownloadOptions &)>;
+
+      /// \brief Constructor.
+      public: DownloadScheduler();
+
+      /// \brief Destructor. Queued downloads are dropped with
+      /// ResultType::FETCH_CANCELLED, and running ones are waited for.
+      public: ~DownloadScheduler();
+
+      /// \brief Set the maximum number of concurrent downloads of a class.
+      /// \param[in] _priority Priority class.
+      /// \param[in] _jobs Maximum number of downloads, at least 1.
+      public: void SetConcurrency(DownloadPriority _priority,
+          unsigned int _jobs);
+
+      /// \brief Get the maximum number of concurrent downloads of a class.
+      /// \param[in] _priority Priority class.
+      /// \return Maximum number of downloads.
+      public: unsigned int Concurrency(DownloadPriority _priority) const;
+
+      /// \brief Schedule a download. If a download with the same key and
+      /// headers is already queued or running, its result is shared
+      /// instead, and the task is not used. A queued download is promoted
+      /// if the new priority is higher.
+      /// \param[in] _key Identifies the resource, such as its unique name
+      /// and version.
+      /// \param[in] _priority Priority class.
+      /// \param[in] _options Headers, progress callback and cancellation
+      /// token of this waiter, copied.
+      /// \param[in] _task Download, called from a worker thread.
+      /// \return Result of the download, available once it finishes.
+      public: std::shared_future<Result> Schedule(const std::string &_key,
+          DownloadPriority _priority, const DownloadOptions &_options,
+          const Task &_task);
+
+      /// \brief Run a download on the calling thread, without counting
+      /// towards any concurrency limit. A queued download with the same key
+      /// and headers is taken out of its queue and run here. If one is
+      /// already running, it's waited for instead, until it finishes or
+      /// _options is cancelled.
+      /// \param[in] _key Identifies the resource.
+      /// \param[in] _options Headers, progress callback and cancellation
+      /// token of this waiter.
+      /// \param[in] _task Download.
+      /// \return Result of the download, FETCH_CANCELLED if _options was
+      /// cancelled.
+      public: Result Run(const std::string &_key,
+          const DownloadOptions &_options, const Task &_task);
+
+      /// \brief Number of downloads waiting in a queue.
+      /// \param[in] _priority Priority class.
+      /// \return Number of queued downloads.
+      public: size_t Queued(DownloadPriority _priority) const;
+
+      /// \brief Number of downloads running on worker threads.
+      /// \param[in] _priority Priority class.
+      /// \return Number of running downloads.
+      public: size_t Running(DownloadPriority _priority) const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<DownloadSchedulerPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DownloadScheduler.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+/// \brief A task which blocks until released.
+class BlockingTask
+{
+  /// \brief Get the task.
+  /// \return Task, which counts its runs.
+  public: DownloadScheduler::Task Task()
+  {
+    return [this](const DownloadOptions &)
+    {
+      ++this->runs;
+      this->started.set_value();
+      this->release.wait();
+      return Result(ResultType::FETCH);
+    };
+  }
+
+  /// \brief Number of runs.
+  public: std::atomic<int> runs{0};
+
+  /// \brief Set when the task starts.
+  public: std::promise<void> started;
+
+  /// \brief Releases the task.
+  public: std::promise<void> releaser;
+
+  /// \brief Waited for by the task.
+  public: std::shared_future<void> release{releaser.get_future().share()};
+};
+
+/////////////////////////////////////////////////
+TEST(DownloadScheduler, Concurrency)
+{
+  DownloadScheduler scheduler;
+  EXPECT_EQ(8u, scheduler.Concurrency(DownloadPriority::FOREGROUND));
+  EXPECT_EQ(2u, scheduler.Concurrency(DownloadPriority::BACKGROUND));
+
+  scheduler.SetConcurrency(DownloadPriority::FOREGROUND, 0);
+  EXPECT_EQ(1u, scheduler.Concurrency(DownloadPriority::FOREGROUND));
+  scheduler.SetConcurrency(DownloadPriority::FOREGROUND, 2);
+
+  std::atomic<int> running{0};
+  std::atomic<int> maxRunning{0};
+  std::vector<std::shared_future<Result>> futures;
+  for (int i = 0; i < 6; ++i)
+  {
+    futures.push_back(scheduler.Schedule(std::to_string(i),
+        DownloadPriority::FOREGROUND, DownloadOptions(),
+        [&](const DownloadOptions &)
+        {
+          int now = ++running;
+          int max = maxRunning;
+          while (now > max && !maxRunning.compare_exchange_weak(max, now))
+          {
+          }
+          std::this_thread::sleep_for(std::chrono::milliseconds(20));
+          --running;
+          return Result(ResultType::FETCH);
+        }));
+  }
+
+  for (auto &future : futures)
+    EXPECT_EQ(ResultType::FETCH, future.get().Type());
+  EXPECT_GE(2, maxRunning);
+  EXPECT_EQ(0u, scheduler.Queued(DownloadPriority::FOREGROUND));
+  EXPECT_EQ(0u, scheduler.Running(DownloadPriority::FOREGROUND));
+}
+
+/////////////////////////////////////////////////
+TEST(DownloadScheduler, Deduplicate)
+{
+  DownloadScheduler scheduler;
+  BlockingTask task;
+  auto first = scheduler.Schedule("a", DownloadPriority::BACKGROUND,
+      DownloadOptions(), task.Task());
+  task.started.get_future().wait();
+
+  // The running download is shared, and the second task is not used.
+  auto second = scheduler.Schedule("a", DownloadPriority::FOREGROUND,
+      DownloadOptions(), [](const DownloadOptions &)
+      {
+        return Result(ResultType::FETCH_ERROR);
+      });
+  EXPECT_EQ(1u, scheduler.Running(DownloadPriority::BACKGROUND));
+
+  task.releaser.set_value();
+  EXPECT_EQ(ResultType::FETCH, first.get().Type());
+  EXPECT_EQ(ResultType::FETCH, second.get().Type());
+  EXPECT_EQ(1, task.runs);
+}
+
+/////////////////////////////////////////////////
+TEST(DownloadScheduler, Promote)
+{
+  DownloadScheduler scheduler;
+  scheduler.SetConcurrency(DownloadPriority::BACKGROUND, 1);
+
+  // Fill the background class.
+  BlockingTask busy;
+  auto busyFuture = scheduler.Schedule("busy", DownloadPriority::BACKGROUND,
+      DownloadOptions(), busy.Task());
+  busy.started.get_future().wait();
+
+  std::atomic<int> runs{0};
+  auto task = [&runs](const DownloadOptions &)
+  {
+    ++runs;
+    return Result(ResultType::FETCH);
+  };
+  auto queued = scheduler.Schedule("model", DownloadPriority::BACKGROUND,
+      DownloadOptions(), task);
+  EXPECT_EQ(1u, scheduler.Queued(DownloadPriority::BACKGROUND));
+
+  // Foreground downloads don't wait for the background ones, and a queued
+  // background download is promoted.
+  auto other = scheduler.Schedule("other", DownloadPriority::FOREGROUND,
+      DownloadOptions(), task);
+  EXPECT_EQ(ResultType::FETCH, other.get().Type());
+
+  auto promoted = scheduler.Schedule("model", DownloadPriority::FOREGROUND,
+      DownloadOptions(), task);
+  EXPECT_EQ(ResultType::FETCH, promoted.get().Type());
+  EXPECT_EQ(ResultType::FETCH, queued.get().Type());
+  EXPECT_EQ(0u, scheduler.Queued(DownloadPriority::BACKGROUND));
+  EXPECT_EQ(2, runs);
+
+  busy.releaser.set_value();
+  EXPECT_EQ(ResultType::FETCH, busyFuture.get().Type());
+}
+
+/////////////////////////////////////////////////
+TEST(DownloadScheduler, Destroy)
+{
+  std::unique_ptr<DownloadScheduler> scheduler(new DownloadScheduler);
+  scheduler->SetConcurrency(DownloadPriority::BACKGROUND, 1);
+
+  BlockingTask busy;
+  auto running = scheduler->Schedule("busy", DownloadPriority::BACKGROUND,
+      DownloadOptions(), busy.Task());
+  busy.started.get_future().wait();
+  auto queued = scheduler->Schedule("queued", DownloadPriority::BACKGROUND,
+      DownloadOptions(), [](const DownloadOptions &)
+      {
+        return Result(ResultType::FETCH);
+      });
+
+  // Running downloads finish, queued ones are cancelled.
+  std::thread releaser([&busy]()
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    busy.releaser.set_value();
+  });
+  scheduler.reset();
+  releaser.join();
+
+  EXPECT_EQ(ResultType::FETCH, running.get().Type());
+  EXPECT_EQ(ResultType::FETCH_CANCELLED, queued.get().Type());
+}
+
+/////////////////////////////////////////////////
+TEST(DownloadScheduler, Run)
+{
+  DownloadScheduler scheduler;
+  scheduler.SetConcurrency(DownloadPriority::FOREGROUND, 1);
+
+  // Fill the foreground class.
+  BlockingTask busy;
+  auto busyFuture = scheduler.Schedule("busy", DownloadPriority::FOREGROUND,
+      DownloadOptions(), busy.Task());
+  busy.started.get_future().wait();
+
+  // Downloads run on the calling thread don't wait for a worker, and take
+  // queued downloads over.
+  std::atomic<int> runs{0};
+  auto task = [&runs](const DownloadOptions &)
+  {
+    ++runs;
+    return Result(ResultType::FETCH);
+  };
+  auto queued = scheduler.Schedule("model", DownloadPriority::FOREGROUND,
+      DownloadOptions(), task);
+  EXPECT_EQ(1u, scheduler.Queued(DownloadPriority::FOREGROUND));
+  EXPECT_EQ(ResultType::FETCH,
+      scheduler.Run("model", DownloadOptions(), task).Type());
+  EXPECT_EQ(ResultType::FETCH, queued.get().Type());
+  EXPECT_EQ(0u, scheduler.Queued(DownloadPriority::FOREGROUND));
+  EXPECT_EQ(1, runs);
+
+  EXPECT_EQ(ResultType::FETCH,
+      scheduler.Run("other", DownloadOptions(), task).Type());
+  EXPECT_EQ(2, runs);
+
+  busy.releaser.set_value();
+  EXPECT_EQ(ResultType::FETCH, busyFuture.get().Type());
+}
+
+/////////////////////////////////////////////////
+TEST(DownloadScheduler, Waiters)
+{
+  DownloadScheduler scheduler;
+
+  // Reports progress until released or cancelled.
+  std::atomic<int> starts{0};
+  std::atomic<bool> release{false};
+  auto task = [&](const DownloadOptions &_options)
+  {
+    ++starts;
+    for (uint64_t i = 0; !release; ++i)
+    {
+      if (!_options.Report(DownloadPhase::DOWNLOAD, i, 0))
+        return Result(ResultType::FETCH_CANCELLED);
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return Result(ResultType::FETCH);
+  };
+
+  auto options = [](CancellationToken _token, std::atomic<int> &_reports)
+  {
+    DownloadOptions result;
+    result.SetCancellation(_token);
+    result.SetProgressCallback([&_reports](DownloadPhase, uint64_t,
+        uint64_t)
+    {
+      ++_reports;
+    });
+    return result;
+  };
+
+  auto waitFor = [](const std::atomic<int> &_count)
+  {
+    for (int i = 0; i < 200 && _count == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return _count > 0;
+  };
+
+  // Progress is reported to every waiter, and cancelling one of them
+  // doesn't cancel the download for the others.
+  CancellationToken backgroundToken;
+  std::atomic<int> backgroundReports{0};
+  auto background = scheduler.Schedule("a", DownloadPriority::BACKGROUND,
+      options(backgroundToken, backgroundReports), task);
+  ASSERT_TRUE(waitFor(starts));
+
+  std::atomic<int> reports{0};
+  ResultType result{ResultType::UNKNOWN};
+  std::thread waiter([&]()
+  {
+    result = scheduler.Run("a", options(CancellationToken(), reports),
+        task).Type();
+  });
+  EXPECT_TRUE(waitFor(reports));
+  EXPECT_TRUE(waitFor(backgroundReports));
+
+  backgroundToken.Cancel();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  release = true;
+  waiter.join();
+  EXPECT_EQ(ResultType::FETCH, result);
+  EXPECT_EQ(ResultType::FETCH, background.get().Type());
+  EXPECT_EQ(1, starts);
+
+  // The download is cancelled once every waiter has cancelled, and a
+  // cancelled waiter stops waiting right away.
+  release = false;
+  CancellationToken firstToken;
+  CancellationToken secondToken;
+  std::atomic<int> firstReports{0};
+  std::atomic<int> secondReports{0};
+  std::thread first([&]()
+  {
+    result = scheduler.Run("b", options(firstToken, firstReports),
+        task).Type();
+  });
+  ASSERT_TRUE(waitFor(firstReports));
+  auto second = scheduler.Schedule("b", DownloadPriority::BACKGROUND,
+      options(secondToken, secondReports), task);
+
+  secondToken.Cancel();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_NE(std::future_status::ready,
+      second.wait_for(std::chrono::milliseconds(0)));
+
+  firstToken.Cancel();
+  first.join();
+  EXPECT_EQ(ResultType::FETCH_CANCELLED, result);
+  EXPECT_EQ(ResultType::FETCH_CANCELLED, second.get().Type());
+  EXPECT_EQ(2, starts);
+}
+
+/////////////////////////////////////////////////
+TEST(DownloadScheduler, Headers)
+{
+  DownloadScheduler scheduler;
+
+  // Reports progress until released.
+  std::atomic<int> starts{0};
+  std::atomic<bool> release{false};
+  auto task = [&](const DownloadOptions &_options)
+  {
+    ++starts;
+    while (!release)
+    {
+      _options.Report(DownloadPhase::DOWNLOAD, 0, 0);
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return Result(ResultType::FETCH);
+  };
+
+  // Requests with different headers aren't shared, since the credentials
+  // they carry may change the result.
+  DownloadOptions authorized;
+  authorized.SetHeaders({"Private-Token: secret"});
+  auto anonymous = scheduler.Schedule("a", DownloadPriority::FOREGROUND,
+      DownloadOptions(), task);
+  auto first = scheduler.Schedule("a", DownloadPriority::FOREGROUND,
+      authorized, task);
+  auto second = scheduler.Schedule("a", DownloadPriority::FOREGROUND,
+      authorized, task);
+
+  // A progress callback can request the same download.
+  std::atomic<bool> requested{false};
+  std::shared_future<Result> nested;
+  DownloadOptions reentrant;
+  reentrant.SetProgressCallback([&](DownloadPhase, uint64_t, uint64_t)
+  {
+    if (!requested.exchange(true))
+    {
+      nested = scheduler.Schedule("b", DownloadPriority::BACKGROUND,
+          DownloadOptions(), task);
+    }
+  });
+  auto outer = scheduler.Schedule("b", DownloadPriority::FOREGROUND,
+      reentrant, task);
+
+  for (int i = 0; i < 200 && !requested; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_TRUE(requested);
+  release = true;
+
+  EXPECT_EQ(ResultType::FETCH, anonymous.get().Type());
+  EXPECT_EQ(ResultType::FETCH, first.get().Type());
+  EXPECT_EQ(ResultType::FETCH, second.get().Type());
+  EXPECT_EQ(ResultType::FETCH, outer.get().Type());
+  ASSERT_TRUE(nested.valid());
+  EXPECT_EQ(ResultType::FETCH, nested.get().Type());
+  EXPECT_EQ(3, starts);
+}
@@ -18,14 +18,24 @@
 #include <google/protobuf/text_format.h>
 #include <ignition/msgs/fuel_metadata.pb.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <regex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
+#include <ignition/common/StringUtils.hh>
 #include <ignition/common/Util.hh>
 
 #include <ignition/msgs/Utility.hh>
@@ -34,12 +44,17 @@
 #include "ignition/fuel_tools/FuelClient.hh"
 #include "ignition/fuel_tools/JSONParser.hh"
 #include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/Lockfile.hh"
+#include "ignition/fuel_tools/Metrics.hh"
 #include "ignition/fuel_tools/ModelIdentifier.hh"
 #include "ignition/fuel_tools/ModelIterPrivate.hh"
 #include "ignition/fuel_tools/RestClient.hh"
+#include "ignition/fuel_tools/Trace.hh"
 #include "ignition/fuel_tools/WorldIdentifier.hh"
 #include "ignition/fuel_tools/WorldIterPrivate.hh"
 
+#include "DownloadScheduler.hh"
+
 using namespace ignition;
 using namespace fuel_tools;
 
@@ -136,6 +151,119 @@ class ignition::fuel_tools::FuelClientPrivate
   public: void AllFiles(const std::string &_path,
               std::vector<std::string> &_files) const;
 
+  /// \brief Download a model and save it into the cache.
+  /// \param[in] _id The model identifier.
+  /// \param[in] _options Headers, progress callback and cancellation token.
+  /// \return Result of the download operation.
+  public: Result DownloadModel(const ModelIdentifier &_id,
+              const DownloadOptions &_options);
+
+  /// \brief Download a newer version of a cached model by fetching only the
+  /// files which changed since the cached version. Files are compared by
+  /// the hashes in the server's file trees of both versions.
+  /// \param[in] _id The model identifier.
+  /// \param[in] _options Headers, progress callback and cancellation token.
+  /// \param[out] _target Identifier of the version which was, or would
+  /// have been, saved.
+  /// \param[out] _fileTree The server's file tree of that version, if it
+  /// was fetched.
+  /// \return True if the new version was saved. False if there's no
+  /// previous version to start from, or the update must fall back to the
+  /// whole archive.
+  public: bool DownloadModelDelta(const ModelIdentifier &_id,
+              const DownloadOptions &_options, ModelIdentifier &_target,
+              std::string &_fileTree);
+
+  /// \brief Request the details of a model from the server.
+  /// \param[in] _id Identifier with the server, owner and name.
+  /// \param[out] _model The requested model.
+  /// \param[in] _headers Headers to set on the HTTP request, such as
+  /// credentials for private models.
+  /// \param[in] _save True to save the details next to the model listings,
+  /// so the batched ModelDetails can read them back.
+  /// \return Result of the fetch operation.
+  public: Result FetchModelDetails(const ModelIdentifier &_id,
+              ModelIdentifier &_model,
+              const std::vector<std::string> &_headers, const bool _save);
+
+  /// \brief Request the details of a world from the server.
+  /// \param[in] _id Identifier with the server, owner and name.
+  /// \param[out] _world The requested world.
+  /// \param[in] _headers Headers to set on the HTTP request, such as
+  /// credentials for private worlds.
+  /// \param[in] _save True to save the details next to the world listings,
+  /// so the batched WorldDetails can read them back.
+  /// \return Result of the fetch operation.
+  public: Result FetchWorldDetails(const WorldIdentifier &_id,
+              WorldIdentifier &_world,
+              const std::vector<std::string> &_headers, const bool _save);
+
+  /// \brief Check if single details requests save what they fetch, which
+  /// they only do under ListingPolicy::STALE_WHILE_REVALIDATE.
+  /// \return True if details are saved.
+  public: bool SaveSingleDetails() const;
+
+  /// \brief Request a listing of models from the server.
+  /// \param[in] _id Identifier with the server, owner and optionally name.
+  /// \param[in] _route Route of the listing, such as "alice/models".
+  /// \param[out] _ids Models in the listing.
+  /// \return True if the server answered, even if nothing matched.
+  public: bool FetchModelListing(const ModelIdentifier &_id,
+              const std::string &_route, std::vector<ModelIdentifier> &_ids);
+
+  /// \brief Ask a server for the models matching a query.
+  /// \param[in] _server The server.
+  /// \param[in] _query The query.
+  /// \param[out] _ids Matching models, sorted and limited.
+  /// \return False if the server couldn't answer the query.
+  public: bool QueryModels(const ServerConfig &_server,
+              const ModelQuery &_query, std::vector<ModelIdentifier> &_ids);
+
+  /// \brief Answer a listing under ListingPolicy::STALE_WHILE_REVALIDATE.
+  /// \param[in] _id Identifier with the server, owner and optionally name.
+  /// \param[in] _route Route of the listing.
+  /// \return An iterator over the listing.
+  public: ModelIter StaleWhileRevalidate(const ModelIdentifier &_id,
+              const std::string &_route);
+
+  /// \brief Refresh a saved listing in the background, unless it's
+  /// already being refreshed.
+  /// \param[in] _id Identifier with the server, owner and optionally name.
+  /// \param[in] _route Route of the listing.
+  public: void Revalidate(const ModelIdentifier &_id,
+              const std::string &_route);
+
+  /// \brief Run a refresh in the background, unless one with the same key
+  /// is already running.
+  /// \param[in] _key Identifies what is refreshed.
+  /// \param[in] _refresh Refresh, returning true if it succeeded.
+  public: void Revalidate(const std::string &_key,
+              const std::function<bool()> &_refresh);
+
+  /// \brief Pin an unversioned model identifier to the version recorded
+  /// in the lockfile, if there's an entry for it.
+  /// \param[in, out] _id Model identifier to pin.
+  public: void Pin(ModelIdentifier &_id) const;
+
+  /// \brief Pin an unversioned world identifier to the version recorded
+  /// in the lockfile, if there's an entry for it.
+  /// \param[in, out] _id World identifier to pin.
+  public: void Pin(WorldIdentifier &_id) const;
+
+  /// \brief Check a downloaded archive against the hash recorded in the
+  /// lockfile for the same resource version.
+  /// \param[in] _server Server URL.
+  /// \param[in] _owner Resource owner.
+  /// \param[in] _type Resource type, "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \param[in] _version Downloaded version.
+  /// \param[in] _data Downloaded archive.
+  /// \return False if the lockfile pins this version to a different hash.
+  public: bool VerifyLock(const std::string &_server,
+              const std::string &_owner, const std::string &_type,
+              const std::string &_name, unsigned int _version,
+              const std::string &_data) const;
+
   /// \brief Client configuration
   public: ClientConfig config;
 
@@ -145,6 +273,22 @@ class ignition::fuel_tools::FuelClientPrivate
   /// \brief Local Cache
   public: std::shared_ptr<LocalCache> cache;
 
+  /// \brief Scheduler of model downloads. Declared after the cache, so its
+  /// workers are stopped before the cache is destroyed.
+  public: DownloadScheduler scheduler;
+
+  /// \brief Get the lockfile, which may be replaced concurrently.
+  /// \return The current lockfile, never null.
+  public: std::shared_ptr<const Lockfile> CurrentLockfile() const;
+
+  /// \brief Resource versions pinned by the lockfile. Replaced as a whole
+  /// by SetLockfile, never modified.
+  public: std::shared_ptr<const Lockfile> lockfile{
+      std::make_shared<const Lockfile>()};
+
+  /// \brief Protects lockfile.
+  public: mutable std::mutex lockfileMutex;
+
   /// \brief Regex to parse Ignition Fuel model URLs.
   public: std::unique_ptr<std::regex> urlModelRegex;
 
@@ -156,8 +300,110 @@ class ignition::fuel_tools::FuelClientPrivate
 
   /// \brief Regex to parse Ignition Fuel world file URLs.
   public: std::unique_ptr<std::regex> urlWorldFileRegex;
+
+  /// \brief Protects revalidating and revalidations.
+  public: std::mutex listingMutex;
+
+  /// \brief Listings being refreshed, by server and route.
+  public: std::set<std::string> revalidating;
+
+  /// \brief Background refreshes of listings. Declared last, so they're
+  /// waited for before anything they use is destroyed.
+  public: std::vector<std::future<void>> revalidations;
+};
+
+//////////////////////////////////////////////////
+/// \brief Hit and miss counters of one type of cache lookup.
+class CacheLookupMetrics
+{
+  /// \brief Constructor.
+  /// \param[in] _lookup Lookup type, such as "model".
+  public: explicit CacheLookupMetrics(const std::string &_lookup)
+    : hits(MetricsRegistry::Global().Counter("ign_fuel_cache_lookups_total",
+          "Local cache lookups, by lookup type and result.",
+          {{"lookup", _lookup}, {"result", "hit"}})),
+      misses(MetricsRegistry::Global().Counter(
+          "ign_fuel_cache_lookups_total",
+          "Local cache lookups, by lookup type and result.",
+          {{"lookup", _lookup}, {"result", "miss"}}))
+  {
+  }
+
+  /// \brief Count a lookup.
+  /// \param[in] _result Result of the lookup.
+  /// \return The same result.
+  public: Result Count(const Result &_result)
+  {
+    (_result.Type() == ResultType::FETCH_ALREADY_EXISTS ?
+        this->hits : this->misses).Increment();
+    return _result;
+  }
+
+  /// \brief Count a lookup.
+  /// \param[in] _found Whether the resource was found.
+  /// \return The same value.
+  public: bool Count(bool _found)
+  {
+    (_found ? this->hits : this->misses).Increment();
+    return _found;
+  }
+
+  /// \brief Lookups which found the resource.
+  public: MetricCounter &hits;
+
+  /// \brief Lookups which didn't find the resource.
+  public: MetricCounter &misses;
 };
 
+//////////////////////////////////////////////////
+/// \brief Transfer callback which reports the download phase of a model or
+/// world download, and aborts it once it's cancelled.
+/// \param[in] _options Download options, which must outlive the transfer.
+/// \return The callback.
+static RestTransferCallback downloadCallback(const DownloadOptions &_options)
+{
+  return [&_options](uint64_t _current, uint64_t _total)
+  {
+    return _options.Report(DownloadPhase::DOWNLOAD, _current, _total);
+  };
+}
+
+//////////////////////////////////////////////////
+/// \brief Key of a model download in the scheduler, which adds the
+/// headers of the request to it.
+/// \param[in] _id The model identifier.
+/// \return Unique name and version of the model.
+static std::string downloadKey(const ModelIdentifier &_id)
+{
+  return _id.UniqueName() + "/" + _id.VersionStr();
+}
+
+//////////////////////////////////////////////////
+/// \brief Run a task for each item of a batch, on a few threads at once.
+/// \param[in] _count Number of items.
+/// \param[in] _task Task, called with the index of an item.
+static void runBatch(size_t _count, const std::function<void(size_t)> &_task)
+{
+  // Enough requests in flight to hide the latency of the server, without
+  // opening too many connections to it.
+  const size_t kMaxThreads = 8;
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]()
+  {
+    for (size_t i = next++; i < _count; i = next++)
+      _task(i);
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(_count, kMaxThreads); ++i)
+    threads.emplace_back(worker);
+  worker();
+
+  for (auto &thread : threads)
+    thread.join();
+}
+
 //////////////////////////////////////////////////
 FuelClient::FuelClient()
   : FuelClient(ClientConfig(), Rest(), nullptr)
@@ -186,6 +432,21 @@ FuelClient::FuelClient(const ClientConfig &_config, const Rest &_rest,
     this->dataPtr->kModelFileUrlRegexStr));
   this->dataPtr->urlWorldFileRegex.reset(new std::regex(
     this->dataPtr->kWorldFileUrlRegexStr));
+
+  const auto &lockfilePath = this->dataPtr->config.LockfilePath();
+  if (!lockfilePath.empty())
+  {
+    auto lockfile = std::make_shared<Lockfile>();
+    if (lockfile->Load(lockfilePath))
+    {
+      this->dataPtr->lockfile = lockfile;
+    }
+    else
+    {
+      ignwarn << "Failed to load lockfile [" << lockfilePath
+              << "], resource versions won't be pinned." << std::endl;
+    }
+  }
 }
 
 //////////////////////////////////////////////////
@@ -199,26 +460,101 @@ ClientConfig &FuelClient::Config()
   return this->dataPtr->config;
 }
 
+//////////////////////////////////////////////////
+MetricsRegistry &FuelClient::Metrics() const
+{
+  return MetricsRegistry::Global();
+}
+
+//////////////////////////////////////////////////
+void FuelClient::SetLockfile(const Lockfile &_lockfile)
+{
+  auto lockfile = std::make_shared<const Lockfile>(_lockfile);
+  std::lock_guard<std::mutex> lock(this->dataPtr->lockfileMutex);
+  this->dataPtr->lockfile = lockfile;
+}
+
+//////////////////////////////////////////////////
+Lockfile FuelClient::CurrentLockfile() const
+{
+  return *this->dataPtr->CurrentLockfile();
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const Lockfile> FuelClientPrivate::CurrentLockfile() const
+{
+  std::lock_guard<std::mutex> lock(this->lockfileMutex);
+  return this->lockfile;
+}
+
 //////////////////////////////////////////////////
 Result FuelClient::ModelDetails(const ModelIdentifier &_id,
     ModelIdentifier &_model) const
 {
-  ignition::fuel_tools::Rest rest;
-  RestResponse resp;
+  TraceSpan span("FuelClient::ModelDetails", "client");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
 
-  auto serverUrl = _id.Server().Url().Str();
-  auto version = _id.Server().Version();
-  common::URIPath path;
-  path = path / _id.Owner() / "models" / _id.Name();
+  return this->dataPtr->FetchModelDetails(_id, _model, {},
+      this->dataPtr->SaveSingleDetails());
+}
 
-  resp = rest.Request(HttpMethod::GET, serverUrl, version,
-      path.Str(), {}, {}, "");
-  if (resp.statusCode != 200)
-    return Result(ResultType::FETCH_ERROR);
+//////////////////////////////////////////////////
+std::vector<Result> FuelClient::ModelDetails(
+    const std::vector<ModelIdentifier> &_ids,
+    std::vector<ModelIdentifier> &_models,
+    const std::vector<std::string> &_headers) const
+{
+  TraceSpan span("FuelClient::ModelDetails", "client");
+  if (span.Active())
+    span.SetDetail(std::to_string(_ids.size()) + " models");
 
-  _model = JSONParser::ParseModel(resp.data, _id.Server());
+  _models.assign(_ids.size(), ModelIdentifier());
+  std::vector<ResultType> types(_ids.size(), ResultType::UNKNOWN);
+  bool swr = this->dataPtr->config.ListingCachePolicy() ==
+      ListingPolicy::STALE_WHILE_REVALIDATE;
 
-  return Result(ResultType::FETCH);
+  runBatch(_ids.size(), [&](size_t _i)
+  {
+    const auto &id = _ids[_i];
+    common::URIPath path;
+    path = path / id.Owner() / "models" / id.Name();
+
+    // Details saved within the listing TTL are read from disk. Under
+    // stale-while-revalidate, older ones are too, and refreshed in the
+    // background.
+    CacheLookupMetrics metrics("model_details");
+    std::vector<ModelIdentifier> saved;
+    std::chrono::system_clock::time_point savedTime;
+    if (metrics.Count(this->dataPtr->cache->ModelListing(id.Server(),
+        path.Str(), saved, savedTime) && saved.size() == 1u))
+    {
+      bool stale = std::chrono::system_clock::now() - savedTime >=
+          this->dataPtr->config.ListingTtl();
+      if (!stale || swr)
+      {
+        if (stale)
+        {
+          auto *client = this->dataPtr.get();
+          client->Revalidate(id.Server().Url().Str() + "/" + path.Str(),
+              [client, id, _headers]()
+              {
+                ModelIdentifier model;
+                return static_cast<bool>(client->FetchModelDetails(id,
+                    model, _headers, true));
+              });
+        }
+        _models[_i] = saved.front();
+        types[_i] = ResultType::FETCH_ALREADY_EXISTS;
+        return;
+      }
+    }
+
+    types[_i] = this->dataPtr->FetchModelDetails(id, _models[_i], _headers,
+        true).Type();
+  });
+
+  return std::vector<Result>(types.begin(), types.end());
 }
 
 //////////////////////////////////////////////////
@@ -230,6 +566,14 @@ ModelIter FuelClient::Models(const ServerConfig &_server)
 //////////////////////////////////////////////////
 ModelIter FuelClient::Models(const ServerConfig &_server) const
 {
+  if (this->dataPtr->config.ListingCachePolicy() ==
+      ListingPolicy::STALE_WHILE_REVALIDATE)
+  {
+    ModelIdentifier id;
+    id.SetServer(_server);
+    return this->dataPtr->StaleWhileRevalidate(id, "models");
+  }
+
   ModelIter iter = ModelIterFactory::Create(this->dataPtr->rest,
       _server, "models");
 
@@ -251,26 +595,70 @@ ModelIter FuelClient::Models(const ServerConfig &_server) const
 Result FuelClient::WorldDetails(const WorldIdentifier &_id,
     WorldIdentifier &_world) const
 {
-  auto serverUrl = _id.Server().Url().Str();
+  TraceSpan span("FuelClient::WorldDetails", "client");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
 
-  if (serverUrl.empty() || _id.Owner().empty() || _id.Name().empty())
-    return Result(ResultType::FETCH_ERROR);
+  return this->dataPtr->FetchWorldDetails(_id, _world, {},
+      this->dataPtr->SaveSingleDetails());
+}
 
-  ignition::fuel_tools::Rest rest;
-  RestResponse resp;
+//////////////////////////////////////////////////
+std::vector<Result> FuelClient::WorldDetails(
+    const std::vector<WorldIdentifier> &_ids,
+    std::vector<WorldIdentifier> &_worlds,
+    const std::vector<std::string> &_headers) const
+{
+  TraceSpan span("FuelClient::WorldDetails", "client");
+  if (span.Active())
+    span.SetDetail(std::to_string(_ids.size()) + " worlds");
 
-  auto version = _id.Server().Version();
-  common::URIPath path;
-  path = path / _id.Owner() / "worlds" / _id.Name();
+  _worlds.assign(_ids.size(), WorldIdentifier());
+  std::vector<ResultType> types(_ids.size(), ResultType::UNKNOWN);
+  bool swr = this->dataPtr->config.ListingCachePolicy() ==
+      ListingPolicy::STALE_WHILE_REVALIDATE;
 
-  resp = rest.Request(HttpMethod::GET, serverUrl, version,
-      path.Str(), {}, {}, "");
-  if (resp.statusCode != 200)
-    return Result(ResultType::FETCH_ERROR);
+  runBatch(_ids.size(), [&](size_t _i)
+  {
+    const auto &id = _ids[_i];
+    common::URIPath path;
+    path = path / id.Owner() / "worlds" / id.Name();
+
+    // Details saved within the listing TTL are read from disk. Under
+    // stale-while-revalidate, older ones are too, and refreshed in the
+    // background.
+    CacheLookupMetrics metrics("world_details");
+    std::vector<WorldIdentifier> saved;
+    std::chrono::system_clock::time_point savedTime;
+    if (metrics.Count(this->dataPtr->cache->WorldListing(id.Server(),
+        path.Str(), saved, savedTime) && saved.size() == 1u))
+    {
+      bool stale = std::chrono::system_clock::now() - savedTime >=
+          this->dataPtr->config.ListingTtl();
+      if (!stale || swr)
+      {
+        if (stale)
+        {
+          auto *client = this->dataPtr.get();
+          client->Revalidate(id.Server().Url().Str() + "/" + path.Str(),
+              [client, id, _headers]()
+              {
+                WorldIdentifier world;
+                return static_cast<bool>(client->FetchWorldDetails(id,
+                    world, _headers, true));
+              });
+        }
+        _worlds[_i] = saved.front();
+        types[_i] = ResultType::FETCH_ALREADY_EXISTS;
+        return;
+      }
+    }
 
-  _world = JSONParser::ParseWorld(resp.data, _id.Server());
+    types[_i] = this->dataPtr->FetchWorldDetails(id, _worlds[_i], _headers,
+        true).Type();
+  });
 
-  return Result(ResultType::FETCH);
+  return std::vector<Result>(types.begin(), types.end());
 }
 
 //////////////////////////////////////////////////
@@ -302,12 +690,6 @@ ModelIter FuelClient::Models(const ModelIdentifier &_id)
 //////////////////////////////////////////////////
 ModelIter FuelClient::Models(const ModelIdentifier &_id) const
 {
-  // Check local cache first
-  ModelIter localIter = this->dataPtr->cache->MatchingModels(_id);
-  if (localIter)
-    return localIter;
-
-  // TODO(nkoenig) try to fetch model directly from a server
   // Note: ign-fuel-server doesn't like URLs ending in /
   common::URIPath path;
   if (!_id.Name().empty() && !_id.Owner().empty())
@@ -315,6 +697,19 @@ ModelIter FuelClient::Models(const ModelIdentifier &_id) const
   else if (!_id.Owner().empty())
     path = path / _id.Owner() / "models";
 
+  if (!path.Str().empty() &&
+      this->dataPtr->config.ListingCachePolicy() ==
+      ListingPolicy::STALE_WHILE_REVALIDATE)
+  {
+    return this->dataPtr->StaleWhileRevalidate(_id, path.Str());
+  }
+
+  // Check local cache first
+  ModelIter localIter = this->dataPtr->cache->MatchingModels(_id);
+  if (localIter)
+    return localIter;
+
+  // TODO(nkoenig) try to fetch model directly from a server
   if (path.Str().empty())
     return localIter;
 
@@ -324,6 +719,74 @@ ModelIter FuelClient::Models(const ModelIdentifier &_id) const
       path.Str());
 }
 
+//////////////////////////////////////////////////
+ModelIter FuelClient::Models(const ServerConfig &_server,
+    const ModelQuery &_query) const
+{
+  TraceSpan span("FuelClient::Models", "client");
+  if (span.Active())
+    span.SetDetail(_query.Text());
+
+  auto &metrics = MetricsRegistry::Global();
+  std::vector<ModelIdentifier> ids;
+  if (this->dataPtr->QueryModels(_server, _query, ids))
+  {
+    metrics.Counter("ign_fuel_model_queries_total",
+        "Model queries, by where they were answered.",
+        {{"source", "server"}}).Increment();
+    return ModelIterFactory::Create(ids);
+  }
+
+  ignwarn << "Server [" << _server.Url().Str() << "] couldn't answer the "
+          << "query, searching the local index instead." << std::endl;
+  metrics.Counter("ign_fuel_model_queries_total",
+      "Model queries, by where they were answered.",
+      {{"source", "local"}}).Increment();
+
+  for (const auto &id : this->dataPtr->cache->SearchModels(_server,
+      _query.Text(), _query.Tags()))
+  {
+    if (_query.Matches(id))
+      ids.push_back(id);
+  }
+  std::stable_sort(ids.begin(), ids.end(),
+      [&_query](const ModelIdentifier &_a, const ModelIdentifier &_b)
+      {
+        return _query.Before(_a, _b);
+      });
+  if (_query.Limit() > 0u && ids.size() > _query.Limit())
+    ids.resize(_query.Limit());
+
+  return ModelIterFactory::Create(ids);
+}
+
+//////////////////////////////////////////////////
+ModelIter FuelClient::SearchModels(const ServerConfig &_server,
+    const std::string &_text, const std::vector<std::string> &_tags,
+    size_t _limit) const
+{
+  TraceSpan span("FuelClient::SearchModels", "client");
+  if (span.Active())
+    span.SetDetail(_text);
+
+  return ModelIterFactory::Create(this->dataPtr->cache->SearchModels(
+      _server, _text, _tags, _limit));
+}
+
+//////////////////////////////////////////////////
+Result FuelClient::UpdateSearchIndex(const ServerConfig &_server)
+{
+  ModelIdentifier id;
+  id.SetServer(_server);
+
+  std::vector<ModelIdentifier> ids;
+  if (!this->dataPtr->FetchModelListing(id, "models", ids))
+    return Result(ResultType::FETCH_ERROR);
+
+  this->dataPtr->cache->SaveModelListing(_server, "models", ids);
+  return Result(ResultType::FETCH);
+}
+
 //////////////////////////////////////////////////
 WorldIter FuelClient::Worlds(const WorldIdentifier &_id) const
 {
@@ -345,6 +808,184 @@ WorldIter FuelClient::Worlds(const WorldIdentifier &_id) const
   return WorldIterFactory::Create(rest, _id.Server(), path.Str());
 }
 
+//////////////////////////////////////////////////
+ModelIter FuelClient::ModelsFromAllServers(const std::string &_owner) const
+{
+  auto servers = this->dataPtr->config.Servers();
+
+  // Whole catalogs may be served from their snapshots.
+  bool snapshots = _owner.empty() &&
+      this->dataPtr->config.ListingCachePolicy() ==
+      ListingPolicy::STALE_WHILE_REVALIDATE;
+
+  // Request every server concurrently
+  std::vector<std::future<std::vector<ModelIdentifier>>> futures;
+  std::vector<char> fetched(servers.size(), 0);
+  for (size_t i = 0; i < servers.size(); ++i)
+  {
+    futures.push_back(std::async(std::launch::async, [&, i]()
+    {
+      std::vector<ModelIdentifier> ids;
+      if (snapshots)
+      {
+        // Falls back to the cache on its own.
+        for (auto iter = this->Models(servers[i]); iter; ++iter)
+          ids.push_back(iter->Identification());
+        fetched[i] = 1;
+        return ids;
+      }
+
+      ModelIdentifier id;
+      id.SetServer(servers[i]);
+      id.SetOwner(_owner);
+
+      auto result = this->StreamModels(id,
+          [&ids](const std::vector<ModelIdentifier> &_page)
+          {
+            ids.insert(ids.end(), _page.begin(), _page.end());
+            return true;
+          });
+      fetched[i] = result ? 1 : 0;
+      return ids;
+    }));
+  }
+
+  // Merge in configuration order
+  std::vector<ModelIdentifier> ids;
+  for (size_t i = 0; i < servers.size(); ++i)
+  {
+    auto serverIds = futures[i].get();
+    if (!fetched[i])
+    {
+      ignwarn << "Failed to fetch models from server, returning cached "
+              << "models." << std::endl << servers[i].AsString() << std::endl;
+
+      ModelIdentifier id;
+      id.SetServer(servers[i]);
+      id.SetOwner(_owner);
+      for (auto iter = this->dataPtr->cache->MatchingModels(id); iter; ++iter)
+        serverIds.push_back(iter->Identification());
+    }
+    ids.insert(ids.end(), serverIds.begin(), serverIds.end());
+  }
+
+  return ModelIterFactory::Create(ids);
+}
+
+//////////////////////////////////////////////////
+WorldIter FuelClient::WorldsFromAllServers(const std::string &_owner) const
+{
+  auto servers = this->dataPtr->config.Servers();
+
+  // Request every server concurrently
+  std::vector<std::future<std::vector<WorldIdentifier>>> futures;
+  std::vector<char> fetched(servers.size(), 0);
+  for (size_t i = 0; i < servers.size(); ++i)
+  {
+    futures.push_back(std::async(std::launch::async, [&, i]()
+    {
+      WorldIdentifier id;
+      id.SetServer(servers[i]);
+      id.SetOwner(_owner);
+
+      std::vector<WorldIdentifier> ids;
+      auto result = this->StreamWorlds(id,
+          [&ids](const std::vector<WorldIdentifier> &_page)
+          {
+            ids.insert(ids.end(), _page.begin(), _page.end());
+            return true;
+          });
+      fetched[i] = result ? 1 : 0;
+      return ids;
+    }));
+  }
+
+  // Merge in configuration order
+  std::vector<WorldIdentifier> ids;
+  for (size_t i = 0; i < servers.size(); ++i)
+  {
+    auto serverIds = futures[i].get();
+    if (!fetched[i])
+    {
+      ignwarn << "Failed to fetch worlds from server, returning cached "
+              << "worlds." << std::endl << servers[i].AsString() << std::endl;
+
+      WorldIdentifier id;
+      id.SetServer(servers[i]);
+      id.SetOwner(_owner);
+      for (auto iter = this->dataPtr->cache->MatchingWorlds(id); iter; ++iter)
+        serverIds.push_back(iter);
+    }
+    ids.insert(ids.end(), serverIds.begin(), serverIds.end());
+  }
+
+  return WorldIterFactory::Create(ids);
+}
+
+//////////////////////////////////////////////////
+Result FuelClient::StreamModels(const ModelIdentifier &_id,
+    const std::function<bool(const std::vector<ModelIdentifier> &)>
+    &_callback) const
+{
+  std::string path = "models";
+  if (!_id.Owner().empty())
+    path = (common::URIPath() / _id.Owner() / "models").Str();
+
+  std::vector<std::string> headers = {"Accept: application/json"};
+  for (int page = 1; ; ++page)
+  {
+    auto resp = this->dataPtr->rest.Request(HttpMethod::GET,
+        _id.Server().Url().Str(), _id.Server().Version(), path,
+        {"page=" + std::to_string(page)}, headers, "");
+
+    // Past the last page, the server either fails or returns null
+    if (resp.data == "null\n" || resp.statusCode != 200)
+    {
+      if (page == 1)
+        return Result(ResultType::FETCH_ERROR);
+      break;
+    }
+
+    auto ids = JSONParser::ParseModels(resp.data, _id.Server());
+    if (ids.empty() || !_callback(ids))
+      break;
+  }
+
+  return Result(ResultType::FETCH);
+}
+
+//////////////////////////////////////////////////
+Result FuelClient::StreamWorlds(const WorldIdentifier &_id,
+    const std::function<bool(const std::vector<WorldIdentifier> &)>
+    &_callback) const
+{
+  std::string path = "worlds";
+  if (!_id.Owner().empty())
+    path = (common::URIPath() / _id.Owner() / "worlds").Str();
+
+  std::vector<std::string> headers = {"Accept: application/json"};
+  for (int page = 1; ; ++page)
+  {
+    auto resp = this->dataPtr->rest.Request(HttpMethod::GET,
+        _id.Server().Url().Str(), _id.Server().Version(), path,
+        {"page=" + std::to_string(page)}, headers, "");
+
+    // Past the last page, the server either fails or returns null
+    if (resp.data == "null\n" || resp.statusCode != 200)
+    {
+      if (page == 1)
+        return Result(ResultType::FETCH_ERROR);
+      break;
+    }
+
+    auto ids = JSONParser::ParseWorlds(resp.data, _id.Server());
+    if (ids.empty() || !_callback(ids))
+      break;
+  }
+
+  return Result(ResultType::FETCH);
+}
+
 //////////////////////////////////////////////////
 Result FuelClient::UploadModel(const std::string &_pathToModelDir,
     const ModelIdentifier &_id, const std::vector<std::string> &_headers,
@@ -545,13 +1186,26 @@ Result FuelClient::DeleteUrl(const ignition::common::URI &_uri,
 //////////////////////////////////////////////////
 Result FuelClient::DownloadModel(const ModelIdentifier &_id)
 {
-  return this->DownloadModel(_id, {});
+  return this->DownloadModel(_id, DownloadOptions());
 }
 
 //////////////////////////////////////////////////
 Result FuelClient::DownloadModel(const ModelIdentifier &_id,
     const std::vector<std::string> &_headers)
 {
+  DownloadOptions options;
+  options.SetHeaders(_headers);
+  return this->DownloadModel(_id, options);
+}
+
+//////////////////////////////////////////////////
+Result FuelClientPrivate::DownloadModel(const ModelIdentifier &_id,
+    const DownloadOptions &_options)
+{
+  TraceSpan span("FuelClient::DownloadModel", "client");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
   // Server config
   if (!_id.Server().Url().Valid() || _id.Server().Version().empty())
   {
@@ -565,13 +1219,34 @@ Result FuelClient::DownloadModel(const ModelIdentifier &_id,
   route = route / _id.Owner() / "models" / _id.Name() / _id.VersionStr() /
         (_id.Name() + ".zip");
 
+  if (_options.Cancellation().Cancelled())
+    return Result(ResultType::FETCH_CANCELLED);
+
+  // A newer version of a cached model only needs the files which changed.
+  ModelIdentifier deltaId;
+  std::string fileTree;
+  if (this->config.DeltaUpdates() &&
+      this->DownloadModelDelta(_id, _options, deltaId, fileTree))
+  {
+    return Result(ResultType::FETCH);
+  }
+  if (_options.Cancellation().Cancelled())
+    return Result(ResultType::FETCH_CANCELLED);
+
   ignmsg << "Downloading model [" << _id.UniqueName() << "]" << std::endl;
 
   // Request
   ignition::fuel_tools::Rest rest;
+  rest.SetTransferCallback(downloadCallback(_options));
   RestResponse resp;
   resp = rest.Request(HttpMethod::GET, _id.Server().Url().Str(),
-      _id.Server().Version(), route.Str(), {}, _headers, "");
+      _id.Server().Version(), route.Str(), {}, _options.Headers(), "");
+  if (_options.Cancellation().Cancelled())
+  {
+    ignmsg << "Cancelled download of model [" << _id.UniqueName() << "]"
+           << std::endl;
+    return Result(ResultType::FETCH_CANCELLED);
+  }
   if (resp.statusCode != 200)
   {
     ignerr << "Failed to download model." << std::endl
@@ -604,17 +1279,242 @@ Result FuelClient::DownloadModel(const ModelIdentifier &_id,
   }
   newId.SetVersion(version);
 
+  if (!this->VerifyLock(newId.Server().Url().Str(), newId.Owner(), "models",
+        newId.Name(), version, resp.data))
+  {
+    return Result(ResultType::FETCH_ERROR);
+  }
+
   // Save
   // Note that the save function doesn't return the path
-  if (!this->dataPtr->cache->SaveModel(newId, resp.data, true))
-    return Result(ResultType::FETCH_ERROR);
+  if (!this->cache->SaveModel(newId, resp.data, true, _options))
+  {
+    return Result(_options.Cancellation().Cancelled() ?
+        ResultType::FETCH_CANCELLED : ResultType::FETCH_ERROR);
+  }
+
+  // Keep the file tree which was fetched for the delta, so the next update
+  // doesn't need to fetch it again.
+  if (!fileTree.empty() && deltaId.Version() == newId.Version())
+    this->cache->SaveFileTree(newId, fileTree);
 
   return Result(ResultType::FETCH);
 }
 
+//////////////////////////////////////////////////
+bool FuelClientPrivate::DownloadModelDelta(const ModelIdentifier &_id,
+    const DownloadOptions &_options, ModelIdentifier &_target,
+    std::string &_fileTree)
+{
+  // Find the latest cached version.
+  ModelIdentifier previousId = _id;
+  previousId.SetVersion(0);
+  Model previous = this->cache->MatchingColdModel(previousId);
+  if (!previous)
+    return false;
+  unsigned int previousVersion = previous.Identification().Version();
+
+  TraceSpan span("FuelClient::DownloadModelDelta", "client");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
+  ignition::fuel_tools::Rest rest;
+  rest.SetTransferCallback(downloadCallback(_options));
+  auto request = [&](const common::URIPath &_route)
+  {
+    return rest.Request(HttpMethod::GET, _id.Server().Url().Str(),
+        _id.Server().Version(), _route.Str(), {}, _options.Headers(), "");
+  };
+
+  common::URIPath modelRoute;
+  modelRoute = modelRoute / _id.Owner() / "models" / _id.Name();
+
+  // Resolve the tip, to know whether the cached version is outdated.
+  _target = _id;
+  if (_target.Version() == 0)
+  {
+    auto resp = request(modelRoute);
+    if (resp.statusCode != 200)
+      return false;
+    _target.SetVersion(
+        JSONParser::ParseModel(resp.data, _id.Server()).Version());
+  }
+  if (_target.Version() <= previousVersion)
+    return false;
+
+  // Versions pinned to an archive hash need the archive to be verified.
+  LockEntry entry;
+  if (this->CurrentLockfile()->Find(_id.Server().Url().Str(), _id.Owner(),
+        "models", _id.Name(), entry) && entry.version == _target.Version() &&
+      !entry.hash.empty())
+  {
+    return false;
+  }
+
+  static auto &applied = MetricsRegistry::Global().Counter(
+      "ign_fuel_delta_updates_total",
+      "Model updates attempted from a cached previous version.",
+      {{"result", "applied"}});
+  static auto &fallback = MetricsRegistry::Global().Counter(
+      "ign_fuel_delta_updates_total",
+      "Model updates attempted from a cached previous version.",
+      {{"result", "fallback"}});
+
+  // File trees of both versions. The previous one is usually cached.
+  std::map<std::string, std::string> newFiles;
+  std::map<std::string, std::string> previousFiles;
+  {
+    auto resp = request(modelRoute / _target.VersionStr() / "files");
+    if (resp.statusCode != 200 ||
+        !JSONParser::ParseFileTree(resp.data, newFiles))
+    {
+      fallback.Increment();
+      return false;
+    }
+    _fileTree = resp.data;
+  }
+
+  std::string previousTree = this->cache->FileTree(previous.PathToModel());
+  if (previousTree.empty())
+  {
+    auto resp = request(modelRoute / std::to_string(previousVersion) /
+        "files");
+    if (resp.statusCode == 200)
+      previousTree = resp.data;
+  }
+  if (!JSONParser::ParseFileTree(previousTree, previousFiles))
+  {
+    fallback.Increment();
+    return false;
+  }
+
+  // SDF files and model.config are always fetched, since the cached copies
+  // were rewritten to point to the previous version's directory.
+  std::vector<std::string> unchanged;
+  std::vector<std::string> changed;
+  for (const auto &file : newFiles)
+  {
+    auto old = previousFiles.find(file.first);
+    bool rewritten = common::EndsWith(file.first, ".sdf") ||
+        common::basename(file.first) == "model.config";
+    if (!rewritten && !file.second.empty() && old != previousFiles.end() &&
+        old->second == file.second &&
+        common::exists(common::joinPaths(previous.PathToModel(), file.first)))
+    {
+      unchanged.push_back(file.first);
+    }
+    else
+    {
+      changed.push_back(file.first);
+    }
+  }
+
+  // Without anything to reuse, the archive is cheaper than file by file.
+  if (unchanged.empty())
+  {
+    fallback.Increment();
+    return false;
+  }
+
+  ignmsg << "Updating model [" << _id.UniqueName() << "] from version ["
+         << previousVersion << "] to [" << _target.Version() << "], "
+         << changed.size() << " of " << newFiles.size() << " files changed"
+         << std::endl;
+
+  std::map<std::string, std::string> changedData;
+  for (const auto &file : changed)
+  {
+    common::URIPath route = modelRoute / _target.VersionStr() / "files";
+    for (const auto &segment : common::Split(file, '/'))
+    {
+      if (!segment.empty())
+        route = route / segment;
+    }
+
+    auto resp = request(route);
+    if (_options.Cancellation().Cancelled())
+      return false;
+    if (resp.statusCode != 200)
+    {
+      ignwarn << "Failed to download file [" << file << "] of model ["
+              << _id.UniqueName() << "], downloading the whole model."
+              << std::endl;
+      fallback.Increment();
+      return false;
+    }
+    changedData[file] = resp.data;
+  }
+
+  if (!_options.Report(DownloadPhase::FIX_PATHS, 0, 1))
+    return false;
+
+  if (!this->cache->SaveModelDelta(_target, previous.PathToModel(), unchanged,
+      changedData, _fileTree))
+  {
+    fallback.Increment();
+    return false;
+  }
+  _options.Report(DownloadPhase::FIX_PATHS, 1, 1);
+
+  applied.Increment();
+  return true;
+}
+
+//////////////////////////////////////////////////
+Result FuelClient::DownloadModel(const ModelIdentifier &_id,
+    const DownloadOptions &_options)
+{
+  // Blocking downloads run on the calling thread, so they're not limited
+  // by the concurrency of any priority class. A queued download of the same
+  // model is taken over, or waited for if it's already running.
+  auto *client = this->dataPtr.get();
+  return this->dataPtr->scheduler.Run(downloadKey(_id), _options,
+      [client, &_id](const DownloadOptions &_combined)
+      {
+        return client->DownloadModel(_id, _combined);
+      });
+}
+
+//////////////////////////////////////////////////
+std::shared_future<Result> FuelClient::QueueDownloadModel(
+    const ModelIdentifier &_id, DownloadPriority _priority,
+    const DownloadOptions &_options)
+{
+  auto *client = this->dataPtr.get();
+  return this->dataPtr->scheduler.Schedule(downloadKey(_id),
+      _priority, _options, [client, _id](const DownloadOptions &_combined)
+      {
+        return client->DownloadModel(_id, _combined);
+      });
+}
+
+//////////////////////////////////////////////////
+void FuelClient::SetDownloadConcurrency(DownloadPriority _priority,
+    unsigned int _jobs)
+{
+  this->dataPtr->scheduler.SetConcurrency(_priority, _jobs);
+}
+
+//////////////////////////////////////////////////
+unsigned int FuelClient::DownloadConcurrency(DownloadPriority _priority) const
+{
+  return this->dataPtr->scheduler.Concurrency(_priority);
+}
+
 //////////////////////////////////////////////////
 Result FuelClient::DownloadWorld(WorldIdentifier &_id)
 {
+  return this->DownloadWorld(_id, DownloadOptions());
+}
+
+//////////////////////////////////////////////////
+Result FuelClient::DownloadWorld(WorldIdentifier &_id,
+    const DownloadOptions &_options)
+{
+  TraceSpan span("FuelClient::DownloadWorld", "client");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
   // Server config
   if (!_id.Server().Url().Valid() || _id.Server().Version().empty())
   {
@@ -628,13 +1528,23 @@ Result FuelClient::DownloadWorld(WorldIdentifier &_id)
   route = route / _id.Owner() / "worlds" / _id.Name() / _id.VersionStr() /
         (_id.Name() + ".zip");
 
+  if (_options.Cancellation().Cancelled())
+    return Result(ResultType::FETCH_CANCELLED);
+
   ignmsg << "Downloading world [" << _id.UniqueName() << "]" << std::endl;
 
   // Request
   ignition::fuel_tools::Rest rest;
+  rest.SetTransferCallback(downloadCallback(_options));
   RestResponse resp;
   resp = rest.Request(HttpMethod::GET, _id.Server().Url().Str(),
-      _id.Server().Version(), route.Str(), {}, {}, "");
+      _id.Server().Version(), route.Str(), {}, _options.Headers(), "");
+  if (_options.Cancellation().Cancelled())
+  {
+    ignmsg << "Cancelled download of world [" << _id.UniqueName() << "]"
+           << std::endl;
+    return Result(ResultType::FETCH_CANCELLED);
+  }
   if (resp.statusCode != 200)
   {
     ignerr << "Failed to download world." << std::endl
@@ -667,9 +1577,18 @@ Result FuelClient::DownloadWorld(WorldIdentifier &_id)
   }
   _id.SetVersion(version);
 
-  // Save
-  if (!this->dataPtr->cache->SaveWorld(_id, resp.data, true))
+  if (!this->dataPtr->VerifyLock(_id.Server().Url().Str(), _id.Owner(),
+        "worlds", _id.Name(), version, resp.data))
+  {
     return Result(ResultType::FETCH_ERROR);
+  }
+
+  // Save
+  if (!this->dataPtr->cache->SaveWorld(_id, resp.data, true, _options))
+  {
+    return Result(_options.Cancellation().Cancelled() ?
+        ResultType::FETCH_CANCELLED : ResultType::FETCH_ERROR);
+  }
 
   return Result(ResultType::FETCH);
 }
@@ -678,6 +1597,8 @@ Result FuelClient::DownloadWorld(WorldIdentifier &_id)
 bool FuelClient::ParseModelUrl(const common::URI &_modelUrl,
     ModelIdentifier &_id)
 {
+  TraceSpan span("FuelClient::ParseModelUrl", "url");
+
   if (!_modelUrl.Valid())
     return false;
 
@@ -691,8 +1612,6 @@ bool FuelClient::ParseModelUrl(const common::URI &_modelUrl,
   std::string modelName;
   std::string modelVersion;
 
-  std::regex_match(urlStr, match, *this->dataPtr->urlModelRegex);
-
   if (std::regex_match(urlStr, match, *this->dataPtr->urlModelRegex) &&
       match.size() >= 5u)
   {
@@ -738,6 +1657,7 @@ bool FuelClient::ParseModelUrl(const common::URI &_modelUrl,
   _id.SetOwner(owner);
   _id.SetName(modelName);
   _id.SetVersionStr(modelVersion);
+  this->dataPtr->Pin(_id);
 
   return true;
 }
@@ -746,6 +1666,8 @@ bool FuelClient::ParseModelUrl(const common::URI &_modelUrl,
 bool FuelClient::ParseWorldUrl(const common::URI &_worldUrl,
     WorldIdentifier &_id)
 {
+  TraceSpan span("FuelClient::ParseWorldUrl", "url");
+
   if (!_worldUrl.Valid())
     return false;
 
@@ -759,8 +1681,6 @@ bool FuelClient::ParseWorldUrl(const common::URI &_worldUrl,
   std::string worldName;
   std::string worldVersion;
 
-  std::regex_match(urlStr, match, *this->dataPtr->urlWorldRegex);
-
   if (std::regex_match(urlStr, match, *this->dataPtr->urlWorldRegex) &&
       match.size() >= 5u)
   {
@@ -806,6 +1726,7 @@ bool FuelClient::ParseWorldUrl(const common::URI &_worldUrl,
   _id.SetOwner(owner);
   _id.SetName(worldName);
   _id.SetVersionStr(worldVersion);
+  this->dataPtr->Pin(_id);
 
   return true;
 }
@@ -814,6 +1735,8 @@ bool FuelClient::ParseWorldUrl(const common::URI &_worldUrl,
 bool FuelClient::ParseModelFileUrl(const common::URI &_fileUrl,
     ModelIdentifier &_id, std::string &_filePath)
 {
+  TraceSpan span("FuelClient::ParseModelFileUrl", "url");
+
   if (!_fileUrl.Valid())
     return false;
 
@@ -874,6 +1797,7 @@ bool FuelClient::ParseModelFileUrl(const common::URI &_fileUrl,
   _id.SetOwner(owner);
   _id.SetName(modelName);
   _id.SetVersionStr(modelVersion);
+  this->dataPtr->Pin(_id);
   _filePath = file;
 
   return true;
@@ -883,6 +1807,8 @@ bool FuelClient::ParseModelFileUrl(const common::URI &_fileUrl,
 bool FuelClient::ParseWorldFileUrl(const common::URI &_fileUrl,
     WorldIdentifier &_id, std::string &_filePath)
 {
+  TraceSpan span("FuelClient::ParseWorldFileUrl", "url");
+
   if (!_fileUrl.Valid())
     return false;
 
@@ -943,6 +1869,7 @@ bool FuelClient::ParseWorldFileUrl(const common::URI &_fileUrl,
   _id.SetOwner(owner);
   _id.SetName(worldName);
   _id.SetVersionStr(worldVersion);
+  this->dataPtr->Pin(_id);
   _filePath = file;
 
   return true;
@@ -951,6 +1878,13 @@ bool FuelClient::ParseWorldFileUrl(const common::URI &_fileUrl,
 //////////////////////////////////////////////////
 Result FuelClient::DownloadModel(const common::URI &_modelUrl,
   std::string &_path)
+{
+  return this->DownloadModel(_modelUrl, _path, DownloadOptions());
+}
+
+//////////////////////////////////////////////////
+Result FuelClient::DownloadModel(const common::URI &_modelUrl,
+  std::string &_path, const DownloadOptions &_options)
 {
   // Get data from URL
   ModelIdentifier id;
@@ -960,7 +1894,7 @@ Result FuelClient::DownloadModel(const common::URI &_modelUrl,
   }
 
   // Download
-  Result result = this->DownloadModel(id);
+  Result result = this->DownloadModel(id, _options);
   if (!result)
     return result;
 
@@ -970,7 +1904,7 @@ Result FuelClient::DownloadModel(const common::URI &_modelUrl,
   // We need to figure out the version for the tip
   if (id.Version() == 0 || id.VersionStr() == "tip")
   {
-    Model model = this->dataPtr->cache->MatchingModel(id);
+    Model model = this->dataPtr->cache->MatchingColdModel(id);
     id.SetVersion(model.Identification().Version());
   }
 
@@ -981,9 +1915,78 @@ Result FuelClient::DownloadModel(const common::URI &_modelUrl,
   return result;
 }
 
+//////////////////////////////////////////////////
+Result FuelClient::DownloadModelFile(const common::URI &_fileUrl,
+    std::string &_path, const std::vector<std::string> &_headers)
+{
+  TraceSpan span("FuelClient::DownloadModelFile", "client");
+  if (span.Active())
+    span.SetDetail(_fileUrl.Str());
+
+  ModelIdentifier id;
+  std::string filePath;
+  if (!this->ParseModelFileUrl(_fileUrl, id, filePath) || filePath.empty())
+    return Result(ResultType::FETCH_ERROR);
+
+  // Files are saved under a version number, so resolve the tip first
+  if (id.Version() == 0)
+  {
+    ModelIdentifier details;
+    if (!this->dataPtr->FetchModelDetails(id, details, _headers,
+        this->dataPtr->SaveSingleDetails()) ||
+        details.Version() == 0)
+    {
+      ignerr << "Unable to get the latest version of model ["
+             << id.UniqueName() << "]" << std::endl;
+      return Result(ResultType::FETCH_ERROR);
+    }
+    id.SetVersion(details.Version());
+  }
+
+  common::URIPath route;
+  route = route / id.Owner() / "models" / id.Name() / id.VersionStr() /
+      "files";
+  for (const auto &segment : common::Split(filePath, '/'))
+  {
+    if (!segment.empty())
+      route = route / segment;
+  }
+
+  ignmsg << "Downloading file [" << filePath << "] of model ["
+         << id.UniqueName() << "]" << std::endl;
+
+  auto resp = this->dataPtr->rest.Request(HttpMethod::GET,
+      id.Server().Url().Str(), id.Server().Version(), route.Str(), {},
+      _headers, "");
+  if (resp.statusCode != 200)
+  {
+    ignerr << "Failed to download model file." << std::endl
+           << "  Server: " << id.Server().Url().Str() << std::endl
+           << "  Route: " << route.Str() << std::endl
+           << "  REST response code: " << resp.statusCode << std::endl;
+    return Result(ResultType::FETCH_ERROR);
+  }
+
+  if (!this->dataPtr->cache->SaveModelFile(id, filePath, resp.data))
+    return Result(ResultType::FETCH_ERROR);
+
+  _path = common::joinPaths(this->Config().CacheLocation(),
+      id.Server().Url().Path().Str(), id.Owner(), "models", id.Name(),
+      id.VersionStr(), filePath);
+
+  return Result(ResultType::FETCH);
+}
+
 //////////////////////////////////////////////////
 Result FuelClient::DownloadWorld(const common::URI &_worldUrl,
   std::string &_path)
+{
+  return this->DownloadWorld(_worldUrl, _path, DownloadOptions());
+}
+
+//////////////////////////////////////////////////
+Result FuelClient::DownloadWorld(const common::URI &_worldUrl,
+  std::string &_path, const DownloadOptions &_options)
 {
   // Get data from URL
   WorldIdentifier id;
@@ -993,7 +1996,7 @@ Result FuelClient::DownloadWorld(const common::URI &_worldUrl,
   }
 
   // Download
-  auto result = this->DownloadWorld(id);
+  auto result = this->DownloadWorld(id, _options);
   if (!result)
     return result;
 
@@ -1005,19 +2008,26 @@ Result FuelClient::DownloadWorld(const common::URI &_worldUrl,
 //////////////////////////////////////////////////
 bool FuelClient::CachedModel(const common::URI &_modelUrl)
 {
+  static CacheLookupMetrics metrics("model");
   // Get data from URL
   ModelIdentifier id;
   if (!this->ParseModelUrl(_modelUrl, id))
     return Result(ResultType::FETCH_ERROR);
 
   // Check local cache
-  return this->dataPtr->cache->MatchingModel(id) ? true : false;
+  return metrics.Count(
+      static_cast<bool>(this->dataPtr->cache->MatchingColdModel(id)));
 }
 
 //////////////////////////////////////////////////
 Result FuelClient::CachedModel(const common::URI &_modelUrl,
   std::string &_path)
 {
+  static CacheLookupMetrics metrics("model");
+  TraceSpan span("FuelClient::CachedModel", "cache");
+  if (span.Active())
+    span.SetDetail(_modelUrl.Str());
+
   // Get data from URL
   ModelIdentifier id;
   if (!this->ParseModelUrl(_modelUrl, id))
@@ -1030,28 +2040,30 @@ Result FuelClient::CachedModel(const common::URI &_modelUrl,
   if (modelIter)
   {
     _path = modelIter.PathToModel();
-    return Result(ResultType::FETCH_ALREADY_EXISTS);
+    return metrics.Count(Result(ResultType::FETCH_ALREADY_EXISTS));
   }
 
-  return Result(ResultType::FETCH_ERROR);
+  return metrics.Count(Result(ResultType::FETCH_ERROR));
 }
 
 //////////////////////////////////////////////////
 bool FuelClient::CachedWorld(const common::URI &_worldUrl)
 {
+  static CacheLookupMetrics metrics("world");
   // Get data from URL
   WorldIdentifier id;
   if (!this->ParseWorldUrl(_worldUrl, id))
     return Result(ResultType::FETCH_ERROR);
 
   // Check local cache
-  return this->dataPtr->cache->MatchingWorld(id);
+  return metrics.Count(this->dataPtr->cache->MatchingColdWorld(id));
 }
 
 //////////////////////////////////////////////////
 Result FuelClient::CachedWorld(const common::URI &_worldUrl,
   std::string &_path)
 {
+  static CacheLookupMetrics metrics("world");
   // Get data from URL
   WorldIdentifier id;
   if (!this->ParseWorldUrl(_worldUrl, id))
@@ -1064,16 +2076,21 @@ Result FuelClient::CachedWorld(const common::URI &_worldUrl,
   if (success)
   {
     _path = id.LocalPath();
-    return Result(ResultType::FETCH_ALREADY_EXISTS);
+    return metrics.Count(Result(ResultType::FETCH_ALREADY_EXISTS));
   }
 
-  return Result(ResultType::FETCH_ERROR);
+  return metrics.Count(Result(ResultType::FETCH_ERROR));
 }
 
 //////////////////////////////////////////////////
 Result FuelClient::CachedModelFile(const common::URI &_fileUrl,
   std::string &_path)
 {
+  static CacheLookupMetrics metrics("model_file");
+  TraceSpan span("FuelClient::CachedModelFile", "cache");
+  if (span.Active())
+    span.SetDetail(_fileUrl.Str());
+
   // Get data from URL
   ModelIdentifier id;
   std::string filePath;
@@ -1087,7 +2104,16 @@ Result FuelClient::CachedModelFile(const common::URI &_fileUrl,
   auto modelIter = this->dataPtr->cache->MatchingModel(id);
 
   if (!modelIter)
-    return Result(ResultType::FETCH_ERROR);
+  {
+    // The file may have been fetched on its own
+    auto partialPath =
+        this->dataPtr->cache->MatchingPartialModelFile(id, filePath);
+    if (partialPath.empty())
+      return metrics.Count(Result(ResultType::FETCH_ERROR));
+
+    _path = partialPath;
+    return metrics.Count(Result(ResultType::FETCH_ALREADY_EXISTS));
+  }
 
   auto modelPath = modelIter.PathToModel();
 
@@ -1097,16 +2123,17 @@ Result FuelClient::CachedModelFile(const common::URI &_fileUrl,
   if (common::exists(filePath))
   {
     _path = filePath;
-    return Result(ResultType::FETCH_ALREADY_EXISTS);
+    return metrics.Count(Result(ResultType::FETCH_ALREADY_EXISTS));
   }
 
-  return Result(ResultType::FETCH_ERROR);
+  return metrics.Count(Result(ResultType::FETCH_ERROR));
 }
 
 //////////////////////////////////////////////////
 Result FuelClient::CachedWorldFile(const common::URI &_fileUrl,
   std::string &_path)
 {
+  static CacheLookupMetrics metrics("world_file");
   // Get data from URL
   WorldIdentifier id;
   std::string filePath;
@@ -1120,7 +2147,7 @@ Result FuelClient::CachedWorldFile(const common::URI &_fileUrl,
   auto success = this->dataPtr->cache->MatchingWorld(id);
 
   if (!success)
-    return Result(ResultType::FETCH_ERROR);
+    return metrics.Count(Result(ResultType::FETCH_ERROR));
 
   auto worldPath = id.LocalPath();
 
@@ -1130,10 +2157,319 @@ Result FuelClient::CachedWorldFile(const common::URI &_fileUrl,
   if (common::exists(filePath))
   {
     _path = filePath;
-    return Result(ResultType::FETCH_ALREADY_EXISTS);
+    return metrics.Count(Result(ResultType::FETCH_ALREADY_EXISTS));
+  }
+
+  return metrics.Count(Result(ResultType::FETCH_ERROR));
+}
+
+//////////////////////////////////////////////////
+bool FuelClientPrivate::FetchModelListing(const ModelIdentifier &_id,
+    const std::string &_route, std::vector<ModelIdentifier> &_ids)
+{
+  TraceSpan span("FuelClient::FetchModelListing", "client");
+  if (span.Active())
+    span.SetDetail(_route);
+
+  Rest rest(this->rest);
+  std::vector<std::string> headers = {"Accept: application/json"};
+  _ids.clear();
+
+  // A single model is returned as an object, not as a page.
+  if (!_id.Name().empty())
+  {
+    auto resp = rest.Request(HttpMethod::GET, _id.Server().Url().Str(),
+        _id.Server().Version(), _route, {}, headers, "");
+    if (resp.statusCode == 404)
+      return true;
+    if (resp.statusCode != 200)
+      return false;
+
+    auto model = JSONParser::ParseModel(resp.data, _id.Server());
+    if (!model.Name().empty())
+      _ids.push_back(model);
+    return true;
+  }
+
+  for (int page = 1; ; ++page)
+  {
+    auto resp = rest.Request(HttpMethod::GET, _id.Server().Url().Str(),
+        _id.Server().Version(), _route, {"page=" + std::to_string(page)},
+        headers, "");
+
+    // Past the last page, the server either fails or returns null
+    if (resp.data == "null\n" || resp.statusCode != 200)
+      return page > 1 || resp.statusCode == 404;
+
+    auto ids = JSONParser::ParseModels(resp.data, _id.Server());
+    if (ids.empty())
+      return true;
+    _ids.insert(_ids.end(), ids.begin(), ids.end());
+  }
+}
+
+//////////////////////////////////////////////////
+Result FuelClientPrivate::FetchModelDetails(const ModelIdentifier &_id,
+    ModelIdentifier &_model, const std::vector<std::string> &_headers,
+    const bool _save)
+{
+  common::URIPath path;
+  path = path / _id.Owner() / "models" / _id.Name();
+
+  auto resp = this->rest.Request(HttpMethod::GET, _id.Server().Url().Str(),
+      _id.Server().Version(), path.Str(), {}, _headers, "");
+  if (resp.statusCode != 200)
+    return Result(ResultType::FETCH_ERROR);
+
+  _model = JSONParser::ParseModel(resp.data, _id.Server());
+
+  if (_save)
+    this->cache->SaveModelListing(_id.Server(), path.Str(), {_model});
+  return Result(ResultType::FETCH);
+}
+
+//////////////////////////////////////////////////
+Result FuelClientPrivate::FetchWorldDetails(const WorldIdentifier &_id,
+    WorldIdentifier &_world, const std::vector<std::string> &_headers,
+    const bool _save)
+{
+  auto serverUrl = _id.Server().Url().Str();
+
+  if (serverUrl.empty() || _id.Owner().empty() || _id.Name().empty())
+    return Result(ResultType::FETCH_ERROR);
+
+  common::URIPath path;
+  path = path / _id.Owner() / "worlds" / _id.Name();
+
+  auto resp = this->rest.Request(HttpMethod::GET, serverUrl,
+      _id.Server().Version(), path.Str(), {}, _headers, "");
+  if (resp.statusCode != 200)
+    return Result(ResultType::FETCH_ERROR);
+
+  _world = JSONParser::ParseWorld(resp.data, _id.Server());
+
+  if (_save)
+    this->cache->SaveWorldListing(_id.Server(), path.Str(), {_world});
+  return Result(ResultType::FETCH);
+}
+
+//////////////////////////////////////////////////
+bool FuelClientPrivate::SaveSingleDetails() const
+{
+  return this->config.ListingCachePolicy() ==
+      ListingPolicy::STALE_WHILE_REVALIDATE;
+}
+
+//////////////////////////////////////////////////
+bool FuelClientPrivate::QueryModels(const ServerConfig &_server,
+    const ModelQuery &_query, std::vector<ModelIdentifier> &_ids)
+{
+  common::URIPath path;
+  if (!_query.Owner().empty())
+    path = path / _query.Owner() / "models";
+  else
+    path = path / "models";
+
+  std::vector<std::string> headers = {"Accept: application/json"};
+  auto queryStrings = _query.QueryStrings();
+  queryStrings.insert(queryStrings.begin(), "");
+
+  // While the server returns models in the requested order, the first
+  // matches are the final ones, and later pages aren't needed.
+  bool serverSorted = true;
+  std::unique_ptr<ModelIdentifier> previous;
+  _ids.clear();
+  for (int page = 1; ; ++page)
+  {
+    queryStrings[0] = "page=" + std::to_string(page);
+    auto resp = this->rest.Request(HttpMethod::GET, _server.Url().Str(),
+        _server.Version(), path.Str(), queryStrings, headers, "");
+
+    // Past the last page, the server either fails or returns null. Failing
+    // on the first page means it doesn't support the query, unless the
+    // owner doesn't exist.
+    if (resp.data == "null\n" || resp.statusCode != 200)
+    {
+      if (page == 1 && resp.statusCode != 200 && resp.statusCode != 404)
+        return false;
+      break;
+    }
+
+    auto ids = JSONParser::ParseModels(resp.data, _server);
+    if (ids.empty())
+      break;
+
+    for (const auto &id : ids)
+    {
+      if (serverSorted && previous && _query.Before(id, *previous))
+        serverSorted = false;
+      if (_query.Matches(id))
+        _ids.push_back(id);
+      previous.reset(new ModelIdentifier(id));
+    }
+
+    if (serverSorted && _query.Limit() > 0u && _ids.size() >= _query.Limit())
+      break;
+  }
+
+  if (!serverSorted)
+  {
+    std::stable_sort(_ids.begin(), _ids.end(),
+        [&_query](const ModelIdentifier &_a, const ModelIdentifier &_b)
+        {
+          return _query.Before(_a, _b);
+        });
+  }
+  if (_query.Limit() > 0u && _ids.size() > _query.Limit())
+    _ids.resize(_query.Limit());
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+ModelIter FuelClientPrivate::StaleWhileRevalidate(const ModelIdentifier &_id,
+    const std::string &_route)
+{
+  CacheLookupMetrics metrics("model_listing");
+
+  // The whole catalog is read from its snapshot, without parsing it.
+  if (_route == "models")
+  {
+    auto snapshot = this->cache->ModelSnapshot(_id.Server());
+    if (metrics.Count(snapshot != nullptr))
+    {
+      if (std::chrono::system_clock::now() - snapshot->Saved() >=
+          this->config.ListingTtl())
+      {
+        this->Revalidate(_id, _route);
+      }
+      return ModelIterFactory::Create(snapshot, _id.Server());
+    }
+  }
+
+  std::vector<ModelIdentifier> ids;
+  std::chrono::system_clock::time_point saved;
+  if (_route != "models" && metrics.Count(this->cache->ModelListing(
+      _id.Server(), _route, ids, saved)))
+  {
+    if (std::chrono::system_clock::now() - saved >= this->config.ListingTtl())
+      this->Revalidate(_id, _route);
+    return ModelIterFactory::Create(ids);
+  }
+
+  // Never listed before, so the caller has to wait for the server.
+  if (this->FetchModelListing(_id, _route, ids))
+  {
+    this->cache->SaveModelListing(_id.Server(), _route, ids);
+    return ModelIterFactory::Create(ids);
+  }
+
+  ignwarn << "Failed to fetch [" << _route << "] from server, returning "
+          << "cached models." << std::endl;
+  return this->cache->MatchingModels(_id);
+}
+
+//////////////////////////////////////////////////
+void FuelClientPrivate::Revalidate(const ModelIdentifier &_id,
+    const std::string &_route)
+{
+  this->Revalidate(_id.Server().Url().Str() + "/" + _route,
+      [this, _id, _route]()
+      {
+        std::vector<ModelIdentifier> ids;
+        return this->FetchModelListing(_id, _route, ids) &&
+            this->cache->SaveModelListing(_id.Server(), _route, ids);
+      });
+}
+
+//////////////////////////////////////////////////
+void FuelClientPrivate::Revalidate(const std::string &_key,
+    const std::function<bool()> &_refresh)
+{
+  std::lock_guard<std::mutex> lock(this->listingMutex);
+  if (!this->revalidating.insert(_key).second)
+    return;
+
+  // Forget refreshes which are done.
+  this->revalidations.erase(std::remove_if(this->revalidations.begin(),
+      this->revalidations.end(), [](const std::future<void> &_future)
+      {
+        return _future.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready;
+      }), this->revalidations.end());
+
+  this->revalidations.push_back(std::async(std::launch::async,
+      [this, _key, _refresh]()
+      {
+        static auto &updated = MetricsRegistry::Global().Counter(
+            "ign_fuel_listing_revalidations_total",
+            "Saved model listings refreshed in the background.",
+            {{"result", "updated"}});
+        static auto &failed = MetricsRegistry::Global().Counter(
+            "ign_fuel_listing_revalidations_total",
+            "Saved model listings refreshed in the background.",
+            {{"result", "failed"}});
+
+        if (_refresh())
+          updated.Increment();
+        else
+          failed.Increment();
+
+        std::lock_guard<std::mutex> doneLock(this->listingMutex);
+        this->revalidating.erase(_key);
+      }));
+}
+
+//////////////////////////////////////////////////
+void FuelClientPrivate::Pin(ModelIdentifier &_id) const
+{
+  LockEntry entry;
+  auto lockfile = this->CurrentLockfile();
+  if (_id.Version() == 0 && lockfile->Size() > 0 &&
+      lockfile->Find(_id.Server().Url().Str(), _id.Owner(), "models",
+        _id.Name(), entry))
+  {
+    _id.SetVersion(entry.version);
+  }
+}
+
+//////////////////////////////////////////////////
+void FuelClientPrivate::Pin(WorldIdentifier &_id) const
+{
+  LockEntry entry;
+  auto lockfile = this->CurrentLockfile();
+  if (_id.Version() == 0 && lockfile->Size() > 0 &&
+      lockfile->Find(_id.Server().Url().Str(), _id.Owner(), "worlds",
+        _id.Name(), entry))
+  {
+    _id.SetVersion(entry.version);
   }
+}
+
+//////////////////////////////////////////////////
+bool FuelClientPrivate::VerifyLock(const std::string &_server,
+    const std::string &_owner, const std::string &_type,
+    const std::string &_name, unsigned int _version,
+    const std::string &_data) const
+{
+  LockEntry entry;
+  auto lockfile = this->CurrentLockfile();
+  if (lockfile->Size() == 0 ||
+      !lockfile->Find(_server, _owner, _type, _name, entry) ||
+      entry.version != _version || entry.hash.empty())
+  {
+    return true;
+  }
+
+  auto hash = Lockfile::Hash(_data);
+  if (hash == entry.hash)
+    return true;
 
-  return Result(ResultType::FETCH_ERROR);
+  ignerr << "Downloaded archive doesn't match the lockfile." << std::endl
+         << "  Resource: " << entry.url << std::endl
+         << "  Expected: " << entry.hash << std::endl
+         << "  Received: " << hash << std::endl;
+  return false;
 }
 
 //////////////////////////////////////////////////
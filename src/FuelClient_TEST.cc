@@ -16,20 +16,32 @@
 */
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
+#include <ignition/common/StringUtils.hh>
 #include "ignition/fuel_tools/FuelClient.hh"
 #include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
 #include "ignition/fuel_tools/Result.hh"
 #include "ignition/fuel_tools/WorldIdentifier.hh"
+#include "ignition/fuel_tools/Zip.hh"
 
+#include "HttpServer.hh"
 #include "test/test_config.h"
 
 #ifdef _WIN32
 #include <direct.h>
 #define ChangeDirectory _chdir
 #else
+#include <sys/stat.h>
 #include <unistd.h>
 #define ChangeDirectory chdir
 #endif
@@ -1247,6 +1259,54 @@ TEST_F(FuelClientTest, Worlds)
   }
 }
 
+/////////////////////////////////////////////////
+TEST_F(FuelClientTest, ModelsFromAllServers)
+{
+  ClientConfig config;
+  config.SetCacheLocation(common::cwd() + "/test_cache");
+
+  // An unreachable server shouldn't prevent results from the others.
+  ServerConfig badServer;
+  badServer.SetUrl(common::URI("http://localhost:8007/"));
+  config.AddServer(badServer);
+
+  FuelClient client(config);
+
+  {
+    // Uses fuel.ignitionrobotics.org by default
+    ModelIter iter = client.ModelsFromAllServers();
+    EXPECT_TRUE(iter);
+  }
+
+  {
+    ModelIter iter = client.ModelsFromAllServers("openrobotics");
+    EXPECT_TRUE(iter);
+    for (; iter; ++iter)
+      EXPECT_EQ("openrobotics", iter->Identification().Owner());
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(FuelClientTest, WorldsFromAllServers)
+{
+  ClientConfig config;
+  config.SetCacheLocation(common::cwd() + "/test_cache");
+  FuelClient client(config);
+
+  {
+    // Uses fuel.ignitionrobotics.org by default
+    WorldIter iter = client.WorldsFromAllServers();
+    EXPECT_TRUE(iter);
+  }
+
+  {
+    WorldIter iter = client.WorldsFromAllServers("openrobotics");
+    EXPECT_TRUE(iter);
+    for (; iter; ++iter)
+      EXPECT_EQ("openrobotics", iter->Owner());
+  }
+}
+
 /////////////////////////////////////////////////
 TEST_F(FuelClientTest, DownloadModelFail)
 {
@@ -1288,6 +1348,673 @@ TEST_F(FuelClientTest, UploadModelFail)
   EXPECT_EQ(ResultType::UPLOAD_ERROR, result.Type());
 }
 
+#ifndef _WIN32
+/////////////////////////////////////////////////
+/// \brief Write a file, creating its parent directories.
+/// \param[in] _path Path of the file.
+/// \param[in] _content Content of the file.
+void writeFile(const std::string &_path, const std::string &_content)
+{
+  common::createDirectories(common::parentPath(_path));
+  std::ofstream out(_path, std::ios::binary);
+  out << _content;
+}
+
+/////////////////////////////////////////////////
+/// \brief Read a whole file.
+/// \param[in] _path Path of the file.
+/// \return Content of the file.
+std::string readFile(const std::string &_path)
+{
+  std::ifstream in(_path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>());
+}
+
+/////////////////////////////////////////////////
+TEST_F(FuelClientTest, DeltaUpdate)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_delta_update");
+  common::removeAll(root);
+
+  // Version 2 only changes the texture and the SDF file.
+  const std::string config = "<?xml version=\"1.0\"?><model><name>am1</name>"
+      "<sdf version=\"1.6\">model.sdf</sdf></model>";
+  auto sdf = [](const std::string &_name)
+  {
+    return "<?xml version=\"1.0\"?><sdf version=\"1.6\">"
+        "<model name=\"" + _name + "\"><link name=\"l\"><visual name=\"v\">"
+        "<geometry><mesh><uri>model://am1/meshes/mesh.dae</uri></mesh>"
+        "</geometry></visual></link></model></sdf>";
+  };
+  for (auto version : {"1", "2"})
+  {
+    std::string dir = common::joinPaths(root, "server", version);
+    writeFile(common::joinPaths(dir, "model.config"), config);
+    writeFile(common::joinPaths(dir, "model.sdf"),
+        sdf(std::string("am1_") + version));
+    writeFile(common::joinPaths(dir, "meshes", "mesh.dae"), "mesh");
+    writeFile(common::joinPaths(dir, "materials", "texture.png"),
+        std::string("texture ") + version);
+  }
+
+  std::string archive = common::joinPaths(root, "am1.zip");
+  for (auto file : {"model.config", "model.sdf", "meshes", "materials"})
+    Zip::Compress(common::joinPaths(root, "server", "1", file), archive);
+
+  auto fileTree = [](const std::string &_version)
+  {
+    return "{\"name\": \"am1\", \"version\": " + _version + ", "
+        "\"file_tree\": ["
+        "{\"name\": \"model.config\", \"path\": \"/model.config\","
+        " \"hash\": \"c1\"},"
+        "{\"name\": \"model.sdf\", \"path\": \"/model.sdf\","
+        " \"hash\": \"s" + _version + "\"},"
+        "{\"name\": \"meshes\", \"path\": \"/meshes\", \"children\": ["
+        "{\"name\": \"mesh.dae\", \"path\": \"/meshes/mesh.dae\","
+        " \"hash\": \"m1\"}]},"
+        "{\"name\": \"materials\", \"path\": \"/materials\", \"children\": ["
+        "{\"name\": \"texture.png\", \"path\": \"/materials/texture.png\","
+        " \"hash\": \"t" + _version + "\"}]}]}";
+  };
+
+  std::mutex mutex;
+  std::vector<std::string> requests;
+  HttpServer server([&](const HttpRequest &_request, HttpResponse &_response)
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          requests.push_back(_request.path);
+        }
+
+        const std::string prefix = "/1.0/alice/models/am1";
+        const std::string filesPrefix = prefix + "/2/files/";
+        if (_request.path == prefix)
+        {
+          _response.body = "{\"name\": \"am1\", \"owner\": \"alice\","
+              " \"version\": 2}";
+        }
+        else if (_request.path == prefix + "/1/am1.zip")
+        {
+          _response.file = archive;
+          _response.headers["X-Ign-Resource-Version"] = "1";
+        }
+        else if (_request.path == prefix + "/1/files")
+        {
+          _response.body = fileTree("1");
+        }
+        else if (_request.path == prefix + "/2/files")
+        {
+          _response.body = fileTree("2");
+        }
+        else if (_request.path.find(filesPrefix) == 0)
+        {
+          _response.file = common::joinPaths(root, "server", "2",
+              _request.path.substr(filesPrefix.size()));
+        }
+        else
+        {
+          _response.status = 404;
+        }
+      });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  ServerConfig serverConfig;
+  serverConfig.SetUrl(common::URI(server.Url()));
+  ClientConfig clientConfig;
+  clientConfig.SetCacheLocation(common::joinPaths(root, "cache"));
+  clientConfig.AddServer(serverConfig);
+  clientConfig.SetLockfilePath("");
+  clientConfig.SetDeltaUpdates(true);
+  FuelClient client(clientConfig);
+
+  ModelIdentifier id;
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server.Url() + "/1.0/alice/models/am1/1"), id));
+  ASSERT_TRUE(client.DownloadModel(id));
+
+  std::string modelDir = common::joinPaths(root, "cache",
+      common::URI(server.Url()).Path().Str(), "alice", "models", "am1");
+  std::string v1 = common::joinPaths(modelDir, "1");
+  std::string v2 = common::joinPaths(modelDir, "2");
+  ASSERT_TRUE(common::exists(common::joinPaths(v1, "model.sdf")));
+
+  // Updating to the tip only fetches the files which changed.
+  requests.clear();
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server.Url() + "/1.0/alice/models/am1"), id));
+  ASSERT_TRUE(client.DownloadModel(id));
+
+  EXPECT_EQ(std::vector<std::string>({
+      "/1.0/alice/models/am1",
+      "/1.0/alice/models/am1/2/files",
+      "/1.0/alice/models/am1/1/files",
+      "/1.0/alice/models/am1/2/files/materials/texture.png",
+      "/1.0/alice/models/am1/2/files/model.config",
+      "/1.0/alice/models/am1/2/files/model.sdf"}), requests);
+
+  EXPECT_EQ("texture 2",
+      readFile(common::joinPaths(v2, "materials", "texture.png")));
+  EXPECT_EQ("mesh", readFile(common::joinPaths(v2, "meshes", "mesh.dae")));
+
+  // Unchanged files are shared with the previous version.
+  struct stat st1, st2;
+  ASSERT_EQ(0, stat(common::joinPaths(v1, "meshes", "mesh.dae").c_str(),
+      &st1));
+  ASSERT_EQ(0, stat(common::joinPaths(v2, "meshes", "mesh.dae").c_str(),
+      &st2));
+  EXPECT_EQ(st1.st_ino, st2.st_ino);
+
+  // Paths point to the new version.
+  std::string sdfContent = readFile(common::joinPaths(v2, "model.sdf"));
+  EXPECT_NE(std::string::npos, sdfContent.find("am1_2"));
+  EXPECT_NE(std::string::npos,
+      sdfContent.find(common::joinPaths(v2, "meshes", "mesh.dae")));
+
+  LocalCache cache(&clientConfig);
+  EXPECT_EQ(2u, cache.MatchingModel(id).Identification().Version());
+  EXPECT_FALSE(cache.FileTree(v2).empty());
+  EXPECT_FALSE(common::exists(common::joinPaths(modelDir, ".2.delta")));
+
+  common::removeAll(root);
+}
+
+/////////////////////////////////////////////////
+TEST_F(FuelClientTest, StaleWhileRevalidate)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_stale_while_revalidate");
+  common::removeAll(root);
+
+  std::mutex mutex;
+  std::vector<std::string> names{"m1"};
+  int listings{0};
+  HttpServer server([&](const HttpRequest &_request, HttpResponse &_response)
+      {
+        if (_request.path != "/1.0/alice/models")
+        {
+          _response.status = 404;
+          return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (_request.query != "page=1")
+        {
+          _response.body = "[]";
+          return;
+        }
+
+        ++listings;
+        _response.body = "[";
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+          _response.body += std::string(i > 0 ? "," : "") +
+              "{\"name\": \"" + names[i] + "\", \"owner\": \"alice\"," +
+              " \"version\": 1}";
+        }
+        _response.body += "]";
+      });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  ServerConfig serverConfig;
+  serverConfig.SetUrl(common::URI(server.Url()));
+  ClientConfig config;
+  config.SetCacheLocation(common::joinPaths(root, "cache"));
+  config.AddServer(serverConfig);
+  config.SetListingCachePolicy(ListingPolicy::STALE_WHILE_REVALIDATE);
+  config.SetListingTtl(std::chrono::seconds(3600));
+
+  ModelIdentifier id;
+  id.SetServer(serverConfig);
+  id.SetOwner("alice");
+
+  auto count = [](ModelIter _iter)
+  {
+    size_t result{0};
+    for (; _iter; ++_iter)
+      ++result;
+    return result;
+  };
+
+  auto waitForListings = [&](int _expected)
+  {
+    for (int i = 0; i < 100; ++i)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (listings >= _expected)
+          return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+  };
+
+  {
+    FuelClient client(config);
+
+    // The first listing waits for the server, later ones are served from
+    // the saved listing while it's fresh.
+    EXPECT_EQ(1u, count(client.Models(id)));
+    EXPECT_EQ(1u, count(client.Models(id)));
+    EXPECT_EQ(1, listings);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    names.push_back("m2");
+  }
+
+  {
+    // Once stale, the saved listing is still served, and refreshed in the
+    // background for the next call.
+    config.SetListingTtl(std::chrono::seconds(0));
+    FuelClient client(config);
+    EXPECT_EQ(1u, count(client.Models(id)));
+    ASSERT_TRUE(waitForListings(2));
+  }
+
+  // The refreshed listing is saved for other clients.
+  config.SetListingTtl(std::chrono::seconds(3600));
+  FuelClient client(config);
+  EXPECT_EQ(2u, count(client.Models(id)));
+  EXPECT_EQ(2, listings);
+
+  common::removeAll(root);
+}
+
+//////////////////////////////////////////////////
+TEST_F(FuelClientTest, BatchDetails)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_batch_details");
+  common::removeAll(root);
+
+  std::mutex mutex;
+  std::vector<std::string> requests;
+  HttpServer server([&](const HttpRequest &_request, HttpResponse &_response)
+      {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          requests.push_back(_request.path);
+        }
+
+        // Each resource's version is the length of its name. Resources
+        // named "private" need a token.
+        std::string name = _request.path.substr(
+            _request.path.rfind('/') + 1);
+        auto token = _request.headers.find("private-token");
+        if (_request.path.find("/1.0/alice/") != 0u || name == "missing" ||
+            (name == "private" && (token == _request.headers.end() ||
+            token->second != "secret")))
+        {
+          _response.status = 404;
+          return;
+        }
+
+        _response.body = "{\"name\": \"" + name +
+            "\", \"owner\": \"alice\", \"version\": " +
+            std::to_string(name.size()) + "}";
+      });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  ServerConfig serverConfig;
+  serverConfig.SetUrl(common::URI(server.Url()));
+  ClientConfig config;
+  config.SetCacheLocation(common::joinPaths(root, "cache"));
+  config.AddServer(serverConfig);
+  config.SetListingTtl(std::chrono::seconds(3600));
+
+  std::vector<ModelIdentifier> modelIds;
+  for (const std::string name : {"a", "bb", "missing", "cccc", "ddddd",
+      "e", "ff", "ggg", "hhhh", "iiiii"})
+  {
+    ModelIdentifier id;
+    id.SetServer(serverConfig);
+    id.SetOwner("alice");
+    id.SetName(name);
+    modelIds.push_back(id);
+  }
+
+  {
+    // Details of a single model are only persisted under
+    // stale-while-revalidate.
+    FuelClient client(config);
+    ModelIdentifier model;
+    EXPECT_TRUE(client.ModelDetails(modelIds[0], model));
+    EXPECT_FALSE(common::exists(common::joinPaths(root, "cache",
+        ".listings")));
+    requests.clear();
+  }
+
+  {
+    FuelClient client(config);
+    std::vector<ModelIdentifier> models;
+    auto results = client.ModelDetails(modelIds, models);
+    ASSERT_EQ(modelIds.size(), results.size());
+    ASSERT_EQ(modelIds.size(), models.size());
+    for (size_t i = 0; i < modelIds.size(); ++i)
+    {
+      if (modelIds[i].Name() == "missing")
+      {
+        EXPECT_EQ(ResultType::FETCH_ERROR, results[i].Type());
+        continue;
+      }
+      EXPECT_EQ(ResultType::FETCH, results[i].Type());
+      EXPECT_EQ(modelIds[i].Name(), models[i].Name());
+      EXPECT_EQ(modelIds[i].Name().size(), models[i].Version());
+    }
+    EXPECT_EQ(modelIds.size(), requests.size());
+  }
+
+  {
+    // Batched details are persisted under any policy, so another client
+    // only asks for the model which wasn't found.
+    requests.clear();
+    FuelClient client(config);
+    std::vector<ModelIdentifier> models;
+    auto results = client.ModelDetails(modelIds, models);
+    ASSERT_EQ(modelIds.size(), results.size());
+    for (size_t i = 0; i < modelIds.size(); ++i)
+    {
+      if (modelIds[i].Name() == "missing")
+        continue;
+      EXPECT_EQ(ResultType::FETCH_ALREADY_EXISTS, results[i].Type());
+      EXPECT_EQ(modelIds[i].Name(), models[i].Name());
+      EXPECT_EQ("alice", models[i].Owner());
+      EXPECT_EQ(modelIds[i].Name().size(), models[i].Version());
+    }
+    ASSERT_EQ(1u, requests.size());
+    EXPECT_EQ("/1.0/alice/models/missing", requests[0]);
+  }
+
+  {
+    // Expired details are fetched again.
+    requests.clear();
+    config.SetListingTtl(std::chrono::seconds(0));
+    FuelClient client(config);
+    std::vector<ModelIdentifier> models;
+    auto results = client.ModelDetails(modelIds, models);
+    EXPECT_EQ(ResultType::FETCH, results[0].Type());
+    EXPECT_EQ(modelIds.size(), requests.size());
+  }
+
+  {
+    // Under stale-while-revalidate, expired details are still served, and
+    // refreshed in the background.
+    requests.clear();
+    config.SetListingCachePolicy(ListingPolicy::STALE_WHILE_REVALIDATE);
+    FuelClient client(config);
+    std::vector<ModelIdentifier> models;
+    auto results = client.ModelDetails(modelIds, models);
+    EXPECT_EQ(ResultType::FETCH_ALREADY_EXISTS, results[0].Type());
+    EXPECT_EQ(1u, models[0].Version());
+  }
+  // The client waits for the refreshes when destroyed.
+  EXPECT_EQ(modelIds.size(), requests.size());
+  config.SetListingCachePolicy(ListingPolicy::CACHE_FIRST);
+
+  std::vector<WorldIdentifier> worldIds(2);
+  worldIds[0].SetServer(serverConfig);
+  worldIds[0].SetOwner("alice");
+  worldIds[0].SetName("w");
+  worldIds[1] = worldIds[0];
+  worldIds[1].SetName("ww");
+
+  config.SetListingTtl(std::chrono::seconds(3600));
+  FuelClient client(config);
+  for (auto expected : {ResultType::FETCH, ResultType::FETCH_ALREADY_EXISTS})
+  {
+    std::vector<WorldIdentifier> worlds;
+    auto results = client.WorldDetails(worldIds, worlds);
+    ASSERT_EQ(2u, results.size());
+    ASSERT_EQ(2u, worlds.size());
+    for (size_t i = 0; i < worldIds.size(); ++i)
+    {
+      EXPECT_EQ(expected, results[i].Type());
+      EXPECT_EQ(worldIds[i].Name(), worlds[i].Name());
+      EXPECT_EQ(i + 1, worlds[i].Version());
+    }
+  }
+
+  // Headers are forwarded, so private worlds can be fetched.
+  std::vector<WorldIdentifier> privateIds(1, worldIds[0]);
+  privateIds[0].SetName("private");
+  std::vector<WorldIdentifier> worlds;
+  EXPECT_EQ(ResultType::FETCH_ERROR,
+      client.WorldDetails(privateIds, worlds)[0].Type());
+  EXPECT_EQ(ResultType::FETCH, client.WorldDetails(privateIds, worlds,
+      {"Private-Token: secret"})[0].Type());
+  EXPECT_EQ(7u, worlds[0].Version());
+
+  // An empty batch doesn't issue any request.
+  requests.clear();
+  std::vector<ModelIdentifier> models;
+  EXPECT_TRUE(client.ModelDetails(std::vector<ModelIdentifier>(),
+      models).empty());
+  EXPECT_TRUE(models.empty());
+  EXPECT_TRUE(requests.empty());
+
+  common::removeAll(root);
+}
+
+//////////////////////////////////////////////////
+TEST_F(FuelClientTest, ModelQuery)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_model_query");
+  common::removeAll(root);
+
+  struct Entry
+  {
+    std::string owner;
+    std::string name;
+    std::string tag;
+    unsigned int downloads;
+  };
+  const std::vector<Entry> catalog = {
+      {"alice", "Drill", "tools", 10}, {"bob", "Table", "furniture", 50},
+      {"alice", "Drill Press", "machines", 30},
+      {"bob", "Cordless Drill", "tools", 20},
+      {"carol", "Hammer", "tools", 40}};
+
+  // The server finds models whose name or tag match every word, sorts and
+  // pages as asked, unless it's pretending to be an older server which
+  // ignores the query, or one which rejects it.
+  enum class Mode {SMART, IGNORE, REJECT};
+  Mode mode = Mode::SMART;
+  std::mutex mutex;
+  std::vector<HttpRequest> requests;
+  HttpServer server([&](const HttpRequest &_request, HttpResponse &_response)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(_request);
+
+        auto param = [&](const std::string &_name)
+        {
+          auto it = _request.params.find(_name);
+          return it == _request.params.end() ? "" : it->second;
+        };
+
+        if (mode == Mode::REJECT && !param("q").empty())
+        {
+          _response.status = 400;
+          return;
+        }
+
+        std::vector<Entry> entries;
+        for (const auto &entry : catalog)
+        {
+          if (_request.path != "/1.0/models" &&
+              _request.path != "/1.0/" + entry.owner + "/models")
+          {
+            continue;
+          }
+          bool matches = true;
+          for (const auto &word : common::Split(param("q"), ' '))
+          {
+            matches = matches && (word == entry.tag ||
+                entry.name.find(word) != std::string::npos);
+          }
+          if (mode == Mode::SMART && !matches)
+            continue;
+          entries.push_back(entry);
+        }
+
+        size_t perPage = 2;
+        if (mode == Mode::SMART)
+        {
+          if (param("order_by") == "downloads")
+          {
+            std::sort(entries.begin(), entries.end(),
+                [](const Entry &_a, const Entry &_b)
+                {
+                  return _a.downloads > _b.downloads;
+                });
+          }
+          if (!param("per_page").empty())
+            perPage = std::stoul(param("per_page"));
+        }
+
+        size_t first = (std::stoul(param("page")) - 1) * perPage;
+        _response.body = "[";
+        for (size_t i = first; i < entries.size() && i < first + perPage; ++i)
+        {
+          _response.body += std::string(i > first ? "," : "") +
+              "{\"name\": \"" + entries[i].name + "\", \"owner\": \"" +
+              entries[i].owner + "\", \"tags\": [\"" + entries[i].tag +
+              "\"], \"downloads\": " + std::to_string(entries[i].downloads) +
+              "}";
+        }
+        _response.body += "]";
+      });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  ServerConfig serverConfig;
+  serverConfig.SetUrl(common::URI(server.Url()));
+  ClientConfig config;
+  config.SetCacheLocation(common::joinPaths(root, "cache"));
+  config.AddServer(serverConfig);
+  FuelClient client(config);
+
+  auto names = [](ModelIter _iter)
+  {
+    std::vector<std::string> result;
+    for (; _iter; ++_iter)
+      result.push_back(_iter->Identification().Name());
+    return result;
+  };
+
+  ModelQuery query;
+  query.SetText("Drill");
+  query.SetTags({"tools"});
+  query.SetSort(ModelSort::DOWNLOADS);
+  query.SetLimit(1);
+
+  // The server does the work, so one page is enough.
+  EXPECT_EQ(std::vector<std::string>({"Cordless Drill"}),
+      names(client.Models(serverConfig, query)));
+  ASSERT_EQ(1u, requests.size());
+  EXPECT_EQ("/1.0/models", requests[0].path);
+  EXPECT_EQ("Drill tools", requests[0].params["q"]);
+  EXPECT_EQ("downloads", requests[0].params["order_by"]);
+  EXPECT_EQ("1", requests[0].params["per_page"]);
+
+  // Owners are part of the route.
+  requests.clear();
+  query.SetOwner("alice");
+  query.SetTags({});
+  query.SetLimit(0);
+  EXPECT_EQ(std::vector<std::string>({"Drill Press", "Drill"}),
+      names(client.Models(serverConfig, query)));
+  ASSERT_FALSE(requests.empty());
+  EXPECT_EQ("/1.0/alice/models", requests[0].path);
+
+  // A server ignoring the query returns everything, unsorted, so all pages
+  // are read, filtered and sorted.
+  requests.clear();
+  mode = Mode::IGNORE;
+  query.SetOwner("");
+  query.SetTags({"tools"});
+  query.SetLimit(2);
+  EXPECT_EQ(std::vector<std::string>({"Cordless Drill", "Drill"}),
+      names(client.Models(serverConfig, query)));
+  EXPECT_EQ(4u, requests.size());
+
+  // A server rejecting the query leaves the local index, which only knows
+  // the models listed before.
+  mode = Mode::REJECT;
+  EXPECT_TRUE(names(client.Models(serverConfig, query)).empty());
+  EXPECT_TRUE(client.UpdateSearchIndex(serverConfig));
+  query.SetText("");
+  query.SetLimit(0);
+  EXPECT_EQ(std::vector<std::string>({"Hammer", "Cordless Drill", "Drill"}),
+      names(client.Models(serverConfig, query)));
+
+  common::removeAll(root);
+}
+
+//////////////////////////////////////////////////
+TEST_F(FuelClientTest, CatalogSnapshot)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_client_catalog_snapshot");
+  common::removeAll(root);
+
+  std::mutex mutex;
+  int requests{0};
+  HttpServer server([&](const HttpRequest &_request, HttpResponse &_response)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++requests;
+        if (_request.path != "/1.0/models" || _request.query != "page=1")
+        {
+          _response.body = "[]";
+          return;
+        }
+        _response.body = "[{\"name\": \"m1\", \"owner\": \"alice\"},"
+            " {\"name\": \"m2\", \"owner\": \"bob\"}]";
+      });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  ServerConfig serverConfig;
+  serverConfig.SetUrl(common::URI(server.Url()));
+  ClientConfig config;
+  config.Clear();
+  config.SetCacheLocation(common::joinPaths(root, "cache"));
+  config.AddServer(serverConfig);
+  config.SetListingCachePolicy(ListingPolicy::STALE_WHILE_REVALIDATE);
+  config.SetListingTtl(std::chrono::seconds(3600));
+
+  auto names = [](ModelIter _iter)
+  {
+    std::vector<std::string> result;
+    for (; _iter; ++_iter)
+      result.push_back(_iter->Identification().Name());
+    return result;
+  };
+
+  {
+    FuelClient client(config);
+    EXPECT_EQ(std::vector<std::string>({"m1", "m2"}),
+        names(client.Models(serverConfig)));
+    EXPECT_EQ(2, requests);
+  }
+
+  // Another client maps the snapshot instead of asking the server.
+  FuelClient client(config);
+  EXPECT_NE(nullptr, LocalCache(&config).ModelSnapshot(serverConfig));
+  EXPECT_EQ(std::vector<std::string>({"m1", "m2"}),
+      names(client.Models(serverConfig)));
+  EXPECT_EQ(std::vector<std::string>({"m1", "m2"}),
+      names(client.ModelsFromAllServers("")));
+  EXPECT_EQ(2, requests);
+
+  common::removeAll(root);
+}
+#endif
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
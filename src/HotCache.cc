@@ -0,0 +1,1069 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+#include <ignition/common/StringUtils.hh>
+
+#include "ignition/fuel_tools/Metrics.hh"
+#include "ignition/fuel_tools/Trace.hh"
+
+#include "HotCache.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Files in a versioned directory holding a hash of its content, as
+/// written by LocalCache: the hash of the archive it was extracted from, or
+/// for versions saved from a delta, a hash of the changes.
+static const char kArchiveHashFile[] = ".archive_hash";
+static const char kTreeHashFile[] = ".tree_hash";
+
+/// \brief Prefix of the directories holding a copy each. A copy is never
+/// changed or replaced in place, since its path may be in use.
+static const char kGenerationPrefix[] = ".gen-";
+
+/// \brief Suffix of a generation directory while its copy is made or
+/// removed.
+static const char kStagingSuffix[] = ".promote";
+
+/// \brief File in a generation directory whose copy is no longer used for
+/// new lookups.
+static const char kRetiredFile[] = ".retired";
+
+/// \brief File in a generation directory touched by the processes which
+/// handed out its copy.
+static const char kUsedFile[] = ".used";
+
+/// \brief Seconds after which a retired copy which no process touched is
+/// removed. Processes touch the copies they handed out more often.
+static const std::time_t kGraceSeconds = 3600;
+
+/// \brief Interval between sweeps of the hot tier.
+static const std::chrono::minutes kSweepInterval(10);
+
+class ignition::fuel_tools::HotCachePrivate
+{
+  /// \brief Lookups and tier of a versioned directory.
+  public: struct Entry
+  {
+    /// \brief Number of lookups, halved periodically.
+    uint64_t lookups = 0;
+
+    /// \brief Time of the last lookup.
+    std::chrono::steady_clock::time_point lastLookup;
+
+    /// \brief True once the hot tier was checked for an existing copy.
+    bool checked = false;
+
+    /// \brief True if there's a copy in the hot tier.
+    bool hot = false;
+
+    /// \brief True if waiting to be promoted.
+    bool queued = false;
+
+    /// \brief True if it can't be promoted, because it's larger than the
+    /// hot tier, or has no content hash to check copies against.
+    bool unpromotable = false;
+
+    /// \brief Size of the copy in the hot tier, in bytes.
+    uint64_t bytes = 0;
+
+    /// \brief Path of the copy in the hot tier, while hot.
+    std::string copy;
+
+    /// \brief Content hash of the copy, which matched the cache directory
+    /// when the copy was made or found.
+    std::string hash;
+
+    /// \brief Incremented when the version changes, so a copy made
+    /// meanwhile is dropped.
+    uint64_t generation = 0;
+  };
+
+  /// \brief Get the directory holding the generations of the copies of a
+  /// versioned directory.
+  /// \param[in] _coldDir Versioned directory in the cache directory.
+  /// \return Directory in the hot tier, at the relative path of the parent
+  /// of _coldDir, or empty if _coldDir isn't in the cache directory.
+  public: std::string CopiesDir(const std::string &_coldDir) const;
+
+  /// \brief Halve the lookup counts once in a while. mutex must be locked.
+  public: void Age();
+
+  /// \brief Forget the copy of an entry. mutex must be locked.
+  /// \param[in] _entry The entry.
+  /// \return The copy which was forgotten, or empty if there was none.
+  public: std::string Drop(Entry &_entry);
+
+  /// \brief Choose the copies to remove to fit a number of bytes, and
+  /// forget them. Copies handed out by this process are kept, since
+  /// retiring them wouldn't free their space. mutex must be locked.
+  /// \param[in] _bytes Bytes needed.
+  /// \param[in] _lookups Only copies with fewer lookups are removed.
+  /// \param[out] _demoted Copies which must be retired.
+  /// \param[in] _partial True to remove the copies which can be removed
+  /// even if that isn't enough.
+  /// \return False if there isn't enough room, in which case nothing is
+  /// removed unless _partial is true.
+  public: bool MakeRoom(uint64_t _bytes, uint64_t _lookups,
+      std::vector<std::string> &_demoted, bool _partial = false);
+
+  /// \brief Ask the worker to demote copies if the hot tier holds more
+  /// than its capacity. mutex must be locked.
+  public: void CheckCapacity();
+
+  /// \brief Find an up to date copy left in the hot tier, retiring the
+  /// stale ones on the way.
+  /// \param[in] _coldDir Versioned directory in the cache directory.
+  /// \param[in] _copies Directory holding the generations of its copies.
+  /// \param[out] _hash Content hash of the copy found.
+  /// \return A copy, or empty if there's none.
+  public: std::string FindCopy(const std::string &_coldDir,
+      const std::string &_copies, std::string &_hash);
+
+  /// \brief Hand out the copy of a version if it's hot, without touching
+  /// the cache directory, and count a hot hit.
+  /// \param[in] _coldDir Versioned directory in the cache directory.
+  /// \param[in] _lookup True to also count a lookup if a copy is handed
+  /// out.
+  /// \return The copy, or empty if there's none.
+  public: std::string HandOut(const std::string &_coldDir, bool _lookup);
+
+  /// \brief Stop handing out a copy. It's removed right away unless a
+  /// process handed it out, otherwise its size is counted against the
+  /// capacity until it's removed.
+  /// \param[in] _copy Copy in the hot tier.
+  public: void Retire(const std::string &_copy);
+
+  /// \brief Copy a versioned directory to the hot tier.
+  /// \param[in] _coldDir Versioned directory in the cache directory.
+  public: void Promote(const std::string &_coldDir);
+
+  /// \brief Retire copies demoted to make room.
+  /// \param[in] _demoted Copies in the hot tier.
+  public: void Demote(const std::vector<std::string> &_demoted);
+
+  /// \brief Touch the copies handed out by this process, retire stale
+  /// copies, and remove retired copies no process touched for a while.
+  public: void Sweep();
+
+  /// \brief Sweep a directory of the hot tier.
+  /// \param[in] _hotDir Directory in the hot tier.
+  /// \param[in] _coldDir Matching directory in the cache directory.
+  /// \param[in] _inUse Generation directories handed out by this process.
+  /// \param[in, out] _retiredBytes Incremented by the size of the retired
+  /// copies which are kept.
+  public: void Sweep(const std::string &_hotDir, const std::string &_coldDir,
+      const std::set<std::string> &_inUse, uint64_t &_retiredBytes);
+
+  /// \brief Sweep, then promote and demote until asked to stop.
+  public: void Run();
+
+  /// \brief Cache directory.
+  public: std::string coldRoot;
+
+  /// \brief Directory of the hot tier.
+  public: std::string hotRoot;
+
+  /// \brief Maximum size of the hot tier, in bytes.
+  public: uint64_t capacity = 0;
+
+  /// \brief Lookups after which a version is promoted.
+  public: unsigned int promotion = 1;
+
+  /// \brief Protects the members below.
+  public: mutable std::mutex mutex;
+
+  /// \brief Signaled when there's work, and when the worker is idle.
+  public: mutable std::condition_variable cv;
+
+  /// \brief Entries, by versioned directory in the cache directory.
+  public: std::map<std::string, Entry> entries;
+
+  /// \brief Generation directories whose copies were handed out. They're
+  /// never removed while this process runs.
+  public: std::set<std::string> handedOut;
+
+  /// \brief Versioned directories waiting to be promoted.
+  public: std::deque<std::string> queue;
+
+  /// \brief True while the worker sweeps, promotes or demotes.
+  public: bool busy = true;
+
+  /// \brief True to stop the worker.
+  public: bool stop = false;
+
+  /// \brief True if the hot tier holds more than its capacity, so the
+  /// worker must demote copies.
+  public: bool overfull = false;
+
+  /// \brief Lookups since the counts were last halved.
+  public: uint64_t lookupsSinceAging = 0;
+
+  /// \brief Statistics.
+  public: CacheTierStats stats;
+
+  /// \brief Sweeps, promotes and demotes.
+  public: std::thread worker;
+};
+
+//////////////////////////////////////////////////
+/// \brief Get the total size of the files in a directory.
+/// \param[in] _dir Directory.
+/// \return Size in bytes.
+static uint64_t treeBytes(const std::string &_dir)
+{
+  uint64_t bytes = 0;
+  common::DirIter end;
+  for (common::DirIter iter(_dir); iter != end; ++iter)
+  {
+    if (common::isDirectory(*iter))
+    {
+      bytes += treeBytes(*iter);
+      continue;
+    }
+
+    struct stat info;
+    if (stat((*iter).c_str(), &info) == 0)
+      bytes += static_cast<uint64_t>(info.st_size);
+  }
+  return bytes;
+}
+
+//////////////////////////////////////////////////
+/// \brief Copy a directory.
+/// \param[in] _src Directory to copy.
+/// \param[in] _dst New directory.
+/// \return True if everything was copied.
+static bool copyTree(const std::string &_src, const std::string &_dst)
+{
+  if (!common::createDirectories(_dst))
+    return false;
+
+  common::DirIter end;
+  for (common::DirIter iter(_src); iter != end; ++iter)
+  {
+    std::string dst = common::joinPaths(_dst, common::basename(*iter));
+    if (common::isDirectory(*iter) ? !copyTree(*iter, dst) :
+        !common::copyFile(*iter, dst))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Point the SDF files of a copied model to the copy. Saved models
+/// have their model:// URIs replaced with paths to their directory.
+/// \param[in] _dir Directory of the copy.
+/// \param[in] _from Directory of the original.
+/// \param[in] _to Final directory of the copy.
+static void rewritePaths(const std::string &_dir, const std::string &_from,
+    const std::string &_to)
+{
+  common::DirIter end;
+  for (common::DirIter iter(_dir); iter != end; ++iter)
+  {
+    if (common::isDirectory(*iter))
+    {
+      rewritePaths(*iter, _from, _to);
+      continue;
+    }
+    if (!common::EndsWith(*iter, ".sdf"))
+      continue;
+
+    std::string content;
+    {
+      std::ifstream in(*iter, std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(in),
+          std::istreambuf_iterator<char>());
+    }
+    if (content.find(_from) == std::string::npos)
+      continue;
+
+    for (auto pos = content.find(_from); pos != std::string::npos;
+        pos = content.find(_from, pos + _to.size()))
+    {
+      content.replace(pos, _from.size(), _to);
+    }
+    std::ofstream out(*iter, std::ios::binary | std::ios::trunc);
+    out << content;
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Read the content hash of a versioned directory.
+/// \param[in] _dir Versioned directory.
+/// \return The hash, or empty if not recorded.
+static std::string contentHash(const std::string &_dir)
+{
+  for (const auto *file : {kArchiveHashFile, kTreeHashFile})
+  {
+    std::ifstream in(common::joinPaths(_dir, file));
+    std::string hash;
+    if (std::getline(in, hash) && !hash.empty())
+      return hash;
+  }
+  return "";
+}
+
+//////////////////////////////////////////////////
+/// \brief Check if a copy in the hot tier is of the current version in the
+/// cache directory.
+/// \param[in] _coldDir Versioned directory in the cache directory.
+/// \param[in] _hotDir Copy in the hot tier.
+/// \return True if both exist and the copy has the same content hash.
+static bool upToDate(const std::string &_coldDir, const std::string &_hotDir)
+{
+  if (!common::isDirectory(_coldDir) || !common::isDirectory(_hotDir))
+    return false;
+  std::string hash = contentHash(_coldDir);
+  return !hash.empty() && hash == contentHash(_hotDir);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check if a path is a complete generation directory.
+/// \param[in] _path Path in the hot tier.
+/// \return True if it's a generation directory, and not being made.
+static bool isGeneration(const std::string &_path)
+{
+  std::string name = common::basename(_path);
+  return name.compare(0, sizeof(kGenerationPrefix) - 1,
+      kGenerationPrefix) == 0 && !common::EndsWith(name, kStagingSuffix) &&
+      common::isDirectory(_path);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check if the copy of a generation directory is retired.
+/// \param[in] _generation Generation directory.
+/// \return True if retired.
+static bool retired(const std::string &_generation)
+{
+  return common::exists(common::joinPaths(_generation, kRetiredFile));
+}
+
+//////////////////////////////////////////////////
+/// \brief Stop handing out a copy. It's removed right away if no process
+/// ever handed it out, otherwise once no process touched it for a while.
+/// \param[in] _copy Copy in the hot tier.
+/// \param[in] _inUse True if this process handed it out.
+/// \return True if the copy is kept.
+static bool retire(const std::string &_copy, bool _inUse)
+{
+  std::string generation = common::parentPath(_copy);
+  if (!retired(generation))
+    std::ofstream(common::joinPaths(generation, kRetiredFile)) << "\n";
+
+  // Processes mark a copy as used before checking that it isn't retired,
+  // so either they see it retired, or it's seen used here. It's renamed
+  // before being removed, so it's never found half removed.
+  if (_inUse || common::exists(common::joinPaths(generation, kUsedFile)))
+    return true;
+  std::string removed = generation + kStagingSuffix;
+  if (common::moveFile(generation, removed))
+    common::removeAll(removed);
+  return false;
+}
+
+//////////////////////////////////////////////////
+/// \brief Mark a generation directory as used by this process.
+/// \param[in] _generation Generation directory.
+static void touch(const std::string &_generation)
+{
+  std::ofstream(common::joinPaths(_generation, kUsedFile),
+      std::ios::trunc) << std::time(nullptr) << "\n";
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the last time a path was changed.
+/// \param[in] _path Path.
+/// \return Modification time, or 0 if unknown.
+static std::time_t modified(const std::string &_path)
+{
+  struct stat info;
+  return stat(_path.c_str(), &info) == 0 ? info.st_mtime : 0;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get a new name for a generation directory.
+/// \return The name.
+static std::string generationName()
+{
+  std::random_device device;
+  std::ostringstream name;
+  name << kGenerationPrefix << std::hex << device() << device();
+  return name.str();
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the counter of lookups served by a tier.
+/// \param[in] _tier "hot" or "cold".
+/// \return The counter.
+static MetricCounter &tierHits(const std::string &_tier)
+{
+  return MetricsRegistry::Global().Counter("ign_fuel_cache_tier_hits_total",
+      "Local cache lookups, by the tier which served them.",
+      {{"tier", _tier}});
+}
+
+//////////////////////////////////////////////////
+std::string HotCachePrivate::CopiesDir(const std::string &_coldDir) const
+{
+  if (_coldDir.size() <= this->coldRoot.size() ||
+      _coldDir.compare(0, this->coldRoot.size(), this->coldRoot) != 0 ||
+      (_coldDir[this->coldRoot.size()] != '/' &&
+       _coldDir[this->coldRoot.size()] != '\\'))
+  {
+    return "";
+  }
+  return common::joinPaths(this->hotRoot, common::parentPath(
+      _coldDir.substr(this->coldRoot.size() + 1)));
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::Age()
+{
+  if (++this->lookupsSinceAging <
+      std::max<uint64_t>(1024, 8 * this->entries.size()))
+  {
+    return;
+  }
+  this->lookupsSinceAging = 0;
+
+  for (auto it = this->entries.begin(); it != this->entries.end();)
+  {
+    it->second.lookups /= 2;
+    if (it->second.lookups == 0 && !it->second.hot && !it->second.queued)
+      it = this->entries.erase(it);
+    else
+      ++it;
+  }
+}
+
+//////////////////////////////////////////////////
+std::string HotCachePrivate::Drop(Entry &_entry)
+{
+  if (!_entry.hot)
+    return "";
+
+  _entry.hot = false;
+  this->stats.hotBytes -= _entry.bytes;
+  --this->stats.hotEntries;
+  _entry.bytes = 0;
+  std::string copy;
+  copy.swap(_entry.copy);
+  return copy;
+}
+
+//////////////////////////////////////////////////
+bool HotCachePrivate::MakeRoom(uint64_t _bytes, uint64_t _lookups,
+    std::vector<std::string> &_demoted, bool _partial)
+{
+  uint64_t used = this->stats.hotBytes + this->stats.retiredBytes;
+  if (used + _bytes <= this->capacity)
+    return true;
+
+  std::vector<std::map<std::string, Entry>::iterator> hot;
+  for (auto it = this->entries.begin(); it != this->entries.end(); ++it)
+  {
+    if (it->second.hot && this->handedOut.count(
+        common::parentPath(it->second.copy)) == 0)
+    {
+      hot.push_back(it);
+    }
+  }
+  std::sort(hot.begin(), hot.end(), [](const auto &_a, const auto &_b)
+      {
+        if (_a->second.lookups != _b->second.lookups)
+          return _a->second.lookups < _b->second.lookups;
+        return _a->second.lastLookup < _b->second.lastLookup;
+      });
+
+  // The least looked up copies go first, as long as they're less popular
+  // than the version which needs room.
+  uint64_t freed = 0;
+  size_t victims = 0;
+  while (used - freed + _bytes > this->capacity)
+  {
+    if (victims == hot.size() || hot[victims]->second.lookups >= _lookups)
+    {
+      if (!_partial)
+        return false;
+      break;
+    }
+    freed += hot[victims++]->second.bytes;
+  }
+
+  for (size_t i = 0; i < victims; ++i)
+    _demoted.push_back(this->Drop(hot[i]->second));
+  return used - freed + _bytes <= this->capacity;
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::CheckCapacity()
+{
+  if (this->stats.hotBytes + this->stats.retiredBytes > this->capacity)
+  {
+    this->overfull = true;
+    this->cv.notify_all();
+  }
+}
+
+//////////////////////////////////////////////////
+std::string HotCachePrivate::FindCopy(const std::string &_coldDir,
+    const std::string &_copies, std::string &_hash)
+{
+  if (!common::isDirectory(_copies))
+    return "";
+
+  std::string version = common::basename(_coldDir);
+  common::DirIter end;
+  for (common::DirIter iter(_copies); iter != end; ++iter)
+  {
+    std::string copy = common::joinPaths(*iter, version);
+    if (!isGeneration(*iter) || retired(*iter) || !common::isDirectory(copy))
+      continue;
+    if (upToDate(_coldDir, copy))
+    {
+      _hash = contentHash(copy);
+      return copy;
+    }
+    this->Retire(copy);
+  }
+  return "";
+}
+
+//////////////////////////////////////////////////
+std::string HotCachePrivate::HandOut(const std::string &_coldDir,
+    bool _lookup)
+{
+  static auto &hotHits = tierHits("hot");
+
+  std::string copy;
+  std::string generationDir;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->entries.find(_coldDir);
+    if (it == this->entries.end() || !it->second.hot)
+      return "";
+
+    copy = it->second.copy;
+    generationDir = common::parentPath(copy);
+    if (this->handedOut.count(generationDir) != 0)
+    {
+      if (_lookup)
+      {
+        ++it->second.lookups;
+        it->second.lastLookup = std::chrono::steady_clock::now();
+        this->Age();
+      }
+      ++this->stats.hotHits;
+      hotHits.Increment();
+      return copy;
+    }
+  }
+
+  // The first time, the copy is marked as used by this process, so other
+  // processes keep it. One may have retired it meanwhile.
+  touch(generationDir);
+  bool gone = retired(generationDir) || !common::isDirectory(copy);
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->entries.find(_coldDir);
+  if (gone)
+  {
+    if (it != this->entries.end() && it->second.copy == copy)
+      this->Drop(it->second);
+    return "";
+  }
+
+  this->handedOut.insert(generationDir);
+  if (_lookup && it != this->entries.end())
+  {
+    ++it->second.lookups;
+    it->second.lastLookup = std::chrono::steady_clock::now();
+    this->Age();
+  }
+  ++this->stats.hotHits;
+  hotHits.Increment();
+  return copy;
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::Retire(const std::string &_copy)
+{
+  bool inUse;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    inUse = this->handedOut.count(common::parentPath(_copy)) != 0;
+  }
+
+  if (!retire(_copy, inUse))
+    return;
+
+  uint64_t bytes = treeBytes(common::parentPath(_copy));
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->stats.retiredBytes += bytes;
+  this->CheckCapacity();
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::Demote(const std::vector<std::string> &_demoted)
+{
+  static auto &demotions = MetricsRegistry::Global().Counter(
+      "ign_fuel_cache_tier_demotions_total",
+      "Versions removed from the hot tier of the cache to make room.");
+
+  for (const auto &copy : _demoted)
+  {
+    this->Retire(copy);
+    demotions.Increment();
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->stats.demotions += _demoted.size();
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::Promote(const std::string &_coldDir)
+{
+  TraceSpan span("HotCache::Promote", "cache");
+  if (span.Active())
+    span.SetDetail(_coldDir);
+
+  uint64_t generation;
+  uint64_t lookups;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto &entry = this->entries[_coldDir];
+    if (entry.hot)
+    {
+      entry.queued = false;
+      return;
+    }
+    generation = entry.generation;
+    lookups = entry.lookups;
+  }
+
+  // Copies are only checked against the cache directory by their hash, so
+  // versions without one aren't promoted.
+  std::string hash = contentHash(_coldDir);
+  uint64_t bytes = hash.empty() ? 0 : treeBytes(_coldDir);
+
+  // Make room, reserving the space of the copy.
+  std::vector<std::string> demoted;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto &entry = this->entries[_coldDir];
+    if (bytes == 0 || bytes > this->capacity ||
+        !this->MakeRoom(bytes, lookups, demoted))
+    {
+      entry.queued = false;
+      entry.unpromotable = bytes == 0 || bytes > this->capacity;
+      return;
+    }
+    this->stats.hotBytes += bytes;
+  }
+  this->Demote(demoted);
+
+  // Copy to a new generation directory under a temporary name, and rename
+  // it once complete, so a copy is never used half made.
+  std::string generationDir = common::joinPaths(this->CopiesDir(_coldDir),
+      generationName());
+  std::string stagingDir = generationDir + kStagingSuffix;
+  std::string copy = common::joinPaths(generationDir,
+      common::basename(_coldDir));
+  std::string stagingCopy = common::joinPaths(stagingDir,
+      common::basename(_coldDir));
+  bool copied = copyTree(_coldDir, stagingCopy) &&
+      contentHash(stagingCopy) == hash;
+  if (copied)
+  {
+    rewritePaths(stagingCopy, _coldDir, copy);
+    copied = common::moveFile(stagingDir, generationDir);
+  }
+  if (!copied)
+    common::removeAll(stagingDir);
+
+  static auto &promotions = MetricsRegistry::Global().Counter(
+      "ign_fuel_cache_tier_promotions_total",
+      "Versions copied to the hot tier of the cache.");
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto &entry = this->entries[_coldDir];
+    entry.queued = false;
+    this->stats.hotBytes -= bytes;
+    if (!copied)
+      return;
+
+    if (entry.generation == generation)
+    {
+      entry.hot = true;
+      entry.checked = true;
+      entry.bytes = bytes;
+      entry.copy = copy;
+      entry.hash = hash;
+      this->stats.hotBytes += bytes;
+      ++this->stats.hotEntries;
+      ++this->stats.promotions;
+      promotions.Increment();
+      return;
+    }
+  }
+
+  // The version changed during the copy, and it was never handed out.
+  this->Retire(copy);
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::Sweep()
+{
+  std::set<std::string> inUse;
+  std::map<std::string, Entry> hot;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    inUse = this->handedOut;
+    for (const auto &entry : this->entries)
+    {
+      if (entry.second.hot)
+        hot.insert(entry);
+    }
+  }
+
+  // Touching the copies in use keeps other processes from removing them.
+  for (const auto &generationDir : inUse)
+    touch(generationDir);
+
+  // Versions are normally invalidated when they change, but changes by
+  // other processes may go unnoticed, so the copies handed out are checked
+  // against the cache directory once in a while.
+  for (const auto &entry : hot)
+  {
+    if (contentHash(entry.first) == entry.second.hash)
+      continue;
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      auto it = this->entries.find(entry.first);
+      if (it == this->entries.end() || it->second.copy != entry.second.copy)
+        continue;
+      this->Drop(it->second);
+    }
+    this->Retire(entry.second.copy);
+  }
+
+  uint64_t retiredBytes = 0;
+  this->Sweep(this->hotRoot, this->coldRoot, inUse, retiredBytes);
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->stats.retiredBytes = retiredBytes;
+  this->CheckCapacity();
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::Sweep(const std::string &_hotDir,
+    const std::string &_coldDir, const std::set<std::string> &_inUse,
+    uint64_t &_retiredBytes)
+{
+  std::time_t expiry = std::time(nullptr) - kGraceSeconds;
+
+  common::DirIter end;
+  for (common::DirIter iter(_hotDir); iter != end; ++iter)
+  {
+    const std::string path = *iter;
+    std::string name = common::basename(path);
+    if (!common::isDirectory(path))
+      continue;
+
+    if (name.compare(0, sizeof(kGenerationPrefix) - 1,
+        kGenerationPrefix) != 0)
+    {
+      this->Sweep(path, common::joinPaths(_coldDir, name), _inUse,
+          _retiredBytes);
+      continue;
+    }
+
+    // Left by a process which stopped while copying or removing.
+    if (common::EndsWith(name, kStagingSuffix))
+    {
+      if (modified(path) < expiry)
+        common::removeAll(path);
+      continue;
+    }
+
+    if (!retired(path))
+    {
+      common::DirIter versionEnd;
+      for (common::DirIter version(path); version != versionEnd; ++version)
+      {
+        if (common::isDirectory(*version) && !upToDate(common::joinPaths(
+            _coldDir, common::basename(*version)), *version) &&
+            retire(*version, _inUse.count(path) != 0))
+        {
+          _retiredBytes += treeBytes(path);
+        }
+      }
+      continue;
+    }
+
+    if (_inUse.count(path) == 0 &&
+        std::max({modified(path),
+          modified(common::joinPaths(path, kRetiredFile)),
+          modified(common::joinPaths(path, kUsedFile))}) < expiry)
+    {
+      common::removeAll(path);
+    }
+    else
+    {
+      _retiredBytes += treeBytes(path);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void HotCachePrivate::Run()
+{
+  this->Sweep();
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->busy = false;
+  this->cv.notify_all();
+  while (true)
+  {
+    bool work = this->cv.wait_for(lock, kSweepInterval, [this]
+        {
+          return this->stop || !this->queue.empty() || this->overfull;
+        });
+    if (this->stop)
+      return;
+
+    this->busy = true;
+    if (!work)
+    {
+      lock.unlock();
+      this->Sweep();
+    }
+    else if (!this->queue.empty())
+    {
+      std::string coldDir = this->queue.front();
+      this->queue.pop_front();
+      lock.unlock();
+      this->Promote(coldDir);
+    }
+    else
+    {
+      // Copies found in the hot tier, or retired copies still in use, don't
+      // fit. As many copies as needed, or as possible, are demoted.
+      this->overfull = false;
+      std::vector<std::string> demoted;
+      this->MakeRoom(0, std::numeric_limits<uint64_t>::max(), demoted,
+          true);
+      lock.unlock();
+      this->Demote(demoted);
+    }
+    lock.lock();
+    this->busy = false;
+    this->cv.notify_all();
+  }
+}
+
+//////////////////////////////////////////////////
+HotCache::HotCache(const std::string &_coldRoot, const std::string &_hotRoot,
+    uint64_t _capacity, unsigned int _promotion)
+  : dataPtr(new HotCachePrivate)
+{
+  this->dataPtr->coldRoot = _coldRoot;
+  while (this->dataPtr->coldRoot.size() > 1 &&
+      (this->dataPtr->coldRoot.back() == '/' ||
+       this->dataPtr->coldRoot.back() == '\\'))
+  {
+    this->dataPtr->coldRoot.pop_back();
+  }
+  this->dataPtr->hotRoot = _hotRoot;
+  this->dataPtr->capacity = _capacity;
+  this->dataPtr->promotion = std::max(1u, _promotion);
+
+  if (!common::createDirectories(_hotRoot))
+  {
+    ignerr << "Unable to create directory [" << _hotRoot << "]"
+           << std::endl;
+  }
+
+  this->dataPtr->worker = std::thread(&HotCachePrivate::Run,
+      this->dataPtr.get());
+}
+
+//////////////////////////////////////////////////
+HotCache::~HotCache()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->stop = true;
+  }
+  this->dataPtr->cv.notify_all();
+  this->dataPtr->worker.join();
+}
+
+//////////////////////////////////////////////////
+std::string HotCache::Resolve(const std::string &_coldDir)
+{
+  static auto &coldHits = tierHits("cold");
+
+  std::string copiesDir = this->dataPtr->CopiesDir(_coldDir);
+  if (copiesDir.empty())
+    return _coldDir;
+
+  bool check;
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    auto &entry = this->dataPtr->entries[_coldDir];
+    ++entry.lookups;
+    entry.lastLookup = std::chrono::steady_clock::now();
+    check = !entry.checked;
+    generation = entry.generation;
+    this->dataPtr->Age();
+  }
+
+  // The first lookup looks for a copy left by an earlier process, without
+  // holding the lock. Later ones only use the copies known to be up to
+  // date, so they don't touch the cache directory.
+  if (check)
+  {
+    std::string hash;
+    std::string copy = this->dataPtr->FindCopy(_coldDir, copiesDir, hash);
+    uint64_t bytes = copy.empty() ? 0 : treeBytes(copy);
+
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    auto &entry = this->dataPtr->entries[_coldDir];
+
+    // The version may have changed meanwhile, in which case the copy which
+    // was checked isn't used.
+    if (entry.generation == generation && !entry.checked)
+    {
+      entry.checked = true;
+      if (!copy.empty() && !entry.hot)
+      {
+        entry.hot = true;
+        entry.bytes = bytes;
+        entry.copy = copy;
+        entry.hash = hash;
+        this->dataPtr->stats.hotBytes += bytes;
+        ++this->dataPtr->stats.hotEntries;
+        this->dataPtr->CheckCapacity();
+      }
+    }
+  }
+
+  std::string copy = this->dataPtr->HandOut(_coldDir, false);
+  if (!copy.empty())
+    return copy;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  ++this->dataPtr->stats.coldHits;
+  coldHits.Increment();
+
+  auto &entry = this->dataPtr->entries[_coldDir];
+  if (!entry.hot && !entry.queued && !entry.unpromotable &&
+      entry.lookups >= this->dataPtr->promotion)
+  {
+    entry.queued = true;
+    this->dataPtr->queue.push_back(_coldDir);
+    this->dataPtr->cv.notify_all();
+  }
+  return _coldDir;
+}
+
+//////////////////////////////////////////////////
+std::string HotCache::ResolveHot(const std::string &_coldDir)
+{
+  return this->dataPtr->HandOut(_coldDir, true);
+}
+
+//////////////////////////////////////////////////
+void HotCache::Invalidate(const std::string &_coldDir)
+{
+  std::string copiesDir = this->dataPtr->CopiesDir(_coldDir);
+  if (copiesDir.empty())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    auto it = this->dataPtr->entries.find(_coldDir);
+    if (it != this->dataPtr->entries.end())
+    {
+      ++it->second.generation;
+      it->second.unpromotable = false;
+      this->dataPtr->Drop(it->second);
+    }
+  }
+
+  // Copies may be in use, by this process or others, so they're retired
+  // rather than removed.
+  if (!common::isDirectory(copiesDir))
+    return;
+  std::string version = common::basename(_coldDir);
+  common::DirIter end;
+  for (common::DirIter iter(copiesDir); iter != end; ++iter)
+  {
+    std::string copy = common::joinPaths(*iter, version);
+    if (isGeneration(*iter) && !retired(*iter) && common::isDirectory(copy))
+      this->dataPtr->Retire(copy);
+  }
+}
+
+//////////////////////////////////////////////////
+void HotCache::Wait() const
+{
+  std::unique_lock<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->cv.wait(lock, [this]
+      {
+        return this->dataPtr->stop || (!this->dataPtr->busy &&
+            this->dataPtr->queue.empty() && !this->dataPtr->overfull);
+      });
+}
+
+//////////////////////////////////////////////////
+CacheTierStats HotCache::Stats() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->stats;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_FUEL_TOOLS_HOTCACHE_HH_
+#define IGNITION_FUEL_TOOLS_HOTCACHE_HH_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ignition/fuel_tools/Export.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class HotCachePrivate;
+
+    /// \brief A small and fast tier in front of the cache directory. It
+    /// holds copies of the most looked up versioned directories, each in a
+    /// generation directory under the relative path of their parent in the
+    /// cache directory.
+    ///
+    /// Lookups are counted, and a version looked up often enough is copied
+    /// to the hot tier by a worker thread. When the hot tier is full, the
+    /// versions with the fewest lookups are demoted, but only for a version
+    /// with more lookups. Counts are halved periodically, so old popularity
+    /// fades. Copies of models have their paths, which point to the cache
+    /// directory, rewritten.
+    ///
+    /// Copies are checked against the cache directory by their content
+    /// hash when they're made or found, and then handed out without
+    /// touching the cache directory. Versions which change are invalidated,
+    /// and the worker checks the copies in use periodically, in case a
+    /// change went unnoticed.
+    ///
+    /// A copy which was handed out may be in use, so demoted and stale
+    /// copies are only retired: they're no longer handed out, and the worker
+    /// removes them once no process touched them for an hour. Copies handed
+    /// out are never removed while the process which handed them out runs,
+    /// and it touches them periodically. Copies no process handed out are
+    /// removed right away. Retired copies which are kept count against the
+    /// capacity until removed.
+    class IGNITION_FUEL_TOOLS_VISIBLE HotCache
+    {
+      /// \brief Constructor.
+      /// \param[in] _coldRoot Cache directory.
+      /// \param[in] _hotRoot Directory of the hot tier.
+      /// \param[in] _capacity Maximum size of the hot tier, in bytes.
+      /// \param[in] _promotion Lookups after which a version is promoted.
+      public: HotCache(const std::string &_coldRoot,
+          const std::string &_hotRoot, uint64_t _capacity,
+          unsigned int _promotion);
+
+      /// \brief Destructor. Waits for the copy or sweep in progress, if
+      /// any.
+      public: ~HotCache();
+
+      /// \brief Count a lookup of a version, and get the fastest copy of it.
+      /// \param[in] _coldDir Versioned directory in the cache directory.
+      /// \return The copy in the hot tier if there's an up to date one,
+      /// otherwise _coldDir. A copy is never removed while this process
+      /// runs.
+      public: std::string Resolve(const std::string &_coldDir);
+
+      /// \brief Same as Resolve, but only for versions with a copy in the
+      /// hot tier already known to this process, so the version doesn't
+      /// need to be found in the cache directory first.
+      /// \param[in] _coldDir Versioned directory in the cache directory,
+      /// which may not exist.
+      /// \return The copy, or empty if there's none, in which case the
+      /// lookup isn't counted.
+      public: std::string ResolveHot(const std::string &_coldDir);
+
+      /// \brief Retire the copies of a version which changed or was
+      /// removed.
+      /// \param[in] _coldDir Versioned directory in the cache directory.
+      public: void Invalidate(const std::string &_coldDir);
+
+      /// \brief Wait until the sweep at construction, and the queued
+      /// promotions and demotions, are done.
+      public: void Wait() const;
+
+      /// \brief Get lookup and promotion statistics.
+      /// \return Statistics since construction.
+      public: CacheTierStats Stats() const;
+
+      /// \brief Private data.
+      private: std::unique_ptr<HotCachePrivate> dataPtr;
+    };
+  }
+}
+
+#endif
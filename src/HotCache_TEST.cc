@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+#include <utime.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/LocalCache.hh"
+
+#include "HotCache.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+/// \brief Write a file, creating its directory.
+void writeFile(const std::string &_path, const std::string &_content)
+{
+  common::createDirectories(common::parentPath(_path));
+  std::ofstream out(_path, std::ios::binary | std::ios::trunc);
+  out << _content;
+}
+
+/////////////////////////////////////////////////
+/// \brief Read a whole file.
+std::string readFile(const std::string &_path)
+{
+  std::ifstream in(_path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>());
+}
+
+/////////////////////////////////////////////////
+/// \brief Create a saved model of about 200 bytes in the cache directory.
+std::string createModel(const std::string &_cold, const std::string &_name,
+    const std::string &_hash)
+{
+  std::string dir = common::joinPaths(_cold, "localhost:8001", "alice",
+      "models", _name, "1");
+  writeFile(common::joinPaths(dir, "model.sdf"),
+      "<sdf><model><link><visual><geometry><mesh><uri>file://" + dir +
+      "/meshes/a.dae</uri></mesh></geometry></visual></link></model></sdf>");
+  writeFile(common::joinPaths(dir, "meshes", "a.dae"), std::string(50, 'a'));
+  writeFile(common::joinPaths(dir, ".archive_hash"), _hash);
+  return dir;
+}
+
+/////////////////////////////////////////////////
+TEST(HotCache, Promote)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH, "test_tiers");
+  common::removeAll(root);
+  std::string cold = common::joinPaths(root, "cold");
+  std::string hot = common::joinPaths(root, "hot");
+  std::string coldDir = createModel(cold, "m1", "h1");
+  std::string copies = common::joinPaths(hot, "localhost:8001", "alice",
+      "models", "m1");
+
+  HotCache tiers(cold, hot, 1000, 2);
+
+  // Paths outside the cache aren't counted
+  EXPECT_EQ(root, tiers.Resolve(root));
+  EXPECT_EQ(0u, tiers.Stats().coldHits);
+
+  // Promoted on the second lookup, in the background
+  EXPECT_EQ(coldDir, tiers.Resolve(coldDir));
+  tiers.Wait();
+  EXPECT_EQ(0u, tiers.Stats().promotions);
+  EXPECT_FALSE(common::exists(copies));
+
+  EXPECT_EQ(coldDir, tiers.Resolve(coldDir));
+  tiers.Wait();
+  auto stats = tiers.Stats();
+  EXPECT_EQ(1u, stats.promotions);
+  EXPECT_EQ(1u, stats.hotEntries);
+  EXPECT_LT(100u, stats.hotBytes);
+  EXPECT_EQ(2u, stats.coldHits);
+
+  // Each copy has its own generation directory
+  std::string hotDir = tiers.Resolve(coldDir);
+  EXPECT_EQ(1u, tiers.Stats().hotHits);
+  EXPECT_EQ(copies, common::parentPath(common::parentPath(hotDir)));
+  EXPECT_EQ("1", common::basename(hotDir));
+
+  // The copy points to itself
+  std::string sdf = readFile(common::joinPaths(hotDir, "model.sdf"));
+  EXPECT_NE(std::string::npos, sdf.find(hotDir + "/meshes/a.dae"));
+  EXPECT_EQ(std::string::npos, sdf.find(coldDir));
+  EXPECT_EQ(std::string(50, 'a'),
+      readFile(common::joinPaths(hotDir, "meshes", "a.dae")));
+
+  // Known copies are handed out without checking the cache directory
+  EXPECT_EQ(hotDir, tiers.ResolveHot(coldDir));
+  EXPECT_EQ(2u, tiers.Stats().hotHits);
+  EXPECT_TRUE(tiers.ResolveHot(coldDir + "0").empty());
+
+  // A copy of a version saved again isn't used once invalidated, but stays
+  // in place since it was handed out
+  writeFile(common::joinPaths(coldDir, ".archive_hash"), "h2");
+  EXPECT_EQ(hotDir, tiers.Resolve(coldDir));
+  tiers.Invalidate(coldDir);
+  EXPECT_EQ(coldDir, tiers.Resolve(coldDir));
+  EXPECT_TRUE(tiers.ResolveHot(coldDir).empty());
+  auto retiredStats = tiers.Stats();
+  EXPECT_EQ(0u, retiredStats.hotEntries);
+  EXPECT_LT(100u, retiredStats.retiredBytes);
+  tiers.Wait();
+  std::string newHotDir = tiers.Resolve(coldDir);
+  EXPECT_NE(coldDir, newHotDir);
+  EXPECT_NE(hotDir, newHotDir);
+  EXPECT_EQ("h2", readFile(common::joinPaths(newHotDir, ".archive_hash")));
+  EXPECT_EQ("h1", readFile(common::joinPaths(hotDir, ".archive_hash")));
+  EXPECT_TRUE(common::exists(common::joinPaths(hotDir, "meshes", "a.dae")));
+
+  tiers.Invalidate(coldDir);
+  EXPECT_EQ(0u, tiers.Stats().hotBytes);
+  EXPECT_TRUE(common::exists(common::joinPaths(newHotDir, "model.sdf")));
+
+  // Versions without a content hash aren't promoted, since their copies
+  // couldn't be checked
+  std::string unhashed = createModel(cold, "m2", "");
+  tiers.Resolve(unhashed);
+  tiers.Resolve(unhashed);
+  tiers.Wait();
+  EXPECT_EQ(unhashed, tiers.Resolve(unhashed));
+  EXPECT_EQ(2u, tiers.Stats().promotions);
+
+  common::removeAll(root);
+}
+
+/////////////////////////////////////////////////
+TEST(HotCache, TreeHash)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH, "test_tiers");
+  common::removeAll(root);
+  std::string cold = common::joinPaths(root, "cold");
+  std::string hot = common::joinPaths(root, "hot");
+
+  // Versions saved from a delta only have a tree hash
+  std::string coldDir = createModel(cold, "m1", "");
+  common::removeFile(common::joinPaths(coldDir, ".archive_hash"));
+  writeFile(common::joinPaths(coldDir, ".tree_hash"), "t1");
+
+  HotCache tiers(cold, hot, 1000, 1);
+  tiers.Resolve(coldDir);
+  tiers.Wait();
+  std::string hotDir = tiers.Resolve(coldDir);
+  EXPECT_NE(coldDir, hotDir);
+  EXPECT_EQ(1u, tiers.Stats().hotHits);
+  EXPECT_EQ("t1", readFile(common::joinPaths(hotDir, ".tree_hash")));
+
+  common::removeAll(root);
+}
+
+/////////////////////////////////////////////////
+TEST(HotCache, Demote)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH, "test_tiers");
+  common::removeAll(root);
+  std::string cold = common::joinPaths(root, "cold");
+  std::string hot = common::joinPaths(root, "hot");
+  std::string dir1 = createModel(cold, "m1", "h1");
+  std::string dir2 = createModel(cold, "m2", "h2");
+  std::string dir3 = createModel(cold, "m3", "h3");
+  std::string copies1 = common::joinPaths(hot, "localhost:8001", "alice",
+      "models", "m1");
+
+  // Room for a single model
+  uint64_t modelBytes = 0;
+  for (const auto &file : {"model.sdf", "meshes/a.dae", ".archive_hash"})
+    modelBytes += readFile(common::joinPaths(dir1, file)).size();
+  uint64_t capacity = modelBytes * 3 / 2;
+
+  std::string hotDir2;
+  {
+    HotCache tiers(cold, hot, capacity, 1);
+    tiers.Resolve(dir1);
+    tiers.Wait();
+    EXPECT_EQ(1u, tiers.Stats().hotEntries);
+
+    // Less popular models don't replace it
+    tiers.Resolve(dir2);
+    tiers.Wait();
+    EXPECT_EQ(dir2, tiers.Resolve(dir2));
+    EXPECT_EQ(0u, tiers.Stats().demotions);
+
+    // More popular ones do. The demoted copy was never handed out, so it's
+    // removed right away.
+    tiers.Resolve(dir2);
+    tiers.Wait();
+    hotDir2 = tiers.Resolve(dir2);
+    EXPECT_NE(dir2, hotDir2);
+    EXPECT_EQ(1u, tiers.Stats().demotions);
+    EXPECT_FALSE(common::DirIter(copies1) != common::DirIter());
+    EXPECT_EQ(0u, tiers.Stats().retiredBytes);
+
+    // A copy handed out isn't demoted, since its space wouldn't be freed
+    for (int i = 0; i < 5; ++i)
+      tiers.Resolve(dir1);
+    tiers.Wait();
+    EXPECT_EQ(dir1, tiers.Resolve(dir1));
+    EXPECT_EQ(hotDir2, tiers.Resolve(dir2));
+    auto stats = tiers.Stats();
+    EXPECT_EQ(1u, stats.demotions);
+    EXPECT_EQ(1u, stats.hotEntries);
+  }
+
+  // Copies outlive the process which made them
+  {
+    HotCache tiers(cold, hot, 10 * capacity, 5);
+    tiers.Wait();
+    EXPECT_EQ(hotDir2, tiers.Resolve(dir2));
+    EXPECT_EQ(dir1, tiers.Resolve(dir1));
+    EXPECT_EQ(dir3, tiers.Resolve(dir3));
+    EXPECT_EQ(1u, tiers.Stats().hotEntries);
+
+    // Retired copies which were handed out are kept
+    tiers.Invalidate(dir2);
+    EXPECT_TRUE(common::exists(common::joinPaths(hotDir2, "model.sdf")));
+    EXPECT_LT(modelBytes / 2, tiers.Stats().retiredBytes);
+  }
+
+  // They're kept for a while, since other processes may use them, and
+  // their space counts, so nothing else fits
+  {
+    HotCache tiers(cold, hot, capacity, 1);
+    tiers.Wait();
+    EXPECT_LT(modelBytes / 2, tiers.Stats().retiredBytes);
+    tiers.Resolve(dir1);
+    tiers.Wait();
+    EXPECT_EQ(dir1, tiers.Resolve(dir1));
+    EXPECT_EQ(0u, tiers.Stats().promotions);
+    EXPECT_TRUE(common::exists(common::joinPaths(hotDir2, "model.sdf")));
+  }
+
+#ifndef _WIN32
+  // Retired copies nobody touched for a while are removed by the next
+  // process
+  std::string generation2 = common::parentPath(hotDir2);
+  struct utimbuf old;
+  old.actime = old.modtime = time(nullptr) - 7200;
+  for (const auto &path : {generation2,
+      common::joinPaths(generation2, ".retired"),
+      common::joinPaths(generation2, ".used")})
+  {
+    EXPECT_EQ(0, utime(path.c_str(), &old)) << path;
+  }
+
+  HotCache tiers(cold, hot, capacity, 1);
+  tiers.Wait();
+  EXPECT_FALSE(common::exists(generation2));
+  EXPECT_EQ(0u, tiers.Stats().retiredBytes);
+  tiers.Resolve(dir1);
+  tiers.Wait();
+  EXPECT_NE(dir1, tiers.Resolve(dir1));
+#endif
+
+  common::removeAll(root);
+}
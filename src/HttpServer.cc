@@ -0,0 +1,742 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+  #include <arpa/inet.h>
+  #include <fcntl.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <poll.h>
+  #include <sys/socket.h>
+  #include <sys/types.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/common/Console.hh>
+#include <ignition/common/StringUtils.hh>
+#include <ignition/common/Util.hh>
+
+#include "HttpServer.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+/// \brief Private data for HttpServer.
+class ignition::fuel_tools::HttpServerPrivate
+{
+  /// \brief A connection being served by its own thread.
+  public: struct Connection
+  {
+    /// \brief Socket.
+    int fd = -1;
+
+    /// \brief Thread serving the connection.
+    std::thread thread;
+
+    /// \brief Set once the thread is about to exit.
+    std::atomic<bool> done{false};
+  };
+
+  /// \brief Accept connections until stopped.
+  public: void AcceptLoop();
+
+  /// \brief Serve all the requests of a connection.
+  /// \param[in] _conn Connection to serve.
+  public: void Serve(Connection &_conn);
+
+  /// \brief Read one request from a connection.
+  /// \param[in] _fd Socket.
+  /// \param[in,out] _buffer Data received but not processed yet.
+  /// \param[out] _request Parsed request.
+  /// \param[out] _error Status to answer with before closing the
+  /// connection, or 0 to close it silently.
+  /// \return False if the connection was closed or the request is invalid.
+  public: bool ReadRequest(int _fd, std::string &_buffer,
+      HttpRequest &_request, int &_error);
+
+  /// \brief Send a response.
+  /// \param[in] _fd Socket.
+  /// \param[in] _request Request being answered.
+  /// \param[in] _response Response to send.
+  /// \param[in] _keepAlive Whether the connection will stay open.
+  /// \return True if the whole response was sent.
+  public: bool WriteResponse(int _fd, const HttpRequest &_request,
+      const HttpResponse &_response, bool _keepAlive);
+
+  /// \brief Join threads of connections which are done.
+  /// \param[in] _all True to close and join every connection.
+  public: void Reap(bool _all);
+
+  /// \brief Request handler.
+  public: HttpServer::Handler handler;
+
+  /// \brief Listening socket.
+  public: int listenFd = -1;
+
+  /// \brief Pipe used to wake up the accept loop on Stop().
+  public: int wakeFds[2] = {-1, -1};
+
+  /// \brief Port, when listening on TCP.
+  public: uint16_t port = 0;
+
+  /// \brief Host, when listening on TCP.
+  public: std::string host;
+
+  /// \brief Socket path, when listening on a Unix socket.
+  public: std::string unixPath;
+
+  /// \brief Whether the server is running.
+  public: std::atomic<bool> running{false};
+
+  /// \brief Thread accepting connections.
+  public: std::thread acceptThread;
+
+  /// \brief Open connections.
+  public: std::list<Connection> connections;
+
+  /// \brief Protects connections.
+  public: std::mutex mutex;
+
+  /// \brief Largest request body accepted, in bytes.
+  public: std::atomic<size_t> maxBodySize{1024 * 1024};
+
+  /// \brief Maximum number of open connections.
+  public: std::atomic<size_t> maxConnections{256};
+};
+
+//////////////////////////////////////////////////
+/// \brief Get the reason phrase of a status code.
+/// \param[in] _status Status code.
+/// \return Reason phrase, such as "Not Found".
+static std::string statusReason(int _status)
+{
+  switch (_status)
+  {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Decode %XX sequences and, optionally, '+' as space.
+/// \param[in] _str String to decode.
+/// \param[in] _plusAsSpace Whether '+' means space, as in query strings.
+/// \return Decoded string.
+static std::string percentDecode(const std::string &_str, bool _plusAsSpace)
+{
+  std::string result;
+  result.reserve(_str.size());
+  for (size_t i = 0; i < _str.size(); ++i)
+  {
+    if (_str[i] == '%' && i + 2 < _str.size() &&
+        std::isxdigit(static_cast<unsigned char>(_str[i + 1])) &&
+        std::isxdigit(static_cast<unsigned char>(_str[i + 2])))
+    {
+      result += static_cast<char>(std::stoi(_str.substr(i + 1, 2), nullptr,
+          16));
+      i += 2;
+    }
+    else if (_str[i] == '+' && _plusAsSpace)
+    {
+      result += ' ';
+    }
+    else
+    {
+      result += _str[i];
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+HttpServer::HttpServer(const Handler &_handler)
+  : dataPtr(new HttpServerPrivate)
+{
+  this->dataPtr->handler = _handler;
+}
+
+//////////////////////////////////////////////////
+HttpServer::~HttpServer()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void HttpServer::SetMaxBodySize(size_t _size)
+{
+  this->dataPtr->maxBodySize = _size;
+}
+
+//////////////////////////////////////////////////
+size_t HttpServer::MaxBodySize() const
+{
+  return this->dataPtr->maxBodySize;
+}
+
+//////////////////////////////////////////////////
+void HttpServer::SetMaxConnections(size_t _count)
+{
+  this->dataPtr->maxConnections = std::max<size_t>(1u, _count);
+}
+
+//////////////////////////////////////////////////
+size_t HttpServer::MaxConnections() const
+{
+  return this->dataPtr->maxConnections;
+}
+
+#ifdef _WIN32
+//////////////////////////////////////////////////
+bool HttpServer::Start(const std::string &, uint16_t)
+{
+  ignerr << "HttpServer is not supported on Windows." << std::endl;
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool HttpServer::StartUnix(const std::string &)
+{
+  ignerr << "HttpServer is not supported on Windows." << std::endl;
+  return false;
+}
+
+//////////////////////////////////////////////////
+void HttpServer::Stop()
+{
+}
+
+#else
+//////////////////////////////////////////////////
+bool HttpServer::Start(const std::string &_host, uint16_t _port)
+{
+  if (this->dataPtr->running)
+  {
+    ignerr << "Server is already running." << std::endl;
+    return false;
+  }
+
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(_port);
+  if (inet_pton(AF_INET, _host.c_str(), &addr.sin_addr) != 1)
+  {
+    ignerr << "Invalid address [" << _host << "]" << std::endl;
+    return false;
+  }
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    ignerr << "Unable to create socket: " << strerror(errno) << std::endl;
+    return false;
+  }
+
+  int enable = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      listen(fd, SOMAXCONN) < 0)
+  {
+    ignerr << "Unable to listen on [" << _host << ":" << _port << "]: "
+           << strerror(errno) << std::endl;
+    close(fd);
+    return false;
+  }
+
+  socklen_t len = sizeof(addr);
+  getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+
+  this->dataPtr->listenFd = fd;
+  this->dataPtr->host = _host;
+  this->dataPtr->port = ntohs(addr.sin_port);
+  this->dataPtr->unixPath.clear();
+
+  if (pipe(this->dataPtr->wakeFds) < 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  this->dataPtr->running = true;
+  this->dataPtr->acceptThread =
+      std::thread(&HttpServerPrivate::AcceptLoop, this->dataPtr.get());
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool HttpServer::StartUnix(const std::string &_path)
+{
+  if (this->dataPtr->running)
+  {
+    ignerr << "Server is already running." << std::endl;
+    return false;
+  }
+
+  struct sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (_path.empty() || _path.size() >= sizeof(addr.sun_path))
+  {
+    ignerr << "Invalid socket path [" << _path << "]" << std::endl;
+    return false;
+  }
+  std::strncpy(addr.sun_path, _path.c_str(), sizeof(addr.sun_path) - 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    ignerr << "Unable to create socket: " << strerror(errno) << std::endl;
+    return false;
+  }
+
+  unlink(_path.c_str());
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      listen(fd, SOMAXCONN) < 0)
+  {
+    ignerr << "Unable to listen on [" << _path << "]: " << strerror(errno)
+           << std::endl;
+    close(fd);
+    return false;
+  }
+
+  this->dataPtr->listenFd = fd;
+  this->dataPtr->host.clear();
+  this->dataPtr->port = 0;
+  this->dataPtr->unixPath = _path;
+
+  if (pipe(this->dataPtr->wakeFds) < 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  this->dataPtr->running = true;
+  this->dataPtr->acceptThread =
+      std::thread(&HttpServerPrivate::AcceptLoop, this->dataPtr.get());
+  return true;
+}
+
+//////////////////////////////////////////////////
+void HttpServer::Stop()
+{
+  if (!this->dataPtr->running)
+    return;
+
+  this->dataPtr->running = false;
+  char wake = 0;
+  if (write(this->dataPtr->wakeFds[1], &wake, 1) < 0)
+    ignwarn << "Unable to wake up the server thread." << std::endl;
+
+  if (this->dataPtr->acceptThread.joinable())
+    this->dataPtr->acceptThread.join();
+
+  this->dataPtr->Reap(true);
+
+  close(this->dataPtr->listenFd);
+  close(this->dataPtr->wakeFds[0]);
+  close(this->dataPtr->wakeFds[1]);
+  this->dataPtr->listenFd = -1;
+  this->dataPtr->port = 0;
+
+  if (!this->dataPtr->unixPath.empty())
+    unlink(this->dataPtr->unixPath.c_str());
+}
+
+//////////////////////////////////////////////////
+void HttpServerPrivate::AcceptLoop()
+{
+  while (this->running)
+  {
+    struct pollfd fds[2];
+    fds[0].fd = this->listenFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = this->wakeFds[0];
+    fds[1].events = POLLIN;
+
+    // Wake up regularly to join finished connections.
+    if (poll(fds, 2, 1000) <= 0 || !(fds[0].revents & POLLIN))
+    {
+      this->Reap(false);
+      continue;
+    }
+
+    int fd = accept(this->listenFd, nullptr, nullptr);
+    if (fd < 0)
+      continue;
+
+#ifdef SO_NOSIGPIPE
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+    if (this->unixPath.empty())
+    {
+      int noDelay = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+
+    // Each connection has its own thread, so don't let clients open as
+    // many as they like.
+    size_t open;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      open = this->connections.size();
+    }
+    if (open >= this->maxConnections)
+    {
+      this->Reap(false);
+      std::lock_guard<std::mutex> lock(this->mutex);
+      open = this->connections.size();
+    }
+    if (open >= this->maxConnections)
+    {
+      HttpRequest request;
+      HttpResponse busy;
+      busy.status = 503;
+      this->WriteResponse(fd, request, busy, false);
+      close(fd);
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->connections.emplace_back();
+    auto &conn = this->connections.back();
+    conn.fd = fd;
+    conn.thread = std::thread(&HttpServerPrivate::Serve, this,
+        std::ref(conn));
+  }
+}
+
+//////////////////////////////////////////////////
+void HttpServerPrivate::Reap(bool _all)
+{
+  std::list<Connection> finished;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto it = this->connections.begin(); it != this->connections.end();)
+    {
+      if (_all || it->done)
+      {
+        // Unblock any pending read, the thread closes the socket.
+        if (_all)
+          shutdown(it->fd, SHUT_RDWR);
+        auto next = std::next(it);
+        finished.splice(finished.end(), this->connections, it);
+        it = next;
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+
+  for (auto &conn : finished)
+  {
+    if (conn.thread.joinable())
+      conn.thread.join();
+    close(conn.fd);
+  }
+}
+
+//////////////////////////////////////////////////
+void HttpServerPrivate::Serve(Connection &_conn)
+{
+  std::string buffer;
+  while (this->running)
+  {
+    HttpRequest request;
+    int error{0};
+    if (!this->ReadRequest(_conn.fd, buffer, request, error))
+    {
+      if (error != 0)
+      {
+        HttpResponse response;
+        response.status = error;
+        this->WriteResponse(_conn.fd, request, response, false);
+      }
+      break;
+    }
+
+    HttpResponse response;
+    try
+    {
+      this->handler(request, response);
+    }
+    catch(const std::exception &_e)
+    {
+      ignerr << "Error handling [" << request.path << "]: " << _e.what()
+             << std::endl;
+      response = HttpResponse();
+      response.status = 500;
+    }
+
+    auto connection = request.headers.find("connection");
+    bool keepAlive = this->running && (connection == request.headers.end() ||
+        common::lowercase(connection->second) != "close");
+
+    if (!this->WriteResponse(_conn.fd, request, response, keepAlive) ||
+        !keepAlive)
+    {
+      break;
+    }
+  }
+
+  _conn.done = true;
+}
+
+//////////////////////////////////////////////////
+bool HttpServerPrivate::ReadRequest(int _fd, std::string &_buffer,
+    HttpRequest &_request, int &_error)
+{
+  _error = 0;
+  const size_t kMaxHeaderSize{64 * 1024};
+
+  // Read until the end of the headers, waiting at most 30s for idle
+  // keep-alive connections.
+  size_t headerEnd;
+  char chunk[16 * 1024];
+  while ((headerEnd = _buffer.find("\r\n\r\n")) == std::string::npos)
+  {
+    if (_buffer.size() > kMaxHeaderSize)
+      return false;
+
+    struct pollfd pfd;
+    pfd.fd = _fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 30000) <= 0)
+      return false;
+
+    auto count = recv(_fd, chunk, sizeof(chunk), 0);
+    if (count <= 0)
+      return false;
+    _buffer.append(chunk, static_cast<size_t>(count));
+  }
+
+  std::istringstream stream(_buffer.substr(0, headerEnd));
+  _buffer.erase(0, headerEnd + 4);
+
+  // Request line, such as "GET /1.0/models?page=2 HTTP/1.1"
+  std::string line;
+  std::getline(stream, line);
+  std::istringstream requestLine(line);
+  std::string target;
+  requestLine >> _request.method >> target;
+  if (_request.method.empty() || target.empty())
+    return false;
+
+  auto queryPos = target.find('?');
+  if (queryPos != std::string::npos)
+  {
+    _request.query = target.substr(queryPos + 1);
+    target.erase(queryPos);
+  }
+  _request.path = percentDecode(target, false);
+
+  for (const auto &param : common::Split(_request.query, '&'))
+  {
+    auto eq = param.find('=');
+    if (eq == std::string::npos)
+    {
+      _request.params[percentDecode(param, true)] = "";
+    }
+    else
+    {
+      _request.params[percentDecode(param.substr(0, eq), true)] =
+          percentDecode(param.substr(eq + 1), true);
+    }
+  }
+
+  while (std::getline(stream, line))
+  {
+    auto colon = line.find(':');
+    if (colon == std::string::npos)
+      continue;
+    _request.headers[common::lowercase(common::trimmed(line.substr(0, colon)))]
+        = common::trimmed(line.substr(colon + 1));
+  }
+
+  // Body
+  auto length = _request.headers.find("content-length");
+  if (length != _request.headers.end())
+  {
+    size_t size{0};
+    try
+    {
+      size = std::stoul(length->second);
+    }
+    catch(const std::out_of_range &)
+    {
+      _error = 413;
+      return false;
+    }
+    catch(...)
+    {
+      _error = 400;
+      return false;
+    }
+
+    // The body is buffered in memory, don't let clients choose its size.
+    if (size > this->maxBodySize)
+    {
+      _error = 413;
+      return false;
+    }
+
+    while (_buffer.size() < size)
+    {
+      struct pollfd pfd;
+      pfd.fd = _fd;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, 30000) <= 0)
+        return false;
+
+      auto count = recv(_fd, chunk, sizeof(chunk), 0);
+      if (count <= 0)
+        return false;
+      _buffer.append(chunk, static_cast<size_t>(count));
+    }
+    _request.body = _buffer.substr(0, size);
+    _buffer.erase(0, size);
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Send a whole buffer.
+/// \param[in] _fd Socket.
+/// \param[in] _data Data to send.
+/// \param[in] _size Number of bytes to send.
+/// \return True if everything was sent.
+static bool sendAll(int _fd, const char *_data, size_t _size)
+{
+  while (_size > 0)
+  {
+    auto count = send(_fd, _data, _size, MSG_NOSIGNAL);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      return false;
+    _data += count;
+    _size -= static_cast<size_t>(count);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool HttpServerPrivate::WriteResponse(int _fd, const HttpRequest &_request,
+    const HttpResponse &_response, bool _keepAlive)
+{
+  std::ifstream file;
+  uint64_t length = _response.body.size();
+  if (!_response.file.empty())
+  {
+    file.open(_response.file, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+      HttpResponse notFound;
+      notFound.status = 404;
+      return this->WriteResponse(_fd, _request, notFound, _keepAlive);
+    }
+    length = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+  }
+
+  std::ostringstream header;
+  header << "HTTP/1.1 " << _response.status << " "
+         << statusReason(_response.status) << "\r\n";
+  for (const auto &field : _response.headers)
+    header << field.first << ": " << field.second << "\r\n";
+  header << "Content-Length: " << length << "\r\n"
+         << "Connection: " << (_keepAlive ? "keep-alive" : "close")
+         << "\r\n\r\n";
+
+  std::string headerStr = header.str();
+  if (!sendAll(_fd, headerStr.data(), headerStr.size()))
+    return false;
+
+  if (_request.method == "HEAD")
+    return true;
+
+  if (_response.file.empty())
+    return sendAll(_fd, _response.body.data(), _response.body.size());
+
+  std::vector<char> buffer(256 * 1024);
+  while (file)
+  {
+    file.read(buffer.data(), buffer.size());
+    if (file.gcount() > 0 &&
+        !sendAll(_fd, buffer.data(), static_cast<size_t>(file.gcount())))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
+//////////////////////////////////////////////////
+bool HttpServer::Running() const
+{
+  return this->dataPtr->running;
+}
+
+//////////////////////////////////////////////////
+uint16_t HttpServer::Port() const
+{
+  return this->dataPtr->port;
+}
+
+//////////////////////////////////////////////////
+std::string HttpServer::Url() const
+{
+  if (this->dataPtr->port == 0)
+    return "";
+  return "http://" + this->dataPtr->host + ":" +
+      std::to_string(this->dataPtr->port);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_FUEL_TOOLS_HTTPSERVER_HH_
+#define IGNITION_FUEL_TOOLS_HTTPSERVER_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "ignition/fuel_tools/Export.hh"
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class HttpServerPrivate;
+
+    /// \brief A request received by HttpServer.
+    struct IGNITION_FUEL_TOOLS_VISIBLE HttpRequest
+    {
+      /// \brief HTTP method, such as "GET".
+      public: std::string method;
+
+      /// \brief Percent-decoded path, without the query string.
+      /// E.g.: "/1.0/openrobotics/models"
+      public: std::string path;
+
+      /// \brief Raw query string, without the leading '?'. E.g.: "page=2"
+      public: std::string query;
+
+      /// \brief Decoded query parameters.
+      public: std::map<std::string, std::string> params;
+
+      /// \brief Request headers. Keys are lowercase.
+      public: std::map<std::string, std::string> headers;
+
+      /// \brief Request body.
+      public: std::string body;
+    };
+
+    /// \brief A response to be sent by HttpServer.
+    struct IGNITION_FUEL_TOOLS_VISIBLE HttpResponse
+    {
+      /// \brief Status code. E.g.: 200
+      public: int status = 200;
+
+      /// \brief Response headers. Content-Length and Connection are added
+      /// by the server.
+      public: std::map<std::string, std::string> headers;
+
+      /// \brief Response body, used if file is empty.
+      public: std::string body;
+
+      /// \brief Path to a file whose content is sent as the body, without
+      /// loading it in memory.
+      public: std::string file;
+    };
+
+    /// \brief A small multi-threaded HTTP/1.1 server, listening on a TCP
+    /// port or a Unix domain socket. It's used to serve Fuel routes from the
+    /// local machine, such as by 'ign fuel serve-cache'. Each connection is
+    /// handled by its own thread and may be kept alive for several requests.
+    /// Connections beyond MaxConnections() are answered with 503, and
+    /// request bodies larger than MaxBodySize() with 413.
+    /// Only available on POSIX systems.
+    class IGNITION_FUEL_TOOLS_VISIBLE HttpServer
+    {
+      /// \brief Function called for each request. It's called concurrently
+      /// from several threads.
+      public: using Handler =
+          std::function<void(const HttpRequest &, HttpResponse &)>;
+
+      /// \brief Constructor.
+      /// \param[in] _handler Function handling the requests.
+      public: explicit HttpServer(const Handler &_handler);
+
+      /// \brief Destructor. Stops the server.
+      public: ~HttpServer();
+
+      /// \brief Set the largest request body accepted. Defaults to 1 MiB.
+      /// \param[in] _size Size in bytes.
+      public: void SetMaxBodySize(size_t _size);
+
+      /// \brief Get the largest request body accepted.
+      /// \return Size in bytes.
+      public: size_t MaxBodySize() const;
+
+      /// \brief Set how many connections may be open at once, each of them
+      /// being served by its own thread. Defaults to 256.
+      /// \param[in] _count Number of connections, at least 1.
+      public: void SetMaxConnections(size_t _count);
+
+      /// \brief Get how many connections may be open at once.
+      /// \return Number of connections.
+      public: size_t MaxConnections() const;
+
+      /// \brief Start listening on a TCP port.
+      /// \param[in] _host Address to bind to. E.g.: "127.0.0.1"
+      /// \param[in] _port Port to bind to. Use 0 for any free port, which
+      /// can then be read with Port().
+      /// \return True if the server started.
+      public: bool Start(const std::string &_host, uint16_t _port);
+
+      /// \brief Start listening on a Unix domain socket. An existing socket
+      /// file at the same path is replaced.
+      /// \param[in] _path Path to the socket file.
+      /// \return True if the server started.
+      public: bool StartUnix(const std::string &_path);
+
+      /// \brief Stop the server, closing every connection and waiting for
+      /// pending requests to finish.
+      public: void Stop();
+
+      /// \brief Whether the server is running.
+      /// \return True if running.
+      public: bool Running() const;
+
+      /// \brief Port the server is listening on.
+      /// \return Port number, or 0 if not listening on TCP.
+      public: uint16_t Port() const;
+
+      /// \brief Base URL of the server. E.g.: "http://127.0.0.1:8000"
+      /// \return URL, or empty if not listening on TCP.
+      public: std::string Url() const;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<HttpServerPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+  #include <arpa/inet.h>
+  #include <netinet/in.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/RestClient.hh"
+
+#include "HttpServer.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+#ifndef _WIN32
+/// \brief Open a connection to a local server.
+/// \param[in] _port Server port.
+/// \return Socket, or -1 on failure.
+static int connectTo(uint16_t _port)
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(_port);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr),
+        sizeof(addr)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/////////////////////////////////////////////////
+/// \brief Send raw data on a socket and read the status line of the answer.
+/// \param[in] _fd Socket.
+/// \param[in] _data Data to send.
+/// \return Status line, such as "HTTP/1.1 200 OK".
+static std::string exchange(int _fd, const std::string &_data)
+{
+  if (send(_fd, _data.data(), _data.size(), 0) < 0)
+    return "";
+
+  std::string answer;
+  char chunk[1024];
+  ssize_t count;
+  while (answer.find("\r\n") == std::string::npos &&
+      (count = recv(_fd, chunk, sizeof(chunk), 0)) > 0)
+  {
+    answer.append(chunk, static_cast<size_t>(count));
+  }
+  return answer.substr(0, answer.find("\r\n"));
+}
+
+/////////////////////////////////////////////////
+TEST(HttpServer, Request)
+{
+  HttpServer server([](const HttpRequest &_request, HttpResponse &_response)
+  {
+    if (_request.path == "/missing")
+    {
+      _response.status = 404;
+      return;
+    }
+
+    auto header = _request.headers.find("private-token");
+    _response.headers["Content-Type"] = "text/plain";
+    _response.body = _request.method + " " + _request.path + " " +
+        (_request.params.count("page") ? _request.params.at("page") : "") +
+        " " + (header != _request.headers.end() ? header->second : "");
+  });
+
+  EXPECT_FALSE(server.Running());
+  EXPECT_EQ(0u, server.Port());
+  EXPECT_TRUE(server.Url().empty());
+
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+  EXPECT_TRUE(server.Running());
+  EXPECT_NE(0u, server.Port());
+  EXPECT_EQ("http://127.0.0.1:" + std::to_string(server.Port()),
+      server.Url());
+
+  Rest rest;
+  auto resp = rest.Request(HttpMethod::GET, server.Url(), "1.0",
+      "alice/models", {"page=2"}, {"Private-Token: secret"}, "");
+  EXPECT_EQ(200, resp.statusCode);
+  EXPECT_EQ("GET /1.0/alice/models 2 secret", resp.data);
+
+  resp = rest.Request(HttpMethod::GET, server.Url(), "", "missing", {}, {},
+      "");
+  EXPECT_EQ(404, resp.statusCode);
+
+  std::string url = server.Url();
+  server.Stop();
+  EXPECT_FALSE(server.Running());
+  EXPECT_TRUE(server.Url().empty());
+
+  resp = rest.Request(HttpMethod::GET, url, "", "missing", {}, {}, "");
+  EXPECT_EQ(0, resp.statusCode);
+}
+
+/////////////////////////////////////////////////
+TEST(HttpServer, File)
+{
+  std::string path = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_http_server_file.txt");
+  {
+    std::ofstream out(path);
+    out << std::string(100000, 'x');
+  }
+
+  HttpServer server([&](const HttpRequest &, HttpResponse &_response)
+  {
+    _response.file = path;
+  });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  Rest rest;
+  auto resp = rest.Request(HttpMethod::GET, server.Url(), "", "file", {}, {},
+      "");
+  EXPECT_EQ(200, resp.statusCode);
+  EXPECT_EQ(std::string(100000, 'x'), resp.data);
+
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+TEST(HttpServer, Limits)
+{
+  HttpServer server([](const HttpRequest &_request, HttpResponse &_response)
+  {
+    _response.body = _request.body;
+  });
+  EXPECT_EQ(1024u * 1024u, server.MaxBodySize());
+  EXPECT_EQ(256u, server.MaxConnections());
+  server.SetMaxBodySize(10);
+  server.SetMaxConnections(1);
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  // Bodies up to the limit are accepted.
+  int fd = connectTo(server.Port());
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ("HTTP/1.1 200 OK", exchange(fd,
+      "POST / HTTP/1.1\r\nContent-Length: 10\r\n\r\n0123456789"));
+
+  // While that connection is open, others are turned down.
+  int other = connectTo(server.Port());
+  ASSERT_GE(other, 0);
+  EXPECT_EQ("HTTP/1.1 503 Service Unavailable",
+      exchange(other, "GET / HTTP/1.1\r\n\r\n"));
+  close(other);
+
+  // Larger bodies aren't read.
+  EXPECT_EQ("HTTP/1.1 413 Payload Too Large", exchange(fd,
+      "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n"));
+  close(fd);
+
+  server.Stop();
+}
+#endif
@@ -15,7 +15,15 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "ignition/common/Console.hh"
+#include "ignition/fuel_tools/ClientConfig.hh"
 #include "ignition/fuel_tools/Interface.hh"
 #include "ignition/fuel_tools/WorldIdentifier.hh"
 
@@ -23,11 +31,102 @@ namespace ignition
 {
   namespace fuel_tools
   {
+    /// \brief Maximum number of resources downloaded at the same time by
+    /// fetchResources.
+    static const unsigned int kFetchJobs = 8;
+
+    //////////////////////////////////////////////
+    /// \brief Get the client shared by fetchResource and fetchResources.
+    /// It's created on first use, which is thread-safe, so that the
+    /// configuration is only loaded once per process.
+    /// \return The process-wide client.
+    static FuelClient &defaultClient()
+    {
+      static FuelClient client;
+      return client;
+    }
+
     //////////////////////////////////////////////
     std::string fetchResource(const std::string &_uri)
     {
-      ignition::fuel_tools::FuelClient client;
-      return fetchResourceWithClient(_uri, client);
+      return fetchResourceWithClient(_uri, defaultClient());
+    }
+
+    //////////////////////////////////////////////
+    std::vector<std::string> fetchResources(
+        const std::vector<std::string> &_uris)
+    {
+      return fetchResourcesWithClient(_uris, defaultClient());
+    }
+
+    //////////////////////////////////////////////
+    std::vector<std::string> fetchResourcesWithClient(
+        const std::vector<std::string> &_uris,
+        ignition::fuel_tools::FuelClient &_client)
+    {
+      std::vector<std::string> result(_uris.size());
+
+      // Group the URIs by model or world, so each resource is handled by a
+      // single thread and downloaded only once. The other URIs of the same
+      // resource are then found in the cache.
+      std::map<std::string, std::vector<size_t>> groups;
+      for (size_t i = 0; i < _uris.size(); ++i)
+      {
+        ignition::common::URI uri(_uris[i]);
+        ModelIdentifier model;
+        WorldIdentifier world;
+        std::string fileUrl;
+        if (_client.ParseModelUrl(uri, model) ||
+            _client.ParseModelFileUrl(uri, model, fileUrl))
+        {
+          groups[model.UniqueName()].push_back(i);
+        }
+        else if (_client.ParseWorldUrl(uri, world) ||
+            _client.ParseWorldFileUrl(uri, world, fileUrl))
+        {
+          groups[world.UniqueName()].push_back(i);
+        }
+        else
+        {
+          ignwarn << "Unable to fetch [" << _uris[i]
+                  << "], it isn't a model or world URI." << std::endl;
+        }
+      }
+
+      std::vector<const std::vector<size_t> *> work;
+      for (const auto &group : groups)
+        work.push_back(&group.second);
+
+      std::atomic<size_t> next{0};
+      auto worker = [&]()
+      {
+        for (size_t w = next++; w < work.size(); w = next++)
+        {
+          // Identical URIs are only resolved once.
+          std::map<std::string, std::string> resolved;
+          for (auto i : *work[w])
+          {
+            auto it = resolved.find(_uris[i]);
+            if (it == resolved.end())
+            {
+              it = resolved.emplace(_uris[i],
+                  fetchResourceWithClient(_uris[i], _client)).first;
+            }
+            result[i] = it->second;
+          }
+        }
+      };
+
+      std::vector<std::thread> threads;
+      unsigned int jobs = static_cast<unsigned int>(
+          std::min<size_t>(kFetchJobs, work.size()));
+      for (unsigned int i = 1; i < jobs; ++i)
+        threads.emplace_back(worker);
+      worker();
+      for (auto &thread : threads)
+        thread.join();
+
+      return result;
     }
 
     //////////////////////////////////////////////
@@ -50,6 +149,14 @@ namespace ignition
       else if (_client.ParseModelFileUrl(uri, model, fileUrl) &&
           !_client.CachedModelFile(uri, result))
       {
+        // Only fetch the requested file, if allowed. Otherwise, or if that
+        // fails, download the whole model.
+        if (_client.Config().LazyFileFetch() &&
+            _client.DownloadModelFile(uri, result))
+        {
+          return result;
+        }
+
         auto modelUri = _uri.substr(0,
             _uri.find("files", model.UniqueName().size())-1);
         _client.DownloadModel(common::URI(modelUri), result);
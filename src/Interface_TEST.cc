@@ -251,3 +251,92 @@ TEST(Interface, FetchResources)
      }
   }
 }
+
+/////////////////////////////////////////////////
+TEST(Interface, FetchResourcesBatch)
+{
+  common::Console::SetVerbosity(4);
+
+  // Configure to use binary path as cache
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig config;
+  config.SetCacheLocation(common::cwd() + "/test_cache");
+  FuelClient client(config);
+
+  std::vector<std::string> uris{
+    "https://fuel.ignitionrobotics.org/1.0/openrobotics/models/Bus/1/files"
+      "/meshes/bus.obj",
+    "https://fuel.ignitionrobotics.org/1.0/nate/worlds/Empty",
+    "https://fuel.ignitionrobotics.org/1.0/openrobotics/models/Bus/1/",
+    "https://fuel.ignitionrobotics.org/1.0/nate/worlds/Empty",
+    "not a resource"};
+
+  auto paths = fetchResourcesWithClient(uris, client);
+  ASSERT_EQ(uris.size(), paths.size());
+
+  EXPECT_EQ(common::cwd() +
+      "/test_cache/fuel.ignitionrobotics.org/openrobotics/models/Bus/1/"
+      "meshes/bus.obj", paths[0]);
+  EXPECT_EQ(common::cwd() +
+      "/test_cache/fuel.ignitionrobotics.org/nate/worlds/Empty/1", paths[1]);
+  EXPECT_EQ(common::cwd() +
+      "/test_cache/fuel.ignitionrobotics.org/openrobotics/models/Bus/1",
+      paths[2]);
+  EXPECT_EQ(paths[1], paths[3]);
+  EXPECT_TRUE(paths[4].empty());
+
+  EXPECT_TRUE(common::exists(paths[0]));
+  EXPECT_TRUE(common::exists(paths[1]));
+
+  // Empty batch
+  EXPECT_TRUE(fetchResourcesWithClient({}, client).empty());
+}
+
+/////////////////////////////////////////////////
+TEST(Interface, FetchResourcesLazyFile)
+{
+  common::Console::SetVerbosity(4);
+
+  // Configure to use binary path as cache
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig config;
+  config.SetCacheLocation(common::cwd() + "/test_cache");
+  config.SetLazyFileFetch(true);
+  FuelClient client(config);
+
+  common::URI modelUrl{
+    "https://fuel.ignitionrobotics.org/1.0/openrobotics/models/Bus/1/"};
+  common::URI modelFileUrl{
+    "https://fuel.ignitionrobotics.org/1.0/openrobotics/models/Bus/1/files"
+    "/meshes/bus.obj"};
+
+  // Only the file is downloaded
+  std::string path = fetchResourceWithClient(modelFileUrl.Str(), client);
+  EXPECT_EQ(path, common::cwd() +
+      "/test_cache/fuel.ignitionrobotics.org/openrobotics/models/Bus/1/"
+      "meshes/bus.obj");
+  EXPECT_TRUE(common::exists(path));
+  EXPECT_FALSE(common::exists(
+      "test_cache/fuel.ignitionrobotics.org/openrobotics/models/Bus/1/"
+      "model.sdf"));
+
+  // The file is cached, but not the model
+  std::string cachedPath;
+  EXPECT_EQ(Result(ResultType::FETCH_ALREADY_EXISTS),
+      client.CachedModelFile(modelFileUrl, cachedPath));
+  EXPECT_EQ(path, cachedPath);
+  EXPECT_FALSE(client.CachedModel(modelUrl));
+
+  // Fetching the model completes it
+  path = fetchResourceWithClient(modelUrl.Str(), client);
+  EXPECT_EQ(path, common::cwd() +
+      "/test_cache/fuel.ignitionrobotics.org/openrobotics/models/Bus/1");
+  EXPECT_TRUE(common::exists(
+      "test_cache/fuel.ignitionrobotics.org/openrobotics/models/Bus/1/"
+      "model.sdf"));
+  EXPECT_TRUE(client.CachedModel(modelUrl));
+}
@@ -16,12 +16,16 @@
 */
 
 #include <json/json.h>
+#include <ctime>
+#include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <ignition/common/Console.hh>
 
 #include "ignition/fuel_tools/ClientConfig.hh"
 #include "ignition/fuel_tools/JSONParser.hh"
+#include "ignition/fuel_tools/Trace.hh"
 
 using namespace ignition;
 using namespace fuel_tools;
@@ -90,6 +94,8 @@ std::vector<std::string> JSONParser::ParseTags(const Json::Value &_json)
 ModelIdentifier JSONParser::ParseModel(const std::string &_json,
   const ServerConfig &_server)
 {
+  TraceSpan span("JSONParser::ParseModel", "json");
+
   Json::CharReaderBuilder reader;
   Json::Value model;
   ModelIdentifier id;
@@ -109,6 +115,8 @@ ModelIdentifier JSONParser::ParseModel(const std::string &_json,
 std::vector<ModelIdentifier> JSONParser::ParseModels(const std::string &_json,
   const ServerConfig &_server)
 {
+  TraceSpan span("JSONParser::ParseModels", "json");
+
   std::vector<ModelIdentifier> ids;
   Json::CharReaderBuilder reader;
   Json::Value models;
@@ -211,10 +219,77 @@ std::string JSONParser::BuildModel(ModelIter _modelIt)
   return Json::writeString(builder, value);
 }
 
+/////////////////////////////////////////////////
+/// \brief Format a date as the server does.
+/// \param[in] _time Time to format.
+/// \return Date, such as "2020-01-31T12:00:00Z".
+static std::string FormatDateTime(const std::time_t &_time)
+{
+  std::tm tm;
+#ifdef _WIN32
+  gmtime_s(&tm, &_time);
+#else
+  gmtime_r(&_time, &tm);
+#endif
+  char buffer[32];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+  return buffer;
+}
+
+/////////////////////////////////////////////////
+std::string JSONParser::BuildModels(const std::vector<ModelIdentifier> &_ids)
+{
+  Json::Value models(Json::arrayValue);
+  for (const auto &id : _ids)
+  {
+    Json::Value value;
+    value["name"] = id.Name();
+    value["owner"] = id.Owner();
+    value["createdAt"] = FormatDateTime(id.UploadDate());
+    value["updatedAt"] = FormatDateTime(id.ModifyDate());
+    value["description"] = id.Description();
+    value["likes"] = id.LikeCount();
+    value["downloads"] = id.DownloadCount();
+    value["filesize"] = id.FileSize();
+    value["license_name"] = id.LicenseName();
+    value["license_url"] = id.LicenseUrl();
+    value["license_image"] = id.LicenseImageUrl();
+    value["version"] = id.Version();
+    value["tags"] = Json::Value(Json::arrayValue);
+    for (const auto &tag : id.Tags())
+      value["tags"].append(tag);
+    models.append(value);
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, models);
+}
+
+/////////////////////////////////////////////////
+std::string JSONParser::BuildWorlds(const std::vector<WorldIdentifier> &_ids)
+{
+  Json::Value worlds(Json::arrayValue);
+  for (const auto &id : _ids)
+  {
+    Json::Value value;
+    value["name"] = id.Name();
+    value["owner"] = id.Owner();
+    value["version"] = id.Version();
+    worlds.append(value);
+  }
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, worlds);
+}
+
 /////////////////////////////////////////////////
 WorldIdentifier JSONParser::ParseWorld(const std::string &_json,
   const ServerConfig &_server)
 {
+  TraceSpan span("JSONParser::ParseWorld", "json");
+
   Json::CharReaderBuilder reader;
   Json::Value world;
   WorldIdentifier id;
@@ -234,6 +309,8 @@ WorldIdentifier JSONParser::ParseWorld(const std::string &_json,
 std::vector<WorldIdentifier> JSONParser::ParseWorlds(const std::string &_json,
   const ServerConfig &_server)
 {
+  TraceSpan span("JSONParser::ParseWorlds", "json");
+
   std::vector<WorldIdentifier> ids;
   Json::CharReaderBuilder reader;
   Json::Value worlds;
@@ -313,3 +390,59 @@ std::string JSONParser::BuildWorld(WorldIter _worldIt)
   Json::StreamWriterBuilder builder;
   return Json::writeString(builder, value);
 }
+
+/////////////////////////////////////////////////
+/// \brief Recursively collect the files of a file tree.
+/// \param[in] _nodes Array of file tree nodes.
+/// \param[out] _files Hash of each file, by path.
+/// \return False if a node is malformed.
+static bool parseFileTreeNodes(const Json::Value &_nodes,
+    std::map<std::string, std::string> &_files)
+{
+  if (!_nodes.isArray())
+    return false;
+
+  for (const auto &node : _nodes)
+  {
+    if (!node.isObject() || !node["path"].isString())
+      return false;
+
+    if (node.isMember("children"))
+    {
+      if (!parseFileTreeNodes(node["children"], _files))
+        return false;
+      continue;
+    }
+
+    std::string path = node["path"].asString();
+    while (!path.empty() && path[0] == '/')
+      path = path.substr(1);
+    if (path.empty())
+      return false;
+
+    _files[path] = node["hash"].isString() ? node["hash"].asString() : "";
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool JSONParser::ParseFileTree(const std::string &_json,
+    std::map<std::string, std::string> &_files)
+{
+  TraceSpan span("JSONParser::ParseFileTree", "json");
+
+  Json::CharReaderBuilder reader;
+  Json::Value root;
+  std::istringstream iss(_json);
+  JSONCPP_STRING errs;
+
+  _files.clear();
+  if (!Json::parseFromStream(reader, iss, &root, &errs) ||
+      !root.isObject() || !parseFileTreeNodes(root["file_tree"], _files))
+  {
+    ignerr << "Unable to parse file tree\n";
+    _files.clear();
+    return false;
+  }
+  return true;
+}
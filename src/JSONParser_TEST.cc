@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include <ctime>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -170,6 +171,30 @@ TEST(JSONParser, ParseWorld)
   EXPECT_EQ("banana://testServer", world.Server().Url().Str());
 }
 
+/////////////////////////////////////////////////
+/// \brief Parse the file tree of a resource version
+TEST(JSONParser, ParseFileTree)
+{
+  std::stringstream tmpJsonStr;
+  tmpJsonStr << "{\"name\": \"car\", \"file_tree\": ["
+    << "{\"name\": \"model.sdf\", \"path\": \"/model.sdf\","
+    << " \"hash\": \"abc\"},"
+    << "{\"name\": \"meshes\", \"path\": \"/meshes\", \"children\": ["
+    << "{\"name\": \"car.dae\", \"path\": \"/meshes/car.dae\"}]}]}";
+
+  std::map<std::string, std::string> files;
+  ASSERT_TRUE(JSONParser::ParseFileTree(tmpJsonStr.str(), files));
+  ASSERT_EQ(2u, files.size());
+  EXPECT_EQ("abc", files["model.sdf"]);
+  ASSERT_NE(files.end(), files.find("meshes/car.dae"));
+  EXPECT_TRUE(files["meshes/car.dae"].empty());
+
+  EXPECT_FALSE(JSONParser::ParseFileTree("[]", files));
+  EXPECT_TRUE(files.empty());
+  EXPECT_FALSE(JSONParser::ParseFileTree(
+      "{\"file_tree\": [{\"name\": \"a\"}]}", files));
+}
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
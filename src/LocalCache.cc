@@ -19,30 +19,68 @@
   #include <unistd.h>
 #endif
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include <stdio.h>
 #include <tinyxml2.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <regex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
 #include <ignition/common/StringUtils.hh>
 #include <ignition/common/Util.hh>
 
+#include "ignition/fuel_tools/CatalogSnapshot.hh"
 #include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/DownloadOptions.hh"
+#include "ignition/fuel_tools/JSONParser.hh"
 #include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/Lockfile.hh"
+#include "ignition/fuel_tools/Metrics.hh"
 #include "ignition/fuel_tools/ModelIterPrivate.hh"
 #include "ignition/fuel_tools/ModelPrivate.hh"
+#include "ignition/fuel_tools/SearchIndex.hh"
+#include "ignition/fuel_tools/Trace.hh"
 #include "ignition/fuel_tools/Zip.hh"
 #include "ignition/fuel_tools/WorldIterPrivate.hh"
 
+#include "CacheWatcher.hh"
+#include "HotCache.hh"
+
 using namespace ignition;
 using namespace fuel_tools;
 
+/// \brief Name of the file which marks a versioned directory holding only
+/// some of the files of a model.
+static const char kPartialMarker[] = ".partial";
+
+/// \brief File in a versioned directory holding the hash of the archive it
+/// was extracted from.
+static const char kArchiveHashFile[] = ".archive_hash";
+
+/// \brief File in a versioned directory saved with SaveModelDelta holding
+/// a hash which identifies its content, since there's no archive to hash.
+static const char kTreeHashFile[] = ".tree_hash";
+
+/// \brief Name of the file holding the server's file tree of a model
+/// version, used to find the files which changed in later versions.
+static const char kFileTreeFile[] = ".file_tree";
+
 class ignition::fuel_tools::LocalCachePrivate
 {
   /// \brief return all models in a given directory
@@ -86,8 +124,324 @@ class ignition::fuel_tools::LocalCachePrivate
   public: void FixPathsInUri(tinyxml2::XMLElement *_elem,
               const std::string &_modelVersionedDir);
 
+  /// \brief Get the search index of a server's models, building it from
+  /// the cached models and the saved listings the first time.
+  /// indexMutex must be locked.
+  /// \param[in] _server Server of the models.
+  /// \return The index.
+  public: SearchIndex &ModelIndex(const ServerConfig &_server);
+
+  /// \brief Get the hot tier, created on first use. Creating it starts
+  /// watching the cache directory, so copies of versions changed by other
+  /// processes are retired.
+  /// \return The hot tier, or null if there's none configured.
+  public: HotCache *Tiers();
+
+  /// \brief Get the copy in the hot tier of a version, without looking
+  /// through the cache directory, counting a lookup if there's one.
+  /// \param[in] _url URL of the version's server.
+  /// \param[in] _relativeDir Versioned directory, relative to the
+  /// directory of its server in the cache directory.
+  /// \param[out] _server Configuration of the server.
+  /// \return The copy, or empty if there's no copy known to be up to date.
+  public: std::string HotCopy(const std::string &_url,
+      const std::string &_relativeDir, ServerConfig &_server);
+
+  /// \brief Start watching the cache directory, if not watching already.
+  /// eventMutex must be locked.
+  public: void Watch();
+
+  /// \brief Count a lookup of a versioned directory, and get the fastest
+  /// copy of it.
+  /// \param[in] _path Versioned directory in the cache directory.
+  /// \return The copy in the hot tier, if any, otherwise _path.
+  public: std::string Resolve(const std::string &_path);
+
+  /// \brief Same as Resolve, for a model.
+  /// \param[in] _model Model found in the cache directory.
+  /// \return The model, located in the fastest tier holding it.
+  public: Model Resolve(const Model &_model);
+
+  /// \brief Remove the copy in the hot tier of a version which was
+  /// updated or removed.
+  /// \param[in] _event The change.
+  public: void Invalidate(const CacheEvent &_event);
+
+  /// \brief Report a change made through this cache to the subscribers.
+  /// \param[in] _type Kind of change.
+  /// \param[in] _entry Version which changed.
+  public: void Notify(CacheEventType _type, const CacheEntry &_entry);
+
+  /// \brief Report a change noticed by the watcher to the subscribers,
+  /// unless it was made through this cache.
+  /// \param[in] _event The change.
+  public: void NotifyExternal(const CacheEvent &_event);
+
+  /// \brief Mark a versioned directory as being changed through this
+  /// cache, or as done changing, so the watcher doesn't report the change
+  /// again.
+  /// \param[in] _path Versioned directory.
+  /// \param[in] _busy True when the change starts, false once it's done.
+  public: void MarkOwnChange(const std::string &_path, bool _busy);
+
   /// \brief client configuration
   public: const ClientConfig *config = nullptr;
+
+  /// \brief Protects the subscribers and the changes made through this
+  /// cache.
+  public: std::mutex eventMutex;
+
+  /// \brief Subscribers, by id.
+  public: std::map<uint64_t, LocalCache::EventCallback> subscribers;
+
+  /// \brief Id of the next subscription.
+  public: uint64_t nextSubscriber = 1;
+
+  /// \brief Versioned directories changed through this cache, with the
+  /// time until which the watcher's events about them are ignored.
+  public: std::map<std::string, std::chrono::steady_clock::time_point>
+      ownChanges;
+
+  /// \brief Protects the search indexes.
+  public: std::mutex indexMutex;
+
+  /// \brief Search indexes, by server URL.
+  public: std::map<std::string, SearchIndex> indexes;
+
+  /// \brief Protects the hot tier while it's created.
+  public: std::mutex tierMutex;
+
+  /// \brief Hot tier, if configured.
+  public: std::unique_ptr<HotCache> hotCache;
+
+  /// \brief Absolute path of the cache directory, as given to the hot
+  /// tier.
+  public: std::string tierRoot;
+
+  /// \brief Watches the cache directory once there are subscribers or a
+  /// hot tier.
+  /// Declared last, so its thread stops before the rest is destroyed.
+  public: std::unique_ptr<CacheWatcher> watcher;
+};
+
+/// \brief How long the watcher's events about a versioned directory are
+/// ignored after it was changed through this cache.
+static const std::chrono::seconds kOwnChangeGrace{2};
+
+//////////////////////////////////////////////////
+/// \brief Describe a versioned directory of the cache.
+/// \param[in] _server Server directory.
+/// \param[in] _owner Owner name.
+/// \param[in] _type "models" or "worlds".
+/// \param[in] _name Resource name.
+/// \param[in] _version Resource version.
+/// \param[in] _path Versioned directory.
+/// \return The entry.
+static CacheEntry cacheEntry(const std::string &_server,
+    const std::string &_owner, const std::string &_type,
+    const std::string &_name, unsigned int _version, const std::string &_path)
+{
+  CacheEntry entry;
+  entry.server = _server;
+  entry.owner = _owner;
+  entry.type = _type;
+  entry.name = _name;
+  entry.version = _version;
+  entry.path = _path;
+  return entry;
+}
+
+//////////////////////////////////////////////////
+HotCache *LocalCachePrivate::Tiers()
+{
+  HotCache *tiers;
+  bool created = false;
+  {
+    std::lock_guard<std::mutex> lock(this->tierMutex);
+    if (!this->hotCache && this->config &&
+        !this->config->HotCacheLocation().empty())
+    {
+      this->tierRoot = common::absPath(this->config->CacheLocation());
+      this->hotCache.reset(new HotCache(this->tierRoot,
+          this->config->HotCacheLocation(),
+          this->config->HotCacheCapacity(),
+          this->config->HotCachePromotion()));
+      created = true;
+    }
+    tiers = this->hotCache.get();
+  }
+
+  // Copies are handed out without checking the cache directory, so other
+  // processes' changes must be noticed.
+  if (created)
+  {
+    std::lock_guard<std::mutex> lock(this->eventMutex);
+    this->Watch();
+  }
+  return tiers;
+}
+
+//////////////////////////////////////////////////
+std::string LocalCachePrivate::HotCopy(const std::string &_url,
+    const std::string &_relativeDir, ServerConfig &_server)
+{
+  if (!this->config)
+    return "";
+
+  auto *tiers = this->Tiers();
+  if (!tiers)
+    return "";
+
+  for (const auto &server : this->config->Servers())
+  {
+    if (server.Url().Str() != _url)
+      continue;
+
+    _server = server;
+    return tiers->ResolveHot(common::joinPaths(this->tierRoot,
+        server.Url().Path().Str(), _relativeDir));
+  }
+  return "";
+}
+
+//////////////////////////////////////////////////
+void LocalCachePrivate::Watch()
+{
+  if (this->watcher || !this->config)
+    return;
+
+  this->watcher.reset(new CacheWatcher(this->config->CacheLocation(),
+      [this](const CacheEvent &_event)
+      {
+        this->NotifyExternal(_event);
+      }));
+}
+
+//////////////////////////////////////////////////
+std::string LocalCachePrivate::Resolve(const std::string &_path)
+{
+  auto *tiers = this->Tiers();
+  return tiers ? tiers->Resolve(_path) : _path;
+}
+
+//////////////////////////////////////////////////
+Model LocalCachePrivate::Resolve(const Model &_model)
+{
+  if (!_model)
+    return _model;
+
+  std::string path = this->Resolve(_model.dataPtr->pathOnDisk);
+  if (path == _model.dataPtr->pathOnDisk)
+    return _model;
+
+  std::shared_ptr<ModelPrivate> modPriv(new ModelPrivate(*_model.dataPtr));
+  modPriv->pathOnDisk = path;
+  return Model(modPriv);
+}
+
+//////////////////////////////////////////////////
+void LocalCachePrivate::Invalidate(const CacheEvent &_event)
+{
+  if (_event.type == CacheEventType::INSTALLED)
+    return;
+
+  // Without a hot tier yet, there's nothing to invalidate. One created
+  // later checks the copies it finds.
+  HotCache *tiers;
+  {
+    std::lock_guard<std::mutex> lock(this->tierMutex);
+    tiers = this->hotCache.get();
+  }
+  if (tiers)
+    tiers->Invalidate(_event.entry.path);
+}
+
+//////////////////////////////////////////////////
+void LocalCachePrivate::Notify(CacheEventType _type,
+    const CacheEntry &_entry)
+{
+  CacheEvent event;
+  event.type = _type;
+  event.entry = _entry;
+  this->Invalidate(event);
+
+  std::vector<LocalCache::EventCallback> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(this->eventMutex);
+    for (const auto &subscriber : this->subscribers)
+      callbacks.push_back(subscriber.second);
+  }
+
+  for (const auto &callback : callbacks)
+    callback(event);
+}
+
+//////////////////////////////////////////////////
+void LocalCachePrivate::NotifyExternal(const CacheEvent &_event)
+{
+  std::vector<LocalCache::EventCallback> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(this->eventMutex);
+    auto own = this->ownChanges.find(_event.entry.path);
+    if (own != this->ownChanges.end() &&
+        own->second > std::chrono::steady_clock::now())
+    {
+      return;
+    }
+    this->Invalidate(_event);
+
+    for (const auto &subscriber : this->subscribers)
+      callbacks.push_back(subscriber.second);
+  }
+
+  for (const auto &callback : callbacks)
+    callback(_event);
+}
+
+//////////////////////////////////////////////////
+void LocalCachePrivate::MarkOwnChange(const std::string &_path, bool _busy)
+{
+  std::lock_guard<std::mutex> lock(this->eventMutex);
+  if (!this->watcher)
+    return;
+
+  auto now = std::chrono::steady_clock::now();
+  for (auto it = this->ownChanges.begin(); it != this->ownChanges.end();)
+  {
+    if (it->second <= now)
+      it = this->ownChanges.erase(it);
+    else
+      ++it;
+  }
+
+  this->ownChanges[_path] = _busy ?
+      std::chrono::steady_clock::time_point::max() : now + kOwnChangeGrace;
+}
+
+/// \brief Marks a versioned directory as being changed through the cache
+/// for the lifetime of the object.
+class OwnChange
+{
+  /// \brief Constructor.
+  /// \param[in] _cache Private data of the cache.
+  /// \param[in] _path Versioned directory.
+  public: OwnChange(LocalCachePrivate *_cache, const std::string &_path)
+    : cache(_cache), path(_path)
+  {
+    this->cache->MarkOwnChange(this->path, true);
+  }
+
+  /// \brief Destructor.
+  public: ~OwnChange()
+  {
+    this->cache->MarkOwnChange(this->path, false);
+  }
+
+  /// \brief Private data of the cache.
+  private: LocalCachePrivate *cache;
+
+  /// \brief Versioned directory.
+  private: std::string path;
 };
 
 //////////////////////////////////////////////////
@@ -131,7 +485,10 @@ std::vector<Model> LocalCachePrivate::ModelsInServer(
           continue;
         }
 
-        if (common::exists(common::joinPaths(*versionIter, "model.config")))
+        // Partial models may lack files, so they're only used through
+        // MatchingPartialModelFile.
+        if (common::exists(common::joinPaths(*versionIter, "model.config")) &&
+            !common::exists(common::joinPaths(*versionIter, kPartialMarker)))
         {
           std::shared_ptr<ModelPrivate> modPriv(new ModelPrivate);
           modPriv->id.SetName(common::basename(*modIter));
@@ -219,6 +576,47 @@ LocalCache::~LocalCache()
 {
 }
 
+//////////////////////////////////////////////////
+uint64_t LocalCache::Subscribe(const EventCallback &_callback)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->eventMutex);
+  uint64_t id = this->dataPtr->nextSubscriber++;
+  this->dataPtr->subscribers[id] = _callback;
+
+  // Other processes' changes are watched for as long as the cache lives.
+  this->dataPtr->Watch();
+  return id;
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::Unsubscribe(uint64_t _id)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->eventMutex);
+  return this->dataPtr->subscribers.erase(_id) > 0;
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::Watching() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->eventMutex);
+  return this->dataPtr->watcher && this->dataPtr->watcher->Active();
+}
+
+//////////////////////////////////////////////////
+CacheTierStats LocalCache::TierStats() const
+{
+  auto *tiers = this->dataPtr->Tiers();
+  return tiers ? tiers->Stats() : CacheTierStats();
+}
+
+//////////////////////////////////////////////////
+void LocalCache::WaitForTiers() const
+{
+  auto *tiers = this->dataPtr->Tiers();
+  if (tiers)
+    tiers->Wait();
+}
+
 //////////////////////////////////////////////////
 ModelIter LocalCache::AllModels()
 {
@@ -271,6 +669,65 @@ WorldIter LocalCache::AllWorlds() const
 //////////////////////////////////////////////////
 Model LocalCache::MatchingModel(const ModelIdentifier &_id)
 {
+  // A version with a copy in the hot tier is served without looking
+  // through the cache directory.
+  if (_id.Version() != 0 && !_id.Owner().empty() && !_id.Name().empty())
+  {
+    ServerConfig server;
+    std::string copy = this->dataPtr->HotCopy(_id.Server().Url().Str(),
+        common::joinPaths(_id.Owner(), "models", _id.Name(),
+        _id.VersionStr()), server);
+    if (!copy.empty())
+    {
+      std::shared_ptr<ModelPrivate> modPriv(new ModelPrivate);
+      modPriv->id.SetServer(server);
+      modPriv->id.SetOwner(_id.Owner());
+      modPriv->id.SetName(_id.Name());
+      modPriv->id.SetVersion(_id.Version());
+      modPriv->pathOnDisk = copy;
+      return Model(modPriv);
+    }
+  }
+
+  return this->dataPtr->Resolve(this->MatchingColdModel(_id));
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::MatchingWorld(WorldIdentifier &_id) const
+{
+  if (_id.Version() != 0 && !_id.Owner().empty() && !_id.Name().empty())
+  {
+    ServerConfig server;
+    std::string copy = this->dataPtr->HotCopy(_id.Server().Url().Str(),
+        common::joinPaths(_id.Owner(), "worlds", _id.Name(),
+        _id.VersionStr()), server);
+    if (!copy.empty())
+    {
+      WorldIdentifier id;
+      id.SetServer(server);
+      id.SetOwner(_id.Owner());
+      id.SetName(_id.Name());
+      id.SetVersion(_id.Version());
+      id.SetLocalPath(copy);
+      _id = id;
+      return true;
+    }
+  }
+
+  if (!this->MatchingColdWorld(_id))
+    return false;
+
+  _id.SetLocalPath(this->dataPtr->Resolve(_id.LocalPath()));
+  return true;
+}
+
+//////////////////////////////////////////////////
+Model LocalCache::MatchingColdModel(const ModelIdentifier &_id)
+{
+  TraceSpan span("LocalCache::MatchingModel", "cache");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
   // For the tip, we have to find the highest version
   bool tip = (_id.Version() == 0);
   Model tipModel;
@@ -291,8 +748,12 @@ Model LocalCache::MatchingModel(const ModelIdentifier &_id)
 }
 
 //////////////////////////////////////////////////
-bool LocalCache::MatchingWorld(WorldIdentifier &_id) const
+bool LocalCache::MatchingColdWorld(WorldIdentifier &_id) const
 {
+  TraceSpan span("LocalCache::MatchingWorld", "cache");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
   // For the tip, we have to find the highest version
   bool tip = (_id.Version() == 0);
   WorldIdentifier tipWorld;
@@ -315,9 +776,7 @@ bool LocalCache::MatchingWorld(WorldIdentifier &_id) const
 
   auto foundTip = !(tipWorld == WorldIdentifier());
   if (foundTip)
-  {
     _id = tipWorld;
-  }
 
   return foundTip;
 }
@@ -368,10 +827,66 @@ WorldIter LocalCache::MatchingWorlds(const WorldIdentifier &_id) const
   return WorldIterFactory::Create(worldIds);
 }
 
+//////////////////////////////////////////////////
+/// \brief Write the hash of the archive a versioned directory was extracted
+/// from.
+/// \param[in] _versionedDir Versioned directory.
+/// \param[in] _data Archive content.
+static void writeArchiveHash(const std::string &_versionedDir,
+    const std::string &_data)
+{
+  std::ofstream out(common::joinPaths(_versionedDir, kArchiveHashFile));
+  out << Lockfile::Hash(_data);
+  if (!out)
+  {
+    ignwarn << "Unable to write the archive hash of [" << _versionedDir
+            << "]" << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+std::string LocalCache::ArchiveHash(const std::string &_versionedDir) const
+{
+  std::ifstream in(common::joinPaths(_versionedDir, kArchiveHashFile));
+  std::string hash;
+  std::getline(in, hash);
+  return hash;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the hash identifying the content of a versioned directory:
+/// the hash of its archive, or the tree hash of a version saved with
+/// SaveModelDelta.
+/// \param[in] _versionedDir Versioned directory.
+/// \return Hash, or empty if none was recorded.
+static std::string contentHash(const std::string &_versionedDir)
+{
+  for (const auto *file : {kArchiveHashFile, kTreeHashFile})
+  {
+    std::ifstream in(common::joinPaths(_versionedDir, file));
+    std::string hash;
+    if (std::getline(in, hash) && !hash.empty())
+      return hash;
+  }
+  return "";
+}
+
 //////////////////////////////////////////////////
 bool LocalCache::SaveModel(
   const ModelIdentifier &_id, const std::string &_data, const bool _overwrite)
 {
+  return this->SaveModel(_id, _data, _overwrite, DownloadOptions());
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::SaveModel(
+  const ModelIdentifier &_id, const std::string &_data, const bool _overwrite,
+  const DownloadOptions &_options)
+{
+  TraceSpan span("LocalCache::SaveModel", "cache");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
   if (_id.Server().Url().Str().empty() || _id.Owner().empty() ||
       _id.Name().empty() || _id.Version() == 0)
   {
@@ -387,8 +902,11 @@ bool LocalCache::SaveModel(
   std::string modelVersionedDir =
     common::joinPaths(modelRootDir, _id.VersionStr());
 
-  // Is it already in the cache?
-  if (common::isDirectory(modelVersionedDir) && !_overwrite)
+  // Is it already in the cache? Partial models are completed.
+  std::string partialMarker =
+      common::joinPaths(modelVersionedDir, kPartialMarker);
+  if (common::isDirectory(modelVersionedDir) && !_overwrite &&
+      !common::exists(partialMarker))
   {
     ignerr << "Directory [" << modelVersionedDir << "] already exists"
            << std::endl;
@@ -396,6 +914,9 @@ bool LocalCache::SaveModel(
   }
 
   // Create the model directory.
+  OwnChange ownChange(this->dataPtr.get(), modelVersionedDir);
+  bool existed = common::isDirectory(modelVersionedDir);
+  bool wasPartial = common::exists(partialMarker);
   if (!common::createDirectories(modelVersionedDir))
   {
     ignerr << "Unable to create directory [" << modelVersionedDir << "]"
@@ -403,18 +924,51 @@ bool LocalCache::SaveModel(
   }
 
   auto zipFile = common::joinPaths(modelVersionedDir, _id.Name() + ".zip");
-  std::ofstream ofs(zipFile, std::ofstream::out);
-  ofs << _data;
-  ofs.close();
+  {
+    TraceSpan writeSpan("LocalCache::WriteArchive", "cache");
+    std::ofstream ofs(zipFile, std::ofstream::out);
+    ofs << _data;
+    ofs.close();
+  }
+
+  // A cancelled save leaves the cache as it was. Directories which already
+  // existed are kept, since they may hold files of a partial model.
+  auto cancel = [&]()
+  {
+    ignmsg << "Cancelled saving model [" << _id.UniqueName() << "]"
+           << std::endl;
+    common::removeDirectoryOrFile(existed ? zipFile : modelVersionedDir);
+    return false;
+  };
 
-  if (!Zip::Extract(zipFile, modelVersionedDir))
+  if (!Zip::Extract(zipFile, modelVersionedDir,
+      [&_options](uint64_t _current, uint64_t _total)
+      {
+        return _options.Report(DownloadPhase::EXTRACT, _current, _total);
+      }))
   {
+    if (_options.Cancellation().Cancelled())
+      return cancel();
     ignerr << "Unable to unzip [" << zipFile << "]" << std::endl;
     return false;
   }
 
+  if (!_options.Report(DownloadPhase::FIX_PATHS, 0, 1))
+    return cancel();
+
   // Convert model:// URIs to locations on disk.
+  static auto &fixPathsDuration = MetricsRegistry::Global().Histogram(
+      "ign_fuel_fix_paths_duration_seconds",
+      "Time spent rewriting model:// URIs in saved models.",
+      MetricsRegistry::DurationBuckets());
+  auto start = std::chrono::steady_clock::now();
   this->dataPtr->FixPaths(modelVersionedDir);
+  fixPathsDuration.Observe(std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count());
+  _options.Report(DownloadPhase::FIX_PATHS, 1, 1);
+
+  // Remember the archive, so lockfiles can pin it.
+  writeArchiveHash(modelVersionedDir, _data);
 
   // Cleanup the zip file.
   if (!common::removeDirectoryOrFile(zipFile))
@@ -422,69 +976,619 @@ bool LocalCache::SaveModel(
     ignwarn << "Unable to remove [" << zipFile << "]" << std::endl;
   }
 
+  // The model is now complete.
+  if (common::exists(partialMarker) &&
+      !common::removeDirectoryOrFile(partialMarker))
+  {
+    ignwarn << "Unable to remove [" << partialMarker << "]" << std::endl;
+  }
+
+  this->dataPtr->Notify(existed && !wasPartial ? CacheEventType::UPDATED :
+      CacheEventType::INSTALLED, cacheEntry(_id.Server().Url().Path().Str(),
+      _id.Owner(), "models", _id.Name(), _id.Version(), modelVersionedDir));
   return true;
 }
 
 //////////////////////////////////////////////////
-bool LocalCachePrivate::FixPaths(const std::string &_modelVersionedDir)
+/// \brief Path of the file holding a saved model listing. Listings live
+/// outside the server directories, so they're never mistaken for models.
+/// \param[in] _cacheLocation Root of the cache.
+/// \param[in] _server Server the listing comes from.
+/// \param[in] _route Route of the listing, such as "alice/models".
+/// \return Path to the listing file.
+static std::string listingPath(const std::string &_cacheLocation,
+    const ServerConfig &_server, const std::string &_route)
 {
-  // Get model.config
-  std::string modelConfigPath = common::joinPaths(
-      _modelVersionedDir, "model.config");
+  std::string name = _route;
+  std::replace(name.begin(), name.end(), '/', '.');
+  return common::joinPaths(_cacheLocation, ".listings",
+      _server.Url().Path().Str(), name + ".json");
+}
 
-  // Make sure the model config file exits.
-  if (!common::exists(modelConfigPath))
+//////////////////////////////////////////////////
+/// \brief Path of the catalog snapshot of a server.
+/// \param[in] _cacheLocation Cache location.
+/// \param[in] _server Server of the catalog.
+/// \return Path of the snapshot, next to the saved listings.
+static std::string snapshotPath(const std::string &_cacheLocation,
+    const ServerConfig &_server)
+{
+  return common::joinPaths(_cacheLocation, ".listings",
+      _server.Url().Path().Str(), "models.snapshot");
+}
+
+//////////////////////////////////////////////////
+/// \brief Write a listing, preceded by a line with the current time.
+/// \param[in] _path Path of the listing file.
+/// \param[in] _json Listing.
+/// \return True if the listing was written.
+static bool writeListing(const std::string &_path, const std::string &_json)
+{
+  common::createDirectories(common::parentPath(_path));
+
+  // Listings of the same route may be written by several threads or
+  // processes at once.
+  std::string tmpPath = _path + "." + std::to_string(
+      std::random_device()()) + ".tmp";
   {
-    ignerr << "model.config file does not exist in ["
-      << _modelVersionedDir << ".\n";
-    return false;
+    std::ofstream out(tmpPath, std::ios::trunc);
+    out << std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() << "\n"
+        << _json;
+    if (!out.good())
+    {
+      ignwarn << "Unable to write listing [" << tmpPath << "]" << std::endl;
+      common::removeFile(tmpPath);
+      return false;
+    }
   }
+  return common::moveFile(tmpPath, _path);
+}
 
-  // Load the model config into tinyxml
-  tinyxml2::XMLDocument modelConfigDoc;
-  if (modelConfigDoc.LoadFile(modelConfigPath.c_str()) !=
-      tinyxml2::XML_SUCCESS)
+//////////////////////////////////////////////////
+/// \brief Read a listing written by writeListing.
+/// \param[in] _path Path of the listing file.
+/// \param[out] _json Listing.
+/// \param[out] _saved When the listing was written.
+/// \return True if the listing was read.
+static bool readListing(const std::string &_path, std::string &_json,
+    std::chrono::system_clock::time_point &_saved)
+{
+  std::ifstream in(_path);
+  std::string line;
+  if (!std::getline(in, line))
+    return false;
+
+  try
+  {
+    _saved = std::chrono::system_clock::time_point(
+        std::chrono::seconds(std::stoll(line)));
+  }
+  catch(...)
   {
-    ignerr << "Unable to load model.config file[" << modelConfigPath << "]\n";
     return false;
   }
 
-  // Get the first <model> element. There really should only be one, but
-  // we are not being strict.
-  tinyxml2::XMLElement *modelElement = modelConfigDoc.FirstChildElement(
-      "model");
+  _json.assign(std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>());
+  return true;
+}
 
-  // Get the <sdf> element with the highest (most recent) version.
-  tinyxml2::XMLElement *sdfElementLatest = nullptr;
-  double maxVersion = 0.0;
-  tinyxml2::XMLElement *sdfElement = modelElement->FirstChildElement("sdf");
-  while (sdfElement)
+//////////////////////////////////////////////////
+bool LocalCache::SaveModelListing(const ServerConfig &_server,
+    const std::string &_route, const std::vector<ModelIdentifier> &_ids)
+{
+  if (!writeListing(listingPath(this->dataPtr->config->CacheLocation(),
+      _server, _route), JSONParser::BuildModels(_ids)))
   {
-    double version = std::stod(sdfElement->Attribute("version"));
-    if (version > maxVersion)
-    {
-      maxVersion = version;
-      sdfElementLatest = sdfElement;
-    }
-
-    sdfElement = sdfElement->NextSiblingElement("sdf");
+    return false;
   }
 
-  // Get name of the model SDF file.
-  std::string modelSdfFilePath = common::joinPaths(_modelVersionedDir,
-      sdfElementLatest->GetText());
-
-  // Load the model SDF file
-  tinyxml2::XMLDocument modelSdfDoc;
-  if (modelSdfDoc.LoadFile(modelSdfFilePath.c_str()) !=
-      tinyxml2::XML_SUCCESS)
+  // Later processes can map the whole catalog instead of parsing it.
+  if (_route == "models")
   {
-    ignerr << "Unable to load SDF file[" << modelSdfFilePath << "]\n";
-    return false;
+    CatalogSnapshot::Write(snapshotPath(this->dataPtr->config->CacheLocation(),
+        _server), _ids);
   }
 
-  // Process each <model>
-  tinyxml2::XMLElement *modelElem =
+  // Keep a search index which was already built up to date.
+  std::lock_guard<std::mutex> lock(this->dataPtr->indexMutex);
+  auto index = this->dataPtr->indexes.find(_server.Url().Str());
+  if (index != this->dataPtr->indexes.end())
+    index->second.Add(_ids);
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const CatalogSnapshot> LocalCache::ModelSnapshot(
+    const ServerConfig &_server) const
+{
+  auto snapshot = std::make_shared<CatalogSnapshot>();
+  if (!snapshot->Open(snapshotPath(this->dataPtr->config->CacheLocation(),
+      _server)))
+  {
+    return nullptr;
+  }
+  return snapshot;
+}
+
+//////////////////////////////////////////////////
+std::vector<ModelIdentifier> LocalCache::SearchModels(
+    const ServerConfig &_server, const std::string &_text,
+    const std::vector<std::string> &_tags, size_t _limit) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->indexMutex);
+  return this->dataPtr->ModelIndex(_server).Search(_text, _tags, _limit);
+}
+
+//////////////////////////////////////////////////
+SearchIndex &LocalCachePrivate::ModelIndex(const ServerConfig &_server)
+{
+  auto found = this->indexes.find(_server.Url().Str());
+  if (found != this->indexes.end())
+    return found->second;
+
+  TraceSpan span("LocalCache::ModelIndex", "cache");
+  if (span.Active())
+    span.SetDetail(_server.Url().Str());
+
+  auto &index = this->indexes[_server.Url().Str()];
+
+  // Downloaded models come first, so the richer metadata of listings
+  // replaces them.
+  std::string serverPath = common::joinPaths(this->config->CacheLocation(),
+      _server.Url().Path().Str());
+  if (common::isDirectory(serverPath))
+  {
+    for (const auto &model : this->ModelsInServer(serverPath))
+    {
+      auto id = model.Identification();
+      id.SetServer(_server);
+      index.Add(id);
+    }
+  }
+
+  // Listings of models are named "models.json", "<owner>.models.json" or
+  // "<owner>.models.<name>.json". Older listings are added first.
+  std::string listingsPath = common::parentPath(
+      listingPath(this->config->CacheLocation(), _server, "models"));
+  std::multimap<std::chrono::system_clock::time_point, std::string> listings;
+  if (common::isDirectory(listingsPath))
+  {
+    common::DirIter end;
+    for (common::DirIter file(listingsPath); file != end; ++file)
+    {
+      std::string name = common::basename(*file);
+      auto parts = common::Split(name, '.');
+      if (!common::EndsWith(name, ".json") || parts.size() < 2u ||
+          (parts[0] != "models" && parts[1] != "models"))
+      {
+        continue;
+      }
+
+      std::string json;
+      std::chrono::system_clock::time_point saved;
+      if (readListing(*file, json, saved))
+        listings.emplace(saved, json);
+    }
+  }
+  for (const auto &listing : listings)
+    index.Add(JSONParser::ParseModels(listing.second, _server));
+
+  return index;
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::ModelListing(const ServerConfig &_server,
+    const std::string &_route, std::vector<ModelIdentifier> &_ids,
+    std::chrono::system_clock::time_point &_saved) const
+{
+  std::string json;
+  if (!readListing(listingPath(this->dataPtr->config->CacheLocation(),
+      _server, _route), json, _saved))
+  {
+    return false;
+  }
+  _ids = JSONParser::ParseModels(json, _server);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::SaveWorldListing(const ServerConfig &_server,
+    const std::string &_route, const std::vector<WorldIdentifier> &_ids)
+{
+  return writeListing(listingPath(this->dataPtr->config->CacheLocation(),
+      _server, _route), JSONParser::BuildWorlds(_ids));
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::WorldListing(const ServerConfig &_server,
+    const std::string &_route, std::vector<WorldIdentifier> &_ids,
+    std::chrono::system_clock::time_point &_saved) const
+{
+  std::string json;
+  if (!readListing(listingPath(this->dataPtr->config->CacheLocation(),
+      _server, _route), json, _saved))
+  {
+    return false;
+  }
+  _ids = JSONParser::ParseWorlds(json, _server);
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Hardlink a file, or copy it where hardlinks aren't supported,
+/// such as across filesystems.
+/// \param[in] _src Existing file.
+/// \param[in] _dst New file.
+/// \return True if the file was linked or copied.
+static bool linkOrCopy(const std::string &_src, const std::string &_dst)
+{
+#ifndef _WIN32
+  if (link(_src.c_str(), _dst.c_str()) == 0)
+    return true;
+#endif
+  return common::copyFile(_src, _dst);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that a path stays within the model directory: it must be
+/// relative and made only of plain segments.
+/// \param[in] _path Path relative to the model directory.
+/// \return True if the path is valid.
+static bool validModelPath(const std::string &_path)
+{
+  bool valid = !_path.empty() && _path.front() != '/' &&
+      _path.back() != '/' && _path.find('\\') == std::string::npos;
+  for (const auto &segment : common::Split(_path, '/'))
+  {
+    valid = valid && !segment.empty() && segment != "." &&
+        segment != "..";
+  }
+  if (!valid)
+    ignerr << "Invalid model file path [" << _path << "]" << std::endl;
+  return valid;
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::SaveModelDelta(const ModelIdentifier &_id,
+    const std::string &_previousDir,
+    const std::vector<std::string> &_unchanged,
+    const std::map<std::string, std::string> &_changed,
+    const std::string &_fileTree)
+{
+  TraceSpan span("LocalCache::SaveModelDelta", "cache");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
+  if (_id.Server().Url().Str().empty() || _id.Owner().empty() ||
+      _id.Name().empty() || _id.Version() == 0)
+  {
+    ignerr << "Incomplete model identifier, failed to save model." << std::endl
+           << _id.AsString();
+    return false;
+  }
+
+  std::string modelVersionedDir = common::joinPaths(
+      this->dataPtr->config->CacheLocation(), _id.Server().Url().Path().Str(),
+      _id.Owner(), "models", _id.Name(), _id.VersionStr());
+  if (common::exists(modelVersionedDir))
+  {
+    ignerr << "Directory [" << modelVersionedDir << "] already exists"
+           << std::endl;
+    return false;
+  }
+
+  OwnChange ownChange(this->dataPtr.get(), modelVersionedDir);
+
+  // Assemble the version in a staging directory, marked as partial until
+  // its paths are fixed, so an interrupted update never looks like a
+  // complete model.
+  std::string stagingDir = common::joinPaths(
+      common::parentPath(modelVersionedDir), "." + _id.VersionStr() + ".delta");
+  common::removeAll(stagingDir);
+  if (!common::createDirectories(stagingDir))
+  {
+    ignerr << "Unable to create directory [" << stagingDir << "]"
+           << std::endl;
+    return false;
+  }
+  {
+    std::ofstream marker(common::joinPaths(stagingDir, kPartialMarker));
+  }
+
+  auto fail = [&stagingDir]()
+  {
+    common::removeAll(stagingDir);
+    return false;
+  };
+
+  static auto &reusedBytes = MetricsRegistry::Global().Counter(
+      "ign_fuel_delta_reused_bytes_total",
+      "Bytes of unchanged files reused from the previous model version.");
+
+  for (const auto &file : _unchanged)
+  {
+    if (!validModelPath(file))
+      return fail();
+
+    std::string src = common::joinPaths(_previousDir, file);
+    std::string dst = common::joinPaths(stagingDir, file);
+    common::createDirectories(common::parentPath(dst));
+    if (!linkOrCopy(src, dst))
+    {
+      ignerr << "Unable to reuse [" << src << "]" << std::endl;
+      return fail();
+    }
+
+    std::ifstream in(dst, std::ifstream::ate | std::ifstream::binary);
+    if (in.good())
+      reusedBytes.Increment(static_cast<uint64_t>(in.tellg()));
+  }
+
+  for (const auto &file : _changed)
+  {
+    if (!validModelPath(file.first))
+      return fail();
+
+    std::string dst = common::joinPaths(stagingDir, file.first);
+    common::createDirectories(common::parentPath(dst));
+    std::ofstream out(dst, std::ios::binary);
+    out << file.second;
+    if (!out.good())
+    {
+      ignerr << "Unable to write [" << dst << "]" << std::endl;
+      return fail();
+    }
+  }
+
+  if (!common::moveFile(stagingDir, modelVersionedDir))
+  {
+    ignerr << "Unable to move [" << stagingDir << "] to ["
+           << modelVersionedDir << "]" << std::endl;
+    return fail();
+  }
+
+  // Convert model:// URIs to locations on disk. The files which get
+  // rewritten are always among the changed ones, since the copies in the
+  // previous version point to that version's directory.
+  if (!this->dataPtr->FixPaths(modelVersionedDir))
+  {
+    common::removeAll(modelVersionedDir);
+    return false;
+  }
+
+  this->SaveFileTree(_id, _fileTree);
+
+  // There's no archive to hash, so identify the content by the version it
+  // was derived from and the changes applied to it. This keeps versions
+  // saved here recognizable, such as by the hot tier, without reading back
+  // the reused files.
+  std::string tree = contentHash(_previousDir) + "\n" + _fileTree;
+  for (const auto &file : _unchanged)
+    tree += "\n=" + file;
+  for (const auto &file : _changed)
+    tree += "\n+" + file.first + " " + Lockfile::Hash(file.second);
+  {
+    std::ofstream out(common::joinPaths(modelVersionedDir, kTreeHashFile));
+    out << Lockfile::Hash(tree);
+    if (!out)
+    {
+      ignwarn << "Unable to write the tree hash of [" << modelVersionedDir
+              << "]" << std::endl;
+    }
+  }
+  common::removeFile(common::joinPaths(modelVersionedDir, kPartialMarker));
+
+  this->dataPtr->Notify(CacheEventType::INSTALLED,
+      cacheEntry(_id.Server().Url().Path().Str(), _id.Owner(), "models",
+      _id.Name(), _id.Version(), modelVersionedDir));
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::SaveFileTree(const ModelIdentifier &_id,
+    const std::string &_fileTree)
+{
+  std::string modelVersionedDir = common::joinPaths(
+      this->dataPtr->config->CacheLocation(), _id.Server().Url().Path().Str(),
+      _id.Owner(), "models", _id.Name(), _id.VersionStr());
+  if (_id.Version() == 0 || !common::isDirectory(modelVersionedDir))
+    return false;
+
+  std::ofstream out(common::joinPaths(modelVersionedDir, kFileTreeFile));
+  out << _fileTree;
+  if (!out)
+  {
+    ignwarn << "Unable to write the file tree of [" << modelVersionedDir
+            << "]" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string LocalCache::FileTree(const std::string &_versionedDir) const
+{
+  std::ifstream in(common::joinPaths(_versionedDir, kFileTreeFile));
+  return std::string(std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>());
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::SaveModelFile(const ModelIdentifier &_id,
+    const std::string &_filePath, const std::string &_data)
+{
+  TraceSpan span("LocalCache::SaveModelFile", "cache");
+  if (span.Active())
+    span.SetDetail(_filePath);
+
+  if (_id.Server().Url().Str().empty() || _id.Owner().empty() ||
+      _id.Name().empty() || _id.Version() == 0 || _filePath.empty())
+  {
+    ignerr << "Incomplete model identifier, failed to save model file."
+           << std::endl << _id.AsString();
+    return false;
+  }
+
+  // Don't let the file escape the model directory.
+  if (!validModelPath(_filePath))
+    return false;
+
+  std::string modelVersionedDir = common::joinPaths(
+      this->dataPtr->config->CacheLocation(), _id.Server().Url().Path().Str(),
+      _id.Owner(), "models", _id.Name(), _id.VersionStr());
+
+  // Mark new directories as partial before any file is written, so they're
+  // never mistaken for complete models.
+  if (!common::isDirectory(modelVersionedDir))
+  {
+    if (!common::createDirectories(modelVersionedDir))
+    {
+      ignerr << "Unable to create directory [" << modelVersionedDir << "]"
+             << std::endl;
+      return false;
+    }
+    std::ofstream marker(common::joinPaths(modelVersionedDir, kPartialMarker));
+  }
+
+  std::string filePath = common::joinPaths(modelVersionedDir, _filePath);
+  common::createDirectories(common::parentPath(filePath));
+
+  // Write through a temporary file, so concurrent readers never see a
+  // partial file.
+  std::string tmpPath = filePath + ".download";
+  {
+    std::ofstream out(tmpPath, std::ios::binary);
+    out << _data;
+    if (!out.good())
+    {
+      ignerr << "Unable to write [" << tmpPath << "]" << std::endl;
+      return false;
+    }
+  }
+  if (!common::moveFile(tmpPath, filePath))
+  {
+    ignerr << "Unable to move [" << tmpPath << "] to [" << filePath << "]"
+           << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string LocalCache::MatchingPartialModelFile(const ModelIdentifier &_id,
+    const std::string &_filePath) const
+{
+  if (!this->dataPtr->config || _filePath.empty())
+    return "";
+
+  std::string modelDir = common::joinPaths(
+      this->dataPtr->config->CacheLocation(), _id.Server().Url().Path().Str(),
+      _id.Owner(), "models", _id.Name());
+
+  std::vector<std::string> versionDirs;
+  if (_id.Version() != 0)
+  {
+    versionDirs.push_back(common::joinPaths(modelDir, _id.VersionStr()));
+  }
+  else if (common::isDirectory(modelDir))
+  {
+    // For the tip, look from the highest version down.
+    std::vector<std::pair<unsigned int, std::string>> versions;
+    common::DirIter end;
+    for (common::DirIter verIter(modelDir); verIter != end; ++verIter)
+    {
+      try
+      {
+        versions.push_back({std::stoul(common::basename(*verIter)),
+            *verIter});
+      }
+      catch(...)
+      {
+      }
+    }
+    std::sort(versions.rbegin(), versions.rend());
+    for (const auto &version : versions)
+      versionDirs.push_back(version.second);
+  }
+
+  for (const auto &dir : versionDirs)
+  {
+    std::string filePath = common::joinPaths(dir, _filePath);
+    if (common::exists(common::joinPaths(dir, kPartialMarker)) &&
+        common::isFile(filePath))
+    {
+      return filePath;
+    }
+  }
+
+  return "";
+}
+
+//////////////////////////////////////////////////
+bool LocalCachePrivate::FixPaths(const std::string &_modelVersionedDir)
+{
+  TraceSpan span("LocalCache::FixPaths", "cache");
+
+  // Get model.config
+  std::string modelConfigPath = common::joinPaths(
+      _modelVersionedDir, "model.config");
+
+  // Make sure the model config file exits.
+  if (!common::exists(modelConfigPath))
+  {
+    ignerr << "model.config file does not exist in ["
+      << _modelVersionedDir << ".\n";
+    return false;
+  }
+
+  // Load the model config into tinyxml
+  tinyxml2::XMLDocument modelConfigDoc;
+  if (modelConfigDoc.LoadFile(modelConfigPath.c_str()) !=
+      tinyxml2::XML_SUCCESS)
+  {
+    ignerr << "Unable to load model.config file[" << modelConfigPath << "]\n";
+    return false;
+  }
+
+  // Get the first <model> element. There really should only be one, but
+  // we are not being strict.
+  tinyxml2::XMLElement *modelElement = modelConfigDoc.FirstChildElement(
+      "model");
+
+  // Get the <sdf> element with the highest (most recent) version.
+  tinyxml2::XMLElement *sdfElementLatest = nullptr;
+  double maxVersion = 0.0;
+  tinyxml2::XMLElement *sdfElement = modelElement->FirstChildElement("sdf");
+  while (sdfElement)
+  {
+    double version = std::stod(sdfElement->Attribute("version"));
+    if (version > maxVersion)
+    {
+      maxVersion = version;
+      sdfElementLatest = sdfElement;
+    }
+
+    sdfElement = sdfElement->NextSiblingElement("sdf");
+  }
+
+  // Get name of the model SDF file.
+  std::string modelSdfFilePath = common::joinPaths(_modelVersionedDir,
+      sdfElementLatest->GetText());
+
+  // Load the model SDF file
+  tinyxml2::XMLDocument modelSdfDoc;
+  if (modelSdfDoc.LoadFile(modelSdfFilePath.c_str()) !=
+      tinyxml2::XML_SUCCESS)
+  {
+    ignerr << "Unable to load SDF file[" << modelSdfFilePath << "]\n";
+    return false;
+  }
+
+  // Process each <model>
+  tinyxml2::XMLElement *modelElem =
     modelSdfDoc.RootElement()->FirstChildElement("model");
   while (modelElem)
   {
@@ -681,6 +1785,18 @@ void LocalCachePrivate::FixPathsInGeomElement(tinyxml2::XMLElement *_geomElem,
 bool LocalCache::SaveWorld(
   WorldIdentifier &_id, const std::string &_data, const bool _overwrite)
 {
+  return this->SaveWorld(_id, _data, _overwrite, DownloadOptions());
+}
+
+//////////////////////////////////////////////////
+bool LocalCache::SaveWorld(
+  WorldIdentifier &_id, const std::string &_data, const bool _overwrite,
+  const DownloadOptions &_options)
+{
+  TraceSpan span("LocalCache::SaveWorld", "cache");
+  if (span.Active())
+    span.SetDetail(_id.UniqueName());
+
   if (!_id.Server().Url().Valid() || _id.Owner().empty() ||
       _id.Name().empty() || _id.Version() == 0)
   {
@@ -703,6 +1819,8 @@ bool LocalCache::SaveWorld(
   }
 
   // Create the world directory.
+  OwnChange ownChange(this->dataPtr.get(), worldVersionedDir);
+  bool existed = common::isDirectory(worldVersionedDir);
   if (!common::createDirectories(worldVersionedDir))
   {
     ignerr << "Unable to create directory [" << worldVersionedDir << "]"
@@ -714,8 +1832,19 @@ bool LocalCache::SaveWorld(
   ofs << _data;
   ofs.close();
 
-  if (!Zip::Extract(zipFile, worldVersionedDir))
+  if (!Zip::Extract(zipFile, worldVersionedDir,
+      [&_options](uint64_t _current, uint64_t _total)
+      {
+        return _options.Report(DownloadPhase::EXTRACT, _current, _total);
+      }))
   {
+    if (_options.Cancellation().Cancelled())
+    {
+      ignmsg << "Cancelled saving world [" << _id.UniqueName() << "]"
+             << std::endl;
+      common::removeDirectoryOrFile(existed ? zipFile : worldVersionedDir);
+      return false;
+    }
     ignerr << "Unable to unzip [" << zipFile << "]" << std::endl;
     return false;
   }
@@ -725,10 +1854,517 @@ bool LocalCache::SaveWorld(
     ignwarn << "Unable to remove [" << zipFile << "]" << std::endl;
   }
 
+  // Remember the archive, so lockfiles can pin it.
+  writeArchiveHash(worldVersionedDir, _data);
+
   _id.SetLocalPath(worldVersionedDir);
   ignmsg << "Saved world at:" << std::endl
          << "  " << worldVersionedDir << std::endl;
 
+  this->dataPtr->Notify(existed ? CacheEventType::UPDATED :
+      CacheEventType::INSTALLED, cacheEntry(_id.Server().Url().Path().Str(),
+      _id.Owner(), "worlds", _id.Name(), _id.Version(), worldVersionedDir));
   return true;
 }
 
+
+//////////////////////////////////////////////////
+/// \brief Call a function for every index in [0, _count), spreading the
+/// calls over several threads.
+/// \param[in] _count Number of indices.
+/// \param[in] _jobs Maximum number of threads. Zero uses one thread per core.
+/// \param[in] _func Function to call with each index.
+static void parallelFor(size_t _count, unsigned int _jobs,
+    const std::function<void(size_t)> &_func)
+{
+  if (_jobs == 0)
+    _jobs = std::max(1u, std::thread::hardware_concurrency());
+  _jobs = static_cast<unsigned int>(
+      std::min(static_cast<size_t>(_jobs), _count));
+
+  if (_jobs <= 1)
+  {
+    for (size_t i = 0; i < _count; ++i)
+      _func(i);
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> workers;
+  for (unsigned int j = 0; j < _jobs; ++j)
+  {
+    workers.emplace_back([&]()
+    {
+      for (size_t i = next++; i < _count; i = next++)
+        _func(i);
+    });
+  }
+  for (auto &worker : workers)
+    worker.join();
+}
+
+//////////////////////////////////////////////////
+/// \brief Recursively list all the files in a directory.
+/// \param[in] _dir Directory to list.
+/// \param[out] _files Paths of the files found.
+static void listFiles(const std::string &_dir, std::vector<std::string> &_files)
+{
+  common::DirIter end;
+  for (common::DirIter iter(_dir); iter != end; ++iter)
+  {
+    if (common::isDirectory(*iter))
+      listFiles(*iter, _files);
+    else
+      _files.push_back(*iter);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Read a whole file, computing a 64-bit FNV-1a hash of its content.
+/// \param[in] _path Path to the file.
+/// \param[out] _bytes Number of bytes read.
+/// \param[out] _hash Hash of the content.
+/// \return True if the whole file could be read.
+static bool readFile(const std::string &_path, uint64_t &_bytes,
+    uint64_t &_hash)
+{
+  _bytes = 0;
+  _hash = 14695981039346656037ull;
+
+  std::ifstream in(_path, std::ifstream::binary);
+  if (!in.is_open())
+    return false;
+
+  std::vector<char> buffer(1 << 20);
+  while (in)
+  {
+    in.read(buffer.data(), buffer.size());
+    auto count = in.gcount();
+    for (std::streamsize i = 0; i < count; ++i)
+    {
+      _hash ^= static_cast<unsigned char>(buffer[i]);
+      _hash *= 1099511628211ull;
+    }
+    _bytes += static_cast<uint64_t>(count);
+  }
+  return in.eof() && !in.bad();
+}
+
+//////////////////////////////////////////////////
+std::vector<CacheEntry> LocalCache::Entries(unsigned int _jobs) const
+{
+  std::vector<CacheEntry> entries;
+  if (!this->dataPtr->config)
+    return entries;
+
+  std::string cacheLocation = this->dataPtr->config->CacheLocation();
+  if (!common::isDirectory(cacheLocation))
+    return entries;
+
+  // Owner directories have the form <cache>/<server>/<owner>
+  std::vector<std::pair<std::string, std::string>> owners;
+  common::DirIter end;
+  for (common::DirIter srvIter(cacheLocation); srvIter != end; ++srvIter)
+  {
+    if (!common::isDirectory(*srvIter))
+      continue;
+
+    for (common::DirIter ownIter(*srvIter); ownIter != end; ++ownIter)
+    {
+      if (common::isDirectory(*ownIter))
+        owners.push_back({common::basename(*srvIter), *ownIter});
+    }
+  }
+
+  // Find versioned directories of each owner in parallel
+  std::vector<std::vector<CacheEntry>> ownerEntries(owners.size());
+  parallelFor(owners.size(), _jobs, [&](size_t _index)
+  {
+    for (const std::string type : {"models", "worlds"})
+    {
+      std::string typeDir = common::joinPaths(owners[_index].second, type);
+      if (!common::isDirectory(typeDir))
+        continue;
+
+      for (common::DirIter resIter(typeDir); resIter != end; ++resIter)
+      {
+        if (!common::isDirectory(*resIter))
+          continue;
+
+        for (common::DirIter verIter(*resIter); verIter != end; ++verIter)
+        {
+          if (!common::isDirectory(*verIter))
+            continue;
+
+          CacheEntry entry;
+          try
+          {
+            entry.version = std::stoul(common::basename(*verIter));
+          }
+          catch(...)
+          {
+            continue;
+          }
+          entry.server = owners[_index].first;
+          entry.owner = common::basename(owners[_index].second);
+          entry.type = type;
+          entry.name = common::basename(*resIter);
+          entry.path = *verIter;
+          entry.partial = common::exists(
+              common::joinPaths(*verIter, kPartialMarker));
+          ownerEntries[_index].push_back(entry);
+        }
+      }
+    }
+  });
+
+  for (auto &ownerEntry : ownerEntries)
+    entries.insert(entries.end(), ownerEntry.begin(), ownerEntry.end());
+
+  // Size each entry in parallel
+  parallelFor(entries.size(), _jobs, [&](size_t _index)
+  {
+    auto &entry = entries[_index];
+    std::vector<std::string> files;
+    listFiles(entry.path, files);
+
+    for (const auto &file : files)
+    {
+      struct stat info;
+      if (stat(file.c_str(), &info) != 0)
+        continue;
+
+      ++entry.files;
+      entry.bytes += static_cast<uint64_t>(info.st_size);
+      entry.lastUsed = std::max({entry.lastUsed, info.st_atime,
+          info.st_mtime});
+    }
+  });
+
+  std::sort(entries.begin(), entries.end(),
+      [](const CacheEntry &_a, const CacheEntry &_b)
+      {
+        return _a.path < _b.path;
+      });
+
+  return entries;
+}
+
+//////////////////////////////////////////////////
+CacheStats LocalCache::Stats(const std::vector<CacheEntry> &_entries,
+    size_t _largest, unsigned int _jobs) const
+{
+  CacheStats stats;
+  for (const auto &entry : _entries)
+  {
+    if (entry.type == "models")
+      ++stats.models;
+    else
+      ++stats.worlds;
+
+    stats.files += entry.files;
+    stats.bytes += entry.bytes;
+    stats.bytesPerServer[entry.server] += entry.bytes;
+    stats.bytesPerOwner[entry.server + "/" + entry.owner] += entry.bytes;
+  }
+
+  stats.largest = _entries;
+  std::sort(stats.largest.begin(), stats.largest.end(),
+      [](const CacheEntry &_a, const CacheEntry &_b)
+      {
+        return _a.bytes > _b.bytes;
+      });
+  if (stats.largest.size() > _largest)
+    stats.largest.resize(_largest);
+
+  // Files can only be duplicates if they have the same size, so only those
+  // need to be read.
+  std::vector<std::vector<std::string>> entryFiles(_entries.size());
+  parallelFor(_entries.size(), _jobs, [&](size_t _index)
+  {
+    listFiles(_entries[_index].path, entryFiles[_index]);
+  });
+
+  std::map<uint64_t, std::vector<std::string>> filesBySize;
+  for (const auto &files : entryFiles)
+  {
+    for (const auto &file : files)
+    {
+      struct stat info;
+      if (stat(file.c_str(), &info) == 0 && info.st_size > 0)
+        filesBySize[static_cast<uint64_t>(info.st_size)].push_back(file);
+    }
+  }
+
+  std::vector<std::string> candidates;
+  for (const auto &sizeFiles : filesBySize)
+  {
+    if (sizeFiles.second.size() > 1)
+    {
+      candidates.insert(candidates.end(), sizeFiles.second.begin(),
+          sizeFiles.second.end());
+    }
+  }
+
+  std::vector<std::pair<uint64_t, uint64_t>> sizeHashes(candidates.size());
+  parallelFor(candidates.size(), _jobs, [&](size_t _index)
+  {
+    if (!readFile(candidates[_index], sizeHashes[_index].first,
+        sizeHashes[_index].second))
+    {
+      sizeHashes[_index] = {0, 0};
+    }
+  });
+
+  std::map<std::pair<uint64_t, uint64_t>, uint64_t> copies;
+  for (const auto &sizeHash : sizeHashes)
+  {
+    if (sizeHash.first > 0 && copies[sizeHash]++ > 0)
+      stats.duplicateBytes += sizeHash.first;
+  }
+
+  return stats;
+}
+
+//////////////////////////////////////////////////
+std::vector<CacheEntry> LocalCache::Prune(
+    const std::vector<CacheEntry> &_entries,
+    const CachePruneOptions &_options, unsigned int _jobs)
+{
+  std::vector<char> remove(_entries.size(), 0);
+
+  // Too old
+  if (_options.maxAge.count() > 0)
+  {
+    std::time_t oldest = std::time(nullptr) - _options.maxAge.count();
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+      if (_entries[i].lastUsed < oldest)
+        remove[i] = 1;
+    }
+  }
+
+  // Too many versions
+  if (_options.keepVersions > 0)
+  {
+    std::map<std::string, std::vector<size_t>> versions;
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+      const auto &entry = _entries[i];
+      versions[common::joinPaths(entry.server, entry.owner, entry.type,
+          entry.name)].push_back(i);
+    }
+
+    for (auto &resource : versions)
+    {
+      auto &indices = resource.second;
+      std::sort(indices.begin(), indices.end(), [&](size_t _a, size_t _b)
+          {
+            return _entries[_a].version > _entries[_b].version;
+          });
+      for (size_t i = _options.keepVersions; i < indices.size(); ++i)
+        remove[indices[i]] = 1;
+    }
+  }
+
+  // Too large, remove the least recently used entries first
+  if (_options.maxBytes > 0)
+  {
+    uint64_t total{0};
+    std::vector<size_t> remaining;
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+      if (!remove[i])
+      {
+        total += _entries[i].bytes;
+        remaining.push_back(i);
+      }
+    }
+
+    std::sort(remaining.begin(), remaining.end(), [&](size_t _a, size_t _b)
+        {
+          return _entries[_a].lastUsed < _entries[_b].lastUsed;
+        });
+    for (auto index : remaining)
+    {
+      if (total <= _options.maxBytes)
+        break;
+      remove[index] = 1;
+      total -= _entries[index].bytes;
+    }
+  }
+
+  std::vector<CacheEntry> removed;
+  for (size_t i = 0; i < _entries.size(); ++i)
+  {
+    if (remove[i])
+      removed.push_back(_entries[i]);
+  }
+
+  if (_options.dryRun)
+    return removed;
+
+  for (const auto &entry : removed)
+    this->dataPtr->MarkOwnChange(entry.path, true);
+
+  std::vector<char> success(removed.size(), 0);
+  parallelFor(removed.size(), _jobs, [&](size_t _index)
+  {
+    success[_index] = common::removeAll(removed[_index].path) ? 1 : 0;
+    if (!success[_index])
+    {
+      ignerr << "Unable to remove [" << removed[_index].path << "]"
+             << std::endl;
+    }
+  });
+
+  std::vector<CacheEntry> result;
+  for (size_t i = 0; i < removed.size(); ++i)
+  {
+    this->dataPtr->MarkOwnChange(removed[i].path, false);
+    if (!success[i])
+      continue;
+
+    result.push_back(removed[i]);
+
+    // Remove the resource directory once its last version is gone.
+    std::string resourceDir = common::parentPath(removed[i].path);
+    common::DirIter end;
+    if (common::isDirectory(resourceDir) &&
+        !(common::DirIter(resourceDir) != end))
+    {
+      common::removeDirectoryOrFile(resourceDir);
+    }
+  }
+
+  for (const auto &entry : result)
+    this->dataPtr->Notify(CacheEventType::REMOVED, entry);
+
+  return result;
+}
+
+//////////////////////////////////////////////////
+std::vector<CacheIssue> LocalCache::Verify(
+    const std::vector<CacheEntry> &_entries, unsigned int _jobs) const
+{
+  std::vector<std::vector<CacheIssue>> entryIssues(_entries.size());
+  parallelFor(_entries.size(), _jobs, [&](size_t _index)
+  {
+    const auto &entry = _entries[_index];
+    auto &issues = entryIssues[_index];
+
+    std::vector<std::string> files;
+    listFiles(entry.path, files);
+
+    if (files.empty())
+      issues.push_back({entry.path, "Empty directory"});
+
+    for (const auto &file : files)
+    {
+      uint64_t bytes;
+      uint64_t hash;
+      if (!readFile(file, bytes, hash))
+        issues.push_back({file, "Unable to read file"});
+
+      if (common::basename(file) == entry.name + ".zip")
+      {
+        issues.push_back({file,
+            "Leftover archive, the download may have been interrupted"});
+      }
+    }
+
+    // Partial models only hold the files which were requested.
+    if (entry.type != "models" || entry.partial)
+      return;
+
+    std::string configPath = common::joinPaths(entry.path, "model.config");
+    if (!common::exists(configPath))
+    {
+      issues.push_back({entry.path, "Missing model.config"});
+      return;
+    }
+
+    tinyxml2::XMLDocument configDoc;
+    if (configDoc.LoadFile(configPath.c_str()) != tinyxml2::XML_SUCCESS)
+    {
+      issues.push_back({configPath, "Unable to parse model.config"});
+      return;
+    }
+
+    auto modelElem = configDoc.FirstChildElement("model");
+    if (!modelElem)
+    {
+      issues.push_back({configPath, "Missing <model> element"});
+      return;
+    }
+
+    // Check the SDF file with the highest version, as FixPaths does.
+    tinyxml2::XMLElement *sdfElemLatest = nullptr;
+    double maxVersion = -1.0;
+    for (auto sdfElem = modelElem->FirstChildElement("sdf"); sdfElem;
+         sdfElem = sdfElem->NextSiblingElement("sdf"))
+    {
+      double version{0.0};
+      if (sdfElem->Attribute("version"))
+      {
+        try
+        {
+          version = std::stod(sdfElem->Attribute("version"));
+        }
+        catch(...)
+        {
+        }
+      }
+      if (version > maxVersion)
+      {
+        maxVersion = version;
+        sdfElemLatest = sdfElem;
+      }
+    }
+
+    if (!sdfElemLatest || !sdfElemLatest->GetText())
+    {
+      issues.push_back({configPath, "Missing <sdf> element"});
+      return;
+    }
+
+    std::string sdfPath = common::joinPaths(entry.path,
+        sdfElemLatest->GetText());
+    tinyxml2::XMLDocument sdfDoc;
+    if (!common::exists(sdfPath))
+      issues.push_back({sdfPath, "Missing SDF file"});
+    else if (sdfDoc.LoadFile(sdfPath.c_str()) != tinyxml2::XML_SUCCESS)
+      issues.push_back({sdfPath, "Unable to parse SDF file"});
+  });
+
+  std::vector<CacheIssue> issues;
+  for (const auto &entryIssue : entryIssues)
+    issues.insert(issues.end(), entryIssue.begin(), entryIssue.end());
+  return issues;
+}
+
+//////////////////////////////////////////////////
+uint64_t LocalCache::Warm(const std::vector<CacheEntry> &_entries,
+    unsigned int _jobs) const
+{
+  std::vector<std::vector<std::string>> entryFiles(_entries.size());
+  parallelFor(_entries.size(), _jobs, [&](size_t _index)
+  {
+    listFiles(_entries[_index].path, entryFiles[_index]);
+  });
+
+  std::vector<std::string> files;
+  for (const auto &entryFile : entryFiles)
+    files.insert(files.end(), entryFile.begin(), entryFile.end());
+
+  std::atomic<uint64_t> total{0};
+  parallelFor(files.size(), _jobs, [&](size_t _index)
+  {
+    std::ifstream in(files[_index], std::ifstream::binary);
+    std::vector<char> buffer(1 << 20);
+    while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0)
+      total += static_cast<uint64_t>(in.gcount());
+  });
+
+  return total;
+}
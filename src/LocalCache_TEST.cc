@@ -17,9 +17,15 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 #include <ignition/common/Filesystem.hh>
 
 #include "ignition/fuel_tools/ClientConfig.hh"
@@ -39,6 +45,14 @@
 using namespace ignition;
 using namespace fuel_tools;
 
+/// \brief Read a whole file.
+std::string readFile(const std::string &_path)
+{
+  std::ifstream in(_path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>());
+}
+
 /// \brief Creates a directory structure in the build directory with 6 models
 void createLocal6Models(ClientConfig &_conf)
 {
@@ -407,9 +421,543 @@ TEST(LocalCache, MatchingWorld)
   EXPECT_FALSE(cache.MatchingWorld(bogus3));
 }
 
+/////////////////////////////////////////////////
+TEST(LocalCache, Entries)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+  createLocal6Models(conf);
+  createLocal3Worlds(conf);
+
+  // Directories which aren't versions are ignored
+  common::createDirectories("test_cache/localhost:8001/alice/models/am1/tip");
+
+  ignition::fuel_tools::LocalCache cache(&conf);
+
+  auto entries = cache.Entries(2);
+  ASSERT_EQ(9u, entries.size());
+
+  EXPECT_EQ("localhost:8001", entries[0].server);
+  EXPECT_EQ("alice", entries[0].owner);
+  EXPECT_EQ("models", entries[0].type);
+  EXPECT_EQ("am1", entries[0].name);
+  EXPECT_EQ(2u, entries[0].version);
+  EXPECT_EQ(1u, entries[0].files);
+  EXPECT_EQ(21u, entries[0].bytes);
+  EXPECT_NE(0, entries[0].lastUsed);
+
+  unsigned int worlds{0};
+  for (const auto &entry : entries)
+  {
+    if (entry.type == "worlds")
+    {
+      ++worlds;
+      EXPECT_EQ("localhost:8007", entry.server);
+    }
+  }
+  EXPECT_EQ(3u, worlds);
+
+  // Same result with a single thread
+  EXPECT_EQ(entries.size(), cache.Entries(1).size());
+}
+
+/////////////////////////////////////////////////
+TEST(LocalCache, Stats)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+  createLocal6Models(conf);
+  createLocal3Worlds(conf);
+
+  ignition::fuel_tools::LocalCache cache(&conf);
+
+  auto stats = cache.Stats(cache.Entries(), 2);
+  EXPECT_EQ(6u, stats.models);
+  EXPECT_EQ(3u, stats.worlds);
+  EXPECT_EQ(9u, stats.files);
+  EXPECT_EQ(9u * 21u, stats.bytes);
+  EXPECT_EQ(6u * 21u, stats.bytesPerServer["localhost:8001"]);
+  EXPECT_EQ(3u * 21u, stats.bytesPerServer["localhost:8007"]);
+  EXPECT_EQ(2u * 21u, stats.bytesPerOwner["localhost:8001/alice"]);
+  EXPECT_EQ(2u, stats.largest.size());
+
+  // All files have the same content
+  EXPECT_EQ(8u * 21u, stats.duplicateBytes);
+}
+
+/////////////////////////////////////////////////
+TEST(LocalCache, Prune)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+  createLocal6Models(conf);
+
+  // Older versions of am1
+  for (auto version : {"1", "3"})
+  {
+    std::string dir = std::string("test_cache/localhost:8001/alice/models/am1/")
+        + version;
+    common::createDirectories(dir);
+    common::copyFile("test_cache/localhost:8001/alice/models/am1/2/"
+        "model.config", dir + "/model.config");
+  }
+
+  ignition::fuel_tools::LocalCache cache(&conf);
+  ASSERT_EQ(8u, cache.Entries().size());
+
+  // Nothing is old enough
+  CachePruneOptions options;
+  options.maxAge = std::chrono::hours(24);
+  EXPECT_TRUE(cache.Prune(cache.Entries(), options).empty());
+
+  // Dry run doesn't remove anything
+  options = CachePruneOptions();
+  options.keepVersions = 1;
+  options.dryRun = true;
+  auto removed = cache.Prune(cache.Entries(), options);
+  ASSERT_EQ(2u, removed.size());
+  EXPECT_EQ(8u, cache.Entries().size());
+
+  // Keep only the latest version
+  options.dryRun = false;
+  removed = cache.Prune(cache.Entries(), options);
+  ASSERT_EQ(2u, removed.size());
+  EXPECT_EQ(1u, removed[0].version);
+  EXPECT_EQ(2u, removed[1].version);
+  EXPECT_FALSE(common::exists("test_cache/localhost:8001/alice/models/am1/1"));
+  EXPECT_TRUE(common::exists("test_cache/localhost:8001/alice/models/am1/3"));
+  EXPECT_EQ(6u, cache.Entries().size());
+
+  // Shrink the cache, removing resource directories which become empty
+  options = CachePruneOptions();
+  options.maxBytes = 2 * 21;
+  removed = cache.Prune(cache.Entries(), options);
+  EXPECT_EQ(4u, removed.size());
+  EXPECT_EQ(2u, cache.Entries().size());
+  EXPECT_FALSE(common::exists(removed[0].path));
+  EXPECT_FALSE(common::exists(common::parentPath(removed[0].path)));
+}
+
+/////////////////////////////////////////////////
+TEST(LocalCache, VerifyAndWarm)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+
+  // A valid model
+  std::string good = "test_cache/localhost:8001/alice/models/good/1";
+  common::createDirectories(good);
+  {
+    std::ofstream config(good + "/model.config");
+    config << "<?xml version=\"1.0\"?><model><name>good</name>"
+           << "<sdf version=\"1.5\">old.sdf</sdf>"
+           << "<sdf version=\"1.6\">model.sdf</sdf></model>";
+    std::ofstream sdf(good + "/model.sdf");
+    sdf << "<?xml version=\"1.0\"?><sdf version=\"1.6\"></sdf>";
+  }
+
+  // Missing SDF file
+  std::string noSdf = "test_cache/localhost:8001/alice/models/noSdf/1";
+  common::createDirectories(noSdf);
+  common::copyFile(good + "/model.config", noSdf + "/model.config");
+
+  // Interrupted download
+  std::string zip = "test_cache/localhost:8001/bob/models/zip/1";
+  common::createDirectories(zip);
+  common::copyFile(good + "/model.config", zip + "/model.config");
+  common::copyFile(good + "/model.sdf", zip + "/model.sdf");
+  std::ofstream(zip + "/zip.zip") << "zip";
+
+  // Empty world
+  common::createDirectories("test_cache/localhost:8001/bob/worlds/empty/1");
+
+  ignition::fuel_tools::LocalCache cache(&conf);
+  auto entries = cache.Entries();
+  ASSERT_EQ(4u, entries.size());
+
+  auto issues = cache.Verify(entries, 2);
+  ASSERT_EQ(3u, issues.size());
+
+  std::set<std::string> reasons;
+  for (const auto &issue : issues)
+    reasons.insert(issue.reason);
+  EXPECT_NE(reasons.end(), reasons.find("Missing SDF file"));
+  EXPECT_NE(reasons.end(), reasons.find("Empty directory"));
+  EXPECT_NE(reasons.end(), reasons.find(
+      "Leftover archive, the download may have been interrupted"));
+
+  // Warm reads every byte
+  uint64_t bytes{0};
+  for (const auto &entry : entries)
+    bytes += entry.bytes;
+  EXPECT_EQ(bytes, cache.Warm(entries, 2));
+  EXPECT_EQ(0u, cache.Warm({}));
+}
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
 }
+
+/////////////////////////////////////////////////
+TEST(LocalCache, PartialModel)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+  createLocal6Models(conf);
+
+  ignition::fuel_tools::LocalCache cache(&conf);
+
+  ModelIdentifier id;
+  id.SetServer(conf.Servers().back());
+  id.SetOwner("alice");
+  id.SetName("am1");
+  id.SetVersion(3);
+
+  // Incomplete identifier or path outside of the model
+  EXPECT_FALSE(cache.SaveModelFile(ModelIdentifier(), "a.dae", "data"));
+  EXPECT_FALSE(cache.SaveModelFile(id, "../../am2/1/a.dae", "data"));
+  EXPECT_FALSE(cache.SaveModelFile(id, "/tmp/a.dae", "data"));
+  EXPECT_FALSE(cache.SaveModelFile(id, "meshes\\..\\a.dae", "data"));
+  EXPECT_FALSE(cache.SaveModelFile(id, "meshes//a.dae", "data"));
+  EXPECT_FALSE(cache.SaveModelFile(id, "./a.dae", "data"));
+
+  // Version 3 only has some files
+  EXPECT_TRUE(cache.SaveModelFile(id, "meshes/a.dae", "mesh"));
+  EXPECT_TRUE(cache.SaveModelFile(id, "model.config", "<model/>"));
+
+  std::string dir = "test_cache/localhost:8001/alice/models/am1/3";
+  EXPECT_TRUE(common::isFile(common::joinPaths(dir, "meshes", "a.dae")));
+
+  // Partial models aren't matched, so the tip is still version 2
+  ModelIdentifier tipId = id;
+  tipId.SetVersionStr("tip");
+  EXPECT_EQ(2u, cache.MatchingModel(tipId).Identification().Version());
+  EXPECT_FALSE(cache.MatchingModel(id));
+
+  // But their files are
+  EXPECT_EQ(common::cwd() + "/" + dir + "/meshes/a.dae",
+      cache.MatchingPartialModelFile(id, "meshes/a.dae"));
+  EXPECT_EQ(common::cwd() + "/" + dir + "/meshes/a.dae",
+      cache.MatchingPartialModelFile(tipId, "meshes/a.dae"));
+  EXPECT_TRUE(cache.MatchingPartialModelFile(id, "meshes/b.dae").empty());
+
+  // Files of complete models aren't partial
+  id.SetVersion(2);
+  EXPECT_TRUE(cache.MatchingPartialModelFile(id, "model.config").empty());
+
+  std::vector<CacheEntry> partial;
+  for (const auto &entry : cache.Entries())
+  {
+    if (entry.partial)
+      partial.push_back(entry);
+  }
+  ASSERT_EQ(1u, partial.size());
+  EXPECT_EQ(3u, partial[0].version);
+
+  // Partial models aren't verified as complete ones
+  EXPECT_TRUE(cache.Verify(partial).empty());
+}
+
+/////////////////////////////////////////////////
+TEST(LocalCache, SaveModelDelta)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+  createLocal6Models(conf);
+
+  ignition::fuel_tools::LocalCache cache(&conf);
+
+  ModelIdentifier id;
+  id.SetServer(conf.Servers().back());
+  id.SetOwner("alice");
+  id.SetName("am1");
+  id.SetVersion(3);
+
+  std::string am1 = common::cwd() + "/test_cache/localhost:8001/alice/"
+      "models/am1";
+  std::map<std::string, std::string> files{{"meshes/a.dae", "mesh"}};
+
+  // Paths outside of the model
+  for (const std::string path : {"../am2/1/model.config", "/tmp/a.dae",
+      "meshes\\a.dae", "meshes//a.dae", "./model.config", ""})
+  {
+    EXPECT_FALSE(cache.SaveModelDelta(id, am1 + "/2", {path}, files, ""))
+        << path;
+    EXPECT_FALSE(cache.SaveModelDelta(id, am1 + "/2", {"model.config"},
+        {{path, "data"}}, "")) << path;
+  }
+  EXPECT_FALSE(common::exists(am1 + "/3"));
+  EXPECT_FALSE(common::exists(am1 + "/.3.delta"));
+
+  // Versions saved from a delta have no archive, but a tree hash which
+  // depends on the changes
+  ASSERT_TRUE(cache.SaveModelDelta(id, am1 + "/2", {"model.config"}, files,
+      ""));
+  EXPECT_EQ("mesh", readFile(am1 + "/3/meshes/a.dae"));
+  EXPECT_TRUE(cache.ArchiveHash(am1 + "/3").empty());
+  std::string hash3 = readFile(am1 + "/3/.tree_hash");
+  EXPECT_EQ(0u, hash3.find("fnv1a64:"));
+
+  id.SetVersion(4);
+  files["meshes/a.dae"] = "other mesh";
+  ASSERT_TRUE(cache.SaveModelDelta(id, am1 + "/2", {"model.config"}, files,
+      ""));
+  std::string hash4 = readFile(am1 + "/4/.tree_hash");
+  EXPECT_FALSE(hash4.empty());
+  EXPECT_NE(hash3, hash4);
+}
+
+/////////////////////////////////////////////////
+/// \brief Collects the events of a cache subscription.
+class EventLog
+{
+  /// \brief Record an event.
+  /// \param[in] _event The event.
+  public: void Add(const CacheEvent &_event)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->events.push_back(_event);
+    this->cv.notify_all();
+  }
+
+  /// \brief Wait until a number of events were recorded.
+  /// \param[in] _count Number of events.
+  /// \param[in] _timeout How long to wait at most.
+  /// \return The events recorded.
+  public: std::vector<CacheEvent> Wait(size_t _count,
+      std::chrono::milliseconds _timeout = std::chrono::seconds(5))
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->cv.wait_for(lock, _timeout,
+        [&]{return this->events.size() >= _count;});
+    return this->events;
+  }
+
+  /// \brief Forget the events recorded.
+  public: void Clear()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->events.clear();
+  }
+
+  /// \brief Protects the events.
+  private: std::mutex mutex;
+
+  /// \brief Signaled when an event is recorded.
+  private: std::condition_variable cv;
+
+  /// \brief Events recorded.
+  private: std::vector<CacheEvent> events;
+};
+
+/////////////////////////////////////////////////
+TEST(LocalCache, Subscribe)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+  createLocal6Models(conf);
+
+  ignition::fuel_tools::LocalCache cache(&conf);
+  EXPECT_FALSE(cache.Watching());
+
+  EventLog log;
+  auto id = cache.Subscribe([&log](const CacheEvent &_event)
+      {
+        log.Add(_event);
+      });
+#ifdef __linux__
+  EXPECT_TRUE(cache.Watching());
+#endif
+
+  std::map<std::string, std::string> files{
+      {"model.config",
+       "<model><sdf version=\"1.6\">model.sdf</sdf></model>"},
+      {"model.sdf", "<sdf version=\"1.6\"><model name=\"m\"/></sdf>"}};
+  std::string am1 = common::cwd() + "/test_cache/localhost:8001/alice/"
+      "models/am1";
+
+  // Changes made through the cache are reported once, by the saving thread
+  ModelIdentifier id3;
+  id3.SetServer(conf.Servers().back());
+  id3.SetOwner("alice");
+  id3.SetName("am1");
+  id3.SetVersion(3);
+  ASSERT_TRUE(cache.SaveModelDelta(id3, am1 + "/2", {}, files, ""));
+
+  auto events = log.Wait(1);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(CacheEventType::INSTALLED, events[0].type);
+  EXPECT_FALSE(events[0].external);
+  EXPECT_EQ("localhost:8001", events[0].entry.server);
+  EXPECT_EQ("alice", events[0].entry.owner);
+  EXPECT_EQ("models", events[0].entry.type);
+  EXPECT_EQ("am1", events[0].entry.name);
+  EXPECT_EQ(3u, events[0].entry.version);
+  EXPECT_EQ(1u, log.Wait(2, std::chrono::milliseconds(500)).size());
+  log.Clear();
+
+  CachePruneOptions options;
+  options.keepVersions = 1;
+  auto removed = cache.Prune(cache.Entries(), options);
+  ASSERT_EQ(1u, removed.size());
+  events = log.Wait(1);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(CacheEventType::REMOVED, events[0].type);
+  EXPECT_EQ(2u, events[0].entry.version);
+  EXPECT_FALSE(events[0].external);
+  log.Clear();
+
+#ifdef __linux__
+  // Changes made elsewhere are noticed by watching the cache directory
+  ignition::fuel_tools::LocalCache other(&conf);
+  ModelIdentifier id4 = id3;
+  id4.SetVersion(4);
+  ASSERT_TRUE(other.SaveModelDelta(id4, am1 + "/3", {}, files, ""));
+
+  events = log.Wait(1);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(CacheEventType::INSTALLED, events[0].type);
+  EXPECT_TRUE(events[0].external);
+  EXPECT_EQ(4u, events[0].entry.version);
+  EXPECT_EQ(am1 + "/4", events[0].entry.path);
+  log.Clear();
+
+  // Including new owners
+  common::createDirectories("test_cache/localhost:8001/carol/models/cm1/1");
+  std::ofstream(
+      "test_cache/localhost:8001/carol/models/cm1/1/model.config")
+      << "<model/>";
+  events = log.Wait(1);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ("carol", events[0].entry.owner);
+  log.Clear();
+
+  EXPECT_TRUE(common::removeAll(am1 + "/4"));
+  events = log.Wait(1);
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(CacheEventType::REMOVED, events[0].type);
+  EXPECT_TRUE(events[0].external);
+  EXPECT_EQ(4u, events[0].entry.version);
+  log.Clear();
+
+  // Leftovers of interrupted updates aren't versions
+  common::createDirectories(am1 + "/.5.delta");
+  std::ofstream(am1 + "/.5.delta/model.config") << "<model/>";
+  common::removeAll(am1 + "/.5.delta");
+  EXPECT_TRUE(log.Wait(1, std::chrono::milliseconds(500)).empty());
+
+  // Neither are numbers too large for a version
+  common::createDirectories(am1 + "/99999999999999999999");
+  std::ofstream(am1 + "/99999999999999999999/model.config") << "<model/>";
+  EXPECT_TRUE(log.Wait(1, std::chrono::milliseconds(500)).empty());
+  common::removeAll(am1 + "/99999999999999999999");
+#endif
+
+  EXPECT_TRUE(cache.Unsubscribe(id));
+  EXPECT_FALSE(cache.Unsubscribe(id));
+  common::removeAll("test_cache/localhost:8001/bob");
+  EXPECT_TRUE(log.Wait(1, std::chrono::milliseconds(500)).empty());
+}
+
+/////////////////////////////////////////////////
+TEST(LocalCache, HotTier)
+{
+  ASSERT_EQ(0, ChangeDirectory(PROJECT_BINARY_PATH));
+  common::removeAll("test_cache");
+  common::removeAll("test_hot_cache");
+  common::createDirectories("test_cache");
+  ClientConfig conf;
+  conf.SetCacheLocation(common::cwd() + "/test_cache");
+  createLocal6Models(conf);
+
+  ModelIdentifier id;
+  id.SetServer(conf.Servers().back());
+  id.SetOwner("alice");
+  id.SetName("am1");
+  id.SetVersion(2);
+  std::string coldDir = common::cwd() +
+      "/test_cache/localhost:8001/alice/models/am1/2";
+  std::string copies = common::cwd() +
+      "/test_hot_cache/localhost:8001/alice/models/am1";
+
+  // Copies are checked by the hash recorded when saving a version
+  std::ofstream(common::joinPaths(coldDir, ".archive_hash")) << "h1";
+
+  // A single tier by default
+  {
+    ignition::fuel_tools::LocalCache cache(&conf);
+    EXPECT_EQ(coldDir, cache.MatchingModel(id).PathToModel());
+    EXPECT_EQ(0u, cache.TierStats().coldHits);
+  }
+
+  conf.SetHotCacheLocation(common::cwd() + "/test_hot_cache");
+  conf.SetHotCachePromotion(2);
+  ignition::fuel_tools::LocalCache cache(&conf);
+
+  EXPECT_EQ(coldDir, cache.MatchingModel(id).PathToModel());
+  EXPECT_EQ(coldDir, cache.MatchingModel(id).PathToModel());
+  cache.WaitForTiers();
+  std::string hotDir = cache.MatchingModel(id).PathToModel();
+  EXPECT_EQ(copies, common::parentPath(common::parentPath(hotDir)));
+  EXPECT_EQ("2", common::basename(hotDir));
+  EXPECT_TRUE(common::exists(common::joinPaths(hotDir, "model.config")));
+
+  // Lookups for the cache's own use aren't counted
+  EXPECT_EQ(coldDir, cache.MatchingColdModel(id).PathToModel());
+
+  auto stats = cache.TierStats();
+  EXPECT_EQ(1u, stats.hotHits);
+  EXPECT_EQ(2u, stats.coldHits);
+  EXPECT_EQ(1u, stats.promotions);
+  EXPECT_EQ(1u, stats.hotEntries);
+  EXPECT_EQ(0u, stats.retiredBytes);
+
+  // Lookups of the tip look through the cache directory, then use the copy
+  ModelIdentifier tipId = id;
+  tipId.SetVersionStr("tip");
+  EXPECT_EQ(hotDir, cache.MatchingModel(tipId).PathToModel());
+  EXPECT_EQ(2u, cache.TierStats().hotHits);
+
+  // Removing a version retires its copy, which was handed out so stays in
+  // place
+  std::vector<CacheEntry> entries;
+  for (const auto &entry : cache.Entries())
+  {
+    if (entry.name == "am1")
+      entries.push_back(entry);
+  }
+  CachePruneOptions options;
+  options.maxBytes = 1;
+  EXPECT_EQ(1u, cache.Prune(entries, options).size());
+  EXPECT_TRUE(common::exists(common::joinPaths(hotDir, "model.config")));
+  EXPECT_TRUE(common::exists(common::joinPaths(common::parentPath(hotDir),
+      ".retired")));
+  EXPECT_EQ(0u, cache.TierStats().hotEntries);
+  EXPECT_LT(0u, cache.TierStats().retiredBytes);
+
+  common::removeAll("test_hot_cache");
+}
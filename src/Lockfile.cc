@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <json/json.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+#include <ignition/common/Util.hh>
+
+#include "ignition/fuel_tools/Lockfile.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Version of the lockfile format.
+static const unsigned int kLockfileVersion = 1;
+
+/// \brief Private data class
+class ignition::fuel_tools::LockfilePrivate
+{
+  /// \brief Key of a resource.
+  /// \param[in] _server Server URL.
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type Resource type.
+  /// \param[in] _name Resource name.
+  /// \return Key, unique per resource. Owners and names are case
+  /// insensitive on Fuel servers.
+  public: static std::string Key(const std::string &_server,
+      const std::string &_owner, const std::string &_type,
+      const std::string &_name)
+  {
+    return _server + "\n" + common::lowercase(_owner) + "\n" + _type + "\n" +
+        common::lowercase(_name);
+  }
+
+  /// \brief Entries, by key.
+  public: std::map<std::string, LockEntry> entries;
+};
+
+//////////////////////////////////////////////////
+Lockfile::Lockfile()
+  : dataPtr(new LockfilePrivate)
+{
+}
+
+//////////////////////////////////////////////////
+Lockfile::Lockfile(const Lockfile &_orig)
+  : dataPtr(new LockfilePrivate)
+{
+  *(this->dataPtr) = *(_orig.dataPtr);
+}
+
+//////////////////////////////////////////////////
+Lockfile &Lockfile::operator=(const Lockfile &_orig)
+{
+  *(this->dataPtr) = *(_orig.dataPtr);
+  return *this;
+}
+
+//////////////////////////////////////////////////
+Lockfile::~Lockfile()
+{
+}
+
+//////////////////////////////////////////////////
+bool Lockfile::Load(const std::string &_path)
+{
+  std::ifstream in(_path);
+  if (!in.is_open())
+  {
+    ignerr << "Unable to open lockfile [" << _path << "]" << std::endl;
+    return false;
+  }
+
+  Json::CharReaderBuilder builder;
+  Json::Value root;
+  std::string errors;
+  if (!Json::parseFromStream(builder, in, &root, &errors) ||
+      !root.isObject() || !root["resources"].isArray())
+  {
+    ignerr << "Unable to parse lockfile [" << _path << "]: " << errors
+           << std::endl;
+    return false;
+  }
+
+  if (root["lockfile_version"].asUInt() > kLockfileVersion)
+  {
+    ignerr << "Lockfile [" << _path << "] has version ["
+           << root["lockfile_version"].asUInt() << "], but only version ["
+           << kLockfileVersion << "] is supported" << std::endl;
+    return false;
+  }
+
+  this->dataPtr->entries.clear();
+  for (const auto &value : root["resources"])
+  {
+    LockEntry entry;
+    entry.url = value["url"].asString();
+    entry.server = value["server"].asString();
+    entry.owner = value["owner"].asString();
+    entry.type = value["type"].asString();
+    entry.name = value["name"].asString();
+    entry.version = value["version"].asUInt();
+    entry.hash = value["hash"].asString();
+
+    if (entry.server.empty() || entry.owner.empty() || entry.name.empty() ||
+        (entry.type != "models" && entry.type != "worlds") ||
+        entry.version == 0)
+    {
+      ignwarn << "Skipping invalid entry [" << entry.url << "] of lockfile ["
+              << _path << "]" << std::endl;
+      continue;
+    }
+    this->Set(entry);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Lockfile::Save(const std::string &_path) const
+{
+  Json::Value root(Json::objectValue);
+  root["lockfile_version"] = kLockfileVersion;
+  Json::Value &resources = root["resources"];
+  resources = Json::Value(Json::arrayValue);
+  for (const auto &entry : this->Entries())
+  {
+    Json::Value value(Json::objectValue);
+    value["url"] = entry.url;
+    value["server"] = entry.server;
+    value["owner"] = entry.owner;
+    value["type"] = entry.type;
+    value["name"] = entry.name;
+    value["version"] = entry.version;
+    value["hash"] = entry.hash;
+    resources.append(value);
+  }
+
+  std::string tmpPath = _path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::trunc);
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    out << Json::writeString(builder, root) << std::endl;
+    out.close();
+    if (!out)
+    {
+      ignerr << "Unable to write lockfile [" << tmpPath << "]" << std::endl;
+      common::removeFile(tmpPath);
+      return false;
+    }
+  }
+
+  if (!common::moveFile(tmpPath, _path))
+  {
+    ignerr << "Unable to write lockfile [" << _path << "]" << std::endl;
+    common::removeFile(tmpPath);
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Lockfile::Set(const LockEntry &_entry)
+{
+  this->dataPtr->entries[LockfilePrivate::Key(_entry.server, _entry.owner,
+      _entry.type, _entry.name)] = _entry;
+}
+
+//////////////////////////////////////////////////
+bool Lockfile::Find(const std::string &_server, const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    LockEntry &_entry) const
+{
+  auto it = this->dataPtr->entries.find(
+      LockfilePrivate::Key(_server, _owner, _type, _name));
+  if (it == this->dataPtr->entries.end())
+    return false;
+
+  _entry = it->second;
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::vector<LockEntry> Lockfile::Entries() const
+{
+  std::vector<LockEntry> result;
+  for (const auto &entry : this->dataPtr->entries)
+    result.push_back(entry.second);
+  return result;
+}
+
+//////////////////////////////////////////////////
+size_t Lockfile::Size() const
+{
+  return this->dataPtr->entries.size();
+}
+
+//////////////////////////////////////////////////
+std::string Lockfile::Hash(const std::string &_data)
+{
+  // 64-bit FNV-1a, as used by 'ign fuel cache stats' to find duplicates.
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : _data)
+  {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx",
+      static_cast<unsigned long long>(hash));
+  return std::string("fnv1a64:") + hex;
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/FuelClient.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/Lockfile.hh"
+#include "ignition/fuel_tools/WorldIdentifier.hh"
+#include "ignition/fuel_tools/Zip.hh"
+
+#include "HttpServer.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+/// \brief Create a lock entry.
+LockEntry makeEntry(const std::string &_server, const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    unsigned int _version, const std::string &_hash = "")
+{
+  LockEntry entry;
+  entry.url = _server + "/1.0/" + _owner + "/" + _type + "/" + _name;
+  entry.server = _server;
+  entry.owner = _owner;
+  entry.type = _type;
+  entry.name = _name;
+  entry.version = _version;
+  entry.hash = _hash;
+  return entry;
+}
+
+/////////////////////////////////////////////////
+TEST(Lockfile, SetFind)
+{
+  Lockfile lockfile;
+  EXPECT_EQ(0u, lockfile.Size());
+
+  const std::string server = "https://fuel.ignitionrobotics.org";
+  lockfile.Set(makeEntry(server, "OpenRobotics", "models", "Ambulance", 2));
+  lockfile.Set(makeEntry(server, "openrobotics", "worlds", "Ambulance", 1));
+  EXPECT_EQ(2u, lockfile.Size());
+
+  // Owners and names are case insensitive, types aren't mixed up.
+  LockEntry entry;
+  ASSERT_TRUE(lockfile.Find(server, "openrobotics", "models", "ambulance",
+      entry));
+  EXPECT_EQ(2u, entry.version);
+  EXPECT_EQ("OpenRobotics", entry.owner);
+  ASSERT_TRUE(lockfile.Find(server, "openrobotics", "worlds", "Ambulance",
+      entry));
+  EXPECT_EQ(1u, entry.version);
+  EXPECT_FALSE(lockfile.Find("https://other.org", "openrobotics", "models",
+      "Ambulance", entry));
+  EXPECT_FALSE(lockfile.Find(server, "openrobotics", "models", "Car",
+      entry));
+
+  // Setting the same resource replaces it.
+  lockfile.Set(makeEntry(server, "openrobotics", "models", "AMBULANCE", 3));
+  EXPECT_EQ(2u, lockfile.Size());
+  ASSERT_TRUE(lockfile.Find(server, "openrobotics", "models", "Ambulance",
+      entry));
+  EXPECT_EQ(3u, entry.version);
+
+  // Copies are independent.
+  Lockfile copy(lockfile);
+  copy.Set(makeEntry(server, "openrobotics", "models", "Car", 1));
+  EXPECT_EQ(3u, copy.Size());
+  EXPECT_EQ(2u, lockfile.Size());
+}
+
+/////////////////////////////////////////////////
+TEST(Lockfile, SaveLoad)
+{
+  std::string path = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_lockfile.json");
+  common::removeFile(path);
+
+  const std::string server = "https://fuel.ignitionrobotics.org";
+  Lockfile lockfile;
+  lockfile.Set(makeEntry(server, "openrobotics", "worlds", "Empty", 4,
+      Lockfile::Hash("world")));
+  lockfile.Set(makeEntry(server, "openrobotics", "models", "Ambulance", 2,
+      Lockfile::Hash("model")));
+  ASSERT_TRUE(lockfile.Save(path));
+  EXPECT_FALSE(common::exists(path + ".tmp"));
+
+  Lockfile loaded;
+  ASSERT_TRUE(loaded.Load(path));
+  auto entries = loaded.Entries();
+  ASSERT_EQ(2u, entries.size());
+  EXPECT_EQ("models", entries[0].type);
+  EXPECT_EQ("Ambulance", entries[0].name);
+  EXPECT_EQ(2u, entries[0].version);
+  EXPECT_EQ(Lockfile::Hash("model"), entries[0].hash);
+  EXPECT_EQ(server + "/1.0/openrobotics/models/Ambulance", entries[0].url);
+  EXPECT_EQ("worlds", entries[1].type);
+  EXPECT_EQ(4u, entries[1].version);
+
+  EXPECT_FALSE(loaded.Load(path + ".missing"));
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+TEST(Lockfile, Invalid)
+{
+  std::string path = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_lockfile_invalid.json");
+
+  {
+    std::ofstream out(path);
+    out << "not json";
+  }
+  Lockfile lockfile;
+  EXPECT_FALSE(lockfile.Load(path));
+
+  {
+    std::ofstream out(path);
+    out << "{\"lockfile_version\": 99, \"resources\": []}";
+  }
+  EXPECT_FALSE(lockfile.Load(path));
+
+  // Invalid entries are skipped.
+  {
+    std::ofstream out(path);
+    out << "{\"lockfile_version\": 1, \"resources\": ["
+        << "{\"server\": \"https://a.org\", \"owner\": \"o\","
+        << " \"type\": \"models\", \"name\": \"m\", \"version\": 1},"
+        << "{\"server\": \"https://a.org\", \"owner\": \"o\","
+        << " \"type\": \"models\", \"name\": \"n\", \"version\": 0},"
+        << "{\"server\": \"https://a.org\", \"owner\": \"o\","
+        << " \"type\": \"scenes\", \"name\": \"m\", \"version\": 1}]}";
+  }
+  ASSERT_TRUE(lockfile.Load(path));
+  EXPECT_EQ(1u, lockfile.Size());
+
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+TEST(Lockfile, Hash)
+{
+  // FNV-1a 64 test vectors.
+  EXPECT_EQ("fnv1a64:cbf29ce484222325", Lockfile::Hash(""));
+  EXPECT_EQ("fnv1a64:af63dc4c8601ec8c", Lockfile::Hash("a"));
+  EXPECT_NE(Lockfile::Hash("ab"), Lockfile::Hash("ba"));
+}
+
+/////////////////////////////////////////////////
+TEST(Lockfile, Pin)
+{
+  ClientConfig config;
+  config.SetLockfilePath("");
+  FuelClient client(config);
+
+  const std::string server = "https://fuel.ignitionrobotics.org";
+  Lockfile lockfile;
+  lockfile.Set(makeEntry(server, "openrobotics", "models", "Ambulance", 2));
+  lockfile.Set(makeEntry(server, "openrobotics", "worlds", "Empty", 5));
+  client.SetLockfile(lockfile);
+  EXPECT_EQ(2u, client.CurrentLockfile().Size());
+
+  // Unversioned and tip URLs resolve to the pinned version.
+  ModelIdentifier model;
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server + "/1.0/openrobotics/models/Ambulance"), model));
+  EXPECT_EQ(2u, model.Version());
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server + "/1.0/OpenRobotics/models/ambulance/tip"), model));
+  EXPECT_EQ(2u, model.Version());
+
+  // Explicit versions win.
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server + "/1.0/openrobotics/models/Ambulance/1"), model));
+  EXPECT_EQ(1u, model.Version());
+
+  // Resources which aren't pinned resolve to the tip.
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server + "/1.0/openrobotics/models/Car"), model));
+  EXPECT_EQ(0u, model.Version());
+
+  WorldIdentifier world;
+  ASSERT_TRUE(client.ParseWorldUrl(common::URI(
+      server + "/1.0/openrobotics/worlds/Empty"), world));
+  EXPECT_EQ(5u, world.Version());
+
+  client.SetLockfile(Lockfile());
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server + "/1.0/openrobotics/models/Ambulance"), model));
+  EXPECT_EQ(0u, model.Version());
+}
+
+#ifndef _WIN32
+/////////////////////////////////////////////////
+TEST(Lockfile, VerifyDownload)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_lockfile_download");
+  common::removeAll(root);
+
+  std::string modelDir = common::joinPaths(root, "am1");
+  common::createDirectories(modelDir);
+  {
+    std::ofstream out(common::joinPaths(modelDir, "model.config"));
+    out << "<?xml version=\"1.0\"?><model><name>am1</name>"
+        << "<sdf version=\"1.6\">model.sdf</sdf></model>";
+  }
+  {
+    std::ofstream out(common::joinPaths(modelDir, "model.sdf"));
+    out << "<?xml version=\"1.0\"?><sdf version=\"1.6\">"
+        << "<model name=\"am1\"/></sdf>";
+  }
+  std::string archive = common::joinPaths(root, "am1.zip");
+  for (auto file : {"model.config", "model.sdf"})
+    Zip::Compress(common::joinPaths(modelDir, file), archive);
+
+  std::string data;
+  {
+    std::ifstream in(archive, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>());
+  }
+
+  HttpServer server([&archive](const HttpRequest &_request,
+      HttpResponse &_response)
+      {
+        if (_request.path == "/1.0/alice/models/am1/2/am1.zip")
+        {
+          _response.file = archive;
+          _response.headers["X-Ign-Resource-Version"] = "2";
+        }
+        else
+        {
+          _response.status = 404;
+        }
+      });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  ServerConfig serverConfig;
+  serverConfig.SetUrl(common::URI(server.Url()));
+  ClientConfig config;
+  config.SetCacheLocation(common::joinPaths(root, "cache"));
+  config.AddServer(serverConfig);
+  config.SetLockfilePath("");
+  FuelClient client(config);
+
+  std::string versionDir = common::joinPaths(root, "cache",
+      common::URI(server.Url()).Path().Str(), "alice", "models", "am1", "2");
+
+  // A mismatching hash is rejected, and nothing is cached.
+  Lockfile lockfile;
+  lockfile.Set(makeEntry(server.Url(), "alice", "models", "am1", 2,
+      Lockfile::Hash("something else")));
+  client.SetLockfile(lockfile);
+
+  ModelIdentifier model;
+  ASSERT_TRUE(client.ParseModelUrl(common::URI(
+      server.Url() + "/1.0/alice/models/am1"), model));
+  EXPECT_EQ(2u, model.Version());
+  EXPECT_EQ(ResultType::FETCH_ERROR, client.DownloadModel(model).Type());
+  EXPECT_FALSE(common::exists(versionDir));
+
+  // The matching hash is accepted, and stored next to the model.
+  lockfile.Set(makeEntry(server.Url(), "alice", "models", "am1", 2,
+      Lockfile::Hash(data)));
+  client.SetLockfile(lockfile);
+  EXPECT_EQ(ResultType::FETCH, client.DownloadModel(model).Type());
+  EXPECT_TRUE(common::exists(common::joinPaths(versionDir, "model.sdf")));
+  EXPECT_EQ(Lockfile::Hash(data), LocalCache(&config).ArchiveHash(versionDir));
+
+  common::removeAll(root);
+}
+#endif
@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/Metrics.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Kind of metric.
+enum class MetricType
+{
+  COUNTER,
+  GAUGE,
+  HISTOGRAM
+};
+
+/// \brief All the instances of a metric, one per label set.
+struct MetricFamily
+{
+  /// \brief Description.
+  std::string help;
+
+  /// \brief Kind of metric.
+  MetricType type;
+
+  /// \brief Counters, by serialized labels.
+  std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+
+  /// \brief Gauges, by serialized labels.
+  std::map<std::string, std::unique_ptr<MetricGauge>> gauges;
+
+  /// \brief Histograms, by serialized labels.
+  std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+};
+
+/// \brief Private data for MetricsRegistry.
+class ignition::fuel_tools::MetricsRegistryPrivate
+{
+  /// \brief Get or create a family, checking its type.
+  /// \param[in] _name Metric name.
+  /// \param[in] _help Description.
+  /// \param[in] _type Kind of metric.
+  /// \return The family, or null if the name is used by another kind of
+  /// metric.
+  public: MetricFamily *Family(const std::string &_name,
+      const std::string &_help, MetricType _type);
+
+  /// \brief Metric families, by name.
+  public: std::map<std::string, MetricFamily> families;
+
+  /// \brief Metrics which couldn't be registered, kept alive so callers
+  /// still get a valid reference.
+  public: std::list<MetricFamily> orphans;
+
+  /// \brief Protects families and orphans. Metrics themselves are updated
+  /// without it.
+  public: mutable std::mutex mutex;
+};
+
+//////////////////////////////////////////////////
+/// \brief Escape a label value or help text.
+/// \param[in] _str String.
+/// \param[in] _quotes Whether double quotes are escaped.
+/// \return Escaped string.
+static std::string escape(const std::string &_str, bool _quotes)
+{
+  std::string result;
+  for (char c : _str)
+  {
+    if (c == '\\')
+      result += "\\\\";
+    else if (c == '\n')
+      result += "\\n";
+    else if (c == '"' && _quotes)
+      result += "\\\"";
+    else
+      result += c;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+/// \brief Serialize labels, such as server="x",code="200".
+/// \param[in] _labels Labels.
+/// \return Serialized labels, without braces.
+static std::string serializeLabels(const MetricLabels &_labels)
+{
+  std::string result;
+  for (const auto &label : _labels)
+  {
+    result += (result.empty() ? "" : ",") + label.first + "=\"" +
+        escape(label.second, true) + "\"";
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+/// \brief Wrap serialized labels in braces.
+/// \param[in] _labels Serialized labels.
+/// \return Labels in braces, or empty if there are no labels.
+static std::string braces(const std::string &_labels)
+{
+  return _labels.empty() ? "" : "{" + _labels + "}";
+}
+
+//////////////////////////////////////////////////
+/// \brief Format a number for the Prometheus text format.
+/// \param[in] _value Number.
+/// \return Formatted number.
+static std::string formatNumber(double _value)
+{
+  if (std::isinf(_value))
+    return _value > 0 ? "+Inf" : "-Inf";
+  std::ostringstream out;
+  out.precision(15);
+  out << _value;
+  return out.str();
+}
+
+//////////////////////////////////////////////////
+void MetricCounter::Increment(uint64_t _value)
+{
+  this->value.fetch_add(_value, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+uint64_t MetricCounter::Value() const
+{
+  return this->value.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+void MetricGauge::Add(int64_t _value)
+{
+  this->value.fetch_add(_value, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+void MetricGauge::Set(int64_t _value)
+{
+  this->value.store(_value, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+int64_t MetricGauge::Value() const
+{
+  return this->value.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+MetricHistogram::MetricHistogram(const std::vector<double> &_bounds)
+  : bounds(_bounds),
+    buckets(new std::atomic<uint64_t>[_bounds.size() + 1])
+{
+  std::sort(this->bounds.begin(), this->bounds.end());
+  for (size_t i = 0; i <= this->bounds.size(); ++i)
+    this->buckets[i] = 0;
+}
+
+//////////////////////////////////////////////////
+void MetricHistogram::Observe(double _value)
+{
+  size_t index = std::lower_bound(this->bounds.begin(), this->bounds.end(),
+      _value) - this->bounds.begin();
+  this->buckets[index].fetch_add(1, std::memory_order_relaxed);
+  this->count.fetch_add(1, std::memory_order_relaxed);
+
+  double current = this->sum.load(std::memory_order_relaxed);
+  while (!this->sum.compare_exchange_weak(current, current + _value,
+        std::memory_order_relaxed))
+  {
+  }
+}
+
+//////////////////////////////////////////////////
+const std::vector<double> &MetricHistogram::Bounds() const
+{
+  return this->bounds;
+}
+
+//////////////////////////////////////////////////
+uint64_t MetricHistogram::BucketCount(size_t _index) const
+{
+  if (_index > this->bounds.size())
+    return 0;
+  return this->buckets[_index].load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+uint64_t MetricHistogram::Count() const
+{
+  return this->count.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+double MetricHistogram::Sum() const
+{
+  return this->sum.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+MetricsRegistry::MetricsRegistry()
+  : dataPtr(new MetricsRegistryPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+MetricsRegistry::~MetricsRegistry()
+{
+}
+
+//////////////////////////////////////////////////
+MetricsRegistry &MetricsRegistry::Global()
+{
+  // Intentionally leaked, so metrics can be updated while static objects
+  // are destroyed.
+  static auto *registry = new MetricsRegistry();
+  return *registry;
+}
+
+//////////////////////////////////////////////////
+const std::vector<double> &MetricsRegistry::DurationBuckets()
+{
+  static const std::vector<double> buckets{0.001, 0.005, 0.01, 0.025, 0.05,
+      0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+  return buckets;
+}
+
+//////////////////////////////////////////////////
+MetricFamily *MetricsRegistryPrivate::Family(const std::string &_name,
+    const std::string &_help, MetricType _type)
+{
+  auto it = this->families.find(_name);
+  if (it == this->families.end())
+  {
+    it = this->families.emplace(_name, MetricFamily()).first;
+    it->second.help = _help;
+    it->second.type = _type;
+  }
+
+  if (it->second.type != _type)
+  {
+    ignerr << "Metric [" << _name << "] is already registered with another "
+           << "type. It won't be exported." << std::endl;
+    this->orphans.emplace_back();
+    return nullptr;
+  }
+
+  return &it->second;
+}
+
+//////////////////////////////////////////////////
+MetricCounter &MetricsRegistry::Counter(const std::string &_name,
+    const std::string &_help, const MetricLabels &_labels)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto *family = this->dataPtr->Family(_name, _help, MetricType::COUNTER);
+  if (!family)
+    family = &this->dataPtr->orphans.back();
+
+  auto &metric = family->counters[serializeLabels(_labels)];
+  if (!metric)
+    metric.reset(new MetricCounter());
+  return *metric;
+}
+
+//////////////////////////////////////////////////
+MetricGauge &MetricsRegistry::Gauge(const std::string &_name,
+    const std::string &_help, const MetricLabels &_labels)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto *family = this->dataPtr->Family(_name, _help, MetricType::GAUGE);
+  if (!family)
+    family = &this->dataPtr->orphans.back();
+
+  auto &metric = family->gauges[serializeLabels(_labels)];
+  if (!metric)
+    metric.reset(new MetricGauge());
+  return *metric;
+}
+
+//////////////////////////////////////////////////
+MetricHistogram &MetricsRegistry::Histogram(const std::string &_name,
+    const std::string &_help, const std::vector<double> &_bounds,
+    const MetricLabels &_labels)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto *family = this->dataPtr->Family(_name, _help, MetricType::HISTOGRAM);
+  if (!family)
+    family = &this->dataPtr->orphans.back();
+
+  auto &metric = family->histograms[serializeLabels(_labels)];
+  if (!metric)
+    metric.reset(new MetricHistogram(_bounds));
+  return *metric;
+}
+
+//////////////////////////////////////////////////
+std::string MetricsRegistry::PrometheusText() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  std::ostringstream out;
+  for (const auto &entry : this->dataPtr->families)
+  {
+    const auto &name = entry.first;
+    const auto &family = entry.second;
+
+    out << "# HELP " << name << " " << escape(family.help, false) << "\n";
+    switch (family.type)
+    {
+      case MetricType::COUNTER:
+        out << "# TYPE " << name << " counter\n";
+        for (const auto &metric : family.counters)
+        {
+          out << name << braces(metric.first) << " "
+              << metric.second->Value() << "\n";
+        }
+        break;
+      case MetricType::GAUGE:
+        out << "# TYPE " << name << " gauge\n";
+        for (const auto &metric : family.gauges)
+        {
+          out << name << braces(metric.first) << " "
+              << metric.second->Value() << "\n";
+        }
+        break;
+      case MetricType::HISTOGRAM:
+        out << "# TYPE " << name << " histogram\n";
+        for (const auto &metric : family.histograms)
+        {
+          const auto &labels = metric.first;
+          const auto &histogram = *metric.second;
+          std::string prefix = labels.empty() ? "" : labels + ",";
+          uint64_t cumulative = 0;
+          for (size_t i = 0; i <= histogram.Bounds().size(); ++i)
+          {
+            cumulative += histogram.BucketCount(i);
+            double bound = i < histogram.Bounds().size() ?
+                histogram.Bounds()[i] : INFINITY;
+            out << name << "_bucket{" << prefix << "le=\""
+                << formatNumber(bound) << "\"} " << cumulative << "\n";
+          }
+          out << name << "_sum" << braces(labels) << " "
+              << formatNumber(histogram.Sum()) << "\n";
+          out << name << "_count" << braces(labels) << " "
+              << histogram.Count() << "\n";
+        }
+        break;
+    }
+  }
+  return out.str();
+}
+
+//////////////////////////////////////////////////
+bool MetricsRegistry::WritePrometheusText(const std::string &_path) const
+{
+  std::string tmpPath = _path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::trunc);
+    out << this->PrometheusText();
+    out.close();
+    if (!out)
+    {
+      ignerr << "Unable to write metrics to [" << tmpPath << "]"
+             << std::endl;
+      common::removeFile(tmpPath);
+      return false;
+    }
+  }
+
+  if (!common::moveFile(tmpPath, _path))
+  {
+    ignerr << "Unable to write metrics to [" << _path << "]" << std::endl;
+    common::removeFile(tmpPath);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/FuelClient.hh"
+#include "ignition/fuel_tools/Metrics.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+TEST(Metrics, Counter)
+{
+  MetricsRegistry registry;
+  auto &counter = registry.Counter("test_total", "Test counter.",
+      {{"kind", "a"}});
+  EXPECT_EQ(0u, counter.Value());
+
+  // The same name and labels return the same counter.
+  EXPECT_EQ(&counter, &registry.Counter("test_total", "", {{"kind", "a"}}));
+  EXPECT_NE(&counter, &registry.Counter("test_total", "", {{"kind", "b"}}));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&counter]()
+    {
+      for (int j = 0; j < 1000; ++j)
+        counter.Increment();
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(4000u, counter.Value());
+
+  counter.Increment(10);
+  EXPECT_EQ(4010u, counter.Value());
+}
+
+/////////////////////////////////////////////////
+TEST(Metrics, Gauge)
+{
+  MetricsRegistry registry;
+  auto &gauge = registry.Gauge("test_in_flight", "Test gauge.");
+  gauge.Add(3);
+  gauge.Add(-1);
+  EXPECT_EQ(2, gauge.Value());
+  gauge.Set(-5);
+  EXPECT_EQ(-5, gauge.Value());
+}
+
+/////////////////////////////////////////////////
+TEST(Metrics, Histogram)
+{
+  MetricsRegistry registry;
+  auto &histogram = registry.Histogram("test_seconds", "Test histogram.",
+      {0.1, 1.0});
+  histogram.Observe(0.05);
+  histogram.Observe(0.1);
+  histogram.Observe(0.5);
+  histogram.Observe(7.0);
+
+  ASSERT_EQ(2u, histogram.Bounds().size());
+  EXPECT_EQ(2u, histogram.BucketCount(0));
+  EXPECT_EQ(1u, histogram.BucketCount(1));
+  EXPECT_EQ(1u, histogram.BucketCount(2));
+  EXPECT_EQ(4u, histogram.Count());
+  EXPECT_DOUBLE_EQ(7.65, histogram.Sum());
+
+  EXPECT_FALSE(MetricsRegistry::DurationBuckets().empty());
+}
+
+/////////////////////////////////////////////////
+TEST(Metrics, PrometheusText)
+{
+  MetricsRegistry registry;
+  EXPECT_TRUE(registry.PrometheusText().empty());
+
+  registry.Counter("test_requests_total", "Requests.",
+      {{"code", "200"}, {"server", "http://a\"b"}}).Increment(3);
+  registry.Gauge("test_in_flight", "In flight.").Set(2);
+  auto &histogram = registry.Histogram("test_seconds", "Durations.",
+      {0.5, 1.0}, {{"server", "s"}});
+  histogram.Observe(0.25);
+  histogram.Observe(2.0);
+
+  std::string text = registry.PrometheusText();
+  EXPECT_NE(std::string::npos, text.find(
+      "# HELP test_requests_total Requests.\n"
+      "# TYPE test_requests_total counter\n"
+      "test_requests_total{code=\"200\",server=\"http://a\\\"b\"} 3\n"))
+      << text;
+  EXPECT_NE(std::string::npos, text.find(
+      "# TYPE test_in_flight gauge\n"
+      "test_in_flight 2\n")) << text;
+  EXPECT_NE(std::string::npos, text.find(
+      "# TYPE test_seconds histogram\n"
+      "test_seconds_bucket{server=\"s\",le=\"0.5\"} 1\n"
+      "test_seconds_bucket{server=\"s\",le=\"1\"} 1\n"
+      "test_seconds_bucket{server=\"s\",le=\"+Inf\"} 2\n"
+      "test_seconds_sum{server=\"s\"} 2.25\n"
+      "test_seconds_count{server=\"s\"} 2\n")) << text;
+
+  // A name reused with another type gets a working metric, which is not
+  // exported.
+  registry.Gauge("test_requests_total", "Conflict.").Set(1);
+  EXPECT_EQ(text, registry.PrometheusText());
+
+  std::string path = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_metrics.prom");
+  common::removeFile(path);
+  EXPECT_TRUE(registry.WritePrometheusText(path));
+  std::ifstream in(path);
+  std::stringstream written;
+  written << in.rdbuf();
+  EXPECT_EQ(text, written.str());
+  common::removeFile(path);
+
+  EXPECT_FALSE(registry.WritePrometheusText(
+      common::joinPaths(path, "missing", "dir.prom")));
+}
+
+/////////////////////////////////////////////////
+TEST(Metrics, FuelClient)
+{
+  ClientConfig config;
+  config.SetCacheLocation(common::joinPaths(PROJECT_BINARY_PATH,
+      "test_cache_metrics"));
+  FuelClient client(config);
+  EXPECT_EQ(&MetricsRegistry::Global(), &client.Metrics());
+
+  auto &misses = client.Metrics().Counter("ign_fuel_cache_lookups_total", "",
+      {{"lookup", "model"}, {"result", "miss"}});
+  uint64_t before = misses.Value();
+
+  std::string path;
+  EXPECT_FALSE(client.CachedModel(common::URI(
+      "https://fuel.ignitionrobotics.org/1.0/alice/models/missing"), path));
+  EXPECT_EQ(before + 1, misses.Value());
+}
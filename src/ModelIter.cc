@@ -55,6 +55,16 @@ ModelIter ModelIterFactory::Create(const Rest &_rest,
   return ModelIter(std::move(priv));
 }
 
+//////////////////////////////////////////////////
+ModelIter ModelIterFactory::Create(
+    std::shared_ptr<const CatalogSnapshot> _snapshot,
+    const ServerConfig &_server)
+{
+  std::unique_ptr<ModelIterPrivate> priv(new IterSnapshot(
+    std::move(_snapshot), _server));
+  return ModelIter(std::move(priv));
+}
+
 //////////////////////////////////////////////////
 ModelIter ModelIterFactory::Create()
 {
@@ -141,6 +151,52 @@ bool IterModels::HasReachedEnd()
   return this->models.empty() || this->modelIter == this->models.end();
 }
 
+//////////////////////////////////////////////////
+IterSnapshot::IterSnapshot(std::shared_ptr<const CatalogSnapshot> _snapshot,
+    const ServerConfig &_server)
+  : snapshot(std::move(_snapshot)), server(_server)
+{
+  this->Load();
+}
+
+//////////////////////////////////////////////////
+IterSnapshot::~IterSnapshot()
+{
+}
+
+//////////////////////////////////////////////////
+void IterSnapshot::Load()
+{
+  if (!this->snapshot)
+    return;
+
+  std::shared_ptr<ModelPrivate> ptr(new ModelPrivate);
+  while (!this->HasReachedEnd() &&
+      !this->snapshot->At(this->index, ptr->id))
+  {
+    ++this->index;
+  }
+
+  if (!this->HasReachedEnd())
+  {
+    ptr->id.SetServer(this->server);
+    this->model = Model(ptr);
+  }
+}
+
+//////////////////////////////////////////////////
+void IterSnapshot::Next()
+{
+  ++this->index;
+  this->Load();
+}
+
+//////////////////////////////////////////////////
+bool IterSnapshot::HasReachedEnd()
+{
+  return !this->snapshot || this->index >= this->snapshot->Size();
+}
+
 //////////////////////////////////////////////////
 IterRestIds::~IterRestIds()
 {
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ignition/common/StringUtils.hh>
+
+#include "ignition/fuel_tools/ModelQuery.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Largest page the server is asked for.
+static const size_t kMaxPageSize = 100;
+
+/// \brief Private data class
+class ignition::fuel_tools::ModelQueryPrivate
+{
+  /// \brief Search text.
+  public: std::string text;
+
+  /// \brief Required tags.
+  public: std::vector<std::string> tags;
+
+  /// \brief Owner, or empty for any owner.
+  public: std::string owner;
+
+  /// \brief License, or empty for any license.
+  public: std::string license;
+
+  /// \brief Minimum modification date, or 0 for any date.
+  public: std::time_t modifiedSince = 0;
+
+  /// \brief Order of the results.
+  public: ModelSort sort = ModelSort::NONE;
+
+  /// \brief Maximum number of results, or 0 for no limit.
+  public: size_t limit = 0;
+};
+
+//////////////////////////////////////////////////
+/// \brief Percent-encode a query string value.
+/// \param[in] _value Value to encode.
+/// \return Encoded value.
+static std::string encode(const std::string &_value)
+{
+  std::string result;
+  for (char c : _value)
+  {
+    auto u = static_cast<unsigned char>(c);
+    if (std::isalnum(u) || c == '-' || c == '.' || c == '_' || c == '~')
+    {
+      result += c;
+    }
+    else
+    {
+      char escaped[4];
+      std::snprintf(escaped, sizeof(escaped), "%%%02X", u);
+      result += escaped;
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+ModelQuery::ModelQuery()
+  : dataPtr(new ModelQueryPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+ModelQuery::ModelQuery(const ModelQuery &_orig)
+  : dataPtr(new ModelQueryPrivate)
+{
+  *(this->dataPtr) = *(_orig.dataPtr);
+}
+
+//////////////////////////////////////////////////
+ModelQuery &ModelQuery::operator=(const ModelQuery &_orig)
+{
+  *(this->dataPtr) = *(_orig.dataPtr);
+  return *this;
+}
+
+//////////////////////////////////////////////////
+ModelQuery::~ModelQuery()
+{
+}
+
+//////////////////////////////////////////////////
+const std::string &ModelQuery::Text() const
+{
+  return this->dataPtr->text;
+}
+
+//////////////////////////////////////////////////
+void ModelQuery::SetText(const std::string &_text)
+{
+  this->dataPtr->text = _text;
+}
+
+//////////////////////////////////////////////////
+const std::vector<std::string> &ModelQuery::Tags() const
+{
+  return this->dataPtr->tags;
+}
+
+//////////////////////////////////////////////////
+void ModelQuery::SetTags(const std::vector<std::string> &_tags)
+{
+  this->dataPtr->tags = _tags;
+}
+
+//////////////////////////////////////////////////
+const std::string &ModelQuery::Owner() const
+{
+  return this->dataPtr->owner;
+}
+
+//////////////////////////////////////////////////
+void ModelQuery::SetOwner(const std::string &_owner)
+{
+  this->dataPtr->owner = _owner;
+}
+
+//////////////////////////////////////////////////
+const std::string &ModelQuery::License() const
+{
+  return this->dataPtr->license;
+}
+
+//////////////////////////////////////////////////
+void ModelQuery::SetLicense(const std::string &_license)
+{
+  this->dataPtr->license = _license;
+}
+
+//////////////////////////////////////////////////
+std::time_t ModelQuery::ModifiedSince() const
+{
+  return this->dataPtr->modifiedSince;
+}
+
+//////////////////////////////////////////////////
+void ModelQuery::SetModifiedSince(std::time_t _date)
+{
+  this->dataPtr->modifiedSince = _date;
+}
+
+//////////////////////////////////////////////////
+ModelSort ModelQuery::Sort() const
+{
+  return this->dataPtr->sort;
+}
+
+//////////////////////////////////////////////////
+void ModelQuery::SetSort(ModelSort _sort)
+{
+  this->dataPtr->sort = _sort;
+}
+
+//////////////////////////////////////////////////
+size_t ModelQuery::Limit() const
+{
+  return this->dataPtr->limit;
+}
+
+//////////////////////////////////////////////////
+void ModelQuery::SetLimit(size_t _limit)
+{
+  this->dataPtr->limit = _limit;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> ModelQuery::QueryStrings() const
+{
+  std::vector<std::string> result;
+
+  // Tags are searched as words, and checked exactly by Matches.
+  std::string search = this->dataPtr->text;
+  for (const auto &tag : this->dataPtr->tags)
+    search += " " + tag;
+  search = common::trimmed(search);
+  if (!search.empty())
+    result.push_back("q=" + encode(search));
+
+  switch (this->dataPtr->sort)
+  {
+    case ModelSort::DOWNLOADS:
+      result.push_back("order_by=downloads");
+      result.push_back("order=desc");
+      break;
+    case ModelSort::LIKES:
+      result.push_back("order_by=likes");
+      result.push_back("order=desc");
+      break;
+    case ModelSort::MODIFIED:
+      result.push_back("order_by=updated_at");
+      result.push_back("order=desc");
+      break;
+    case ModelSort::NAME:
+      result.push_back("order_by=name");
+      result.push_back("order=asc");
+      break;
+    case ModelSort::NONE:
+    default:
+      break;
+  }
+
+  if (this->dataPtr->limit > 0u)
+  {
+    result.push_back("per_page=" +
+        std::to_string(std::min(this->dataPtr->limit, kMaxPageSize)));
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+bool ModelQuery::Matches(const ModelIdentifier &_id) const
+{
+  if (!this->dataPtr->owner.empty() &&
+      common::lowercase(_id.Owner()) != common::lowercase(this->dataPtr->owner))
+  {
+    return false;
+  }
+
+  if (!this->dataPtr->license.empty() &&
+      common::lowercase(_id.LicenseName()) !=
+      common::lowercase(this->dataPtr->license))
+  {
+    return false;
+  }
+
+  if (this->dataPtr->modifiedSince > 0 &&
+      _id.ModifyDate() < this->dataPtr->modifiedSince)
+  {
+    return false;
+  }
+
+  std::vector<std::string> tags;
+  for (const auto &tag : _id.Tags())
+    tags.push_back(common::lowercase(common::trimmed(tag)));
+  for (const auto &tag : this->dataPtr->tags)
+  {
+    if (std::find(tags.begin(), tags.end(),
+        common::lowercase(common::trimmed(tag))) == tags.end())
+    {
+      return false;
+    }
+  }
+
+  std::string haystack = common::lowercase(_id.Name() + "\n" + _id.Owner() +
+      "\n" + _id.Description());
+  for (const auto &tag : tags)
+    haystack += "\n" + tag;
+  for (const auto &keyword : common::Split(this->dataPtr->text, ' '))
+  {
+    if (!keyword.empty() &&
+        haystack.find(common::lowercase(keyword)) == std::string::npos)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ModelQuery::Before(const ModelIdentifier &_a,
+    const ModelIdentifier &_b) const
+{
+  switch (this->dataPtr->sort)
+  {
+    case ModelSort::DOWNLOADS:
+      return _a.DownloadCount() > _b.DownloadCount();
+    case ModelSort::LIKES:
+      return _a.LikeCount() > _b.LikeCount();
+    case ModelSort::MODIFIED:
+      return _a.ModifyDate() > _b.ModifyDate();
+    case ModelSort::NAME:
+      return common::lowercase(_a.Name()) < common::lowercase(_b.Name());
+    case ModelSort::NONE:
+    default:
+      return false;
+  }
+}
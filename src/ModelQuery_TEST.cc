@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+#include "ignition/fuel_tools/ModelQuery.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+TEST(ModelQuery, QueryStrings)
+{
+  ModelQuery query;
+  EXPECT_TRUE(query.QueryStrings().empty());
+  EXPECT_EQ(ModelSort::NONE, query.Sort());
+  EXPECT_EQ(0u, query.Limit());
+
+  query.SetText("cordless drill");
+  query.SetTags({"power&tools"});
+  query.SetSort(ModelSort::DOWNLOADS);
+  query.SetLimit(500);
+  EXPECT_EQ(std::vector<std::string>({"q=cordless%20drill%20power%26tools",
+      "order_by=downloads", "order=desc", "per_page=100"}),
+      query.QueryStrings());
+
+  // The owner is part of the route, and the license and date are only
+  // checked locally.
+  ModelQuery other;
+  other.SetOwner("alice");
+  other.SetLicense("MIT");
+  other.SetModifiedSince(1000);
+  other.SetSort(ModelSort::NAME);
+  other.SetLimit(5);
+  EXPECT_EQ(std::vector<std::string>({"order_by=name", "order=asc",
+      "per_page=5"}), other.QueryStrings());
+
+  // Copies are independent.
+  ModelQuery copy(query);
+  query.SetText("");
+  EXPECT_EQ("cordless drill", copy.Text());
+  copy = other;
+  EXPECT_EQ("alice", copy.Owner());
+  EXPECT_EQ("MIT", copy.License());
+  EXPECT_EQ(1000, copy.ModifiedSince());
+}
+
+/////////////////////////////////////////////////
+TEST(ModelQuery, Matches)
+{
+  ModelIdentifier id;
+  id.SetOwner("Alice");
+  id.SetName("Cordless Drill");
+  id.SetDescription("A drill without a cord");
+  id.SetTags({"Tools", "power"});
+  id.SetLicenseName("MIT");
+  id.SetModifyDate(2000);
+
+  ModelQuery query;
+  EXPECT_TRUE(query.Matches(id));
+
+  query.SetText("DRILL  cord");
+  EXPECT_TRUE(query.Matches(id));
+  query.SetText("drill saw");
+  EXPECT_FALSE(query.Matches(id));
+  query.SetText("");
+
+  query.SetTags({"tools", "POWER"});
+  EXPECT_TRUE(query.Matches(id));
+  query.SetTags({"tool"});
+  EXPECT_FALSE(query.Matches(id));
+  query.SetTags({});
+
+  query.SetOwner("alice");
+  EXPECT_TRUE(query.Matches(id));
+  query.SetOwner("bob");
+  EXPECT_FALSE(query.Matches(id));
+  query.SetOwner("");
+
+  query.SetLicense("mit");
+  EXPECT_TRUE(query.Matches(id));
+  query.SetLicense("Apache 2.0");
+  EXPECT_FALSE(query.Matches(id));
+  query.SetLicense("");
+
+  query.SetModifiedSince(2000);
+  EXPECT_TRUE(query.Matches(id));
+  query.SetModifiedSince(2001);
+  EXPECT_FALSE(query.Matches(id));
+}
+
+/////////////////////////////////////////////////
+TEST(ModelQuery, Before)
+{
+  ModelIdentifier a;
+  a.SetName("apple");
+  a.SetDownloadCount(10);
+  a.SetLikeCount(1);
+  a.SetModifyDate(100);
+
+  ModelIdentifier b;
+  b.SetName("Banana");
+  b.SetDownloadCount(20);
+  b.SetLikeCount(1);
+  b.SetModifyDate(50);
+
+  ModelQuery query;
+  EXPECT_FALSE(query.Before(a, b));
+  EXPECT_FALSE(query.Before(b, a));
+
+  query.SetSort(ModelSort::DOWNLOADS);
+  EXPECT_TRUE(query.Before(b, a));
+  EXPECT_FALSE(query.Before(a, b));
+
+  query.SetSort(ModelSort::LIKES);
+  EXPECT_FALSE(query.Before(a, b));
+  EXPECT_FALSE(query.Before(b, a));
+
+  query.SetSort(ModelSort::MODIFIED);
+  EXPECT_TRUE(query.Before(a, b));
+
+  query.SetSort(ModelSort::NAME);
+  EXPECT_TRUE(query.Before(a, b));
+  EXPECT_FALSE(query.Before(b, a));
+}
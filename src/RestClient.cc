@@ -21,14 +21,19 @@
 #undef DELETE
 #endif
 
+#include <chrono>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include <ignition/common/Console.hh>
 
+#include "ignition/fuel_tools/Metrics.hh"
 #include "ignition/fuel_tools/RestClient.hh"
+#include "ignition/fuel_tools/Trace.hh"
 
 using namespace ignition;
 using namespace fuel_tools;
@@ -127,6 +132,135 @@ size_t RestWriteMemoryCallback(void *_buffer, size_t _size, size_t _nmemb,
   return _size;
 }
 
+/////////////////////////////////////////////////
+int RestTransferInfoCallback(void *_userp, curl_off_t _dlTotal,
+    curl_off_t _dlNow, curl_off_t /*_ulTotal*/, curl_off_t /*_ulNow*/)
+{
+  auto *callback = static_cast<RestTransferCallback *>(_userp);
+  bool proceed = (*callback)(static_cast<uint64_t>(_dlNow),
+      static_cast<uint64_t>(_dlTotal));
+  return proceed ? 0 : 1;
+}
+
+/////////////////////////////////////////////////
+/// \brief A curl easy handle for one request. Each thread keeps an easy
+/// handle alive between requests, so that consecutive requests to the same
+/// server reuse its open connections instead of connecting again. A nested
+/// request, issued while the thread handle is busy, gets its own handle.
+class CurlHandle
+{
+  /// \brief Constructor.
+  public: CurlHandle()
+  {
+    static thread_local ThreadHandle threadHandle;
+    if (threadHandle.curl && !threadHandle.busy)
+    {
+      threadHandle.busy = true;
+      curl_easy_reset(threadHandle.curl);
+      this->curl = threadHandle.curl;
+      this->owner = &threadHandle;
+    }
+    else
+    {
+      this->curl = curl_easy_init();
+    }
+  }
+
+  /// \brief Destructor. Returns the thread handle, or cleans up our own.
+  public: ~CurlHandle()
+  {
+    if (this->owner)
+      this->owner->busy = false;
+    else if (this->curl)
+      curl_easy_cleanup(this->curl);
+  }
+
+  /// \brief The handle of a thread.
+  private: struct ThreadHandle
+  {
+    ThreadHandle() : curl(curl_easy_init()) {}
+    ~ThreadHandle()
+    {
+      if (this->curl)
+        curl_easy_cleanup(this->curl);
+    }
+    CURL *curl = nullptr;
+    bool busy = false;
+  };
+
+  /// \brief The curl easy handle.
+  public: CURL *curl = nullptr;
+
+  /// \brief Thread handle lent to this request, if any.
+  private: ThreadHandle *owner = nullptr;
+};
+
+/////////////////////////////////////////////////
+/// \brief Metrics of the requests to one server.
+struct ServerMetrics
+{
+  /// \brief Request durations.
+  MetricHistogram *duration = nullptr;
+
+  /// \brief New connections.
+  MetricCounter *connections = nullptr;
+
+  /// \brief Bytes received.
+  MetricCounter *received = nullptr;
+
+  /// \brief Requests, by status code.
+  std::map<int, MetricCounter *> requests;
+};
+
+/////////////////////////////////////////////////
+/// \brief Get the metrics of a server. Looking metrics up in the registry
+/// takes its lock, so each thread keeps the ones of the servers it has
+/// talked to, which live as long as the registry.
+/// \param[in] _url Server URL.
+/// \return The metrics.
+static ServerMetrics &serverMetrics(const std::string &_url)
+{
+  static thread_local std::map<std::string, ServerMetrics> cache;
+  auto &result = cache[_url];
+  if (!result.duration)
+  {
+    auto &metrics = MetricsRegistry::Global();
+    result.duration = &metrics.Histogram(
+        "ign_fuel_http_request_duration_seconds",
+        "Duration of HTTP requests, by server.",
+        MetricsRegistry::DurationBuckets(), {{"server", _url}});
+    result.connections = &metrics.Counter("ign_fuel_http_connections_total",
+        "New connections opened for HTTP requests, by server. Requests that "
+        "reuse an open connection do not count.",
+        {{"server", _url}});
+    result.received = &metrics.Counter("ign_fuel_http_received_bytes_total",
+        "Bytes of HTTP response bodies, by server.",
+        {{"server", _url}});
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////
+/// \brief Get the request counter of a server and status code.
+/// \param[in] _url Server URL.
+/// \param[in,out] _server Metrics of the server.
+/// \param[in] _code Status code.
+/// \return The counter.
+static MetricCounter &requestCounter(const std::string &_url,
+    ServerMetrics &_server, int _code)
+{
+  auto &counter = _server.requests[_code];
+  if (!counter)
+  {
+    counter = &MetricsRegistry::Global().Counter(
+        "ign_fuel_http_requests_total",
+        "HTTP requests, by server and status code. Code 0 means the request "
+        "failed before a response was received.",
+        {{"server", _url}, {"code", std::to_string(_code)}});
+  }
+  return *counter;
+}
+
 /////////////////////////////////////////////////
 RestResponse Rest::Request(HttpMethod _method,
     const std::string &_url, const std::string &_version,
@@ -134,14 +268,27 @@ RestResponse Rest::Request(HttpMethod _method,
     const std::vector<std::string> &_headers, const std::string &_data,
     const std::multimap<std::string, std::string> &_form) const
 {
+  TraceSpan span("Rest::Request", "http");
+  if (span.Active())
+    span.SetDetail(RestJoinUrl(RestJoinUrl(_url, _version), _path));
+
   RestResponse res;
 
   if (_url.empty())
     return res;
 
+  // curl_global_init is not thread safe, and curl_easy_init would call it
+  // implicitly. Do it once here so requests can be issued from many threads.
+  static std::once_flag curlInitFlag;
+  std::call_once(curlInitFlag, []()
+  {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+  });
+
   std::string url = RestJoinUrl(_url, _version);
 
-  CURL *curl = curl_easy_init();
+  CurlHandle handle;
+  CURL *curl = handle.curl;
 
   // First, unescape the _path since it might have %XX encodings. If this
   // step is not performed, then curl_easy_escape will encode the %XX
@@ -176,8 +323,8 @@ RestResponse Rest::Request(HttpMethod _method,
       ignerr << "[Rest::Request()]: Error processing header.\n  ["
                 << header.c_str() << "]" << std::endl;
 
-      // cleanup
-      curl_easy_cleanup(curl);
+      curl_free(encodedPath);
+      curl_slist_free_all(headers);
       return res;
     }
   }
@@ -194,6 +341,16 @@ RestResponse Rest::Request(HttpMethod _method,
   curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, RestHeaderCallback);
   curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headerData);
 
+  // Copied, so the callback can't be changed during the transfer.
+  RestTransferCallback transferCallback = this->transferCallback;
+  if (transferCallback)
+  {
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION,
+        RestTransferInfoCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transferCallback);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+  }
+
   char errbuf[CURL_ERROR_SIZE];
   // provide a buffer to store errors in
   curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errbuf);
@@ -296,12 +453,24 @@ RestResponse Rest::Request(HttpMethod _method,
 
     // Cleanup.
     curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
     return res;
   }
 
+  static auto &inFlight = MetricsRegistry::Global().Gauge(
+      "ign_fuel_http_requests_in_flight", "HTTP requests being transferred.");
+
+  inFlight.Add(1);
+  auto start = std::chrono::steady_clock::now();
   CURLcode success = curl_easy_perform(curl);
-  if (success != CURLE_OK)
+  std::chrono::duration<double> duration =
+      std::chrono::steady_clock::now() - start;
+  inFlight.Add(-1);
+
+  if (success == CURLE_ABORTED_BY_CALLBACK)
+  {
+    igndbg << "REST request aborted [" << url << "]" << std::endl;
+  }
+  else if (success != CURLE_OK)
   {
     ignerr << "Error in REST request" << std::endl;
     size_t len = strlen(errbuf);
@@ -315,8 +484,18 @@ RestResponse Rest::Request(HttpMethod _method,
       fprintf(stderr, "%s\n", curl_easy_strerror(success));
   }
 
-  // Update the status code.
+  // Update the status code. An aborted transfer has no valid response.
   curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &res.statusCode);
+  if (success == CURLE_ABORTED_BY_CALLBACK)
+    res.statusCode = 0;
+
+  auto &server = serverMetrics(_url);
+  server.duration->Observe(duration.count());
+  requestCounter(_url, server, res.statusCode).Increment();
+  long connects = 0;
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+  server.connections->Increment(connects);
+  server.received->Increment(responseData.size());
 
   // Update the data.
   res.data = responseData;
@@ -333,9 +512,6 @@ RestResponse Rest::Request(HttpMethod _method,
   // free the headers
   curl_slist_free_all(headers);
 
-  // Cleaning.
-  curl_easy_cleanup(curl);
-
   if (ifs.is_open())
     ifs.close();
   return res;
@@ -352,3 +528,9 @@ const std::string &Rest::UserAgent() const
 {
   return this->userAgent;
 }
+
+/////////////////////////////////////////////////
+void Rest::SetTransferCallback(const RestTransferCallback &_callback)
+{
+  this->transferCallback = _callback;
+}
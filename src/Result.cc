@@ -92,6 +92,8 @@ std::string Result::ReadableResult() const
         return "Model already exists";
     case ResultType::UPLOAD_ERROR:
         return "Upload failed. Other errors";
+    case ResultType::FETCH_CANCELLED:
+        return "Fetch cancelled";
     case ResultType::UNKNOWN:
     default:
       return "Unknown result";
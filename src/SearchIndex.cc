@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ignition/common/StringUtils.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/SearchIndex.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief List of models, by position in the ranking.
+using Postings = std::vector<uint32_t>;
+
+/// \brief Private data class
+class ignition::fuel_tools::SearchIndexPrivate
+{
+  /// \brief Key of a model.
+  /// \param[in] _id Model identifier.
+  /// \return Key, unique per model. Owners and names are case insensitive
+  /// on Fuel servers.
+  public: static std::string Key(const ModelIdentifier &_id)
+  {
+    return _id.Server().Url().Str() + "\n" + common::lowercase(_id.Owner()) +
+        "\n" + common::lowercase(_id.Name());
+  }
+
+  /// \brief Split text into lowercase words.
+  /// \param[in] _text Text to split.
+  /// \param[out] _words Words are appended here.
+  public: static void Words(const std::string &_text,
+              std::vector<std::string> &_words);
+
+  /// \brief Rank the models and rebuild the postings.
+  public: void Build();
+
+  /// \brief Models, by key.
+  public: std::map<std::string, ModelIdentifier> models;
+
+  /// \brief Whether models changed since the postings were built.
+  public: bool dirty = false;
+
+  /// \brief Models, most downloaded first.
+  public: std::vector<const ModelIdentifier *> ranked;
+
+  /// \brief Postings of each word, sorted by word for prefix lookups.
+  public: std::vector<std::pair<std::string, Postings>> words;
+
+  /// \brief Postings of each lowercase tag.
+  public: std::unordered_map<std::string, Postings> tags;
+};
+
+//////////////////////////////////////////////////
+void SearchIndexPrivate::Words(const std::string &_text,
+    std::vector<std::string> &_words)
+{
+  std::string word;
+  for (char c : _text)
+  {
+    auto u = static_cast<unsigned char>(c);
+
+    // Bytes of multibyte UTF-8 characters are kept as they are.
+    if (u >= 0x80 || std::isalnum(u))
+    {
+      word += static_cast<char>(u < 0x80 ? std::tolower(u) : u);
+    }
+    else if (!word.empty())
+    {
+      _words.push_back(word);
+      word.clear();
+    }
+  }
+  if (!word.empty())
+    _words.push_back(word);
+}
+
+//////////////////////////////////////////////////
+void SearchIndexPrivate::Build()
+{
+  this->ranked.clear();
+  this->ranked.reserve(this->models.size());
+  for (const auto &model : this->models)
+    this->ranked.push_back(&model.second);
+
+  // Models are already sorted by key, which breaks ties.
+  std::stable_sort(this->ranked.begin(), this->ranked.end(),
+      [](const ModelIdentifier *_a, const ModelIdentifier *_b)
+      {
+        if (_a->DownloadCount() != _b->DownloadCount())
+          return _a->DownloadCount() > _b->DownloadCount();
+        return _a->LikeCount() > _b->LikeCount();
+      });
+
+  // Models are visited in rank order, so every posting list is sorted.
+  std::unordered_map<std::string, Postings> postings;
+  this->tags.clear();
+  std::vector<std::string> modelWords;
+  for (uint32_t i = 0; i < this->ranked.size(); ++i)
+  {
+    const auto &id = *this->ranked[i];
+
+    modelWords.clear();
+    Words(id.Name(), modelWords);
+    Words(id.Owner(), modelWords);
+    Words(id.Description(), modelWords);
+    for (const auto &tag : id.Tags())
+    {
+      Words(tag, modelWords);
+
+      auto &tagPostings = this->tags[common::lowercase(common::trimmed(tag))];
+      if (tagPostings.empty() || tagPostings.back() != i)
+        tagPostings.push_back(i);
+    }
+
+    std::sort(modelWords.begin(), modelWords.end());
+    modelWords.erase(std::unique(modelWords.begin(), modelWords.end()),
+        modelWords.end());
+    for (const auto &word : modelWords)
+      postings[word].push_back(i);
+  }
+
+  this->words.assign(std::make_move_iterator(postings.begin()),
+      std::make_move_iterator(postings.end()));
+  std::sort(this->words.begin(), this->words.end(),
+      [](const std::pair<std::string, Postings> &_a,
+         const std::pair<std::string, Postings> &_b)
+      {
+        return _a.first < _b.first;
+      });
+
+  this->dirty = false;
+}
+
+//////////////////////////////////////////////////
+SearchIndex::SearchIndex()
+  : dataPtr(new SearchIndexPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+SearchIndex::SearchIndex(const SearchIndex &_orig)
+  : dataPtr(new SearchIndexPrivate)
+{
+  *this = _orig;
+}
+
+//////////////////////////////////////////////////
+SearchIndex &SearchIndex::operator=(const SearchIndex &_orig)
+{
+  // The ranking points into the models, so it's rebuilt instead of copied.
+  this->dataPtr->models = _orig.dataPtr->models;
+  this->dataPtr->ranked.clear();
+  this->dataPtr->words.clear();
+  this->dataPtr->tags.clear();
+  this->dataPtr->dirty = true;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+SearchIndex::~SearchIndex()
+{
+}
+
+//////////////////////////////////////////////////
+void SearchIndex::Add(const ModelIdentifier &_id)
+{
+  this->dataPtr->models[SearchIndexPrivate::Key(_id)] = _id;
+  this->dataPtr->dirty = true;
+}
+
+//////////////////////////////////////////////////
+void SearchIndex::Add(const std::vector<ModelIdentifier> &_ids)
+{
+  for (const auto &id : _ids)
+    this->Add(id);
+}
+
+//////////////////////////////////////////////////
+bool SearchIndex::Remove(const ModelIdentifier &_id)
+{
+  if (this->dataPtr->models.erase(SearchIndexPrivate::Key(_id)) == 0u)
+    return false;
+  this->dataPtr->dirty = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SearchIndex::Clear()
+{
+  this->dataPtr->models.clear();
+  this->dataPtr->dirty = true;
+}
+
+//////////////////////////////////////////////////
+size_t SearchIndex::Size() const
+{
+  return this->dataPtr->models.size();
+}
+
+//////////////////////////////////////////////////
+std::vector<ModelIdentifier> SearchIndex::Search(const std::string &_text,
+    const std::vector<std::string> &_tags, size_t _limit) const
+{
+  if (this->dataPtr->dirty)
+    this->dataPtr->Build();
+
+  const auto &ranked = this->dataPtr->ranked;
+  if (_limit == 0u || _limit > ranked.size())
+    _limit = ranked.size();
+
+  // Each condition is satisfied by any of its posting lists.
+  std::vector<std::vector<const Postings *>> conditions;
+
+  for (const auto &tag : _tags)
+  {
+    auto it = this->dataPtr->tags.find(common::lowercase(common::trimmed(tag)));
+    if (it == this->dataPtr->tags.end())
+      return {};
+    conditions.push_back({&it->second});
+  }
+
+  std::vector<std::string> keywords;
+  SearchIndexPrivate::Words(_text, keywords);
+  for (const auto &keyword : keywords)
+  {
+    const auto &words = this->dataPtr->words;
+    auto it = std::lower_bound(words.begin(), words.end(), keyword,
+        [](const std::pair<std::string, Postings> &_word,
+           const std::string &_prefix)
+        {
+          return _word.first < _prefix;
+        });
+
+    std::vector<const Postings *> condition;
+    for (; it != words.end() && it->first.compare(0, keyword.size(),
+        keyword) == 0; ++it)
+    {
+      condition.push_back(&it->second);
+    }
+    if (condition.empty())
+      return {};
+    conditions.push_back(condition);
+  }
+
+  std::vector<ModelIdentifier> result;
+  if (conditions.empty())
+  {
+    for (size_t i = 0; i < _limit; ++i)
+      result.push_back(*ranked[i]);
+    return result;
+  }
+
+  // Count the conditions satisfied by each model. A model only moves to
+  // the next count when it satisfied all the previous conditions, and
+  // only once per condition even if several of its words match.
+  std::vector<uint16_t> matched(ranked.size(), 0u);
+  uint16_t count = 0u;
+  for (const auto &condition : conditions)
+  {
+    bool any = false;
+    for (const auto *postings : condition)
+    {
+      for (auto i : *postings)
+      {
+        if (matched[i] == count)
+        {
+          matched[i] = count + 1u;
+          any = true;
+        }
+      }
+    }
+    if (!any)
+      return {};
+    if (++count == UINT16_MAX)
+      break;
+  }
+
+  // Positions are ranks, so models are visited best first.
+  for (size_t i = 0; i < ranked.size() && result.size() < _limit; ++i)
+  {
+    if (matched[i] == count)
+      result.push_back(*ranked[i]);
+  }
+  return result;
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+#include "ignition/fuel_tools/SearchIndex.hh"
+
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+/// \brief Create a model identifier.
+ModelIdentifier makeModel(const std::string &_owner, const std::string &_name,
+    const std::string &_description, const std::vector<std::string> &_tags,
+    uint32_t _downloads, uint32_t _likes = 0)
+{
+  ModelIdentifier id;
+  id.SetOwner(_owner);
+  id.SetName(_name);
+  id.SetDescription(_description);
+  id.SetTags(_tags);
+  id.SetDownloadCount(_downloads);
+  id.SetLikeCount(_likes);
+  return id;
+}
+
+/////////////////////////////////////////////////
+/// \brief Names of models, in order.
+std::vector<std::string> names(const std::vector<ModelIdentifier> &_ids)
+{
+  std::vector<std::string> result;
+  for (const auto &id : _ids)
+    result.push_back(id.Name());
+  return result;
+}
+
+/////////////////////////////////////////////////
+TEST(SearchIndex, Search)
+{
+  SearchIndex index;
+  EXPECT_EQ(0u, index.Size());
+  EXPECT_TRUE(index.Search("").empty());
+
+  index.Add({
+      makeModel("alice", "Cordless Drill", "A drill without a cord",
+          {"tools", "Power Tools"}, 50),
+      makeModel("alice", "Hammer", "A claw hammer", {"tools"}, 100),
+      makeModel("bob", "Drill_Press", "Heavy, bench drill", {"machines"}, 10),
+      makeModel("bob", "Table", "Wooden table", {"furniture"}, 100, 5)});
+  EXPECT_EQ(4u, index.Size());
+
+  // Everything, ranked by downloads, then likes.
+  EXPECT_EQ(std::vector<std::string>(
+      {"Table", "Hammer", "Cordless Drill", "Drill_Press"}),
+      names(index.Search("")));
+  EXPECT_EQ(std::vector<std::string>({"Table", "Hammer"}),
+      names(index.Search("", {}, 2)));
+
+  // Keywords are prefixes of words of the name, owner, description or tags.
+  EXPECT_EQ(std::vector<std::string>({"Cordless Drill", "Drill_Press"}),
+      names(index.Search("dri")));
+  EXPECT_EQ(std::vector<std::string>({"Cordless Drill"}),
+      names(index.Search("DRILL cord")));
+  EXPECT_EQ(std::vector<std::string>({"Drill_Press"}),
+      names(index.Search("press")));
+  EXPECT_EQ(std::vector<std::string>({"Table", "Drill_Press"}),
+      names(index.Search("bob")));
+  EXPECT_EQ(std::vector<std::string>({"Cordless Drill"}),
+      names(index.Search("power")));
+  EXPECT_TRUE(index.Search("drill saw").empty());
+  EXPECT_TRUE(index.Search("rill").empty());
+
+  // Tags match whole, ignoring case.
+  EXPECT_EQ(std::vector<std::string>({"Hammer", "Cordless Drill"}),
+      names(index.Search("", {"TOOLS"})));
+  EXPECT_EQ(std::vector<std::string>({"Cordless Drill"}),
+      names(index.Search("", {"tools", "power tools"})));
+  EXPECT_EQ(std::vector<std::string>({"Hammer"}),
+      names(index.Search("claw", {"tools"})));
+  EXPECT_TRUE(index.Search("", {"tool"}).empty());
+
+  // Adding the same model again replaces it.
+  index.Add(makeModel("Bob", "drill_press", "Heavy, bench drill",
+      {"machines"}, 1000));
+  EXPECT_EQ(4u, index.Size());
+  EXPECT_EQ(std::vector<std::string>({"drill_press", "Cordless Drill"}),
+      names(index.Search("drill")));
+
+  // Copies are independent.
+  SearchIndex copy(index);
+  EXPECT_TRUE(index.Remove(makeModel("bob", "Drill_Press", "", {}, 0)));
+  EXPECT_FALSE(index.Remove(makeModel("bob", "Drill_Press", "", {}, 0)));
+  EXPECT_EQ(3u, index.Size());
+  EXPECT_EQ(std::vector<std::string>({"Cordless Drill"}),
+      names(index.Search("drill")));
+  EXPECT_EQ(2u, copy.Search("drill").size());
+
+  index.Clear();
+  EXPECT_EQ(0u, index.Size());
+  EXPECT_TRUE(index.Search("drill").empty());
+}
+
+/////////////////////////////////////////////////
+TEST(SearchIndex, Large)
+{
+  SearchIndex index;
+  std::vector<ModelIdentifier> ids;
+  for (uint32_t i = 0; i < 100000u; ++i)
+  {
+    ids.push_back(makeModel("owner" + std::to_string(i % 100),
+        "model" + std::to_string(i), "", {i % 2 ? "odd" : "even"}, i));
+  }
+  index.Add(ids);
+  ASSERT_EQ(100000u, index.Size());
+
+  // "owner7" is a prefix of owner7 and owner70 to owner79.
+  auto result = index.Search("owner7 model", {"odd"}, 3);
+  EXPECT_EQ(std::vector<std::string>({"model99979", "model99977",
+      "model99975"}), names(result));
+
+  result = index.Search("model1234");
+  EXPECT_EQ(std::vector<std::string>({"model12349", "model12348",
+      "model12347", "model12346", "model12345", "model12344", "model12343",
+      "model12342", "model12341", "model12340", "model1234"}), names(result));
+}
+
+/////////////////////////////////////////////////
+TEST(SearchIndex, LocalCache)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_search_index");
+  common::removeAll(root);
+
+  ServerConfig server;
+  server.SetUrl(common::URI("http://example.com"));
+  ClientConfig config;
+  config.SetCacheLocation(common::joinPaths(root, "cache"));
+  config.AddServer(server);
+
+  // A downloaded model, which isn't in any listing.
+  std::string modelDir = common::joinPaths(config.CacheLocation(),
+      server.Url().Path().Str(), "carol", "models", "Cached_Box", "1");
+  ASSERT_TRUE(common::createDirectories(modelDir));
+  std::ofstream(common::joinPaths(modelDir, "model.config")) << "<model/>";
+
+  LocalCache cache(&config);
+  ASSERT_TRUE(cache.SaveModelListing(server, "alice/models", {
+      makeModel("alice", "Hammer", "A claw hammer", {"tools"}, 100)}));
+  ASSERT_TRUE(cache.SaveModelListing(server, "models", {
+      makeModel("alice", "Hammer", "A claw hammer", {"tools"}, 100),
+      makeModel("bob", "Saw", "A hand saw", {"tools"}, 10)}));
+
+  auto result = cache.SearchModels(server, "", {"tools"});
+  EXPECT_EQ(std::vector<std::string>({"Hammer", "Saw"}), names(result));
+  ASSERT_FALSE(result.empty());
+  EXPECT_EQ("A claw hammer", result[0].Description());
+  EXPECT_EQ(server.Url().Str(), result[0].Server().Url().Str());
+  EXPECT_EQ(std::vector<std::string>({"Cached_Box"}),
+      names(cache.SearchModels(server, "box")));
+
+  // Listings saved later are searchable right away.
+  ASSERT_TRUE(cache.SaveModelListing(server, "bob/models/Drill",
+      {makeModel("bob", "Drill", "A power drill", {"tools"}, 50)}));
+  EXPECT_EQ(std::vector<std::string>({"Hammer", "Drill", "Saw"}),
+      names(cache.SearchModels(server, "", {"tools"})));
+
+  // Other caches find the same models on disk.
+  LocalCache other(&config);
+  EXPECT_EQ(std::vector<std::string>({"Hammer", "Drill", "Saw"}),
+      names(other.SearchModels(server, "", {"tools"})));
+
+  ServerConfig otherServer;
+  otherServer.SetUrl(common::URI("http://example.org"));
+  EXPECT_TRUE(other.SearchModels(otherServer, "").empty());
+
+  common::removeAll(root);
+}
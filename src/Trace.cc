@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <json/json.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ignition/common/Console.hh>
+
+#include "ignition/fuel_tools/Trace.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Maximum number of recorded spans, so a forgotten trace doesn't
+/// grow without bounds.
+static const size_t kMaxTraceSpans = 1000000;
+
+/// \brief A recorded span.
+struct TraceEvent
+{
+  /// \brief Span name.
+  const char *name;
+
+  /// \brief Span category.
+  const char *category;
+
+  /// \brief Optional detail.
+  std::string detail;
+
+  /// \brief Thread which recorded the span.
+  uint32_t tid;
+
+  /// \brief Start time, in microseconds.
+  int64_t start;
+
+  /// \brief Duration, in microseconds.
+  int64_t duration;
+};
+
+/// \brief Whether spans are recorded.
+static std::atomic<bool> g_traceEnabled{false};
+
+/// \brief Next thread id to assign.
+static std::atomic<uint32_t> g_traceNextTid{1};
+
+//////////////////////////////////////////////////
+/// \brief Recorded spans. Intentionally leaked, so spans can be recorded
+/// and written while static objects are destroyed.
+/// \param[out] _mutex Mutex protecting the spans.
+/// \return The spans.
+static std::vector<TraceEvent> &traceEvents(std::mutex *&_mutex)
+{
+  static auto *mutex = new std::mutex();
+  static auto *events = new std::vector<TraceEvent>();
+  _mutex = mutex;
+  return *events;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get a small id for the calling thread.
+/// \return Thread id, starting at 1 for the first thread which records a
+/// span.
+static uint32_t traceThreadId()
+{
+  thread_local uint32_t tid = g_traceNextTid++;
+  return tid;
+}
+
+//////////////////////////////////////////////////
+void Trace::SetEnabled(bool _enabled)
+{
+  // Make sure the clock epoch is set before the first span.
+  Now();
+  g_traceEnabled = _enabled;
+}
+
+//////////////////////////////////////////////////
+bool Trace::Enabled()
+{
+  return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+void Trace::Clear()
+{
+  std::mutex *mutex;
+  auto &events = traceEvents(mutex);
+  std::lock_guard<std::mutex> lock(*mutex);
+  events.clear();
+}
+
+//////////////////////////////////////////////////
+uint64_t Trace::SpanCount()
+{
+  std::mutex *mutex;
+  auto &events = traceEvents(mutex);
+  std::lock_guard<std::mutex> lock(*mutex);
+  return events.size();
+}
+
+//////////////////////////////////////////////////
+int64_t Trace::Now()
+{
+  static const auto epoch = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - epoch).count();
+}
+
+//////////////////////////////////////////////////
+void Trace::Record(const char *_name, const char *_category,
+    const std::string &_detail, int64_t _start, int64_t _end)
+{
+  uint32_t tid = traceThreadId();
+
+  std::mutex *mutex;
+  auto &events = traceEvents(mutex);
+  std::lock_guard<std::mutex> lock(*mutex);
+  if (events.size() >= kMaxTraceSpans)
+    return;
+  events.push_back({_name, _category, _detail, tid, _start, _end - _start});
+}
+
+//////////////////////////////////////////////////
+std::string Trace::ChromeJson()
+{
+  std::vector<TraceEvent> copy;
+  {
+    std::mutex *mutex;
+    auto &events = traceEvents(mutex);
+    std::lock_guard<std::mutex> lock(*mutex);
+    copy = events;
+  }
+
+  Json::Value root;
+  Json::Value &array = root["traceEvents"];
+  array = Json::Value(Json::arrayValue);
+  for (const auto &event : copy)
+  {
+    Json::Value value;
+    value["name"] = event.name;
+    value["cat"] = event.category;
+    value["ph"] = "X";
+    value["ts"] = static_cast<Json::Int64>(event.start);
+    value["dur"] = static_cast<Json::Int64>(event.duration);
+    value["pid"] = 1;
+    value["tid"] = event.tid;
+    if (!event.detail.empty())
+      value["args"]["detail"] = event.detail;
+    array.append(value);
+  }
+  root["displayTimeUnit"] = "ms";
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, root);
+}
+
+//////////////////////////////////////////////////
+bool Trace::WriteChromeJson(const std::string &_path)
+{
+  std::ofstream out(_path, std::ios::trunc);
+  out << ChromeJson() << std::endl;
+  out.close();
+  if (!out)
+  {
+    ignerr << "Unable to write trace to [" << _path << "]" << std::endl;
+    return false;
+  }
+  return true;
+}
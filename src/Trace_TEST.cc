@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/Trace.hh"
+#include "ignition/fuel_tools/Zip.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+TEST(Trace, Disabled)
+{
+  Trace::SetEnabled(false);
+  Trace::Clear();
+  {
+    TraceSpan span("disabled", "test");
+    EXPECT_FALSE(span.Active());
+  }
+  EXPECT_EQ(0u, Trace::SpanCount());
+  EXPECT_EQ(std::string::npos, Trace::ChromeJson().find("disabled"));
+}
+
+/////////////////////////////////////////////////
+TEST(Trace, Spans)
+{
+  Trace::Clear();
+  Trace::SetEnabled(true);
+  {
+    TraceSpan outer("outer", "test");
+    EXPECT_TRUE(outer.Active());
+    outer.SetDetail("some \"detail\"");
+
+    std::thread thread([]()
+    {
+      TraceSpan span("inner", "test");
+    });
+    thread.join();
+  }
+
+  // The library records its own spans.
+  std::string dst = common::joinPaths(PROJECT_BINARY_PATH, "test_trace");
+  common::removeAll(dst);
+  EXPECT_TRUE(Zip::Extract(std::string(TEST_PATH) + "/media/box.zip", dst));
+  Trace::SetEnabled(false);
+
+  EXPECT_EQ(3u, Trace::SpanCount());
+
+  std::string json = Trace::ChromeJson();
+  EXPECT_NE(std::string::npos, json.find("\"traceEvents\""));
+  EXPECT_NE(std::string::npos, json.find("\"outer\""));
+  EXPECT_NE(std::string::npos, json.find("\"inner\""));
+  EXPECT_NE(std::string::npos, json.find("\"Zip::Extract\""));
+  EXPECT_NE(std::string::npos, json.find("some \\\"detail\\\""));
+  EXPECT_NE(std::string::npos, json.find("\"ph\":\"X\""));
+
+  // Spans of different threads have different ids.
+  EXPECT_NE(std::string::npos, json.find("\"tid\":1"));
+  EXPECT_NE(std::string::npos, json.find("\"tid\":2"));
+
+  std::string path = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_trace.json");
+  EXPECT_TRUE(Trace::WriteChromeJson(path));
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  EXPECT_EQ(json + "\n", content.str());
+
+  Trace::Clear();
+  EXPECT_EQ(0u, Trace::SpanCount());
+  common::removeAll(dst);
+  common::removeFile(path);
+}
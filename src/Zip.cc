@@ -25,6 +25,8 @@
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
 
+#include "ignition/fuel_tools/Metrics.hh"
+#include "ignition/fuel_tools/Trace.hh"
 #include "ignition/fuel_tools/Zip.hh"
 
 using namespace ignition;
@@ -83,6 +85,10 @@ bool CompressFile(zip *_archive, const std::string &_file,
 /////////////////////////////////////////////////
 bool Zip::Compress(const std::string &_src, const std::string &_dst)
 {
+  TraceSpan span("Zip::Compress", "zip");
+  if (span.Active())
+    span.SetDetail(_src);
+
   if (!ignition::common::exists(_src))
   {
     ignerr << "Directory does not exist: " << _src << std::endl;
@@ -113,12 +119,27 @@ bool Zip::Compress(const std::string &_src, const std::string &_dst)
 bool Zip::Extract(const std::string &_src,
     const std::string &_dst)
 {
+  return Extract(_src, _dst, nullptr);
+}
+
+/////////////////////////////////////////////////
+bool Zip::Extract(const std::string &_src,
+    const std::string &_dst,
+    const std::function<bool(uint64_t, uint64_t)> &_progress)
+{
+  TraceSpan span("Zip::Extract", "zip");
+  if (span.Active())
+    span.SetDetail(_src);
+
   if (!ignition::common::exists(_src))
   {
     ignerr << "Source archive does not exist: " << _src << std::endl;
     return false;
   }
 
+  static auto &extractedBytes = MetricsRegistry::Global().Counter(
+      "ign_fuel_extracted_bytes_total", "Bytes extracted from archives.");
+
   int err;
   zip *archive = zip_open(_src.c_str(), 0, &err);
   if (!archive)
@@ -127,6 +148,23 @@ bool Zip::Extract(const std::string &_src,
     return false;
   }
 
+  uint64_t total = 0;
+  uint64_t extracted = 0;
+  if (_progress)
+  {
+    for (unsigned int i = 0; i < zip_get_num_entries(archive, 0); ++i)
+    {
+      struct zip_stat sb;
+      if (zip_stat_index(archive, i, 0, &sb) == 0)
+        total += sb.size;
+    }
+    if (!_progress(0, total))
+    {
+      zip_close(archive);
+      return false;
+    }
+  }
+
   for (unsigned int i = 0; i < zip_get_num_entries(archive, 0); ++i)
   {
     struct zip_stat sb;
@@ -167,13 +205,25 @@ bool Zip::Extract(const std::string &_src,
     int len = zip_fread(zf, buf, readSize);
 
     if (len < 0)
+    {
       ignerr << "Error reading " << sb.name << std::endl;
+    }
     else
+    {
       file.write(buf, len);
+      extractedBytes.Increment(len);
+      extracted += len;
+    }
 
     delete[] buf;
     file.close();
     zip_fclose(zf);
+
+    if (_progress && !_progress(extracted, total))
+    {
+      zip_close(archive);
+      return false;
+    }
   }
 
   if (zip_close(archive) < 0)
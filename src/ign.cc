@@ -16,6 +16,7 @@
 */
 
 #include <curl/curl.h>
+#include <json/json.h>
 #include <string.h>
 #include <tinyxml2.h>
 #include <google/protobuf/text_format.h>
@@ -25,24 +26,52 @@
 #ifdef _WIN32
 // DELETE is defined in winnt.h and causes a problem with REST::DELETE
 #undef DELETE
+#include <io.h>
+#define ign_isatty _isatty
+#define ign_fileno _fileno
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#define ign_isatty isatty
+#define ign_fileno fileno
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
 #include <ignition/common/SignalHandler.hh>
+#include <ignition/common/StringUtils.hh>
 #include <ignition/common/URI.hh>
+#include <ignition/common/Util.hh>
 
 #include "ignition/fuel_tools/ClientConfig.hh"
 #include "ignition/fuel_tools/config.hh"
 #include "ignition/fuel_tools/FuelClient.hh"
 #include "ignition/fuel_tools/Helpers.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/Lockfile.hh"
+#include "ignition/fuel_tools/Metrics.hh"
+#include "ignition/fuel_tools/RestClient.hh"
 #include "ignition/fuel_tools/Result.hh"
+#include "ignition/fuel_tools/Trace.hh"
+#include "CacheServer.hh"
 #include "ign.hh"
 #include "ignition/fuel_tools/WorldIdentifier.hh"
+#include "ignition/fuel_tools/Zip.hh"
 
 //////////////////////////////////////////////////
 /// \brief Print resources in a human readable manner
@@ -124,138 +153,176 @@ extern "C" void uglyPrint(
   }
 }
 
+/// \brief Serializes output of concurrently streamed listings.
+static std::mutex g_streamMutex;
+
 //////////////////////////////////////////////////
-/// \brief Fill a map with all models from a server
-/// \param[in] _client Fuel client
+/// \brief Build the URL of a resource.
 /// \param[in] _server Server configuration
-/// \param[out] _resourceMap Key is owner name, value is vector of resources
-/// \return True if successful, will fail if there's a server error or if the
-/// server has no models yet.
-extern "C" bool getAllModels(
-    const ignition::fuel_tools::FuelClient &_client,
-    const ignition::fuel_tools::ServerConfig &_server,
-    std::map<std::string, std::vector<std::string>> &_resourceMap)
+/// \param[in] _owner Owner name
+/// \param[in] _resourceType Type, such as "models"
+/// \param[in] _name Resource name, which will be URL encoded
+/// \return Resource URL
+std::string resourceUrl(const ignition::fuel_tools::ServerConfig &_server,
+    const std::string &_owner, const std::string &_resourceType,
+    const std::string &_name)
 {
-  auto iter = _client.Models(_server);
-
-  if (!iter)
-  {
-    std::cout <<
-        "Either failed to fetch model list, or server has no models yet."
-        << std::endl;
-    return false;
-  }
+  CURL *curl = curl_easy_init();
+  char *encodedName = curl_easy_escape(curl, _name.c_str(), _name.size());
 
-  // Rearrange by user
-  // key: user name
-  // value: vector of model names
-  for (; iter; ++iter)
-  {
-    _resourceMap[iter->Identification().Owner()].push_back(
-        iter->Identification().Name());
-  }
+  std::string url = _server.Url().Str() + "/" + _server.Version() + "/" +
+      _owner + "/" + _resourceType + "/" + encodedName;
 
-  return true;
+  curl_free(encodedName);
+  curl_easy_cleanup(curl);
+  return url;
 }
 
 //////////////////////////////////////////////////
-/// \brief Fill a map with all worlds from a server
-/// \param[in] _client Fuel client
-/// \param[in] _server Server configuration
-/// \param[out] _resourceMap Key is owner name, value is vector of resources
-/// \return True if successful, will fail if there's a server error or if the
-/// server has no worlds yet.
-extern "C" bool getAllWorlds(
-    const ignition::fuel_tools::FuelClient &_client,
-    const ignition::fuel_tools::ServerConfig &_server,
-    std::map<std::string, std::vector<std::string>> &_resourceMap)
+/// \brief Format a date as an ISO 8601 UTC string, as used by Fuel servers.
+/// \param[in] _time Time to format.
+/// \return Formatted date, such as "2020-01-31T12:00:00Z".
+std::string formatDateTime(const std::time_t &_time)
 {
-  auto iter = _client.Worlds(_server);
+  std::tm tm;
+#ifdef _WIN32
+  gmtime_s(&tm, &_time);
+#else
+  gmtime_r(&_time, &tm);
+#endif
+  char buffer[32];
+  std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+  return buffer;
+}
 
-  if (!iter)
-  {
-    std::cout <<
-        "Either failed to fetch world list, or server has no worlds yet."
-        << std::endl;
-    return false;
-  }
+//////////////////////////////////////////////////
+/// \brief Write a JSON object in a single line.
+/// \param[in] _value JSON object
+/// \return Compact JSON string, without a trailing newline.
+std::string jsonLine(const Json::Value &_value)
+{
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  return Json::writeString(builder, _value);
+}
 
-  // Rearrange by user
-  // key: user name
-  // value: vector of world names
-  for (; iter; ++iter)
-  {
-    _resourceMap[iter->Owner()].push_back(iter->Name());
-  }
+//////////////////////////////////////////////////
+/// \brief Print a model as a line of JSON with all its metadata.
+/// \param[in] _id Model identifier
+void jsonPrintModel(const ignition::fuel_tools::ModelIdentifier &_id)
+{
+  Json::Value value;
+  value["url"] = resourceUrl(_id.Server(), _id.Owner(), "models", _id.Name());
+  value["server"] = _id.Server().Url().Str();
+  value["owner"] = _id.Owner();
+  value["name"] = _id.Name();
+  value["version"] = _id.Version();
+  value["filesize"] = _id.FileSize();
+  value["createdAt"] = formatDateTime(_id.UploadDate());
+  value["updatedAt"] = formatDateTime(_id.ModifyDate());
+  value["description"] = _id.Description();
+  value["likes"] = _id.LikeCount();
+  value["downloads"] = _id.DownloadCount();
+  value["license_name"] = _id.LicenseName();
+
+  value["tags"] = Json::Value(Json::arrayValue);
+  for (const auto &tag : _id.Tags())
+    value["tags"].append(tag);
+
+  std::cout << jsonLine(value) << "\n";
+}
 
-  return true;
+//////////////////////////////////////////////////
+/// \brief Print a world as a line of JSON with all its metadata.
+/// \param[in] _id World identifier
+void jsonPrintWorld(const ignition::fuel_tools::WorldIdentifier &_id)
+{
+  Json::Value value;
+  value["url"] = resourceUrl(_id.Server(), _id.Owner(), "worlds", _id.Name());
+  value["server"] = _id.Server().Url().Str();
+  value["owner"] = _id.Owner();
+  value["name"] = _id.Name();
+  value["version"] = _id.Version();
+
+  std::cout << jsonLine(value) << "\n";
 }
 
 //////////////////////////////////////////////////
-/// \brief Fill a map with all models from an owner
+/// \brief Print all models from a server as each page arrives.
 /// \param[in] _client Fuel client
-/// \param[in] _modelId Identifier for models to be returned
-/// \param[out] _resourceMap Key is owner name, value is vector of resources
-/// \return True if successful, will fail if there's a server error or if the
-/// server has no models yet.
-extern "C" bool getOwnerModels(
-    const ignition::fuel_tools::FuelClient &_client,
-    const ignition::fuel_tools::ModelIdentifier &_modelId,
-    std::map<std::string, std::vector<std::string>> &_resourceMap)
+/// \param[in] _modelId Identifier with the server and optional owner
+/// \param[in] _json True to print JSON lines, false to print URLs.
+/// \return True if successful.
+bool streamModels(const ignition::fuel_tools::FuelClient &_client,
+    const ignition::fuel_tools::ModelIdentifier &_modelId, bool _json)
 {
-  ignition::fuel_tools::ModelIter iter = _client.Models(_modelId);
-
-  if (!iter)
-  {
-    std::cout <<
-        "Either failed to fetch model list, or server has no models yet."
-        << std::endl;
-    return false;
-  }
-
-  // Rearrange by user
-  // key: user name
-  // value: vector of model names
-  for (; iter; ++iter)
+  auto result = _client.StreamModels(_modelId,
+      [&_json](const std::vector<ignition::fuel_tools::ModelIdentifier> &_page)
+      {
+        // Servers may be streamed concurrently, print whole pages at once
+        std::lock_guard<std::mutex> lock(g_streamMutex);
+        for (const auto &id : _page)
+        {
+          if (_json)
+          {
+            jsonPrintModel(id);
+          }
+          else
+          {
+            std::cout << resourceUrl(id.Server(), id.Owner(), "models",
+                id.Name()) << "\n";
+          }
+        }
+        std::cout << std::flush;
+        return true;
+      });
+
+  if (!result)
   {
-    _resourceMap[iter->Identification().Owner()].push_back(
-        iter->Identification().Name());
+    // Keep stdout parseable
+    std::cerr << "Failed to fetch model list from "
+              << _modelId.Server().Url().Str() << std::endl;
   }
-
-  return true;
+  return result;
 }
 
 //////////////////////////////////////////////////
-/// \brief Fill a map with all worlds from an owner
+/// \brief Print all worlds from a server as each page arrives.
 /// \param[in] _client Fuel client
-/// \param[in] _worldId Identifier for worlds to be returned
-/// \param[out] _resourceMap Key is owner name, value is vector of resources
-/// \return True if successful, will fail if there's a server error or if the
-/// server has no worlds yet.
-extern "C" bool getOwnerWorlds(
-    const ignition::fuel_tools::FuelClient &_client,
-    const ignition::fuel_tools::WorldIdentifier &_worldId,
-    std::map<std::string, std::vector<std::string>> &_resourceMap)
+/// \param[in] _worldId Identifier with the server and optional owner
+/// \param[in] _json True to print JSON lines, false to print URLs.
+/// \return True if successful.
+bool streamWorlds(const ignition::fuel_tools::FuelClient &_client,
+    const ignition::fuel_tools::WorldIdentifier &_worldId, bool _json)
 {
-  auto iter = _client.Worlds(_worldId);
-
-  if (!iter)
-  {
-    std::cout <<
-        "Either failed to fetch world list, or server has no worlds yet."
-        << std::endl;
-    return false;
-  }
-
-  // Rearrange by user
-  // key: user name
-  // value: vector of world names
-  for (; iter; ++iter)
+  auto result = _client.StreamWorlds(_worldId,
+      [&_json](const std::vector<ignition::fuel_tools::WorldIdentifier> &_page)
+      {
+        // Servers may be streamed concurrently, print whole pages at once
+        std::lock_guard<std::mutex> lock(g_streamMutex);
+        for (const auto &id : _page)
+        {
+          if (_json)
+          {
+            jsonPrintWorld(id);
+          }
+          else
+          {
+            std::cout << resourceUrl(id.Server(), id.Owner(), "worlds",
+                id.Name()) << "\n";
+          }
+        }
+        std::cout << std::flush;
+        return true;
+      });
+
+  if (!result)
   {
-    _resourceMap[iter->Owner()].push_back(iter->Name());
+    // Keep stdout parseable
+    std::cerr << "Failed to fetch world list from "
+              << _worldId.Server().Url().Str() << std::endl;
   }
-
-  return true;
+  return result;
 }
 
 //////////////////////////////////////////////////
@@ -266,7 +333,8 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE char *ignitionVersion()
 
 //////////////////////////////////////////////////
 extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listModels(const char *_url,
-    const char *_owner, const char *_raw, const char *_configFile)
+    const char *_owner, const char *_raw, const char *_configFile,
+    const char *_stream, const char *_json)
 {
   std::string urlStr{_url};
   if (!urlStr.empty() && !ignition::common::URI::Valid(_url))
@@ -281,6 +349,9 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listModels(const char *_url,
   std::transform(rawStr.begin(), rawStr.end(),
                  rawStr.begin(), ::tolower);
   bool pretty = rawStr != "true";
+  bool json = _json && ignition::common::lowercase(_json) == "true";
+  bool stream = json ||
+      (_stream && ignition::common::lowercase(_stream) == "true");
 
   // Client
   ignition::fuel_tools::ClientConfig conf;
@@ -307,44 +378,74 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listModels(const char *_url,
 
   ignition::fuel_tools::FuelClient client(conf);
 
-  // Get models
-  for (auto server : conf.Servers())
+  // Print each page as it arrives, requesting all servers concurrently
+  if (stream)
   {
-    modelId.SetServer(server);
+    std::atomic<bool> success{true};
+    std::vector<std::thread> threads;
+    for (auto server : conf.Servers())
+    {
+      threads.emplace_back([&, server]()
+      {
+        auto id = modelId;
+        id.SetServer(server);
+        if (!streamModels(client, id, json))
+          success = false;
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    return success;
+  }
 
-    if (pretty)
+  auto servers = conf.Servers();
+  if (pretty)
+  {
+    for (const auto &server : servers)
     {
       std::cout << "Fetching model list from " << server.Url().Str() << "..."
                 << std::endl;
     }
+  }
 
-    auto startTime = std::chrono::high_resolution_clock::now();
+  auto startTime = std::chrono::high_resolution_clock::now();
 
-    std::map<std::string, std::vector<std::string>> modelsMap;
+  // All servers are requested concurrently
+  auto iter = client.ModelsFromAllServers(owner);
 
-    // All models
-    if (owner.empty())
-    {
-      if (!getAllModels(client, server, modelsMap))
-        continue;
-    }
-    else
-    {
-      if (!getOwnerModels(client, modelId, modelsMap))
-        continue;
-    }
+  // Rearrange by server and owner
+  // key: server URL
+  // value: map with owner name as key and vector of model names as value
+  std::map<std::string, std::map<std::string, std::vector<std::string>>>
+      serversMap;
+  for (; iter; ++iter)
+  {
+    auto id = iter->Identification();
+    serversMap[id.Server().Url().Str()][id.Owner()].push_back(id.Name());
+  }
 
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        endTime - startTime);
+  auto endTime = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      endTime - startTime);
 
-    if (pretty)
+  if (pretty)
+  {
+    std::cout << "Received model list (took " << duration.count() << "ms)."
+              << std::endl;
+  }
+
+  // Print all models
+  for (const auto &server : servers)
+  {
+    const auto &modelsMap = serversMap[server.Url().Str()];
+    if (modelsMap.empty())
     {
-      std::cout << "Received model list (took " << duration.count() << "ms)."
+      std::cout << "Either failed to fetch model list from "
+                << server.Url().Str() << ", or server has no models yet."
                 << std::endl;
+      continue;
     }
 
-    // Print all models
     if (pretty)
       prettyPrint(server, modelsMap, "models");
     else
@@ -356,7 +457,8 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listModels(const char *_url,
 
 //////////////////////////////////////////////////
 extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listWorlds(const char *_url,
-    const char *_owner, const char *_raw, const char *_configFile)
+    const char *_owner, const char *_raw, const char *_configFile,
+    const char *_stream, const char *_json)
 {
   std::string urlStr{_url};
   if (!urlStr.empty() && !ignition::common::URI::Valid(_url))
@@ -371,6 +473,9 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listWorlds(const char *_url,
   std::transform(rawStr.begin(), rawStr.end(),
                  rawStr.begin(), ::tolower);
   bool pretty = rawStr != "true";
+  bool json = _json && ignition::common::lowercase(_json) == "true";
+  bool stream = json ||
+      (_stream && ignition::common::lowercase(_stream) == "true");
 
   // Client
   ignition::fuel_tools::ClientConfig conf;
@@ -397,44 +502,74 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listWorlds(const char *_url,
 
   ignition::fuel_tools::FuelClient client(conf);
 
-  // Get worlds
-  for (auto server : conf.Servers())
+  // Print each page as it arrives, requesting all servers concurrently
+  if (stream)
   {
-    worldId.SetServer(server);
+    std::atomic<bool> success{true};
+    std::vector<std::thread> threads;
+    for (auto server : conf.Servers())
+    {
+      threads.emplace_back([&, server]()
+      {
+        auto id = worldId;
+        id.SetServer(server);
+        if (!streamWorlds(client, id, json))
+          success = false;
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+    return success;
+  }
 
-    if (pretty)
+  auto servers = conf.Servers();
+  if (pretty)
+  {
+    for (const auto &server : servers)
     {
       std::cout << "Fetching world list from " << server.Url().Str() << "..."
                 << std::endl;
     }
+  }
 
-    auto startTime = std::chrono::high_resolution_clock::now();
+  auto startTime = std::chrono::high_resolution_clock::now();
 
-    std::map<std::string, std::vector<std::string>> worldsMap;
+  // All servers are requested concurrently
+  auto iter = client.WorldsFromAllServers(owner);
 
-    // All worlds
-    if (owner.empty())
-    {
-      if (!getAllWorlds(client, server, worldsMap))
-        continue;
-    }
-    else
-    {
-      if (!getOwnerWorlds(client, worldId, worldsMap))
-        continue;
-    }
+  // Rearrange by server and owner
+  // key: server URL
+  // value: map with owner name as key and vector of world names as value
+  std::map<std::string, std::map<std::string, std::vector<std::string>>>
+      serversMap;
+  for (; iter; ++iter)
+  {
+    serversMap[iter->Server().Url().Str()][iter->Owner()]
+        .push_back(iter->Name());
+  }
 
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        endTime - startTime);
+  auto endTime = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      endTime - startTime);
 
-    if (pretty)
+  if (pretty)
+  {
+    std::cout << "Received world list (took " << duration.count() << "ms)."
+              << std::endl;
+  }
+
+  // Print all worlds
+  for (const auto &server : servers)
+  {
+    const auto &worldsMap = serversMap[server.Url().Str()];
+    if (worldsMap.empty())
     {
-      std::cout << "Received world list (took " << duration.count() << "ms)."
+      std::cout << "Either failed to fetch world list from "
+                << server.Url().Str() << ", or server has no worlds yet."
                 << std::endl;
+      continue;
     }
 
-    // Print all worlds
     if (pretty)
       prettyPrint(server, worldsMap, "worlds");
     else
@@ -522,7 +657,10 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int downloadUrl(const char *_url,
               << std::endl;
     }
 
-    ignition::fuel_tools::Result result = client.DownloadWorld(world);
+    ignition::fuel_tools::DownloadOptions options;
+    if (_header && strlen(_header) > 0)
+      options.SetHeaders({_header});
+    ignition::fuel_tools::Result result = client.DownloadWorld(world, options);
 
     if (!result)
     {
@@ -546,9 +684,1892 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int downloadUrl(const char *_url,
 }
 
 //////////////////////////////////////////////////
-extern "C" IGNITION_FUEL_TOOLS_VISIBLE void cmdVerbosity(const char *_verbosity)
+/// \brief Outcome of downloading a single resource with downloadUrls.
+struct DownloadItem
 {
-  ignition::common::Console::SetVerbosity(std::atoi(_verbosity));
+  /// \brief Resource URL, as given by the user.
+  std::string url;
+
+  /// \brief True if the resource was downloaded.
+  bool success{false};
+
+  /// \brief Reason of the failure, if any.
+  std::string error;
+
+  /// \brief Local path of the downloaded resource.
+  std::string path;
+
+  /// \brief Size on disk of the downloaded resource.
+  uint64_t bytes{0};
+
+  /// \brief Time it took to download the resource.
+  std::chrono::milliseconds duration{0};
+};
+
+//////////////////////////////////////////////////
+/// \brief Recursively compute the size of all the files in a directory.
+/// \param[in] _path Directory to process.
+/// \return Size in bytes.
+uint64_t directorySize(const std::string &_path)
+{
+  uint64_t size{0};
+  ignition::common::DirIter end;
+  for (ignition::common::DirIter dirIter(_path); dirIter != end; ++dirIter)
+  {
+    if (ignition::common::isDirectory(*dirIter))
+    {
+      size += directorySize(*dirIter);
+    }
+    else
+    {
+      std::ifstream in(*dirIter, std::ifstream::ate | std::ifstream::binary);
+      if (in.good())
+        size += static_cast<uint64_t>(in.tellg());
+    }
+  }
+  return size;
+}
+
+//////////////////////////////////////////////////
+/// \brief Format a number of bytes in a human readable manner.
+/// \param[in] _bytes Number of bytes.
+/// \return Formatted string, such as "3.2 MB".
+std::string formatBytes(double _bytes)
+{
+  const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+  unsigned int unit{0};
+  while (_bytes >= 1024.0 && unit < 4)
+  {
+    _bytes /= 1024.0;
+    ++unit;
+  }
+
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << _bytes
+         << " " << units[unit];
+  return stream.str();
+}
+
+//////////////////////////////////////////////////
+/// \brief Download a single model or world, without printing anything.
+/// \param[in] _client Fuel client shared by all the downloads.
+/// \param[in] _headers HTTP headers.
+/// \param[in,out] _item Item to download, which will be filled with the
+/// outcome of the download.
+void downloadResource(ignition::fuel_tools::FuelClient &_client,
+    const std::vector<std::string> &_headers, DownloadItem &_item)
+{
+  ignition::common::URI url(_item.url);
+  if (!url.Valid())
+  {
+    _item.error = "Malformed URL";
+    return;
+  }
+
+  ignition::fuel_tools::ModelIdentifier model;
+  ignition::fuel_tools::WorldIdentifier world;
+
+  if (_client.ParseModelUrl(url, model))
+  {
+    auto result = _headers.empty() ? _client.DownloadModel(model) :
+        _client.DownloadModel(model, _headers);
+    if (!result)
+    {
+      _item.error = result.ReadableResult();
+      return;
+    }
+    _client.CachedModel(url, _item.path);
+  }
+  else if (_client.ParseWorldUrl(url, world))
+  {
+    ignition::fuel_tools::DownloadOptions options;
+    options.SetHeaders(_headers);
+    auto result = _client.DownloadWorld(world, options);
+    if (!result)
+    {
+      _item.error = result.ReadableResult();
+      return;
+    }
+    _item.path = world.LocalPath();
+  }
+  else
+  {
+    _item.error = "Invalid URL: only models and worlds can be downloaded";
+    return;
+  }
+
+  _item.success = true;
+  if (!_item.path.empty())
+    _item.bytes = directorySize(_item.path);
+}
+
+//////////////////////////////////////////////////
+/// \brief Gather resource URLs from the command line and a manifest file,
+/// skipping duplicates, empty lines and comments.
+/// \param[in] _urls Newline separated list of resource URLs.
+/// \param[in] _manifest Path to a file containing one resource URL per line.
+/// \param[out] _result Unique URLs, in the order they were given.
+/// \return False if the manifest couldn't be read.
+bool collectUrls(const char *_urls, const char *_manifest,
+    std::vector<std::string> &_result)
+{
+  std::set<std::string> uniqueUrls;
+  auto addUrl = [&_result, &uniqueUrls](const std::string &_line)
+  {
+    std::string url = ignition::common::trimmed(_line);
+    if (url.empty() || url[0] == '#')
+      return;
+    if (uniqueUrls.insert(url).second)
+      _result.push_back(url);
+  };
+
+  if (_urls)
+  {
+    for (const auto &url : ignition::common::Split(_urls, '\n'))
+      addUrl(url);
+  }
+
+  if (_manifest && strlen(_manifest) > 0)
+  {
+    std::ifstream manifest(_manifest);
+    if (!manifest.is_open())
+    {
+      std::cout << "Unable to open manifest [" << _manifest << "]"
+                << std::endl;
+      return false;
+    }
+
+    std::string line;
+    while (std::getline(manifest, line))
+      addUrl(line);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Parse the number of jobs given on the command line.
+/// \param[in] _jobs Number of jobs, as text. Empty means 1.
+/// \param[out] _result Number of jobs, at least 1.
+/// \return False if the number couldn't be parsed.
+bool parseJobs(const char *_jobs, unsigned int &_result)
+{
+  _result = 1;
+  if (!_jobs || strlen(_jobs) == 0)
+    return true;
+
+  try
+  {
+    _result = std::max(1, std::stoi(_jobs));
+  }
+  catch(...)
+  {
+    std::cout << "Invalid number of jobs [" << _jobs << "]" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int downloadUrls(const char *_urls,
+    const char *_manifest, const char *_configFile, const char *_header,
+    const char *_jobs)
+{
+  // Gather URLs from the command line and the manifest, skipping duplicates.
+  std::vector<std::string> urls;
+  if (!collectUrls(_urls, _manifest, urls))
+    return false;
+
+  if (urls.empty())
+  {
+    std::cout << "No resource URLs to download." << std::endl;
+    return false;
+  }
+
+  unsigned int jobs{1};
+  if (!parseJobs(_jobs, jobs))
+    return false;
+  jobs = std::min(jobs, static_cast<unsigned int>(urls.size()));
+
+  // Client, shared by all the downloads
+  ignition::fuel_tools::ClientConfig conf;
+  if (_configFile && strlen(_configFile) > 0)
+  {
+    conf.Clear();
+    conf.LoadConfig(_configFile);
+  }
+
+  conf.SetUserAgent("FuelTools " IGNITION_FUEL_TOOLS_VERSION_FULL);
+
+  ignition::fuel_tools::FuelClient client(conf);
+  client.SetDownloadConcurrency(
+      ignition::fuel_tools::DownloadPriority::FOREGROUND, jobs);
+
+  std::vector<std::string> headers;
+  if (_header && strlen(_header) > 0)
+    headers.push_back(_header);
+
+  std::vector<DownloadItem> items(urls.size());
+  for (size_t i = 0; i < urls.size(); ++i)
+    items[i].url = urls[i];
+
+  // Only redraw the progress line when a person is watching.
+  bool interactive = ign_isatty(ign_fileno(stdout)) != 0;
+
+  std::atomic<size_t> next{0};
+  std::mutex progressMutex;
+  size_t completed{0};
+  size_t failed{0};
+  uint64_t totalBytes{0};
+
+  auto startTime = std::chrono::steady_clock::now();
+
+  auto worker = [&]()
+  {
+    for (size_t i = next++; i < items.size(); i = next++)
+    {
+      auto itemStart = std::chrono::steady_clock::now();
+      downloadResource(client, headers, items[i]);
+      items[i].duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - itemStart);
+
+      std::lock_guard<std::mutex> lock(progressMutex);
+      ++completed;
+      if (!items[i].success)
+        ++failed;
+      totalBytes += items[i].bytes;
+
+      if (interactive)
+      {
+        double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "\r\033[K[" << completed << "/" << items.size() << "] "
+                  << (completed - failed) << " succeeded, " << failed
+                  << " failed, " << formatBytes(totalBytes) << " ("
+                  << formatBytes(elapsed > 0 ? totalBytes / elapsed : 0)
+                  << "/s)" << std::flush;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < jobs; ++i)
+    workers.emplace_back(worker);
+  for (auto &thread : workers)
+    thread.join();
+
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - startTime).count();
+
+  if (interactive)
+    std::cout << std::endl;
+
+  // Summary, colored only for a terminal
+  auto color = [interactive](const char *_code)
+  {
+    return interactive ? _code : "";
+  };
+  for (const auto &item : items)
+  {
+    if (item.success)
+    {
+      std::cout << color("\033[92m") << "[ok]" << color("\033[39m")
+                << "     " << item.url << " (" << item.duration.count()
+                << "ms, " << formatBytes(item.bytes) << ")" << std::endl;
+    }
+    else
+    {
+      std::cout << color("\033[91m") << "[failed]" << color("\033[39m")
+                << " " << item.url << ": " << item.error << std::endl;
+    }
+  }
+
+  std::cout << color("\033[36m") << (completed - failed) << " of "
+            << items.size() << " resources downloaded in " << std::fixed
+            << std::setprecision(1) << elapsed << "s using " << jobs
+            << " jobs (" << std::setprecision(2)
+            << (elapsed > 0 ? (completed - failed) / elapsed : 0)
+            << " resources/s, "
+            << formatBytes(elapsed > 0 ? totalBytes / elapsed : 0) << "/s)"
+            << color("\033[39m") << std::endl;
+
+  return failed == 0;
+}
+
+//////////////////////////////////////////////////
+/// \brief Resolve a model or world URL to an exact version and archive
+/// hash, downloading the resource if it isn't cached yet.
+/// \param[in] _client Fuel client shared by all the resources. It must not
+/// be using a lockfile, so that unversioned URLs resolve to the tip.
+/// \param[in] _cache Cache used by the client.
+/// \param[in] _headers HTTP headers.
+/// \param[in] _url Resource URL.
+/// \param[out] _entry Lock entry of the resource.
+/// \param[out] _error Reason of the failure, if any.
+/// \return True if the resource was resolved.
+bool lockResource(ignition::fuel_tools::FuelClient &_client,
+    const ignition::fuel_tools::LocalCache &_cache,
+    const std::vector<std::string> &_headers, const std::string &_url,
+    ignition::fuel_tools::LockEntry &_entry, std::string &_error)
+{
+  ignition::common::URI url(_url);
+  if (!url.Valid())
+  {
+    _error = "Malformed URL";
+    return false;
+  }
+
+  const std::string cacheLocation = _client.Config().CacheLocation();
+  ignition::fuel_tools::ModelIdentifier model;
+  ignition::fuel_tools::WorldIdentifier world;
+  std::string path;
+
+  if (_client.ParseModelUrl(url, model))
+  {
+    if (model.Version() == 0)
+    {
+      ignition::fuel_tools::ModelIdentifier details;
+      auto result = _client.ModelDetails(model, details);
+      if (!result || details.Version() == 0)
+      {
+        _error = "Unable to resolve the latest version";
+        return false;
+      }
+      model.SetVersion(details.Version());
+    }
+
+    path = ignition::common::joinPaths(cacheLocation,
+        model.Server().Url().Path().Str(), model.Owner(), "models",
+        model.Name(), model.VersionStr());
+
+    // Versions saved from a delta have no archive hash. Downloading a
+    // version which is already cached always fetches its whole archive,
+    // which records it.
+    if (_cache.ArchiveHash(path).empty())
+    {
+      auto result = _headers.empty() ? _client.DownloadModel(model) :
+          _client.DownloadModel(model, _headers);
+      if (!result)
+      {
+        _error = result.ReadableResult();
+        return false;
+      }
+    }
+
+    _entry.server = model.Server().Url().Str();
+    _entry.owner = model.Owner();
+    _entry.type = "models";
+    _entry.name = model.Name();
+    _entry.version = model.Version();
+  }
+  else if (_client.ParseWorldUrl(url, world))
+  {
+    if (world.Version() == 0)
+    {
+      ignition::fuel_tools::WorldIdentifier details;
+      auto result = _client.WorldDetails(world, details);
+      if (!result || details.Version() == 0)
+      {
+        _error = "Unable to resolve the latest version";
+        return false;
+      }
+      world.SetVersion(details.Version());
+    }
+
+    path = ignition::common::joinPaths(cacheLocation,
+        world.Server().Url().Path().Str(), world.Owner(), "worlds",
+        world.Name(), world.VersionStr());
+    if (_cache.ArchiveHash(path).empty())
+    {
+      auto result = _client.DownloadWorld(world);
+      if (!result)
+      {
+        _error = result.ReadableResult();
+        return false;
+      }
+    }
+
+    _entry.server = world.Server().Url().Str();
+    _entry.owner = world.Owner();
+    _entry.type = "worlds";
+    _entry.name = world.Name();
+    _entry.version = world.Version();
+  }
+  else
+  {
+    _error = "Invalid URL: only models and worlds can be locked";
+    return false;
+  }
+
+  _entry.url = _url;
+  _entry.hash = _cache.ArchiveHash(path);
+  if (_entry.hash.empty())
+  {
+    _error = "Missing archive hash of version " +
+        std::to_string(_entry.version);
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int lockResources(const char *_urls,
+    const char *_manifest, const char *_output, const char *_configFile,
+    const char *_header, const char *_jobs)
+{
+  if (!_output || strlen(_output) == 0)
+  {
+    std::cout << "Missing lockfile path." << std::endl;
+    return false;
+  }
+
+  std::vector<std::string> urls;
+  if (!collectUrls(_urls, _manifest, urls))
+    return false;
+
+  if (urls.empty())
+  {
+    std::cout << "No resource URLs to lock." << std::endl;
+    return false;
+  }
+
+  unsigned int jobs{1};
+  if (!parseJobs(_jobs, jobs))
+    return false;
+  jobs = std::min(jobs, static_cast<unsigned int>(urls.size()));
+
+  // Update an existing lockfile, so that resources which aren't listed this
+  // time stay pinned.
+  ignition::fuel_tools::Lockfile lockfile;
+  if (ignition::common::exists(_output) && !lockfile.Load(_output))
+  {
+    std::cout << "Unable to read lockfile [" << _output << "]" << std::endl;
+    return false;
+  }
+
+  ignition::fuel_tools::ClientConfig conf;
+  if (_configFile && strlen(_configFile) > 0)
+  {
+    conf.Clear();
+    conf.LoadConfig(_configFile);
+  }
+
+  conf.SetUserAgent("FuelTools " IGNITION_FUEL_TOOLS_VERSION_FULL);
+  // Resolve against the server, not against a previous lockfile.
+  conf.SetLockfilePath("");
+
+  ignition::fuel_tools::FuelClient client(conf);
+  client.SetDownloadConcurrency(
+      ignition::fuel_tools::DownloadPriority::FOREGROUND, jobs);
+  ignition::fuel_tools::LocalCache cache(&conf);
+
+  std::vector<std::string> headers;
+  if (_header && strlen(_header) > 0)
+    headers.push_back(_header);
+
+  std::atomic<size_t> next{0};
+  std::mutex lockfileMutex;
+  size_t failed{0};
+
+  auto worker = [&]()
+  {
+    for (size_t i = next++; i < urls.size(); i = next++)
+    {
+      ignition::fuel_tools::LockEntry entry;
+      std::string error;
+      bool success = lockResource(client, cache, headers, urls[i], entry,
+          error);
+
+      std::lock_guard<std::mutex> lock(lockfileMutex);
+      if (!success)
+      {
+        ++failed;
+        std::cout << "\033[91m[failed]\033[39m " << urls[i] << ": " << error
+                  << std::endl;
+        continue;
+      }
+
+      lockfile.Set(entry);
+      std::cout << "\033[92m[locked]\033[39m " << urls[i] << " -> version "
+                << entry.version << " (" << entry.hash << ")" << std::endl;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < jobs; ++i)
+    workers.emplace_back(worker);
+  for (auto &thread : workers)
+    thread.join();
+
+  if (!lockfile.Save(_output))
+  {
+    std::cout << "Unable to write lockfile [" << _output << "]" << std::endl;
+    return false;
+  }
+
+  std::cout << "\033[36mLocked " << (urls.size() - failed) << " of "
+            << urls.size() << " resources in [" << _output << "]"
+            << "\033[39m" << std::endl;
+
+  return failed == 0;
+}
+
+//////////////////////////////////////////////////
+/// \brief Measurements gathered while running one benchmark scenario.
+struct BenchResult
+{
+  /// \brief Scenario name, such as "extract".
+  std::string name;
+
+  /// \brief Latency of each operation, in milliseconds.
+  std::vector<double> samples;
+
+  /// \brief Number of operations which failed.
+  uint64_t errors{0};
+
+  /// \brief Bytes processed by all the operations.
+  uint64_t bytes{0};
+
+  /// \brief Wall clock time spent running the scenario, in seconds.
+  double seconds{0};
+
+  /// \brief Scenario specific information, such as the number of entries.
+  Json::Value extra{Json::objectValue};
+};
+
+//////////////////////////////////////////////////
+/// \brief Options shared by all the benchmark scenarios.
+struct BenchOptions
+{
+  /// \brief Server used by the list and download scenarios. It may be a live
+  /// server or a local stand-in.
+  ignition::fuel_tools::ServerConfig server;
+
+  /// \brief Client configuration, as loaded from the command line.
+  ignition::fuel_tools::ClientConfig config;
+
+  /// \brief HTTP headers used for downloads.
+  std::vector<std::string> headers;
+
+  /// \brief Resource URLs, used by the parse and download scenarios.
+  std::vector<std::string> urls;
+
+  /// \brief Archives used by the extract scenario.
+  std::vector<std::string> archives;
+
+  /// \brief Scratch directory, removed once the benchmark finishes.
+  std::string workDir;
+
+  /// \brief Number of times each scenario is repeated.
+  unsigned int iterations{5};
+
+  /// \brief Number of concurrent operations.
+  unsigned int jobs{4};
+};
+
+//////////////////////////////////////////////////
+/// \brief Time a single operation.
+/// \param[in] _func Operation, returning true on success.
+/// \param[in,out] _result Result which the sample is added to.
+template<typename Func>
+void benchSample(Func _func, BenchResult &_result)
+{
+  auto start = std::chrono::steady_clock::now();
+  bool success = _func();
+  _result.samples.push_back(std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count());
+  if (!success)
+    ++_result.errors;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get a percentile out of sorted samples, using the nearest rank.
+/// \param[in] _sorted Samples sorted in ascending order.
+/// \param[in] _percentile Percentile between 0 and 100.
+/// \return The percentile, or 0 if there are no samples.
+double benchPercentile(const std::vector<double> &_sorted, double _percentile)
+{
+  if (_sorted.empty())
+    return 0;
+
+  auto rank = static_cast<size_t>(
+      std::ceil(_percentile / 100.0 * _sorted.size()));
+  return _sorted[std::min(std::max<size_t>(rank, 1), _sorted.size()) - 1];
+}
+
+//////////////////////////////////////////////////
+/// \brief Convert the result of a scenario to JSON.
+/// \param[in] _result Result to convert.
+/// \return JSON object with throughput and latency percentiles.
+Json::Value benchJson(const BenchResult &_result)
+{
+  std::vector<double> sorted = _result.samples;
+  std::sort(sorted.begin(), sorted.end());
+
+  double total{0};
+  for (auto sample : sorted)
+    total += sample;
+
+  Json::Value latency;
+  latency["min"] = sorted.empty() ? 0.0 : sorted.front();
+  latency["mean"] = sorted.empty() ? 0.0 : total / sorted.size();
+  latency["p50"] = benchPercentile(sorted, 50);
+  latency["p90"] = benchPercentile(sorted, 90);
+  latency["p99"] = benchPercentile(sorted, 99);
+  latency["max"] = sorted.empty() ? 0.0 : sorted.back();
+
+  Json::Value value;
+  value["name"] = _result.name;
+  value["operations"] = static_cast<Json::UInt64>(sorted.size());
+  value["errors"] = static_cast<Json::UInt64>(_result.errors);
+  value["seconds"] = _result.seconds;
+  value["bytes"] = static_cast<Json::UInt64>(_result.bytes);
+  value["operations_per_second"] = _result.seconds > 0 ?
+      sorted.size() / _result.seconds : 0.0;
+  value["bytes_per_second"] = _result.seconds > 0 ?
+      _result.bytes / _result.seconds : 0.0;
+  value["latency_ms"] = latency;
+  for (const auto &key : _result.extra.getMemberNames())
+    value[key] = _result.extra[key];
+  return value;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the peak resident set size of this process.
+/// \return Size in bytes, or 0 if unknown.
+uint64_t benchPeakRss()
+{
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024u;
+#endif
+#endif
+}
+
+//////////////////////////////////////////////////
+/// \brief Write a synthetic model to disk. The content only depends on the
+/// index, so runs are reproducible.
+/// \param[in] _dir Model directory.
+/// \param[in] _index Model index, used for its name and as random seed.
+/// \param[in] _meshSize Size of the mesh file in bytes.
+void benchWriteModel(const std::string &_dir, unsigned int _index,
+    size_t _meshSize)
+{
+  std::string name = "model_" + std::to_string(_index);
+  ignition::common::createDirectories(
+      ignition::common::joinPaths(_dir, "meshes"));
+
+  std::ofstream config(ignition::common::joinPaths(_dir, "model.config"));
+  config << "<?xml version=\"1.0\"?>\n<model>\n  <name>" << name
+         << "</name>\n  <version>1.0</version>\n"
+         << "  <sdf version=\"1.6\">model.sdf</sdf>\n</model>\n";
+
+  std::ofstream sdf(ignition::common::joinPaths(_dir, "model.sdf"));
+  sdf << "<?xml version=\"1.0\"?>\n<sdf version=\"1.6\">\n  <model name=\""
+      << name << "\">\n    <link name=\"link\">\n      <visual name=\"v\">\n"
+      << "        <geometry><mesh><uri>model://" << name
+      << "/meshes/mesh.dae</uri></mesh></geometry>\n      </visual>\n"
+      << "    </link>\n  </model>\n</sdf>\n";
+
+  std::minstd_rand random(_index + 1);
+  std::string mesh(_meshSize, '\0');
+  for (auto &c : mesh)
+    c = static_cast<char>('a' + random() % 26);
+  std::ofstream meshFile(
+      ignition::common::joinPaths(_dir, "meshes", "mesh.dae"),
+      std::ios::binary);
+  meshFile << mesh;
+}
+
+//////////////////////////////////////////////////
+/// \brief Time parsing of resource URLs.
+/// \param[in] _options Benchmark options.
+/// \return Scenario result.
+BenchResult benchParse(const BenchOptions &_options)
+{
+  BenchResult result;
+  result.name = "parse";
+
+  std::vector<std::string> urls = _options.urls;
+  if (urls.empty())
+  {
+    for (unsigned int i = 0; i < 100; ++i)
+    {
+      std::string model = "https://fuel.bench/1.0/bench/models/model_" +
+          std::to_string(i);
+      urls.push_back(model);
+      urls.push_back(model + "/" + std::to_string(i % 5 + 1));
+      urls.push_back(model + "/tip/files/meshes/mesh.dae");
+      urls.push_back("https://fuel.bench/1.0/bench/worlds/world_" +
+          std::to_string(i));
+    }
+  }
+
+  ignition::fuel_tools::ClientConfig config;
+  config.SetCacheLocation(
+      ignition::common::joinPaths(_options.workDir, "parse"));
+  ignition::fuel_tools::FuelClient client(config);
+
+  std::vector<ignition::common::URI> uris;
+  for (const auto &url : urls)
+    uris.emplace_back(url);
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int it = 0; it < _options.iterations; ++it)
+  {
+    for (const auto &uri : uris)
+    {
+      benchSample([&]()
+      {
+        ignition::fuel_tools::ModelIdentifier model;
+        ignition::fuel_tools::WorldIdentifier world;
+        std::string filePath;
+        return client.ParseModelUrl(uri, model) ||
+            client.ParseWorldUrl(uri, world) ||
+            client.ParseModelFileUrl(uri, model, filePath);
+      }, result);
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  result.extra["urls"] = static_cast<Json::UInt64>(uris.size());
+  return result;
+}
+
+//////////////////////////////////////////////////
+/// \brief Time many concurrent lookups in a cache with synthetic entries.
+/// \param[in] _options Benchmark options.
+/// \return Scenario result.
+BenchResult benchCache(const BenchOptions &_options)
+{
+  BenchResult result;
+  result.name = "cache";
+
+  const unsigned int kEntries{256};
+  const unsigned int kLookupsPerJob{50};
+
+  std::string cacheDir = ignition::common::joinPaths(_options.workDir,
+      "cache");
+  for (unsigned int i = 0; i < kEntries; ++i)
+  {
+    benchWriteModel(ignition::common::joinPaths(cacheDir, "fuel.bench",
+        "bench", "models", "model_" + std::to_string(i), "1"), i, 64);
+  }
+
+  ignition::fuel_tools::ClientConfig config;
+  config.Clear();
+  config.SetCacheLocation(cacheDir);
+  ignition::fuel_tools::ServerConfig server;
+  server.SetUrl(ignition::common::URI("https://fuel.bench"));
+  config.AddServer(server);
+  ignition::fuel_tools::FuelClient client(config);
+
+  std::mutex mutex;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int it = 0; it < _options.iterations; ++it)
+  {
+    std::vector<std::thread> workers;
+    for (unsigned int job = 0; job < _options.jobs; ++job)
+    {
+      workers.emplace_back([&, job]()
+      {
+        BenchResult local;
+        for (unsigned int i = 0; i < kLookupsPerJob; ++i)
+        {
+          // Mostly hits, with one miss every 10 lookups.
+          unsigned int index = (job * kLookupsPerJob + i) % kEntries;
+          std::string name = i % 10 == 9 ? "missing_" + std::to_string(i) :
+              "model_" + std::to_string(index);
+          ignition::common::URI uri(
+              "https://fuel.bench/1.0/bench/models/" + name);
+          benchSample([&]()
+          {
+            std::string path;
+            return client.CachedModel(uri, path) || i % 10 == 9;
+          }, local);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        result.samples.insert(result.samples.end(), local.samples.begin(),
+            local.samples.end());
+        result.errors += local.errors;
+      });
+    }
+    for (auto &worker : workers)
+      worker.join();
+  }
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  result.extra["entries"] = kEntries;
+  result.extra["jobs"] = _options.jobs;
+  return result;
+}
+
+//////////////////////////////////////////////////
+/// \brief Time extraction of model archives, without any network access.
+/// \param[in] _options Benchmark options.
+/// \return Scenario result.
+BenchResult benchExtract(const BenchOptions &_options)
+{
+  BenchResult result;
+  result.name = "extract";
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int it = 0; it < _options.iterations; ++it)
+  {
+    std::string dir = ignition::common::joinPaths(_options.workDir,
+        "extract", std::to_string(it));
+    for (size_t i = 0; i < _options.archives.size(); ++i)
+    {
+      const auto &archive = _options.archives[i];
+      benchSample([&]()
+      {
+        return ignition::fuel_tools::Zip::Extract(archive,
+            ignition::common::joinPaths(dir, std::to_string(i)));
+      }, result);
+
+      std::ifstream in(archive, std::ifstream::ate | std::ifstream::binary);
+      if (in.good())
+        result.bytes += static_cast<uint64_t>(in.tellg());
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  result.extra["archives"] =
+      static_cast<Json::UInt64>(_options.archives.size());
+  return result;
+}
+
+//////////////////////////////////////////////////
+/// \brief Time fetching the whole model catalog of the server.
+/// \param[in] _options Benchmark options.
+/// \return Scenario result.
+BenchResult benchList(const BenchOptions &_options)
+{
+  BenchResult result;
+  result.name = "list";
+
+  ignition::fuel_tools::FuelClient client(_options.config);
+
+  uint64_t models{0};
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int it = 0; it < _options.iterations; ++it)
+  {
+    benchSample([&]()
+    {
+      models = 0;
+      for (auto iter = client.Models(_options.server); iter; ++iter)
+        ++models;
+      return models > 0;
+    }, result);
+  }
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  result.extra["server"] = _options.server.Url().Str();
+  result.extra["models"] = static_cast<Json::UInt64>(models);
+  return result;
+}
+
+//////////////////////////////////////////////////
+/// \brief Time parallel downloads into an empty cache.
+/// \param[in] _options Benchmark options.
+/// \return Scenario result.
+BenchResult benchDownload(const BenchOptions &_options)
+{
+  BenchResult result;
+  result.name = "download";
+
+  // Without explicit URLs, download the first few models of the server.
+  std::vector<std::string> urls = _options.urls;
+  if (urls.empty())
+  {
+    ignition::fuel_tools::FuelClient client(_options.config);
+    for (auto iter = client.Models(_options.server);
+         iter && urls.size() < _options.jobs * 2; ++iter)
+    {
+      auto id = iter->Identification();
+      urls.push_back(resourceUrl(_options.server, id.Owner(), "models",
+          id.Name()));
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int it = 0; it < _options.iterations; ++it)
+  {
+    // Start every iteration from a cold cache.
+    ignition::fuel_tools::ClientConfig config = _options.config;
+    config.SetCacheLocation(ignition::common::joinPaths(_options.workDir,
+        "download", std::to_string(it)));
+    ignition::fuel_tools::FuelClient client(config);
+    client.SetDownloadConcurrency(
+        ignition::fuel_tools::DownloadPriority::FOREGROUND, _options.jobs);
+
+    std::vector<DownloadItem> items(urls.size());
+    for (size_t i = 0; i < urls.size(); ++i)
+      items[i].url = urls[i];
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]()
+    {
+      for (size_t i = next++; i < items.size(); i = next++)
+      {
+        auto itemStart = std::chrono::steady_clock::now();
+        downloadResource(client, _options.headers, items[i]);
+        items[i].duration =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - itemStart);
+      }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < _options.jobs; ++i)
+      workers.emplace_back(worker);
+    for (auto &thread : workers)
+      thread.join();
+
+    for (const auto &item : items)
+    {
+      result.samples.push_back(static_cast<double>(item.duration.count()));
+      result.bytes += item.bytes;
+      if (!item.success)
+        ++result.errors;
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  if (urls.empty())
+    ++result.errors;
+  result.extra["resources"] = static_cast<Json::UInt64>(urls.size());
+  result.extra["jobs"] = _options.jobs;
+  return result;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int bench(const char *_scenarios,
+    const char *_url, const char *_fixture, const char *_manifest,
+    const char *_iterations, const char *_jobs, const char *_output,
+    const char *_configFile, const char *_header)
+{
+  const std::vector<std::string> kAllScenarios{
+    "parse", "cache", "extract", "list", "download"};
+
+  std::vector<std::string> scenarios;
+  std::string scenariosStr = _scenarios ? _scenarios : "";
+  if (scenariosStr.empty() || scenariosStr == "all")
+  {
+    scenarios = kAllScenarios;
+  }
+  else
+  {
+    for (const auto &name : ignition::common::Split(scenariosStr, ','))
+    {
+      auto scenario = ignition::common::trimmed(name);
+      if (std::find(kAllScenarios.begin(), kAllScenarios.end(), scenario) ==
+          kAllScenarios.end())
+      {
+        std::cout << "Unknown scenario [" << scenario << "]. Available "
+                  << "scenarios: parse, cache, extract, list, download."
+                  << std::endl;
+        return false;
+      }
+      scenarios.push_back(scenario);
+    }
+  }
+
+  BenchOptions options;
+  try
+  {
+    if (_iterations && strlen(_iterations) > 0)
+      options.iterations = std::max(1, std::stoi(_iterations));
+    if (_jobs && strlen(_jobs) > 0)
+      options.jobs = std::max(1, std::stoi(_jobs));
+  }
+  catch(...)
+  {
+    std::cout << "Invalid number of iterations or jobs." << std::endl;
+    return false;
+  }
+
+  if (_configFile && strlen(_configFile) > 0)
+  {
+    options.config.Clear();
+    options.config.LoadConfig(_configFile);
+  }
+  options.config.SetUserAgent("FuelTools " IGNITION_FUEL_TOOLS_VERSION_FULL);
+
+  if (_url && strlen(_url) > 0)
+  {
+    if (!ignition::common::URI::Valid(_url))
+    {
+      std::cout << "Invalid URL [" << _url << "]" << std::endl;
+      return false;
+    }
+    options.server.SetUrl(ignition::common::URI(_url));
+  }
+  else if (!options.config.Servers().empty())
+  {
+    options.server = options.config.Servers().front();
+  }
+
+  if (_header && strlen(_header) > 0)
+    options.headers.push_back(_header);
+
+  // A recorded fixture is a directory with model archives and, optionally,
+  // a "urls.txt" file listing resource URLs.
+  std::string fixture = _fixture ? _fixture : "";
+  std::string manifest = _manifest ? _manifest : "";
+  if (!fixture.empty())
+  {
+    if (!ignition::common::isDirectory(fixture))
+    {
+      std::cout << "Fixture directory [" << fixture << "] doesn't exist."
+                << std::endl;
+      return false;
+    }
+
+    ignition::common::DirIter end;
+    for (ignition::common::DirIter file(fixture); file != end; ++file)
+    {
+      std::string path = *file;
+      if (path.size() > 4 && path.substr(path.size() - 4) == ".zip")
+        options.archives.push_back(path);
+    }
+    std::sort(options.archives.begin(), options.archives.end());
+
+    if (manifest.empty() && ignition::common::isFile(
+        ignition::common::joinPaths(fixture, "urls.txt")))
+    {
+      manifest = ignition::common::joinPaths(fixture, "urls.txt");
+    }
+  }
+
+  if (!manifest.empty())
+  {
+    std::ifstream in(manifest);
+    if (!in.is_open())
+    {
+      std::cout << "Unable to open manifest [" << manifest << "]"
+                << std::endl;
+      return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+      line = ignition::common::trimmed(line);
+      if (!line.empty() && line[0] != '#')
+        options.urls.push_back(line);
+    }
+  }
+
+  std::string tmpDir;
+  if (!ignition::common::env("TMPDIR", tmpDir) || tmpDir.empty())
+    tmpDir = ignition::common::cwd();
+  options.workDir = ignition::common::joinPaths(tmpDir, "ign-fuel-bench-" +
+      std::to_string(std::chrono::steady_clock::now().time_since_epoch()
+      .count()));
+  ignition::common::createDirectories(options.workDir);
+
+  // Without a fixture, extract archives of synthetic models.
+  if (options.archives.empty())
+  {
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+      std::string name = "model_" + std::to_string(i);
+      std::string dir = ignition::common::joinPaths(options.workDir,
+          "fixture", name);
+      benchWriteModel(dir, i, 256 * 1024);
+
+      std::string archive = dir + ".zip";
+      if (ignition::fuel_tools::Zip::Compress(dir, archive))
+        options.archives.push_back(archive);
+    }
+  }
+
+  Json::Value root;
+  root["version"] = IGNITION_FUEL_TOOLS_VERSION_FULL;
+  root["timestamp"] = formatDateTime(std::time(nullptr));
+  root["source"] = !fixture.empty() ? "fixture" : "synthetic";
+  root["server"] = options.server.Url().Str();
+  root["iterations"] = options.iterations;
+  root["jobs"] = options.jobs;
+  root["hardware_threads"] = std::thread::hardware_concurrency();
+  root["scenarios"] = Json::Value(Json::arrayValue);
+
+  bool success{true};
+  for (const auto &scenario : scenarios)
+  {
+    ignmsg << "Running [" << scenario << "] benchmark" << std::endl;
+
+    BenchResult result;
+    if (scenario == "parse")
+      result = benchParse(options);
+    else if (scenario == "cache")
+      result = benchCache(options);
+    else if (scenario == "extract")
+      result = benchExtract(options);
+    else if (scenario == "list")
+      result = benchList(options);
+    else if (scenario == "download")
+      result = benchDownload(options);
+
+    success = success && result.errors == 0;
+    root["scenarios"].append(benchJson(result));
+  }
+  root["peak_rss_bytes"] = static_cast<Json::UInt64>(benchPeakRss());
+
+  ignition::common::removeAll(options.workDir);
+
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "  ";
+  std::string json = Json::writeString(builder, root);
+
+  std::string output = _output ? _output : "";
+  if (output.empty())
+  {
+    std::cout << json << std::endl;
+  }
+  else
+  {
+    std::ofstream out(output);
+    if (!out.is_open())
+    {
+      std::cout << "Unable to write to [" << output << "]" << std::endl;
+      return false;
+    }
+    out << json << std::endl;
+  }
+
+  return success;
+}
+
+//////////////////////////////////////////////////
+/// \brief Load the client configuration used by the cache commands.
+/// \param[in] _configFile Path to a YAML configuration file, may be null.
+/// \return Client configuration.
+ignition::fuel_tools::ClientConfig cacheConfig(const char *_configFile)
+{
+  ignition::fuel_tools::ClientConfig conf;
+  if (_configFile && strlen(_configFile) > 0)
+  {
+    conf.Clear();
+    conf.LoadConfig(_configFile);
+  }
+  return conf;
+}
+
+//////////////////////////////////////////////////
+/// \brief Parse the number of threads used by the cache commands.
+/// \param[in] _jobs Number as a string. Empty means one per core.
+/// \param[out] _result Parsed number.
+/// \return True if the number is valid.
+bool cacheJobs(const char *_jobs, unsigned int &_result)
+{
+  _result = 0;
+  if (!_jobs || strlen(_jobs) == 0)
+    return true;
+
+  try
+  {
+    _result = static_cast<unsigned int>(std::max(1, std::stoi(_jobs)));
+  }
+  catch(...)
+  {
+    std::cout << "Invalid number of jobs [" << _jobs << "]" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the cache entries, optionally only of one owner.
+/// \param[in] _cache Local cache.
+/// \param[in] _owner Owner name, or empty for all owners.
+/// \param[in] _jobs Maximum number of threads.
+/// \return Matching entries.
+std::vector<ignition::fuel_tools::CacheEntry> cacheEntries(
+    const ignition::fuel_tools::LocalCache &_cache, const char *_owner,
+    unsigned int _jobs)
+{
+  auto entries = _cache.Entries(_jobs);
+  if (_owner && strlen(_owner) > 0)
+  {
+    std::string owner{_owner};
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [&owner](const ignition::fuel_tools::CacheEntry &_entry)
+        {
+          return _entry.owner != owner;
+        }), entries.end());
+  }
+  return entries;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get a short name for a cache entry.
+/// \param[in] _entry Cache entry.
+/// \return Name such as "server/owner/models/name/2".
+std::string cacheEntryName(const ignition::fuel_tools::CacheEntry &_entry)
+{
+  return _entry.server + "/" + _entry.owner + "/" + _entry.type + "/" +
+      _entry.name + "/" + std::to_string(_entry.version);
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cacheStats(const char *_owner,
+    const char *_json, const char *_jobs, const char *_configFile)
+{
+  unsigned int jobs;
+  if (!cacheJobs(_jobs, jobs))
+    return false;
+
+  auto conf = cacheConfig(_configFile);
+  ignition::fuel_tools::LocalCache cache(&conf);
+  auto entries = cacheEntries(cache, _owner, jobs);
+  auto stats = cache.Stats(entries, 10, jobs);
+
+  if (_json && std::string(_json) == "true")
+  {
+    Json::Value root;
+    root["path"] = conf.CacheLocation();
+    root["models"] = static_cast<Json::UInt64>(stats.models);
+    root["worlds"] = static_cast<Json::UInt64>(stats.worlds);
+    root["files"] = static_cast<Json::UInt64>(stats.files);
+    root["bytes"] = static_cast<Json::UInt64>(stats.bytes);
+    root["duplicate_bytes"] = static_cast<Json::UInt64>(stats.duplicateBytes);
+    for (const auto &server : stats.bytesPerServer)
+      root["servers"][server.first] = static_cast<Json::UInt64>(server.second);
+    for (const auto &owner : stats.bytesPerOwner)
+      root["owners"][owner.first] = static_cast<Json::UInt64>(owner.second);
+    root["largest"] = Json::Value(Json::arrayValue);
+    for (const auto &entry : stats.largest)
+    {
+      Json::Value value;
+      value["path"] = entry.path;
+      value["bytes"] = static_cast<Json::UInt64>(entry.bytes);
+      value["files"] = static_cast<Json::UInt64>(entry.files);
+      root["largest"].append(value);
+    }
+    std::cout << jsonLine(root) << std::endl;
+    return true;
+  }
+
+  std::cout << "Cache: " << conf.CacheLocation() << std::endl
+            << "  " << stats.models << " model versions, " << stats.worlds
+            << " world versions, " << stats.files << " files, "
+            << formatBytes(stats.bytes) << std::endl
+            << "  " << formatBytes(stats.duplicateBytes)
+            << " in duplicate files" << std::endl;
+
+  std::cout << std::endl << "Per server:" << std::endl;
+  for (const auto &server : stats.bytesPerServer)
+  {
+    std::cout << "  " << std::setw(10) << formatBytes(server.second) << "  "
+              << server.first << std::endl;
+  }
+
+  std::cout << std::endl << "Per owner:" << std::endl;
+  for (const auto &owner : stats.bytesPerOwner)
+  {
+    std::cout << "  " << std::setw(10) << formatBytes(owner.second) << "  "
+              << owner.first << std::endl;
+  }
+
+  if (!stats.largest.empty())
+  {
+    std::cout << std::endl << "Largest entries:" << std::endl;
+    for (const auto &entry : stats.largest)
+    {
+      std::cout << "  " << std::setw(10) << formatBytes(entry.bytes) << "  "
+                << cacheEntryName(entry) << std::endl;
+    }
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cachePrune(const char *_owner,
+    const char *_maxAge, const char *_maxSize, const char *_keepVersions,
+    const char *_dryRun, const char *_jobs, const char *_configFile)
+{
+  unsigned int jobs;
+  if (!cacheJobs(_jobs, jobs))
+    return false;
+
+  ignition::fuel_tools::CachePruneOptions options;
+  options.dryRun = _dryRun && std::string(_dryRun) == "true";
+  try
+  {
+    if (_maxAge && strlen(_maxAge) > 0)
+      options.maxAge = std::chrono::hours(24 * std::stoul(_maxAge));
+
+    if (_maxSize && strlen(_maxSize) > 0)
+    {
+      // Accept an optional K, M or G suffix.
+      std::string size{_maxSize};
+      uint64_t multiplier{1};
+      switch (toupper(size.back()))
+      {
+        case 'K': multiplier = 1ull << 10; break;
+        case 'M': multiplier = 1ull << 20; break;
+        case 'G': multiplier = 1ull << 30; break;
+        default: break;
+      }
+      if (multiplier > 1)
+        size.pop_back();
+      options.maxBytes = std::stoull(size) * multiplier;
+    }
+
+    if (_keepVersions && strlen(_keepVersions) > 0)
+      options.keepVersions = std::stoul(_keepVersions);
+  }
+  catch(...)
+  {
+    std::cout << "Invalid prune criteria." << std::endl;
+    return false;
+  }
+
+  if (options.maxAge.count() == 0 && options.maxBytes == 0 &&
+      options.keepVersions == 0)
+  {
+    std::cout << "Missing prune criteria (e.g. --max-age 30)." << std::endl;
+    return false;
+  }
+
+  auto conf = cacheConfig(_configFile);
+  ignition::fuel_tools::LocalCache cache(&conf);
+  auto entries = cacheEntries(cache, _owner, jobs);
+  auto removed = cache.Prune(entries, options, jobs);
+
+  uint64_t bytes{0};
+  for (const auto &entry : removed)
+  {
+    bytes += entry.bytes;
+    std::cout << (options.dryRun ? "Would remove " : "Removed ")
+              << cacheEntryName(entry) << " (" << formatBytes(entry.bytes)
+              << ")" << std::endl;
+  }
+
+  std::cout << (options.dryRun ? "Would remove " : "Removed ")
+            << removed.size() << " of " << entries.size() << " entries, "
+            << "freeing " << formatBytes(bytes) << std::endl;
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cacheVerify(const char *_owner,
+    const char *_jobs, const char *_configFile)
+{
+  unsigned int jobs;
+  if (!cacheJobs(_jobs, jobs))
+    return false;
+
+  auto conf = cacheConfig(_configFile);
+  ignition::fuel_tools::LocalCache cache(&conf);
+  auto entries = cacheEntries(cache, _owner, jobs);
+
+  auto startTime = std::chrono::steady_clock::now();
+  auto issues = cache.Verify(entries, jobs);
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - startTime).count();
+
+  for (const auto &issue : issues)
+  {
+    std::cout << "\033[91m[invalid]\033[39m " << issue.path << ": "
+              << issue.reason << std::endl;
+  }
+
+  std::cout << "Verified " << entries.size() << " entries in " << std::fixed
+            << std::setprecision(1) << elapsed << "s, found " << issues.size()
+            << " problems." << std::endl;
+
+  return issues.empty();
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cacheWarm(const char *_owner,
+    const char *_urls, const char *_jobs, const char *_configFile)
+{
+  unsigned int jobs;
+  if (!cacheJobs(_jobs, jobs))
+    return false;
+
+  auto conf = cacheConfig(_configFile);
+  ignition::fuel_tools::LocalCache cache(&conf);
+  auto entries = cacheEntries(cache, _owner, jobs);
+
+  // Only keep the resources given by URL, if any.
+  std::string urls = _urls ? _urls : "";
+  if (!urls.empty())
+  {
+    ignition::fuel_tools::FuelClient client(conf);
+    std::set<std::string> resources;
+    for (const auto &urlStr : ignition::common::Split(urls, '\n'))
+    {
+      ignition::common::URI url(urlStr);
+      ignition::fuel_tools::ModelIdentifier model;
+      ignition::fuel_tools::WorldIdentifier world;
+      if (client.ParseModelUrl(url, model))
+      {
+        resources.insert(model.Server().Url().Path().Str() + "/" +
+            model.Owner() + "/models/" + model.Name());
+      }
+      else if (client.ParseWorldUrl(url, world))
+      {
+        resources.insert(world.Server().Url().Path().Str() + "/" +
+            world.Owner() + "/worlds/" + world.Name());
+      }
+      else
+      {
+        std::cout << "Invalid URL [" << urlStr << "]" << std::endl;
+        return false;
+      }
+    }
+
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [&resources](const ignition::fuel_tools::CacheEntry &_entry)
+        {
+          return resources.find(_entry.server + "/" + _entry.owner + "/" +
+              _entry.type + "/" + _entry.name) == resources.end();
+        }), entries.end());
+  }
+
+  auto startTime = std::chrono::steady_clock::now();
+  auto bytes = cache.Warm(entries, jobs);
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - startTime).count();
+
+  std::cout << "Read " << formatBytes(bytes) << " from " << entries.size()
+            << " entries in " << std::fixed << std::setprecision(1)
+            << elapsed << "s ("
+            << formatBytes(elapsed > 0 ? bytes / elapsed : 0) << "/s)"
+            << std::endl;
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int serveCache(const char *_host,
+    const char *_port, const char *_socket, const char *_url,
+    const char *_prewarm, const char *_prewarmCount, const char *_ttl,
+    const char *_jobs, const char *_configFile)
+{
+  ignition::common::SignalHandler handler;
+  std::atomic<bool> sigKilled{false};
+  handler.AddCallback([&sigKilled](const int)
+  {
+    sigKilled = true;
+  });
+
+  unsigned int jobs;
+  if (!cacheJobs(_jobs, jobs))
+    return false;
+  if (jobs == 0)
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+
+  int port{8000};
+  int ttl{60};
+  int prewarmCount{0};
+  try
+  {
+    if (_port && strlen(_port) > 0)
+      port = std::stoi(_port);
+    if (_ttl && strlen(_ttl) > 0)
+      ttl = std::stoi(_ttl);
+    if (_prewarmCount && strlen(_prewarmCount) > 0)
+      prewarmCount = std::stoi(_prewarmCount);
+  }
+  catch(...)
+  {
+    std::cout << "Invalid number in the options." << std::endl;
+    return false;
+  }
+  if (port < 0 || port > 65535 || ttl < 0 || prewarmCount < 0)
+  {
+    std::cout << "Invalid port, TTL or prewarm count." << std::endl;
+    return false;
+  }
+
+  auto conf = cacheConfig(_configFile);
+  conf.SetUserAgent("FuelTools " IGNITION_FUEL_TOOLS_VERSION_FULL);
+
+  // Upstream server, defaulting to the first configured one.
+  ignition::fuel_tools::ServerConfig upstream;
+  if (_url && strlen(_url) > 0)
+    upstream.SetUrl(ignition::common::URI(_url));
+  else if (!conf.Servers().empty())
+    upstream = conf.Servers().front();
+
+  ignition::fuel_tools::CacheServer server(conf, upstream);
+  server.SetTtl(std::chrono::seconds(ttl));
+
+  std::string host = _host && strlen(_host) > 0 ? _host : "127.0.0.1";
+  bool started = _socket && strlen(_socket) > 0 ?
+      server.StartUnix(_socket) :
+      server.Start(host, static_cast<uint16_t>(port));
+  if (!started)
+    return false;
+
+  std::cout << "Caching [" << upstream.Url().Str() << "] at ["
+            << (_socket && strlen(_socket) > 0 ?
+                std::string(_socket) : server.Url()) << "]" << std::endl;
+
+  // Prewarm in the background, so requests are served meanwhile.
+  std::vector<std::string> urls = server.Popular(prewarmCount);
+  if (_prewarm && strlen(_prewarm) > 0)
+  {
+    std::ifstream manifest(_prewarm);
+    if (!manifest.is_open())
+    {
+      std::cout << "Unable to read [" << _prewarm << "]" << std::endl;
+      return false;
+    }
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+      line = ignition::common::trimmed(line);
+      if (!line.empty() && line[0] != '#')
+        urls.push_back(line);
+    }
+  }
+  std::thread prewarm([&server, urls, jobs]()
+  {
+    if (urls.empty())
+      return;
+    auto cached = server.Prewarm(urls, jobs);
+    ignmsg << "Prewarmed " << cached << " of " << urls.size()
+           << " resources." << std::endl;
+  });
+
+  while (!sigKilled)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  prewarm.join();
+  server.Stop();
+
+  auto stats = server.Stats();
+  std::cout << "Served " << stats.requests << " requests: " << stats.hits
+            << " hits, " << stats.misses << " misses, " << stats.coalesced
+            << " coalesced, " << stats.upstreamRequests
+            << " upstream requests." << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief An archive to be copied by 'ign fuel mirror'.
+struct MirrorItem
+{
+  /// \brief Route relative to the server version.
+  /// E.g.: "alice/models/am1/2/am1.zip"
+  std::string route;
+
+  /// \brief Destination path.
+  std::string path;
+};
+
+//////////////////////////////////////////////////
+/// \brief Write a file through a temporary file, so that readers never see
+/// it partially written. The file is left untouched if the content is the
+/// same.
+/// \param[in] _path Destination path.
+/// \param[in] _data Content.
+/// \return True if the file holds the content.
+bool mirrorWrite(const std::string &_path, const std::string &_data)
+{
+  {
+    std::ifstream in(_path, std::ios::binary);
+    if (in.is_open())
+    {
+      std::string current((std::istreambuf_iterator<char>(in)),
+          std::istreambuf_iterator<char>());
+      if (current == _data)
+        return true;
+    }
+  }
+
+  ignition::common::createDirectories(ignition::common::parentPath(_path));
+  std::string tmpPath = _path + ".download";
+  {
+    std::ofstream out(tmpPath, std::ios::binary);
+    out << _data;
+    if (!out.good())
+      return false;
+  }
+  return ignition::common::moveFile(tmpPath, _path);
+}
+
+//////////////////////////////////////////////////
+/// \brief Store all the catalog pages of a resource type, and find the
+/// archives which are missing from the mirror.
+/// \param[in] _server Server to mirror.
+/// \param[in] _owner Owner to mirror, or empty for the whole server.
+/// \param[in] _type "models" or "worlds".
+/// \param[in] _root Directory matching the server version route.
+/// \param[in] _headers HTTP headers.
+/// \param[out] _items Archives to fetch.
+/// \param[out] _tips Latest archive of each resource, and the path it must
+/// be copied to so it can be downloaded as "tip".
+/// \param[out] _resources Number of resources found.
+/// \param[out] _pages Number of pages stored.
+/// \return False if the catalog couldn't be fetched.
+bool mirrorCatalog(const ignition::fuel_tools::ServerConfig &_server,
+    const std::string &_owner, const std::string &_type,
+    const std::string &_root, const std::vector<std::string> &_headers,
+    std::vector<MirrorItem> &_items,
+    std::vector<std::pair<std::string, std::string>> &_tips,
+    size_t &_resources, size_t &_pages)
+{
+  ignition::fuel_tools::Rest rest;
+  rest.SetUserAgent("FuelTools " IGNITION_FUEL_TOOLS_VERSION_FULL);
+
+  std::string route = _owner.empty() ? _type : _owner + "/" + _type;
+  std::vector<std::string> headers = _headers;
+  headers.push_back("Accept: application/json");
+
+  for (int page = 1; ; ++page)
+  {
+    auto resp = rest.Request(ignition::fuel_tools::HttpMethod::GET,
+        _server.Url().Str(), _server.Version(), route,
+        {"page=" + std::to_string(page)}, headers, "");
+
+    // Past the last page, the server either fails or returns null
+    if (resp.data == "null\n" || resp.statusCode != 200)
+    {
+      if (page == 1)
+      {
+        std::cout << "Failed to list [" << route << "] from ["
+                  << _server.Url().Str() << "], REST response code: "
+                  << resp.statusCode << std::endl;
+        return false;
+      }
+      break;
+    }
+
+    Json::CharReaderBuilder builder;
+    Json::Value value;
+    std::string errors;
+    std::istringstream stream(resp.data);
+    if (!Json::parseFromStream(builder, stream, &value, &errors) ||
+        !value.isArray() || value.empty())
+    {
+      break;
+    }
+
+    if (!mirrorWrite(ignition::common::joinPaths(_root, route,
+        "page_" + std::to_string(page) + ".json"), resp.data))
+    {
+      std::cout << "Unable to write page " << page << " of [" << route
+                << "]" << std::endl;
+      return false;
+    }
+    ++_pages;
+
+    for (const auto &resource : value)
+    {
+      std::string owner = resource.get("owner", "").asString();
+      std::string name = resource.get("name", "").asString();
+      unsigned int version = resource.get("version", 0).asUInt();
+      if (owner.empty() || name.empty())
+        continue;
+      ++_resources;
+
+      // Details are the same object as the catalog entry.
+      std::string dir = ignition::common::joinPaths(_root, owner, _type, name);
+      Json::StreamWriterBuilder writer;
+      mirrorWrite(ignition::common::joinPaths(dir, "index.json"),
+          Json::writeString(writer, resource));
+
+      // Versions are immutable, so existing archives are kept.
+      for (unsigned int v = 1; v <= version; ++v)
+      {
+        MirrorItem item;
+        item.route = owner + "/" + _type + "/" + name + "/" +
+            std::to_string(v) + "/" + name + ".zip";
+        item.path = ignition::common::joinPaths(dir, std::to_string(v),
+            name + ".zip");
+        if (!ignition::common::exists(item.path))
+          _items.push_back(item);
+      }
+
+      if (version > 0)
+      {
+        _tips.push_back({
+            ignition::common::joinPaths(dir, std::to_string(version),
+              name + ".zip"),
+            ignition::common::joinPaths(dir, "tip", name + ".zip")});
+      }
+    }
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int mirror(const char *_url,
+    const char *_owner, const char *_type, const char *_output,
+    const char *_jobs, const char *_header, const char *_configFile)
+{
+  if (!_output || strlen(_output) == 0)
+  {
+    std::cout << "Missing output directory." << std::endl;
+    return false;
+  }
+
+  unsigned int jobs{4};
+  if (_jobs && strlen(_jobs) > 0)
+  {
+    try
+    {
+      jobs = std::max(1, std::stoi(_jobs));
+    }
+    catch(...)
+    {
+      std::cout << "Invalid number of jobs [" << _jobs << "]" << std::endl;
+      return false;
+    }
+  }
+
+  auto conf = cacheConfig(_configFile);
+
+  // Server to mirror, defaulting to the first configured one.
+  ignition::fuel_tools::ServerConfig server;
+  if (_url && strlen(_url) > 0)
+    server.SetUrl(ignition::common::URI(_url));
+  else if (!conf.Servers().empty())
+    server = conf.Servers().front();
+
+  std::vector<std::string> types;
+  std::string type = _type ? _type : "";
+  if (type.empty() || type == "model")
+    types.push_back("models");
+  if (type.empty() || type == "world")
+    types.push_back("worlds");
+  if (types.empty())
+  {
+    std::cout << "Invalid resource type [" << type << "]" << std::endl;
+    return false;
+  }
+
+  std::vector<std::string> headers;
+  if (_header && strlen(_header) > 0)
+    headers.push_back(_header);
+
+  // The tree mirrors the server routes, so it can be served as is.
+  std::string root = ignition::common::joinPaths(_output, server.Version());
+  std::string owner = _owner ? _owner : "";
+
+  std::vector<MirrorItem> items;
+  std::vector<std::pair<std::string, std::string>> tips;
+  size_t resources{0};
+  size_t pages{0};
+  for (const auto &t : types)
+  {
+    if (!mirrorCatalog(server, owner, t, root, headers, items, tips,
+        resources, pages))
+    {
+      return false;
+    }
+  }
+
+  std::cout << "Found " << resources << " resources in " << pages
+            << " pages, " << items.size() << " archives to fetch."
+            << std::endl;
+
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> failed{0};
+  std::atomic<uint64_t> bytes{0};
+  auto startTime = std::chrono::steady_clock::now();
+  auto worker = [&]()
+  {
+    ignition::fuel_tools::Rest rest;
+    rest.SetUserAgent("FuelTools " IGNITION_FUEL_TOOLS_VERSION_FULL);
+    for (size_t i = next++; i < items.size(); i = next++)
+    {
+      auto resp = rest.Request(ignition::fuel_tools::HttpMethod::GET,
+          server.Url().Str(), server.Version(), items[i].route, {}, headers,
+          "");
+      if (resp.statusCode != 200 || !mirrorWrite(items[i].path, resp.data))
+      {
+        ignerr << "Failed to mirror [" << items[i].route
+               << "], REST response code: " << resp.statusCode << std::endl;
+        ++failed;
+        continue;
+      }
+      bytes += resp.data.size();
+      ignmsg << "Mirrored [" << items[i].route << "]" << std::endl;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < std::min<size_t>(jobs, items.size()); ++i)
+    workers.emplace_back(worker);
+  for (auto &thread : workers)
+    thread.join();
+
+  // Latest versions are also reachable as "tip".
+  for (const auto &tip : tips)
+  {
+    if (!ignition::common::exists(tip.first))
+      continue;
+    ignition::common::createDirectories(
+        ignition::common::parentPath(tip.second));
+    ignition::common::copyFile(tip.first, tip.second);
+  }
+
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - startTime).count();
+  std::cout << "Mirrored " << (items.size() - failed) << " archives ("
+            << formatBytes(static_cast<double>(bytes)) << ") in "
+            << std::fixed << std::setprecision(1) << elapsed << "s";
+  if (failed > 0)
+    std::cout << ", " << failed << " failed";
+  std::cout << "." << std::endl;
+
+  return failed == 0;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE void cmdVerbosity(const char *_verbosity)
+{
+  ignition::common::Console::SetVerbosity(std::atoi(_verbosity));
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE void cmdTraceStart()
+{
+  ignition::fuel_tools::Trace::SetEnabled(true);
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cmdTraceWrite(const char *_path)
+{
+  ignition::fuel_tools::Trace::SetEnabled(false);
+  if (!ignition::fuel_tools::Trace::WriteChromeJson(_path))
+    return false;
+
+  std::cout << "Trace with " << ignition::fuel_tools::Trace::SpanCount()
+            << " spans written to [" << _path << "]" << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cmdMetricsWrite(const char *_path)
+{
+  if (!ignition::fuel_tools::MetricsRegistry::Global().WritePrometheusText(
+      _path))
+  {
+    return false;
+  }
+
+  std::cout << "Metrics written to [" << _path << "]" << std::endl;
+  return true;
 }
 
 //////////////////////////////////////////////////
@@ -29,16 +29,35 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE char *ignitionVersion();
 extern "C" IGNITION_FUEL_TOOLS_VISIBLE void cmdVerbosity(
     const char *_verbosity);
 
+/// \brief Start recording trace spans, for 'ign fuel --trace'.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE void cmdTraceStart();
+
+/// \brief Write the recorded trace spans in the Chrome trace-event format.
+/// \param[in] _path Output file.
+/// \return 1 if successful, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cmdTraceWrite(const char *_path);
+
+/// \brief Write the runtime metrics in the Prometheus text format, for
+/// 'ign fuel --metrics'.
+/// \param[in] _path Output file.
+/// \return 1 if successful, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cmdMetricsWrite(const char *_path);
+
 /// \brief External hook to execute 'ign fuel list -t model' from the command
 /// line.
 /// \param[in] _url Optional server URL.
 /// \param[in] _owner Optional owner name
 /// \param[in] _raw 'true' for machine readable output.
 /// \param[in] _configFile Path to a YAML configuration file.
+/// \param[in] _stream 'true' to print each page of models as soon as it's
+/// received, instead of waiting for the whole list.
+/// \param[in] _json 'true' to print one JSON object per line with the
+/// models' metadata. Implies streaming.
 /// \return 1 if successful, 0 if not.
 extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listModels(
     const char *_url = nullptr, const char *_owner = "",
-    const char *_raw = "false", const char *_configFile = nullptr);
+    const char *_raw = "false", const char *_configFile = nullptr,
+    const char *_stream = "false", const char *_json = "false");
 
 /// \brief External hook to execute 'ign fuel list -t world' from the command
 /// line.
@@ -46,10 +65,15 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listModels(
 /// \param[in] _owner Optional owner name
 /// \param[in] _raw 'true' for machine readable output.
 /// \param[in] _configFile Path to a YAML configuration file.
+/// \param[in] _stream 'true' to print each page of worlds as soon as it's
+/// received, instead of waiting for the whole list.
+/// \param[in] _json 'true' to print one JSON object per line with the
+/// worlds' metadata. Implies streaming.
 /// \return 1 if successful, 0 if not.
 extern "C" IGNITION_FUEL_TOOLS_VISIBLE int listWorlds(
     const char *_url = nullptr, const char *_owner = "",
-    const char *_raw = "false", const char *_configFile = nullptr);
+    const char *_raw = "false", const char *_configFile = nullptr,
+    const char *_stream = "false", const char *_json = "false");
 
 /// \brief External hook to execute 'ign fuel download -u URL' from the command
 /// line.
@@ -61,6 +85,61 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int downloadUrl(
     const char *_url = nullptr, const char *_configFile = nullptr,
     const char *_header = nullptr);
 
+/// \brief External hook to execute 'ign fuel download' with several URLs
+/// and / or a manifest file from the command line. All resources are
+/// downloaded by a single client, using up to `_jobs` concurrent transfers.
+/// \param[in] _urls Newline separated list of resource URLs.
+/// \param[in] _manifest Path to a file containing one resource URL per line.
+/// Empty lines and lines starting with '#' are ignored.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \param[in] _header An HTTP header.
+/// \param[in] _jobs Maximum number of concurrent downloads.
+/// \return 1 if all the resources were downloaded, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int downloadUrls(
+    const char *_urls, const char *_manifest = nullptr,
+    const char *_configFile = nullptr, const char *_header = nullptr,
+    const char *_jobs = "1");
+
+/// \brief External hook to execute 'ign fuel lock' from the command line.
+/// Resolves each resource URL to an exact version and archive hash, and
+/// writes them to a lockfile. Existing entries of the lockfile are kept,
+/// unless they are resolved again.
+/// \param[in] _urls Newline separated list of resource URLs.
+/// \param[in] _manifest Path to a file containing one resource URL per line.
+/// Empty lines and lines starting with '#' are ignored.
+/// \param[in] _output Path to the lockfile.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \param[in] _header An HTTP header.
+/// \param[in] _jobs Maximum number of resources resolved concurrently.
+/// \return 1 if all the resources were locked, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int lockResources(
+    const char *_urls, const char *_manifest = nullptr,
+    const char *_output = nullptr, const char *_configFile = nullptr,
+    const char *_header = nullptr, const char *_jobs = "1");
+
+/// \brief External hook to execute 'ign fuel bench' from the command line.
+/// Runs client-side benchmark scenarios and prints the results as JSON.
+/// \param[in] _scenarios Comma separated scenarios to run: parse, cache,
+/// extract, list and download. Empty or "all" runs all of them.
+/// \param[in] _url URL of the server used by the list and download
+/// scenarios, which may be a live server or a local stand-in.
+/// \param[in] _fixture Directory with recorded model archives, and
+/// optionally a "urls.txt" file. Synthetic models are used if empty.
+/// \param[in] _manifest Path to a file with one resource URL per line, used
+/// by the parse and download scenarios.
+/// \param[in] _iterations Number of times each scenario is repeated.
+/// \param[in] _jobs Number of concurrent operations.
+/// \param[in] _output Path to the JSON output file. Empty for stdout.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \param[in] _header An HTTP header.
+/// \return 1 if all the scenarios ran without errors, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int bench(
+    const char *_scenarios = "", const char *_url = nullptr,
+    const char *_fixture = nullptr, const char *_manifest = nullptr,
+    const char *_iterations = "", const char *_jobs = "",
+    const char *_output = nullptr, const char *_configFile = nullptr,
+    const char *_header = nullptr);
+
 /// \brief External hook to execute 'ign fuel upload -m path' from the command
 /// line.
 ///
@@ -78,6 +157,94 @@ extern "C" IGNITION_FUEL_TOOLS_VISIBLE int upload(const char *_path,
     const char *_url, const char *_header = nullptr,
     const char *_private = nullptr);
 
+/// \brief External hook to execute 'ign fuel cache stats' from the command
+/// line.
+/// \param[in] _owner Only consider resources of this owner. Empty for all.
+/// \param[in] _json 'true' to print the statistics as JSON.
+/// \param[in] _jobs Number of threads. Empty for one per core.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \return 1 if successful, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cacheStats(
+    const char *_owner = "", const char *_json = "false",
+    const char *_jobs = "", const char *_configFile = nullptr);
+
+/// \brief External hook to execute 'ign fuel cache prune' from the command
+/// line.
+/// \param[in] _owner Only consider resources of this owner. Empty for all.
+/// \param[in] _maxAge Remove entries unused for this many days.
+/// \param[in] _maxSize Remove the least recently used entries until the
+/// cache is smaller than this. Accepts K, M and G suffixes.
+/// \param[in] _keepVersions Number of most recent versions to keep for each
+/// resource.
+/// \param[in] _dryRun 'true' to only print what would be removed.
+/// \param[in] _jobs Number of threads. Empty for one per core.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \return 1 if successful, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cachePrune(
+    const char *_owner = "", const char *_maxAge = "",
+    const char *_maxSize = "", const char *_keepVersions = "",
+    const char *_dryRun = "false", const char *_jobs = "",
+    const char *_configFile = nullptr);
+
+/// \brief External hook to execute 'ign fuel cache verify' from the command
+/// line.
+/// \param[in] _owner Only consider resources of this owner. Empty for all.
+/// \param[in] _jobs Number of threads. Empty for one per core.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \return 1 if no problems were found, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cacheVerify(
+    const char *_owner = "", const char *_jobs = "",
+    const char *_configFile = nullptr);
+
+/// \brief External hook to execute 'ign fuel cache warm' from the command
+/// line.
+/// \param[in] _owner Only consider resources of this owner. Empty for all.
+/// \param[in] _urls Newline separated resource URLs to warm. Empty for all.
+/// \param[in] _jobs Number of threads. Empty for one per core.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \return 1 if successful, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int cacheWarm(
+    const char *_owner = "", const char *_urls = "",
+    const char *_jobs = "", const char *_configFile = nullptr);
+
+/// \brief External hook to execute 'ign fuel serve-cache' from the command
+/// line. Serves until interrupted.
+/// \param[in] _host Address to bind to. Empty for "127.0.0.1".
+/// \param[in] _port Port to bind to. Empty for 8000.
+/// \param[in] _socket Unix socket path, used instead of the port if set.
+/// \param[in] _url Upstream server URL. Empty for the first configured one.
+/// \param[in] _prewarm File listing resource URLs to cache on start.
+/// \param[in] _prewarmCount Number of the most requested resources of
+/// previous runs to cache on start.
+/// \param[in] _ttl Seconds to keep listings and details in memory.
+/// \param[in] _jobs Number of concurrent prewarm fetches. Empty for one per
+/// core.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \return 1 if successful, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int serveCache(
+    const char *_host = "", const char *_port = "",
+    const char *_socket = "", const char *_url = "",
+    const char *_prewarm = "", const char *_prewarmCount = "",
+    const char *_ttl = "", const char *_jobs = "",
+    const char *_configFile = nullptr);
+
+/// \brief External hook to execute 'ign fuel mirror' from the command line.
+/// Copies the catalog pages and every version of the archives of a server
+/// into a directory which mirrors the server routes. Archives which are
+/// already in the directory are not fetched again.
+/// \param[in] _url Server URL. Empty for the first configured server.
+/// \param[in] _owner Owner to mirror. Empty for the whole server.
+/// \param[in] _type Resource type ("model" or "world"). Empty for both.
+/// \param[in] _output Output directory.
+/// \param[in] _jobs Number of concurrent transfers. Empty for 4.
+/// \param[in] _header An HTTP header.
+/// \param[in] _configFile Path to a YAML configuration file.
+/// \return 1 if successful, 0 if not.
+extern "C" IGNITION_FUEL_TOOLS_VISIBLE int mirror(
+    const char *_url = "", const char *_owner = "", const char *_type = "",
+    const char *_output = "", const char *_jobs = "",
+    const char *_header = nullptr, const char *_configFile = nullptr);
+
 /// \brief External hook to execute 'ign fuel delete [options]' from the command
 /// line.
 ///
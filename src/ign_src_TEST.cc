@@ -19,9 +19,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <atomic>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <ignition/common/Filesystem.hh>
 
+#include "HttpServer.hh"
 #include "ign.hh"
 #include "test/test_config.h"  // NOLINT(build/include)
 
@@ -151,6 +155,55 @@ TEST(CmdLine, ModelListCustomServerPrettyOwner)
   restoreIO();
 }
 
+/////////////////////////////////////////////////
+TEST(CmdLine, ModelListStreamJson)
+{
+  std::stringstream stdOutBuffer;
+  std::stringstream stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  EXPECT_TRUE(listModels("https://fuel.ignitionrobotics.org", "openrobotics",
+      "false", "", "false", "true"));
+
+  // One JSON object per line
+  std::string line;
+  int count{0};
+  while (std::getline(stdOutBuffer, line))
+  {
+    EXPECT_EQ('{', line.front()) << line;
+    EXPECT_EQ('}', line.back()) << line;
+    EXPECT_NE(line.find("\"owner\":\"openrobotics\""), std::string::npos)
+        << line;
+    EXPECT_NE(line.find("\"version\":"), std::string::npos) << line;
+    EXPECT_NE(line.find("\"tags\":"), std::string::npos) << line;
+    ++count;
+  }
+  EXPECT_GT(count, 0);
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  restoreIO();
+}
+
+/////////////////////////////////////////////////
+TEST(CmdLine, ModelListStreamRaw)
+{
+  std::stringstream stdOutBuffer;
+  std::stringstream stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  EXPECT_TRUE(listModels("https://fuel.ignitionrobotics.org", "openrobotics",
+      "false", "", "true"));
+
+  EXPECT_NE(stdOutBuffer.str().find(
+      "https://fuel.ignitionrobotics.org/1.0/openrobotics/models/"),
+      std::string::npos) << stdOutBuffer.str();
+  EXPECT_EQ(stdOutBuffer.str().find("owners"), std::string::npos)
+      << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  restoreIO();
+}
+
 /////////////////////////////////////////////////
 TEST(CmdLine, ModelDownloadBadUrl)
 {
@@ -221,6 +274,205 @@ TEST(CmdLine, ModelDownloadUnversioned)
   restoreIO();
 }
 
+/////////////////////////////////////////////////
+TEST(CmdLine, DownloadUrlsFail)
+{
+  std::stringstream stdOutBuffer;
+  std::stringstream stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  // Nothing to download
+  EXPECT_FALSE(downloadUrls("\n# comment\n"));
+  EXPECT_NE(stdOutBuffer.str().find("No resource URLs"),
+      std::string::npos) << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  // Missing manifest
+  EXPECT_FALSE(downloadUrls("", "fake_manifest.txt"));
+  EXPECT_NE(stdOutBuffer.str().find("Unable to open manifest"),
+      std::string::npos) << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  // Each bad URL is reported in the summary
+  EXPECT_FALSE(downloadUrls(
+      "fake_url\nhttps://site.com/1.0/ownername/modelname\nfake_url",
+      nullptr, nullptr, nullptr, "4"));
+  EXPECT_NE(stdOutBuffer.str().find("Malformed URL"),
+      std::string::npos) << stdOutBuffer.str();
+  EXPECT_NE(stdOutBuffer.str().find("Invalid URL"),
+      std::string::npos) << stdOutBuffer.str();
+  EXPECT_NE(stdOutBuffer.str().find("0 of 2 resources downloaded"),
+      std::string::npos) << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  restoreIO();
+}
+
+/////////////////////////////////////////////////
+TEST(CmdLine, BenchFail)
+{
+  std::stringstream stdOutBuffer;
+  std::stringstream stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  EXPECT_FALSE(bench("parse,fake"));
+  EXPECT_NE(stdOutBuffer.str().find("Unknown scenario [fake]"),
+      std::string::npos) << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  EXPECT_FALSE(bench("parse", nullptr, "fake_fixture"));
+  EXPECT_NE(stdOutBuffer.str().find("Fixture directory"),
+      std::string::npos) << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  restoreIO();
+}
+
+/////////////////////////////////////////////////
+TEST(CmdLine, BenchOffline)
+{
+  std::stringstream stdOutBuffer;
+  std::stringstream stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  // Scenarios which don't need a server
+  EXPECT_TRUE(bench("parse,cache,extract", nullptr, nullptr, nullptr, "2",
+      "2")) << stdOutBuffer.str();
+
+  for (auto field : {"\"name\" : \"parse\"", "\"name\" : \"cache\"",
+      "\"name\" : \"extract\"", "\"p99\"", "\"peak_rss_bytes\"",
+      "\"operations_per_second\""})
+  {
+    EXPECT_NE(stdOutBuffer.str().find(field), std::string::npos)
+        << field << std::endl << stdOutBuffer.str();
+  }
+  EXPECT_EQ(stdOutBuffer.str().find("\"name\" : \"list\""),
+      std::string::npos) << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  restoreIO();
+}
+
+/////////////////////////////////////////////////
+#ifndef _WIN32
+TEST(CmdLine, Mirror)
+{
+  using namespace ignition::fuel_tools;
+
+  // Fake server with one model, which has 2 versions, on a single page
+  std::atomic<int> archiveRequests{0};
+  HttpServer server([&](const HttpRequest &_request, HttpResponse &_response)
+  {
+    if (_request.path == "/1.0/alice/models" &&
+        _request.params.count("page") && _request.params.at("page") == "1")
+    {
+      _response.body = "[{\"name\":\"am1\",\"owner\":\"alice\",\"version\":2}]";
+    }
+    else if (_request.path == "/1.0/alice/models/am1/1/am1.zip" ||
+        _request.path == "/1.0/alice/models/am1/2/am1.zip")
+    {
+      ++archiveRequests;
+      _response.body = "archive " + _request.path;
+    }
+    else
+    {
+      _response.status = 404;
+    }
+  });
+  ASSERT_TRUE(server.Start("127.0.0.1", 0));
+
+  std::string output = "test_mirror";
+  ignition::common::removeAll(output);
+
+  std::stringstream stdOutBuffer;
+  std::stringstream stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  EXPECT_TRUE(mirror(server.Url().c_str(), "alice", "model", output.c_str(),
+      "2")) << stdOutBuffer.str();
+  EXPECT_NE(stdOutBuffer.str().find("Found 1 resources in 1 pages"),
+      std::string::npos) << stdOutBuffer.str();
+  EXPECT_EQ(2, archiveRequests);
+
+  std::string dir = ignition::common::joinPaths(output, "1.0", "alice",
+      "models");
+  EXPECT_TRUE(ignition::common::isFile(
+      ignition::common::joinPaths(dir, "page_1.json")));
+  EXPECT_TRUE(ignition::common::isFile(
+      ignition::common::joinPaths(dir, "am1", "index.json")));
+  EXPECT_TRUE(ignition::common::isFile(
+      ignition::common::joinPaths(dir, "am1", "1", "am1.zip")));
+  EXPECT_TRUE(ignition::common::isFile(
+      ignition::common::joinPaths(dir, "am1", "2", "am1.zip")));
+
+  std::ifstream tip(ignition::common::joinPaths(dir, "am1", "tip", "am1.zip"));
+  std::string tipData((std::istreambuf_iterator<char>(tip)),
+      std::istreambuf_iterator<char>());
+  EXPECT_EQ("archive /1.0/alice/models/am1/2/am1.zip", tipData);
+
+  // Mirroring again only refreshes the catalog
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  EXPECT_TRUE(mirror(server.Url().c_str(), "alice", "model", output.c_str(),
+      "2")) << stdOutBuffer.str();
+  EXPECT_NE(stdOutBuffer.str().find("0 archives to fetch"),
+      std::string::npos) << stdOutBuffer.str();
+  EXPECT_EQ(2, archiveRequests);
+
+  // Unknown owner
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  EXPECT_FALSE(mirror(server.Url().c_str(), "bob", "model", output.c_str()));
+  EXPECT_NE(stdOutBuffer.str().find("Failed to list"),
+      std::string::npos) << stdOutBuffer.str();
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  restoreIO();
+}
+#endif
+
+/////////////////////////////////////////////////
+TEST(CmdLine, DownloadUrlsManifest)
+{
+  cmdVerbosity("4");
+
+  ignition::common::removeAll("test_cache");
+  ignition::common::createDirectories("test_cache");
+  setenv("IGN_FUEL_CACHE_PATH", "test_cache", true);
+
+  std::ofstream manifest("test_cache/manifest.txt");
+  manifest << "# Resources" << std::endl
+           << "https://fuel.ignitionrobotics.org/1.0/chapulina/models/Test box"
+           << std::endl << std::endl
+           << "https://staging-fuel.ignitionrobotics.org/1.0/nate/worlds/Empty"
+           << std::endl;
+  manifest.close();
+
+  std::stringstream stdOutBuffer;
+  std::stringstream stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  // Download, duplicates are skipped
+  EXPECT_TRUE(downloadUrls(
+      "https://fuel.ignitionrobotics.org/1.0/chapulina/models/Test box",
+      "test_cache/manifest.txt", nullptr, nullptr, "2"));
+
+  EXPECT_NE(stdOutBuffer.str().find("2 of 2 resources downloaded"),
+      std::string::npos) << stdOutBuffer.str();
+
+  // Check files
+  EXPECT_TRUE(ignition::common::isFile(
+      std::string("test_cache/fuel.ignitionrobotics.org/chapulina/models") +
+      "/Test box/2/model.sdf"));
+  EXPECT_TRUE(ignition::common::isFile(
+      std::string("test_cache/staging-fuel.ignitionrobotics.org/nate/worlds/")
+      + "Empty/1/empty.world"));
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+  restoreIO();
+}
+
 /////////////////////////////////////////////////
 TEST(CmdLine, DownloadConfigCache)
 {
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/FuelClient.hh"
+#include "ignition/fuel_tools/RestClient.hh"
+
+#include "FakeFuelServer.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+/// \brief Create a resource version with a model.config, a model.sdf and a
+/// mesh.
+/// \param[in] _dir Version directory.
+/// \param[in] _name Resource name.
+void createResource(const std::string &_dir, const std::string &_name)
+{
+  common::createDirectories(common::joinPaths(_dir, "meshes"));
+  std::ofstream(common::joinPaths(_dir, "model.config"))
+      << "<?xml version=\"1.0\"?><model><name>" << _name << "</name>"
+      << "<sdf version=\"1.6\">model.sdf</sdf></model>";
+  std::ofstream(common::joinPaths(_dir, "model.sdf"))
+      << "<?xml version=\"1.0\"?><sdf version=\"1.6\"><model name=\""
+      << _name << "\"/></sdf>";
+  std::ofstream(common::joinPaths(_dir, "meshes", "mesh.dae"))
+      << std::string(2000, 'x');
+}
+
+/////////////////////////////////////////////////
+/// \brief Create a server tree with 25 models spread across 3 owners, where
+/// alice/am1 has 2 versions, and one world.
+/// \return Root of the tree.
+std::string createTree()
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_fake_fuel_server");
+  common::removeAll(root);
+
+  createResource(common::joinPaths(root, "alice", "models", "am1", "1"),
+      "am1");
+  createResource(common::joinPaths(root, "alice", "models", "am1", "2"),
+      "am1");
+  for (int i = 1; i < 25; ++i)
+  {
+    std::string owner = i % 2 ? "bob" : "trudy";
+    std::string name = "m" + std::to_string(i);
+    createResource(common::joinPaths(root, owner, "models", name, "1"), name);
+  }
+  createResource(common::joinPaths(root, "alice", "worlds", "aw1", "1"),
+      "aw1");
+  return root;
+}
+
+/////////////////////////////////////////////////
+TEST(FakeFuelServer, Routes)
+{
+  std::string root = createTree();
+  FakeFuelServerOptions options;
+  options.pageSize = 10;
+  FakeFuelServer server(root, options);
+  ASSERT_TRUE(server.Start());
+
+  ServerConfig srv;
+  srv.SetUrl(common::URI(server.Url()));
+  ClientConfig conf;
+  conf.Clear();
+  conf.SetCacheLocation(common::joinPaths(root, ".client_cache"));
+  conf.AddServer(srv);
+  FuelClient client(conf);
+
+  // Listings are paginated.
+  int count = 0;
+  for (auto iter = client.Models(srv); iter; ++iter)
+    ++count;
+  EXPECT_EQ(25, count);
+  EXPECT_LE(3u, server.Stats().requests);
+
+  ModelIdentifier owner;
+  owner.SetServer(srv);
+  owner.SetOwner("alice");
+  count = 0;
+  for (auto iter = client.Models(owner); iter; ++iter)
+    ++count;
+  EXPECT_EQ(1, count);
+
+  count = 0;
+  for (auto iter = client.Worlds(srv); iter; ++iter)
+    ++count;
+  EXPECT_EQ(1, count);
+
+  // Details, archives and files.
+  ModelIdentifier id;
+  id.SetServer(srv);
+  id.SetOwner("alice");
+  id.SetName("am1");
+  ModelIdentifier details;
+  EXPECT_TRUE(client.ModelDetails(id, details));
+  EXPECT_EQ(2u, details.Version());
+
+  std::string path;
+  EXPECT_TRUE(client.DownloadModel(
+      common::URI(server.Url() + "/1.0/alice/models/am1"), path));
+  EXPECT_TRUE(common::isFile(common::joinPaths(path, "meshes", "mesh.dae")));
+  EXPECT_EQ("2", common::basename(path));
+  EXPECT_EQ(1u, server.Stats().archives);
+
+  Rest rest;
+  auto resp = rest.Request(HttpMethod::GET, server.Url(), "1.0",
+      "alice/models/am1/1/files/meshes/mesh.dae", {}, {}, "");
+  EXPECT_EQ(200, resp.statusCode);
+  EXPECT_EQ(std::string(2000, 'x'), resp.data);
+
+  resp = rest.Request(HttpMethod::GET, server.Url(), "1.0",
+      "alice/models/am1/3/am1.zip", {}, {}, "");
+  EXPECT_EQ(404, resp.statusCode);
+
+  resp = rest.Request(HttpMethod::GET, server.Url(), "1.0",
+      "alice/models/am1/1/files/../../2/model.sdf", {}, {}, "");
+  EXPECT_EQ(404, resp.statusCode);
+
+  server.Stop();
+  common::removeAll(root);
+}
+
+/////////////////////////////////////////////////
+TEST(FakeFuelServer, Knobs)
+{
+  std::string root = createTree();
+  FakeFuelServer server(root);
+  ASSERT_TRUE(server.Start());
+  Rest rest;
+  std::string route = "alice/models/am1/tip/files/meshes/mesh.dae";
+
+  // Latency
+  FakeFuelServerOptions options;
+  options.latency = std::chrono::milliseconds(200);
+  server.SetOptions(options);
+  auto start = std::chrono::steady_clock::now();
+  auto resp = rest.Request(HttpMethod::GET, server.Url(), "1.0", route, {},
+      {}, "");
+  EXPECT_EQ(200, resp.statusCode);
+  EXPECT_LE(200, std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count());
+
+  // Bandwidth: 2000 bytes at 5000 bytes per second.
+  options = FakeFuelServerOptions();
+  options.bandwidth = 5000;
+  server.SetOptions(options);
+  start = std::chrono::steady_clock::now();
+  resp = rest.Request(HttpMethod::GET, server.Url(), "1.0", route, {}, {},
+      "");
+  EXPECT_EQ(200, resp.statusCode);
+  EXPECT_LE(400, std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count());
+
+  // Throttling
+  options = FakeFuelServerOptions();
+  options.rateLimit = 2;
+  options.retryAfter = 3;
+  server.SetOptions(options);
+  server.ResetStats();
+  int throttled = 0;
+  for (int i = 0; i < 5; ++i)
+  {
+    resp = rest.Request(HttpMethod::GET, server.Url(), "1.0", route, {}, {},
+        "");
+    if (resp.statusCode == 429)
+    {
+      ++throttled;
+      EXPECT_NE(std::string::npos, resp.headers["Retry-After"].find("3"));
+    }
+  }
+  EXPECT_LE(1, throttled);
+  EXPECT_EQ(static_cast<uint64_t>(throttled), server.Stats().throttled);
+
+  // Errors are reproducible for a given seed.
+  options = FakeFuelServerOptions();
+  options.errorRate = 0.5;
+  options.seed = 7;
+  std::string first;
+  std::string second;
+  for (auto *codes : {&first, &second})
+  {
+    server.SetOptions(options);
+    for (int i = 0; i < 20; ++i)
+    {
+      resp = rest.Request(HttpMethod::GET, server.Url(), "1.0", route, {},
+          {}, "");
+      *codes += resp.statusCode == 500 ? "E" : ".";
+    }
+  }
+  EXPECT_EQ(first, second);
+  EXPECT_NE(std::string::npos, first.find("E"));
+  EXPECT_NE(std::string::npos, first.find("."));
+
+  server.Stop();
+  common::removeAll(root);
+}
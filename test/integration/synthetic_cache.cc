@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/JSONParser.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/RestClient.hh"
+
+#include "FakeFuelServer.hh"
+#include "SyntheticCache.hh"
+#include "test/test_config.h"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+TEST(SyntheticCache, Generate)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_synthetic_cache");
+  common::removeAll(root);
+
+  SyntheticCacheOptions options;
+  options.servers = 2;
+  options.owners = 3;
+  options.models = 12;
+  options.versions = 2;
+  options.files = 3;
+  options.minFileSize = 10;
+  options.maxFileSize = 1000;
+  options.catalog = true;
+  options.pageSize = 5;
+  options.archives = true;
+
+  SyntheticCacheStats stats;
+  ASSERT_TRUE(SyntheticCache::Generate(root, options, &stats));
+  EXPECT_EQ(24u, stats.models);
+  EXPECT_EQ(48u, stats.versions);
+  EXPECT_EQ(48u * 5, stats.files);
+  EXPECT_EQ(6u, stats.pages);
+  EXPECT_EQ(48u, stats.archives);
+
+  // The same seed gives the same tree.
+  SyntheticCacheStats again;
+  ASSERT_TRUE(SyntheticCache::Generate(root, options, &again));
+  EXPECT_EQ(stats.bytes, again.bytes);
+
+  // LocalCache sees every model version.
+  ClientConfig conf;
+  conf.Clear();
+  conf.SetCacheLocation(root);
+  for (unsigned int s = 0; s < options.servers; ++s)
+  {
+    ServerConfig srv;
+    srv.SetUrl(common::URI("http://" + SyntheticCache::ServerHost(s)));
+    conf.AddServer(srv);
+  }
+  LocalCache cache(&conf);
+  unsigned int count = 0;
+  for (auto iter = cache.AllModels(); iter; ++iter)
+    ++count;
+  EXPECT_EQ(48u, count);
+
+#ifndef _WIN32
+  // A server directory can be served, and its listing matches the catalog.
+  std::string serverDir = common::joinPaths(root,
+      SyntheticCache::ServerHost(0));
+  FakeFuelServer server(serverDir);
+  ASSERT_TRUE(server.Start());
+
+  ServerConfig srv;
+  srv.SetUrl(common::URI(server.Url()));
+  Rest rest;
+  auto resp = rest.Request(HttpMethod::GET, server.Url(), "1.0", "models",
+      {"page=2", "per_page=5"}, {}, "");
+  ASSERT_EQ(200, resp.statusCode);
+
+  std::ifstream in(common::joinPaths(serverDir, ".catalog", "models",
+      "page_2.json"));
+  std::stringstream page;
+  page << in.rdbuf();
+
+  auto served = JSONParser::ParseModels(resp.data, srv);
+  auto generated = JSONParser::ParseModels(page.str(), srv);
+  ASSERT_EQ(5u, served.size());
+  ASSERT_EQ(served.size(), generated.size());
+  for (size_t i = 0; i < served.size(); ++i)
+  {
+    EXPECT_EQ(generated[i].UniqueName(), served[i].UniqueName());
+    EXPECT_EQ(generated[i].Version(), served[i].Version());
+  }
+
+  // Pre-built archives are served.
+  std::string owner = SyntheticCache::Owner(options, 0);
+  std::string name = SyntheticCache::Name(0);
+  resp = rest.Request(HttpMethod::GET, server.Url(), "1.0",
+      owner + "/models/" + name + "/tip/" + name + ".zip", {}, {}, "");
+  EXPECT_EQ(200, resp.statusCode);
+  std::ifstream archive(common::joinPaths(serverDir, ".archives", owner,
+      "models", name, "2.zip"), std::ios::binary | std::ios::ate);
+  EXPECT_EQ(static_cast<std::streamoff>(resp.data.size()),
+      static_cast<std::streamoff>(archive.tellg()));
+
+  server.Stop();
+#endif
+
+  common::removeAll(root);
+}
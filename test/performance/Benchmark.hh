@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_FUEL_TOOLS_TEST_PERFORMANCE_BENCHMARK_HH_
+#define IGNITION_FUEL_TOOLS_TEST_PERFORMANCE_BENCHMARK_HH_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ignition/common/Filesystem.hh>
+
+#include "test/test_config.h"
+
+/// \brief Minimal harness for the performance tests. Each test times an
+/// operation with Measure(), and main() writes all the results as JSON with
+/// WriteResults(), so they can be tracked over time.
+namespace benchmark
+{
+  /// \brief Timing of one benchmark.
+  struct Result
+  {
+    /// \brief Benchmark name, such as "ParseModelUrl".
+    std::string name;
+
+    /// \brief Duration of each iteration, in milliseconds.
+    std::vector<double> samples;
+
+    /// \brief Number of items processed by each iteration, such as the
+    /// number of URLs parsed. Used to compute the throughput.
+    uint64_t items = 1;
+  };
+
+  /// \brief Results of all the benchmarks run by this executable.
+  /// \return Results, in the order they were measured.
+  inline std::vector<Result> &Results()
+  {
+    static std::vector<Result> results;
+    return results;
+  }
+
+  /// \brief Get a percentile of sorted samples.
+  /// \param[in] _sorted Samples, sorted in ascending order.
+  /// \param[in] _percentile Percentile, between 0 and 100.
+  /// \return The percentile, or 0 if there are no samples.
+  inline double Percentile(const std::vector<double> &_sorted,
+      double _percentile)
+  {
+    if (_sorted.empty())
+      return 0.0;
+    size_t index = static_cast<size_t>(
+        _percentile / 100.0 * static_cast<double>(_sorted.size() - 1) + 0.5);
+    return _sorted[std::min(index, _sorted.size() - 1)];
+  }
+
+  /// \brief Time a function, and record the result.
+  /// \param[in] _name Benchmark name.
+  /// \param[in] _iterations Number of times the function is called.
+  /// \param[in] _items Number of items processed by each call.
+  /// \param[in] _func Function to time.
+  /// \return The recorded result.
+  template<typename Func>
+  const Result &Measure(const std::string &_name, unsigned int _iterations,
+      uint64_t _items, Func _func)
+  {
+    Result result;
+    result.name = _name;
+    result.items = _items;
+
+    // One untimed call, so caches are warm.
+    _func();
+
+    for (unsigned int i = 0; i < _iterations; ++i)
+    {
+      auto start = std::chrono::steady_clock::now();
+      _func();
+      result.samples.push_back(std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << "[ BENCHMARK ] " << _name << ": p50 "
+              << Percentile(sorted, 50) << " ms, p99 "
+              << Percentile(sorted, 99) << " ms" << std::endl;
+
+    Results().push_back(result);
+    return Results().back();
+  }
+
+  /// \brief Write all the results as JSON. The file is written to the
+  /// directory given by the IGN_FUEL_BENCHMARK_DIR environment variable, or
+  /// to the test_results directory of the build.
+  /// \param[in] _suite Suite name, used for the file name.
+  /// \return True if the file was written.
+  inline bool WriteResults(const std::string &_suite)
+  {
+    std::string dir = std::string(PROJECT_BINARY_PATH) + "/test_results";
+    const char *env = std::getenv("IGN_FUEL_BENCHMARK_DIR");
+    if (env && std::string(env).size() > 0)
+      dir = env;
+    ignition::common::createDirectories(dir);
+
+    std::string path = dir + "/" + _suite + "_benchmark.json";
+    std::ofstream out(path);
+    out << std::fixed << std::setprecision(6);
+    out << "{\n  \"suite\" : \"" << _suite << "\",\n  \"results\" : [";
+    for (size_t i = 0; i < Results().size(); ++i)
+    {
+      const auto &result = Results()[i];
+      std::vector<double> sorted = result.samples;
+      std::sort(sorted.begin(), sorted.end());
+      double total{0.0};
+      for (auto sample : sorted)
+        total += sample;
+      double mean = sorted.empty() ? 0.0 : total / sorted.size();
+
+      out << (i == 0 ? "" : ",") << "\n    {\n"
+          << "      \"name\" : \"" << result.name << "\",\n"
+          << "      \"iterations\" : " << sorted.size() << ",\n"
+          << "      \"items\" : " << result.items << ",\n"
+          << "      \"mean_ms\" : " << mean << ",\n"
+          << "      \"p50_ms\" : " << Percentile(sorted, 50) << ",\n"
+          << "      \"p90_ms\" : " << Percentile(sorted, 90) << ",\n"
+          << "      \"p99_ms\" : " << Percentile(sorted, 99) << ",\n"
+          << "      \"items_per_second\" : "
+          << (mean > 0 ? result.items * 1000.0 / mean : 0.0) << "\n"
+          << "    }";
+    }
+    out << "\n  ]\n}\n";
+
+    if (!out.good())
+    {
+      std::cerr << "Unable to write [" << path << "]" << std::endl;
+      return false;
+    }
+    std::cout << "Benchmark results written to [" << path << "]"
+              << std::endl;
+    return true;
+  }
+}
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/JSONParser.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+
+#include "Benchmark.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+/// \brief Build a model listing, similar to one page of /1.0/models.
+/// \param[in] _count Number of models in the listing.
+/// \return JSON array of models.
+std::string listing(unsigned int _count)
+{
+  std::stringstream json;
+  json << "[";
+  for (unsigned int i = 0; i < _count; ++i)
+  {
+    json << (i == 0 ? "" : ",")
+         << "{\"createdAt\":\"2019-04-21T19:25:44.511Z\","
+         << "\"updatedAt\":\"2019-04-23T18:25:43.511Z\","
+         << "\"name\":\"model" << i << "\","
+         << "\"owner\":\"owner" << i % 100 << "\","
+         << "\"description\":\"A model used for benchmarking\","
+         << "\"likes\":" << i % 7 << ",\"downloads\":" << i << ","
+         << "\"filesize\":" << 1000 + i << ","
+         << "\"license_name\":\"Creative Commons - Attribution\","
+         << "\"license_url\":\"http://creativecommons.org/licenses/by/4.0/\","
+         << "\"license_image\":\"https://i.creativecommons.org/l/by/4.0/"
+         << "88x31.png\","
+         << "\"tags\":[\"tag1\",\"tag2\",\"tag3\"],"
+         << "\"version\":" << 1 + i % 5 << "}";
+  }
+  json << "]";
+  return json.str();
+}
+
+/////////////////////////////////////////////////
+TEST(JSONParser, ParseModels)
+{
+  ServerConfig srv;
+  srv.SetUrl(common::URI("https://fuel.ignitionrobotics.org"));
+
+  for (unsigned int count : {100u, 10000u})
+  {
+    std::string json = listing(count);
+    benchmark::Measure("ParseModels/" + std::to_string(count),
+        count > 1000 ? 10 : 100, count, [&]()
+    {
+      auto models = JSONParser::ParseModels(json, srv);
+      EXPECT_EQ(count, models.size());
+    });
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(JSONParser, ParseModel)
+{
+  ServerConfig srv;
+  srv.SetUrl(common::URI("https://fuel.ignitionrobotics.org"));
+  std::string json = listing(1);
+  json = json.substr(1, json.size() - 2);
+
+  benchmark::Measure("ParseModel", 50, 1000, [&]()
+  {
+    for (int i = 0; i < 1000; ++i)
+      EXPECT_EQ("model0", JSONParser::ParseModel(json, srv).Name());
+  });
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  benchmark::WriteResults("json_parser");
+  return result;
+}
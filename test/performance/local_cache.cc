@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+
+#include "Benchmark.hh"
+#include "SyntheticCache.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/////////////////////////////////////////////////
+TEST(LocalCache, MatchingModel)
+{
+  for (unsigned int count : {10000u, 100000u})
+  {
+    std::string cachePath = common::joinPaths(PROJECT_BINARY_PATH,
+        "test_cache_benchmark");
+    common::removeAll(cachePath);
+
+    // Models are spread across 100 owners, with 3 versions each.
+    SyntheticCacheOptions options;
+    options.owners = 100;
+    options.models = count / 3;
+    options.versions = 3;
+    options.files = 0;
+    ASSERT_TRUE(SyntheticCache::Generate(cachePath, options));
+
+    ServerConfig srv;
+    srv.SetUrl(common::URI("http://localhost:8001/"));
+    ClientConfig conf;
+    conf.Clear();
+    conf.SetCacheLocation(cachePath);
+    conf.AddServer(srv);
+    LocalCache cache(&conf);
+
+    // The last model is found after scanning the whole cache.
+    unsigned int last = options.models - 1;
+    ModelIdentifier id;
+    id.SetServer(srv);
+    id.SetOwner(SyntheticCache::Owner(options, last));
+    id.SetName(SyntheticCache::Name(last));
+
+    unsigned int iterations = count > 10000 ? 3 : 10;
+    std::string suffix = "/" + std::to_string(count);
+
+    id.SetVersion(2);
+    benchmark::Measure("MatchingModel" + suffix, iterations, 1, [&]()
+    {
+      EXPECT_TRUE(cache.MatchingModel(id));
+    });
+
+    id.SetVersion(0);
+    benchmark::Measure("MatchingModel/tip" + suffix, iterations, 1, [&]()
+    {
+      EXPECT_TRUE(cache.MatchingModel(id));
+    });
+
+    id.SetName("missing");
+    benchmark::Measure("MatchingModel/miss" + suffix, iterations, 1, [&]()
+    {
+      EXPECT_FALSE(cache.MatchingModel(id));
+    });
+
+    common::removeAll(cachePath);
+  }
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  benchmark::WriteResults("local_cache");
+  return result;
+}
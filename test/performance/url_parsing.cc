@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/FuelClient.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+#include "ignition/fuel_tools/WorldIdentifier.hh"
+
+#include "Benchmark.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Number of URLs parsed by each iteration.
+static const unsigned int kUrls = 1000;
+
+/////////////////////////////////////////////////
+/// \brief Build a list of URLs, alternating between full URLs and unique
+/// names.
+/// \param[in] _pattern URL with "%d" replaced by an index.
+/// \return The URLs.
+std::vector<common::URI> urls(const std::string &_pattern)
+{
+  std::vector<common::URI> result;
+  for (unsigned int i = 0; i < kUrls; ++i)
+  {
+    std::string url = _pattern;
+    url.replace(url.find("%d"), 2, std::to_string(i));
+    if (i % 2)
+      url.replace(url.find("/1.0/"), 5, "/");
+    result.push_back(common::URI(url));
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////
+TEST(UrlParsing, ParseModelUrl)
+{
+  ClientConfig config;
+  FuelClient client(config);
+  auto list = urls("https://fuel.ignitionrobotics.org/1.0/owner/models/m%d/2");
+
+  benchmark::Measure("ParseModelUrl", 50, list.size(), [&]()
+  {
+    ModelIdentifier id;
+    for (const auto &url : list)
+      EXPECT_TRUE(client.ParseModelUrl(url, id));
+  });
+}
+
+/////////////////////////////////////////////////
+TEST(UrlParsing, ParseWorldUrl)
+{
+  ClientConfig config;
+  FuelClient client(config);
+  auto list = urls("https://fuel.ignitionrobotics.org/1.0/owner/worlds/w%d");
+
+  benchmark::Measure("ParseWorldUrl", 50, list.size(), [&]()
+  {
+    WorldIdentifier id;
+    for (const auto &url : list)
+      EXPECT_TRUE(client.ParseWorldUrl(url, id));
+  });
+}
+
+/////////////////////////////////////////////////
+TEST(UrlParsing, ParseModelFileUrl)
+{
+  ClientConfig config;
+  FuelClient client(config);
+  auto list = urls("https://fuel.ignitionrobotics.org/1.0/owner/models/m%d/"
+      "tip/files/meshes/mesh.dae");
+
+  benchmark::Measure("ParseModelFileUrl", 50, list.size(), [&]()
+  {
+    ModelIdentifier id;
+    std::string path;
+    for (const auto &url : list)
+      EXPECT_TRUE(client.ParseModelFileUrl(url, id, path));
+  });
+}
+
+/////////////////////////////////////////////////
+TEST(UrlParsing, ParseWorldFileUrl)
+{
+  ClientConfig config;
+  FuelClient client(config);
+  auto list = urls("https://fuel.ignitionrobotics.org/1.0/owner/worlds/w%d/"
+      "tip/files/w.world");
+
+  benchmark::Measure("ParseWorldFileUrl", 50, list.size(), [&]()
+  {
+    WorldIdentifier id;
+    std::string path;
+    for (const auto &url : list)
+      EXPECT_TRUE(client.ParseWorldFileUrl(url, id, path));
+  });
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  benchmark::WriteResults("url_parsing");
+  return result;
+}
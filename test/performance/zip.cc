@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/ClientConfig.hh"
+#include "ignition/fuel_tools/LocalCache.hh"
+#include "ignition/fuel_tools/ModelIdentifier.hh"
+#include "ignition/fuel_tools/Zip.hh"
+
+#include "Benchmark.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Number of links in the synthetic model.
+static const unsigned int kLinks = 200;
+
+/////////////////////////////////////////////////
+/// \brief Create a model with kLinks links, each with a mesh and a material
+/// referenced through model:// URIs, and compress it.
+/// \param[in] _dir Directory where the model and its archive are created.
+/// \return Path to the archive.
+std::string createModelArchive(const std::string &_dir)
+{
+  std::string modelDir = common::joinPaths(_dir, "bench_model");
+  common::createDirectories(common::joinPaths(modelDir, "meshes"));
+  {
+    std::ofstream out(common::joinPaths(modelDir, "model.config"));
+    out << "<?xml version=\"1.0\"?><model><name>bench_model</name>"
+        << "<sdf version=\"1.6\">model.sdf</sdf></model>";
+  }
+  {
+    std::ofstream out(common::joinPaths(modelDir, "model.sdf"));
+    out << "<?xml version=\"1.0\"?><sdf version=\"1.6\">"
+        << "<model name=\"bench_model\">";
+    for (unsigned int i = 0; i < kLinks; ++i)
+    {
+      std::string mesh = "<geometry><mesh><uri>model://bench_model/meshes/"
+          "mesh" + std::to_string(i) + ".dae</uri></mesh></geometry>";
+      out << "<link name=\"link" << i << "\">"
+          << "<collision name=\"c\">" << mesh << "</collision>"
+          << "<visual name=\"v\">" << mesh
+          << "<material><script><uri>model://bench_model/materials/scripts"
+          << "</uri><name>Bench/Material</name></script></material>"
+          << "</visual></link>";
+    }
+    out << "</model></sdf>";
+  }
+  for (unsigned int i = 0; i < kLinks; ++i)
+  {
+    std::ofstream out(common::joinPaths(modelDir, "meshes",
+        "mesh" + std::to_string(i) + ".dae"));
+    out << std::string(1000, 'x');
+  }
+
+  std::string archive = common::joinPaths(_dir, "bench_model.zip");
+  common::removeAll(archive);
+  for (auto file : {"model.config", "model.sdf", "meshes"})
+    Zip::Compress(common::joinPaths(modelDir, file), archive);
+  return archive;
+}
+
+/////////////////////////////////////////////////
+TEST(Zip, CompressExtract)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_zip_benchmark");
+  common::removeAll(root);
+  common::createDirectories(root);
+
+  std::string src = std::string(TEST_PATH) + "/media/box";
+  std::string archive = common::joinPaths(root, "box.zip");
+  benchmark::Measure("Compress/box", 100, 1, [&]()
+  {
+    common::removeAll(archive);
+    EXPECT_TRUE(Zip::Compress(src, archive));
+  });
+
+  benchmark::Measure("Extract/box", 100, 1, [&]()
+  {
+    EXPECT_TRUE(Zip::Extract(archive, root));
+  });
+
+  std::string modelArchive = createModelArchive(root);
+  std::string dst = common::joinPaths(root, "extracted");
+  benchmark::Measure("Extract/model", 20, kLinks + 2, [&]()
+  {
+    common::removeAll(dst);
+    common::createDirectories(dst);
+    EXPECT_TRUE(Zip::Extract(modelArchive, dst));
+  });
+
+  common::removeAll(root);
+}
+
+/////////////////////////////////////////////////
+/// \brief LocalCache::SaveModel extracts the archive and then fixes the
+/// model:// URIs, so comparing it with Extract/model above isolates the cost
+/// of FixPaths.
+TEST(Zip, SaveModel)
+{
+  std::string root = common::joinPaths(PROJECT_BINARY_PATH,
+      "test_zip_benchmark_save");
+  common::removeAll(root);
+  common::createDirectories(root);
+
+  std::ifstream in(createModelArchive(root), std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(in)),
+      std::istreambuf_iterator<char>());
+
+  ServerConfig srv;
+  srv.SetUrl(common::URI("http://localhost:8001/"));
+  ClientConfig conf;
+  conf.Clear();
+  conf.SetCacheLocation(common::joinPaths(root, "cache"));
+  conf.AddServer(srv);
+  LocalCache cache(&conf);
+
+  ModelIdentifier id;
+  id.SetServer(srv);
+  id.SetOwner("owner");
+  id.SetName("bench_model");
+  id.SetVersion(1);
+
+  benchmark::Measure("SaveModel/FixPaths", 20, kLinks + 2, [&]()
+  {
+    EXPECT_TRUE(cache.SaveModel(id, data, true));
+  });
+
+  // The URIs were rewritten to absolute paths.
+  std::ifstream sdf(common::joinPaths(root, "cache", "localhost:8001",
+      "owner", "models", "bench_model", "1", "model.sdf"));
+  std::stringstream content;
+  content << sdf.rdbuf();
+  EXPECT_EQ(std::string::npos, content.str().find("model://"));
+
+  common::removeAll(root);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  int result = RUN_ALL_TESTS();
+  benchmark::WriteResults("zip");
+  return result;
+}
@@ -0,0 +1,588 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+#include <ignition/common/StringUtils.hh>
+
+#include "ignition/fuel_tools/Zip.hh"
+
+#include "FakeFuelServer.hh"
+#include "HttpServer.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Private data for FakeFuelServer.
+class ignition::fuel_tools::FakeFuelServerPrivate
+{
+  /// \brief Answer a request.
+  /// \param[in] _request Request.
+  /// \param[out] _response Response.
+  public: void Handle(const HttpRequest &_request, HttpResponse &_response);
+
+  /// \brief Answer a request for a route of the Fuel API.
+  /// \param[in] _segments Route, split into non-empty segments, without the
+  /// API version.
+  /// \param[in] _request Request.
+  /// \param[out] _response Response.
+  public: void Route(const std::vector<std::string> &_segments,
+      const HttpRequest &_request, HttpResponse &_response);
+
+  /// \brief Get the versions of a resource.
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \return Versions, in ascending order.
+  public: std::vector<unsigned int> Versions(const std::string &_owner,
+      const std::string &_type, const std::string &_name) const;
+
+  /// \brief Resolve a version string such as "tip" or "2".
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \param[in] _versionStr Version string.
+  /// \param[out] _version Resolved version.
+  /// \return True if the version exists.
+  public: bool Resolve(const std::string &_owner, const std::string &_type,
+      const std::string &_name, const std::string &_versionStr,
+      unsigned int &_version) const;
+
+  /// \brief Build the JSON description of a resource.
+  /// \param[in] _owner Owner name.
+  /// \param[in] _name Resource name.
+  /// \param[in] _version Latest version.
+  /// \return JSON object.
+  public: std::string Describe(const std::string &_owner,
+      const std::string &_name, unsigned int _version) const;
+
+  /// \brief Answer a paginated listing.
+  /// \param[in] _owner Owner name, or empty for all owners.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _request Request, with the page parameters.
+  /// \param[out] _response Response.
+  public: void List(const std::string &_owner, const std::string &_type,
+      const HttpRequest &_request, HttpResponse &_response) const;
+
+  /// \brief Get the archive of a resource version, creating it if needed.
+  /// \param[in] _owner Owner name.
+  /// \param[in] _type "models" or "worlds".
+  /// \param[in] _name Resource name.
+  /// \param[in] _version Version.
+  /// \return Path to the archive, or empty on failure.
+  public: std::string Archive(const std::string &_owner,
+      const std::string &_type, const std::string &_name,
+      unsigned int _version);
+
+  /// \brief Directory with the resources.
+  public: std::string root;
+
+  /// \brief Misbehavior knobs.
+  public: FakeFuelServerOptions options;
+
+  /// \brief Activity counters.
+  public: FakeFuelServerStats stats;
+
+  /// \brief Generator deciding which requests fail.
+  public: std::mt19937 random;
+
+  /// \brief Start of the current throttling window.
+  public: std::chrono::steady_clock::time_point windowStart;
+
+  /// \brief Requests received in the current throttling window.
+  public: unsigned int windowRequests = 0;
+
+  /// \brief Protects options, stats, random and the throttling window.
+  public: mutable std::mutex mutex;
+
+  /// \brief Serializes the creation of archives.
+  public: std::mutex archiveMutex;
+
+  /// \brief HTTP server.
+  public: std::unique_ptr<HttpServer> server;
+};
+
+//////////////////////////////////////////////////
+/// \brief Quote a string for JSON.
+/// \param[in] _str String.
+/// \return Quoted and escaped string.
+static std::string jsonString(const std::string &_str)
+{
+  std::string result = "\"";
+  for (char c : _str)
+  {
+    if (c == '"' || c == '\\')
+    {
+      result += '\\';
+      result += c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      char buffer[8];
+      std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+      result += buffer;
+    }
+    else
+    {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the names of the subdirectories of a directory, skipping
+/// hidden ones.
+/// \param[in] _dir Directory.
+/// \return Sorted names.
+static std::vector<std::string> subdirectories(const std::string &_dir)
+{
+  std::vector<std::string> names;
+  if (!common::isDirectory(_dir))
+    return names;
+
+  common::DirIter end;
+  for (common::DirIter it(_dir); it != end; ++it)
+  {
+    std::string name = common::basename(*it);
+    if (!name.empty() && name[0] != '.' && common::isDirectory(*it))
+      names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+//////////////////////////////////////////////////
+/// \brief Parse a positive number.
+/// \param[in] _str String.
+/// \param[out] _value Parsed number.
+/// \return True if the string is a positive number.
+static bool parseNumber(const std::string &_str, unsigned int &_value)
+{
+  if (_str.empty() || _str.size() > 9 ||
+      !std::all_of(_str.begin(), _str.end(),
+        [](char _c) {return std::isdigit(static_cast<unsigned char>(_c));}))
+  {
+    return false;
+  }
+  _value = static_cast<unsigned int>(std::stoul(_str));
+  return _value > 0;
+}
+
+//////////////////////////////////////////////////
+FakeFuelServer::FakeFuelServer(const std::string &_root,
+    const FakeFuelServerOptions &_options)
+  : dataPtr(new FakeFuelServerPrivate)
+{
+  this->dataPtr->root = _root;
+  this->SetOptions(_options);
+  this->dataPtr->server.reset(new HttpServer(
+      [this](const HttpRequest &_request, HttpResponse &_response)
+      {
+        this->dataPtr->Handle(_request, _response);
+      }));
+}
+
+//////////////////////////////////////////////////
+FakeFuelServer::~FakeFuelServer()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void FakeFuelServer::SetOptions(const FakeFuelServerOptions &_options)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->options = _options;
+  this->dataPtr->random.seed(_options.seed);
+  this->dataPtr->windowStart = std::chrono::steady_clock::now();
+  this->dataPtr->windowRequests = 0;
+}
+
+//////////////////////////////////////////////////
+bool FakeFuelServer::Start(uint16_t _port)
+{
+  return this->dataPtr->server->Start("127.0.0.1", _port);
+}
+
+//////////////////////////////////////////////////
+void FakeFuelServer::Stop()
+{
+  this->dataPtr->server->Stop();
+}
+
+//////////////////////////////////////////////////
+std::string FakeFuelServer::Url() const
+{
+  return this->dataPtr->server->Url();
+}
+
+//////////////////////////////////////////////////
+FakeFuelServerStats FakeFuelServer::Stats() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->stats;
+}
+
+//////////////////////////////////////////////////
+void FakeFuelServer::ResetStats()
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->stats = FakeFuelServerStats();
+}
+
+//////////////////////////////////////////////////
+void FakeFuelServerPrivate::Handle(const HttpRequest &_request,
+    HttpResponse &_response)
+{
+  FakeFuelServerOptions opts;
+  bool throttle{false};
+  bool fail{false};
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    opts = this->options;
+    ++this->stats.requests;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - this->windowStart >= std::chrono::seconds(1))
+    {
+      this->windowStart = now;
+      this->windowRequests = 0;
+    }
+    throttle = opts.rateLimit > 0 && ++this->windowRequests > opts.rateLimit;
+
+    if (throttle)
+      ++this->stats.throttled;
+    else if (opts.errorRate > 0 &&
+        std::uniform_real_distribution<double>(0, 1)(this->random) <
+        opts.errorRate)
+    {
+      fail = true;
+      ++this->stats.errors;
+    }
+  }
+
+  if (opts.latency.count() > 0)
+    std::this_thread::sleep_for(opts.latency);
+
+  if (throttle)
+  {
+    _response.status = 429;
+    _response.headers["Retry-After"] = std::to_string(opts.retryAfter);
+    return;
+  }
+
+  if (fail)
+  {
+    _response.status = 500;
+    return;
+  }
+
+  if (_request.method != "GET" && _request.method != "HEAD")
+  {
+    _response.status = 405;
+    return;
+  }
+
+  auto segments = common::Split(_request.path, '/');
+  segments.erase(std::remove(segments.begin(), segments.end(), ""),
+      segments.end());
+  if (segments.empty() || segments[0] != "1.0" ||
+      std::find(segments.begin(), segments.end(), "..") != segments.end())
+  {
+    _response.status = 404;
+    return;
+  }
+  segments.erase(segments.begin());
+
+  this->Route(segments, _request, _response);
+
+  uint64_t size = _response.body.size();
+  if (!_response.file.empty())
+  {
+    std::ifstream in(_response.file, std::ios::binary | std::ios::ate);
+    size = static_cast<uint64_t>(in.tellg());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stats.bytes += size;
+  }
+
+  if (opts.bandwidth > 0)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(
+        size * 1000 / opts.bandwidth));
+  }
+}
+
+//////////////////////////////////////////////////
+void FakeFuelServerPrivate::Route(const std::vector<std::string> &_segments,
+    const HttpRequest &_request, HttpResponse &_response)
+{
+  auto isType = [](const std::string &_type)
+  {
+    return _type == "models" || _type == "worlds";
+  };
+
+  // Listing of all owners: <type>
+  if (_segments.size() == 1 && isType(_segments[0]))
+  {
+    this->List("", _segments[0], _request, _response);
+    return;
+  }
+
+  // Listing of an owner: <owner>/<type>
+  if (_segments.size() == 2 && isType(_segments[1]))
+  {
+    this->List(_segments[0], _segments[1], _request, _response);
+    return;
+  }
+
+  if (_segments.size() < 3 || !isType(_segments[1]))
+  {
+    _response.status = 404;
+    return;
+  }
+
+  const auto &owner = _segments[0];
+  const auto &type = _segments[1];
+  const auto &name = _segments[2];
+  unsigned int version;
+  if (!this->Resolve(owner, type, name,
+        _segments.size() > 3 ? _segments[3] : "tip", version))
+  {
+    _response.status = 404;
+    return;
+  }
+  _response.headers["X-Ign-Resource-Version"] = std::to_string(version);
+
+  // Details: <owner>/<type>/<name>
+  if (_segments.size() == 3)
+  {
+    _response.body = this->Describe(owner, name, version);
+    _response.headers["Content-Type"] = "application/json";
+    return;
+  }
+
+  // Archive: <owner>/<type>/<name>/<version>/<name>.zip
+  if (_segments.size() == 5 && _segments[4] == name + ".zip")
+  {
+    _response.file = this->Archive(owner, type, name, version);
+    if (_response.file.empty())
+    {
+      _response.status = 500;
+      return;
+    }
+    _response.headers["Content-Type"] = "application/zip";
+    std::lock_guard<std::mutex> lock(this->mutex);
+    ++this->stats.archives;
+    return;
+  }
+
+  // File: <owner>/<type>/<name>/<version>/files/<path>
+  if (_segments.size() > 5 && _segments[4] == "files")
+  {
+    std::string file = common::joinPaths(this->root, owner, type, name,
+        std::to_string(version));
+    for (size_t i = 5; i < _segments.size(); ++i)
+      file = common::joinPaths(file, _segments[i]);
+
+    if (common::isFile(file))
+    {
+      _response.file = file;
+      _response.headers["Content-Type"] = "application/octet-stream";
+      return;
+    }
+  }
+
+  _response.status = 404;
+}
+
+//////////////////////////////////////////////////
+std::vector<unsigned int> FakeFuelServerPrivate::Versions(
+    const std::string &_owner, const std::string &_type,
+    const std::string &_name) const
+{
+  std::vector<unsigned int> versions;
+  for (const auto &dir : subdirectories(
+        common::joinPaths(this->root, _owner, _type, _name)))
+  {
+    unsigned int version;
+    if (parseNumber(dir, version))
+      versions.push_back(version);
+  }
+  std::sort(versions.begin(), versions.end());
+  return versions;
+}
+
+//////////////////////////////////////////////////
+bool FakeFuelServerPrivate::Resolve(const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    const std::string &_versionStr, unsigned int &_version) const
+{
+  auto versions = this->Versions(_owner, _type, _name);
+  if (versions.empty())
+    return false;
+
+  if (_versionStr == "tip")
+  {
+    _version = versions.back();
+    return true;
+  }
+
+  return parseNumber(_versionStr, _version) &&
+      std::find(versions.begin(), versions.end(), _version) != versions.end();
+}
+
+//////////////////////////////////////////////////
+std::string FakeFuelServerPrivate::Describe(const std::string &_owner,
+    const std::string &_name, unsigned int _version) const
+{
+  std::stringstream json;
+  json << "{\"name\":" << jsonString(_name)
+       << ",\"owner\":" << jsonString(_owner)
+       << ",\"description\":" << jsonString("Served by FakeFuelServer")
+       << ",\"createdAt\":\"2020-01-01T00:00:00.000Z\""
+       << ",\"updatedAt\":\"2020-01-01T00:00:00.000Z\""
+       << ",\"likes\":0,\"downloads\":0"
+       << ",\"license_name\":\"Creative Commons - Public Domain\""
+       << ",\"tags\":[]"
+       << ",\"version\":" << _version << "}";
+  return json.str();
+}
+
+//////////////////////////////////////////////////
+void FakeFuelServerPrivate::List(const std::string &_owner,
+    const std::string &_type, const HttpRequest &_request,
+    HttpResponse &_response) const
+{
+  unsigned int pageSize;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    pageSize = this->options.pageSize;
+  }
+
+  unsigned int page = 1;
+  auto param = _request.params.find("page");
+  if (param != _request.params.end() && !parseNumber(param->second, page))
+  {
+    _response.status = 400;
+    return;
+  }
+  param = _request.params.find("per_page");
+  if (param != _request.params.end() &&
+      !parseNumber(param->second, pageSize))
+  {
+    _response.status = 400;
+    return;
+  }
+
+  std::vector<std::string> owners;
+  if (_owner.empty())
+    owners = subdirectories(this->root);
+  else
+    owners.push_back(_owner);
+
+  std::vector<std::string> items;
+  size_t first = static_cast<size_t>(page - 1) * pageSize;
+  size_t index = 0;
+  bool more{false};
+  for (const auto &owner : owners)
+  {
+    for (const auto &name : subdirectories(
+          common::joinPaths(this->root, owner, _type)))
+    {
+      auto versions = this->Versions(owner, _type, name);
+      if (versions.empty())
+        continue;
+
+      if (index >= first + pageSize)
+      {
+        more = true;
+        break;
+      }
+      if (index++ >= first)
+        items.push_back(this->Describe(owner, name, versions.back()));
+    }
+    if (more)
+      break;
+  }
+
+  std::string body = "[";
+  for (const auto &item : items)
+    body += (body.size() > 1 ? "," : "") + item;
+  _response.body = body + "]";
+  _response.headers["Content-Type"] = "application/json";
+
+  if (more)
+  {
+    _response.headers["Link"] = "<" + this->server->Url() + _request.path +
+        "?page=" + std::to_string(page + 1) + "&per_page=" +
+        std::to_string(pageSize) + ">; rel=\"next\"";
+  }
+}
+
+//////////////////////////////////////////////////
+std::string FakeFuelServerPrivate::Archive(const std::string &_owner,
+    const std::string &_type, const std::string &_name,
+    unsigned int _version)
+{
+  std::string archive = common::joinPaths(this->root, ".archives", _owner,
+      _type, _name, std::to_string(_version) + ".zip");
+
+  std::lock_guard<std::mutex> lock(this->archiveMutex);
+  if (common::isFile(archive))
+    return archive;
+
+  common::createDirectories(common::parentPath(archive));
+
+  // Compressing the entries one by one keeps them at the root of the
+  // archive, like the archives of a Fuel server.
+  std::string dir = common::joinPaths(this->root, _owner, _type, _name,
+      std::to_string(_version));
+  std::string partial = archive + ".partial";
+  common::removeAll(partial);
+  common::DirIter end;
+  for (common::DirIter it(dir); it != end; ++it)
+  {
+    if (!Zip::Compress(*it, partial))
+    {
+      ignerr << "Unable to compress [" << *it << "]" << std::endl;
+      common::removeAll(partial);
+      return "";
+    }
+  }
+
+  if (!common::moveFile(partial, archive))
+  {
+    ignerr << "Unable to create archive [" << archive << "]" << std::endl;
+    return "";
+  }
+
+  return archive;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_FUEL_TOOLS_TEST_SERVER_FAKEFUELSERVER_HH_
+#define IGNITION_FUEL_TOOLS_TEST_SERVER_FAKEFUELSERVER_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Forward declaration
+    class FakeFuelServerPrivate;
+
+    /// \brief Knobs controlling how a FakeFuelServer misbehaves. They're
+    /// applied to every request, in this order: latency, throttling,
+    /// errors and bandwidth.
+    struct FakeFuelServerOptions
+    {
+      /// \brief Delay added before answering each request.
+      public: std::chrono::milliseconds latency{0};
+
+      /// \brief Maximum bytes per second of each response body, emulated by
+      /// delaying the response. Zero means unlimited.
+      public: uint64_t bandwidth = 0;
+
+      /// \brief Fraction of requests, between 0 and 1, answered with a 500
+      /// error.
+      public: double errorRate = 0.0;
+
+      /// \brief Maximum requests per second. Requests above it are answered
+      /// with 429 and a Retry-After header. Zero means unlimited.
+      public: unsigned int rateLimit = 0;
+
+      /// \brief Seconds sent in the Retry-After header of 429 responses.
+      public: unsigned int retryAfter = 1;
+
+      /// \brief Number of resources per page of listings, unless the
+      /// request has a per_page parameter.
+      public: unsigned int pageSize = 20;
+
+      /// \brief Seed of the generator deciding which requests fail, so runs
+      /// are reproducible.
+      public: unsigned int seed = 0;
+    };
+
+    /// \brief Counters describing the activity of a FakeFuelServer.
+    struct FakeFuelServerStats
+    {
+      /// \brief Requests received.
+      public: uint64_t requests = 0;
+
+      /// \brief Requests answered with an injected 500 error.
+      public: uint64_t errors = 0;
+
+      /// \brief Requests answered with 429.
+      public: uint64_t throttled = 0;
+
+      /// \brief Archives served.
+      public: uint64_t archives = 0;
+
+      /// \brief Bytes of response bodies sent.
+      public: uint64_t bytes = 0;
+    };
+
+    /// \brief A stand-in for a Fuel server, listening on the loopback
+    /// interface, for tests and benchmarks which must not depend on the
+    /// public server.
+    ///
+    /// Resources are read from a directory laid out like a server's
+    /// directory in the local cache:
+    ///
+    ///   <root>/<owner>/<models|worlds>/<name>/<version>/...
+    ///
+    /// The server answers the paginated "models" and "worlds" listings, the
+    /// per-owner listings, resource details, "<version>/<name>.zip" archives
+    /// and "<version>/files/<path>" routes, where version may be "tip".
+    /// Archives are created on first request and kept in "<root>/.archives".
+    class FakeFuelServer
+    {
+      /// \brief Constructor.
+      /// \param[in] _root Directory with the resources to serve.
+      /// \param[in] _options Misbehavior knobs.
+      public: explicit FakeFuelServer(const std::string &_root,
+          const FakeFuelServerOptions &_options = FakeFuelServerOptions());
+
+      /// \brief Destructor. Stops the server.
+      public: ~FakeFuelServer();
+
+      /// \brief Change the misbehavior knobs. Can be called while the server
+      /// is running.
+      /// \param[in] _options New knobs.
+      public: void SetOptions(const FakeFuelServerOptions &_options);
+
+      /// \brief Start listening on the loopback interface.
+      /// \param[in] _port Port to bind to, or 0 for any free port.
+      /// \return True if the server started.
+      public: bool Start(uint16_t _port = 0);
+
+      /// \brief Stop listening.
+      public: void Stop();
+
+      /// \brief Base URL of the server, to be used in a ServerConfig.
+      /// \return URL, such as "http://127.0.0.1:8000", or empty if the
+      /// server isn't running.
+      public: std::string Url() const;
+
+      /// \brief Get activity counters.
+      /// \return Counters since the server was created or the last call to
+      /// ResetStats().
+      public: FakeFuelServerStats Stats() const;
+
+      /// \brief Reset activity counters.
+      public: void ResetStats();
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<FakeFuelServerPrivate> dataPtr;
+    };
+  }
+}
+
+#endif
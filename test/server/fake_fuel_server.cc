@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "FakeFuelServer.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+/// \brief Set when the process is asked to stop.
+static std::atomic<bool> g_stop{false};
+
+//////////////////////////////////////////////////
+/// \brief Signal handler.
+void onSignal(int)
+{
+  g_stop = true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Serve a directory with a FakeFuelServer until interrupted, so load
+/// tests can be run against it with any HTTP client.
+int main(int argc, char **argv)
+{
+  std::string usage = std::string("Usage: ") + argv[0] +
+      " <root> [--port N] [--latency MS] [--bandwidth BYTES_PER_SEC]"
+      " [--error-rate FRACTION] [--rate-limit REQUESTS_PER_SEC]"
+      " [--page-size N] [--seed N]";
+
+  if (argc < 2 || (argc % 2) != 0)
+  {
+    std::cerr << usage << std::endl;
+    return 1;
+  }
+
+  uint16_t port = 0;
+  FakeFuelServerOptions options;
+  for (int i = 2; i + 1 < argc; i += 2)
+  {
+    std::string flag = argv[i];
+    std::string value = argv[i + 1];
+    if (flag == "--port")
+      port = static_cast<uint16_t>(std::stoul(value));
+    else if (flag == "--latency")
+      options.latency = std::chrono::milliseconds(std::stoul(value));
+    else if (flag == "--bandwidth")
+      options.bandwidth = std::stoull(value);
+    else if (flag == "--error-rate")
+      options.errorRate = std::stod(value);
+    else if (flag == "--rate-limit")
+      options.rateLimit = std::stoul(value);
+    else if (flag == "--page-size")
+      options.pageSize = std::stoul(value);
+    else if (flag == "--seed")
+      options.seed = std::stoul(value);
+    else
+    {
+      std::cerr << "Unknown option [" << flag << "]" << std::endl
+                << usage << std::endl;
+      return 1;
+    }
+  }
+
+  FakeFuelServer server(argv[1], options);
+  if (!server.Start(port))
+    return 1;
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  std::cout << "Serving [" << argv[1] << "] on " << server.Url()
+            << std::endl;
+
+  while (!g_stop)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  server.Stop();
+  auto stats = server.Stats();
+  std::cout << stats.requests << " requests, " << stats.throttled
+            << " throttled, " << stats.errors << " errors, " << stats.bytes
+            << " bytes" << std::endl;
+  return 0;
+}
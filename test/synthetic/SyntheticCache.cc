@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ignition/common/Console.hh>
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/fuel_tools/Zip.hh"
+
+#include "SyntheticCache.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+//////////////////////////////////////////////////
+/// \brief Write a file.
+/// \param[in] _path File path.
+/// \param[in] _data Content.
+/// \return True if the file was written.
+static bool writeFile(const std::string &_path, const std::string &_data)
+{
+  std::ofstream out(_path, std::ios::binary | std::ios::trunc);
+  out << _data;
+  out.close();
+  if (!out)
+  {
+    ignerr << "Unable to write [" << _path << "]" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Write one model version.
+/// \param[in] _dir Version directory.
+/// \param[in] _name Model name.
+/// \param[in] _sizes Size of each mesh file.
+/// \param[in,out] _stats Counters to update.
+/// \return True if the version was written.
+static bool writeVersion(const std::string &_dir, const std::string &_name,
+    const std::vector<uint64_t> &_sizes, SyntheticCacheStats &_stats)
+{
+  if (!common::createDirectories(common::joinPaths(_dir, "meshes")))
+  {
+    ignerr << "Unable to create directory [" << _dir << "]" << std::endl;
+    return false;
+  }
+
+  std::string config = "<?xml version=\"1.0\"?>\n<model>\n  <name>" + _name +
+      "</name>\n  <version>1.0</version>\n"
+      "  <sdf version=\"1.6\">model.sdf</sdf>\n</model>\n";
+
+  std::stringstream sdf;
+  sdf << "<?xml version=\"1.0\"?>\n<sdf version=\"1.6\">\n"
+      << "  <model name=\"" << _name << "\">\n    <link name=\"link\">\n";
+  for (size_t i = 0; i < _sizes.size(); ++i)
+  {
+    sdf << "      <visual name=\"visual" << i << "\">\n"
+        << "        <geometry><mesh><uri>model://" << _name
+        << "/meshes/mesh" << i << ".dae</uri></mesh></geometry>\n"
+        << "      </visual>\n";
+  }
+  sdf << "    </link>\n  </model>\n</sdf>\n";
+
+  if (!writeFile(common::joinPaths(_dir, "model.config"), config) ||
+      !writeFile(common::joinPaths(_dir, "model.sdf"), sdf.str()))
+  {
+    return false;
+  }
+  _stats.files += 2;
+  _stats.bytes += config.size() + sdf.str().size();
+
+  for (size_t i = 0; i < _sizes.size(); ++i)
+  {
+    std::string mesh(_sizes[i], static_cast<char>('a' + i % 26));
+    if (!writeFile(common::joinPaths(_dir, "meshes",
+          "mesh" + std::to_string(i) + ".dae"), mesh))
+    {
+      return false;
+    }
+    ++_stats.files;
+    _stats.bytes += _sizes[i];
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Compress a model version, with its entries at the root of the
+/// archive, like the archives of a Fuel server.
+/// \param[in] _dir Version directory.
+/// \param[in] _archive Archive path.
+/// \return True if the archive was written.
+static bool writeArchive(const std::string &_dir, const std::string &_archive)
+{
+  common::createDirectories(common::parentPath(_archive));
+  common::removeAll(_archive);
+
+  common::DirIter end;
+  for (common::DirIter it(_dir); it != end; ++it)
+  {
+    if (!Zip::Compress(*it, _archive))
+    {
+      ignerr << "Unable to compress [" << *it << "]" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool SyntheticCache::Generate(const std::string &_dir,
+    const SyntheticCacheOptions &_options, SyntheticCacheStats *_stats)
+{
+  if (_options.owners == 0 || _options.versions == 0 ||
+      _options.pageSize == 0 || _options.minFileSize == 0 ||
+      _options.minFileSize > _options.maxFileSize)
+  {
+    ignerr << "Invalid synthetic cache options." << std::endl;
+    return false;
+  }
+
+  SyntheticCacheStats stats;
+  std::mt19937 random(_options.seed);
+  std::uniform_real_distribution<double> logSize(
+      std::log(static_cast<double>(_options.minFileSize)),
+      std::log(static_cast<double>(_options.maxFileSize)));
+
+  for (unsigned int s = 0; s < _options.servers; ++s)
+  {
+    std::string serverDir = common::joinPaths(_dir, ServerHost(s));
+
+    // Owner and name of each model, for the catalog.
+    std::vector<std::pair<std::string, std::string>> catalog;
+
+    for (unsigned int m = 0; m < _options.models; ++m)
+    {
+      std::string owner = Owner(_options, m);
+      std::string name = Name(m);
+      std::string modelDir = common::joinPaths(serverDir, owner, "models",
+          name);
+
+      for (unsigned int v = 1; v <= _options.versions; ++v)
+      {
+        std::vector<uint64_t> sizes;
+        for (unsigned int f = 0; f < _options.files; ++f)
+        {
+          sizes.push_back(std::min(_options.maxFileSize, std::max(
+              _options.minFileSize,
+              static_cast<uint64_t>(std::exp(logSize(random))))));
+        }
+
+        std::string versionDir = common::joinPaths(modelDir,
+            std::to_string(v));
+        if (!writeVersion(versionDir, name, sizes, stats))
+          return false;
+        ++stats.versions;
+
+        if (_options.archives)
+        {
+          if (!writeArchive(versionDir, common::joinPaths(serverDir,
+                ".archives", owner, "models", name,
+                std::to_string(v) + ".zip")))
+          {
+            return false;
+          }
+          ++stats.archives;
+        }
+      }
+
+      ++stats.models;
+      catalog.push_back({owner, name});
+    }
+
+    if (!_options.catalog)
+      continue;
+
+    // Pages list models in the same order as FakeFuelServer.
+    std::sort(catalog.begin(), catalog.end());
+    std::string catalogDir = common::joinPaths(serverDir, ".catalog",
+        "models");
+    common::createDirectories(catalogDir);
+    for (size_t first = 0; first < catalog.size();
+        first += _options.pageSize)
+    {
+      std::stringstream page;
+      page << "[";
+      size_t last = std::min(catalog.size(), first + _options.pageSize);
+      for (size_t i = first; i < last; ++i)
+      {
+        page << (i == first ? "" : ",")
+             << "{\"name\":\"" << catalog[i].second << "\""
+             << ",\"owner\":\"" << catalog[i].first << "\""
+             << ",\"description\":\"Synthetic model\""
+             << ",\"createdAt\":\"2020-01-01T00:00:00.000Z\""
+             << ",\"updatedAt\":\"2020-01-01T00:00:00.000Z\""
+             << ",\"likes\":0,\"downloads\":0"
+             << ",\"license_name\":\"Creative Commons - Public Domain\""
+             << ",\"tags\":[]"
+             << ",\"version\":" << _options.versions << "}";
+      }
+      page << "]";
+
+      if (!writeFile(common::joinPaths(catalogDir, "page_" +
+            std::to_string(first / _options.pageSize + 1) + ".json"),
+            page.str()))
+      {
+        return false;
+      }
+      ++stats.pages;
+    }
+  }
+
+  if (_stats)
+    *_stats = stats;
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string SyntheticCache::ServerHost(unsigned int _server)
+{
+  return "localhost:" + std::to_string(8001 + _server);
+}
+
+//////////////////////////////////////////////////
+std::string SyntheticCache::Owner(const SyntheticCacheOptions &_options,
+    unsigned int _model)
+{
+  return "owner" + std::to_string(_model % std::max(1u, _options.owners));
+}
+
+//////////////////////////////////////////////////
+std::string SyntheticCache::Name(unsigned int _model)
+{
+  return "model" + std::to_string(_model);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_FUEL_TOOLS_TEST_SYNTHETIC_SYNTHETICCACHE_HH_
+#define IGNITION_FUEL_TOOLS_TEST_SYNTHETIC_SYNTHETICCACHE_HH_
+
+#include <cstdint>
+#include <string>
+
+namespace ignition
+{
+  namespace fuel_tools
+  {
+    /// \brief Shape of a synthetic cache.
+    struct SyntheticCacheOptions
+    {
+      /// \brief Number of servers. Server i is "localhost:<8001 + i>".
+      public: unsigned int servers = 1;
+
+      /// \brief Number of owners on each server.
+      public: unsigned int owners = 10;
+
+      /// \brief Number of models on each server, spread evenly across
+      /// owners.
+      public: unsigned int models = 100;
+
+      /// \brief Number of versions of each model.
+      public: unsigned int versions = 1;
+
+      /// \brief Number of mesh files in each version, besides model.config
+      /// and model.sdf. Each one is referenced by a model:// URI in the SDF.
+      public: unsigned int files = 2;
+
+      /// \brief Minimum size of a mesh file, in bytes.
+      public: uint64_t minFileSize = 1000;
+
+      /// \brief Maximum size of a mesh file, in bytes. Sizes follow a
+      /// log-uniform distribution between the minimum and the maximum, so
+      /// most files are small and a few are large.
+      public: uint64_t maxFileSize = 100000;
+
+      /// \brief Seed of the size generator, so trees are reproducible.
+      public: unsigned int seed = 0;
+
+      /// \brief Also write the catalog, as the JSON pages of the "models"
+      /// listing, to "<server>/.catalog/models/page_<N>.json".
+      public: bool catalog = false;
+
+      /// \brief Number of models per catalog page.
+      public: unsigned int pageSize = 100;
+
+      /// \brief Also write the archive of each version, to
+      /// "<server>/.archives/<owner>/models/<name>/<version>.zip", where
+      /// FakeFuelServer looks for them.
+      public: bool archives = false;
+    };
+
+    /// \brief What a synthetic cache contains.
+    struct SyntheticCacheStats
+    {
+      /// \brief Models created, across all servers.
+      public: uint64_t models = 0;
+
+      /// \brief Model versions created.
+      public: uint64_t versions = 0;
+
+      /// \brief Files created in model versions.
+      public: uint64_t files = 0;
+
+      /// \brief Bytes written to files in model versions.
+      public: uint64_t bytes = 0;
+
+      /// \brief Catalog pages written.
+      public: uint64_t pages = 0;
+
+      /// \brief Archives written.
+      public: uint64_t archives = 0;
+    };
+
+    /// \brief Generates synthetic cache trees, so LocalCache, the benchmarks
+    /// and FakeFuelServer can be exercised at a realistic scale.
+    ///
+    /// The tree has the layout of a cache location:
+    ///
+    ///   <dir>/<server>/owner<i>/models/model<j>/<version>/...
+    ///
+    /// Each server directory can also be served by a FakeFuelServer.
+    class SyntheticCache
+    {
+      /// \brief Generate a tree. Existing files are overwritten.
+      /// \param[in] _dir Directory, such as a cache location.
+      /// \param[in] _options Shape of the tree.
+      /// \param[out] _stats Optional description of what was created.
+      /// \return True if the whole tree was created.
+      public: static bool Generate(const std::string &_dir,
+          const SyntheticCacheOptions &_options,
+          SyntheticCacheStats *_stats = nullptr);
+
+      /// \brief Get the host of a server, which is also its directory name.
+      /// \param[in] _server Server index.
+      /// \return Host, such as "localhost:8001".
+      public: static std::string ServerHost(unsigned int _server);
+
+      /// \brief Get the owner of a model.
+      /// \param[in] _options Shape of the tree.
+      /// \param[in] _model Model index.
+      /// \return Owner, such as "owner3".
+      public: static std::string Owner(const SyntheticCacheOptions &_options,
+          unsigned int _model);
+
+      /// \brief Get the name of a model.
+      /// \param[in] _model Model index.
+      /// \return Name, such as "model42".
+      public: static std::string Name(unsigned int _model);
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <iostream>
+#include <string>
+
+#include "SyntheticCache.hh"
+
+using namespace ignition;
+using namespace fuel_tools;
+
+//////////////////////////////////////////////////
+/// \brief Generate a synthetic cache tree from the command line.
+int main(int argc, char **argv)
+{
+  std::string usage = std::string("Usage: ") + argv[0] +
+      " <dir> [--servers N] [--owners N] [--models N] [--versions N]"
+      " [--files N] [--min-size BYTES] [--max-size BYTES] [--seed N]"
+      " [--page-size N] [--catalog] [--archives]";
+
+  if (argc < 2)
+  {
+    std::cerr << usage << std::endl;
+    return 1;
+  }
+
+  SyntheticCacheOptions options;
+  for (int i = 2; i < argc; ++i)
+  {
+    std::string flag = argv[i];
+    if (flag == "--catalog")
+    {
+      options.catalog = true;
+      continue;
+    }
+    if (flag == "--archives")
+    {
+      options.archives = true;
+      continue;
+    }
+
+    if (i + 1 >= argc)
+    {
+      std::cerr << "Missing value of [" << flag << "]" << std::endl
+                << usage << std::endl;
+      return 1;
+    }
+    std::string value = argv[++i];
+
+    if (flag == "--servers")
+      options.servers = std::stoul(value);
+    else if (flag == "--owners")
+      options.owners = std::stoul(value);
+    else if (flag == "--models")
+      options.models = std::stoul(value);
+    else if (flag == "--versions")
+      options.versions = std::stoul(value);
+    else if (flag == "--files")
+      options.files = std::stoul(value);
+    else if (flag == "--min-size")
+      options.minFileSize = std::stoull(value);
+    else if (flag == "--max-size")
+      options.maxFileSize = std::stoull(value);
+    else if (flag == "--seed")
+      options.seed = std::stoul(value);
+    else if (flag == "--page-size")
+      options.pageSize = std::stoul(value);
+    else
+    {
+      std::cerr << "Unknown option [" << flag << "]" << std::endl
+                << usage << std::endl;
+      return 1;
+    }
+  }
+
+  SyntheticCacheStats stats;
+  if (!SyntheticCache::Generate(argv[1], options, &stats))
+    return 1;
+
+  std::cout << stats.models << " models, " << stats.versions << " versions, "
+            << stats.files << " files, " << stats.bytes << " bytes, "
+            << stats.pages << " catalog pages, " << stats.archives
+            << " archives" << std::endl;
+  return 0;
+}